@@ -0,0 +1,123 @@
+/*
+
+Copyright (c) 2016, Robin Raymond
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are those
+of the authors and should not be interpreted as representing official policies,
+either expressed or implied, of the FreeBSD Project.
+
+*/
+
+
+#pragma once
+
+#include <zsLib/eventing/types.h>
+
+namespace zsLib
+{
+  namespace eventing
+  {
+
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    #pragma mark
+    #pragma mark IFlightRecorderTypes
+    #pragma mark
+
+    interaction IFlightRecorderTypes
+    {
+      typedef zsLib::Log::KeywordBitmaskType KeywordBitmaskType;
+      typedef zsLib::Log::Severity Severity;
+
+      // a rule matches when every condition that has a value matches
+      struct TriggerRule
+      {
+        String mProviderName;                   // empty matches any recorded provider
+        Optional<Severity> mMinimumSeverity;    // matches events at or above this severity
+        Optional<size_t> mEventID;              // matches a specific event ID
+      };
+    };
+
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    #pragma mark
+    #pragma mark IFlightRecorder
+    #pragma mark
+
+    // In-process recorder that keeps the most recent events of the selected
+    // providers in a fixed size memory mapped ring file. The file is usable
+    // for post-mortem analysis even if the process terminates abnormally.
+    interaction IFlightRecorder : public IFlightRecorderTypes
+    {
+      // a file size of zero uses the configured default file size
+      static IFlightRecorderPtr create(
+                                       const char *fileName,
+                                       size_t fileSizeInBytes = 0
+                                       ) throw (StdError);
+
+      // converts a ring file (including one left behind by a process which
+      // terminated abnormally) into a trace file (see ITraceFileWriter)
+      // starting at the oldest checkpoint still present in the ring; returns
+      // the total records written
+      static size_t convert(
+                            const char *ringFileName,
+                            const char *traceFileName
+                            ) throw (StdError);
+
+      virtual PUID getID() const = 0;
+
+      virtual void shutdown() = 0;
+
+      virtual String getFileName() const = 0;
+
+      // start (or stop, if keywords is 0) recording events from a provider
+      virtual void setProviderLogging(
+                                      const char *providerName,
+                                      KeywordBitmaskType keywords
+                                      ) = 0;
+
+      virtual size_t getTotalDroppedEvents() const = 0;
+
+      // when a recorded event matches a trigger rule the recorder freezes the
+      // events from the pre-trigger window up to the end of the post-trigger
+      // window into a separate snapshot trace file (see the
+      // "zsLib/eventing/flight-recorder/trigger/..." settings) and then
+      // re-arms; triggers firing while a snapshot is in progress are ignored
+      virtual PUID addTrigger(const TriggerRule &rule) = 0;
+      virtual void removeTrigger(PUID triggerID) = 0;
+
+      virtual size_t getTotalSnapshots() const = 0;
+
+      // offset added to the recorded times to convert them to the clock
+      // recordings are merged on, e.g. the monitor's clock taken from the
+      // IRemoteEventingTypes::Statistics of the connection to the monitor;
+      // stored in snapshots and in the ring file (and thus its conversion)
+      virtual void setClockOffset(Microseconds offset) = 0;
+    };
+  }
+}
@@ -123,6 +123,17 @@ namespace zsLib
 
       static SecureByteBlockPtr convertFromHex(const String &input);
 
+      // buffers prefixed with their size as a 32 bit little endian value
+      // (e.g. a provider schema, see ZS_EVENTING_PROVIDER_SCHEMA_ATOM_NAME)
+      static SecureByteBlockPtr convertToSizePrefixedBuffer(
+                                                            const BYTE *buffer,
+                                                            size_t bufferLengthInBytes
+                                                            );
+      static const BYTE *getSizePrefixedBuffer(
+                                               const BYTE *prefixedBuffer,
+                                               size_t &outBufferLengthInBytes
+                                               );
+
       static String getDebugString(
                                    const SecureByteBlock &buffer,
                                    size_t bytesPerGroup = 4,
@@ -33,6 +33,15 @@ either expressed or implied, of the FreeBSD Project.
 
 #include <zsLib/eventing/types.h>
 
+// A provider may attach its compiled event schema (as embedded in the
+// generated events header) to the eventing atom with this name; the atom
+// points to the schema prefixed with its size as a 32 bit little endian
+// value. Remote eventing ships the schema with the provider's announcement,
+// or ahead of the provider's first event when the schema is attached after
+// the announcement, so the remote party can decode its events without the
+// provider's jman file.
+#define ZS_EVENTING_PROVIDER_SCHEMA_ATOM_NAME "org.zsLib.eventing.ProviderSchema"
+
 namespace zsLib
 {
   namespace eventing
@@ -68,6 +77,57 @@ namespace zsLib
       {
         Port_Default = 63311
       };
+
+      struct EventCounter
+      {
+        UUID mProviderID {};
+        String mProviderName;
+        size_t mEventID {};
+
+        size_t mTotalEvents {};
+        size_t mTotalBytes {};
+        size_t mTotalDropped {};
+      };
+
+      ZS_DECLARE_TYPEDEF_PTR(std::list<EventCounter>, EventCounterList);
+
+      struct Statistics
+      {
+        size_t mEventsSent {};
+        size_t mEventsReceived {};
+        size_t mEventsDropped {};
+
+        size_t mBytesSent {};
+        size_t mBytesReceived {};
+
+        size_t mFramesSent {};
+        size_t mFramesReceived {};
+
+        size_t mSendCalls {};
+        size_t mReceiveCalls {};
+
+        size_t mAsyncQueueHighWaterMark {};
+        size_t mOutgoingQueueHighWaterMark {};
+
+        Microseconds mWriteBlockedTime {};
+
+        size_t mEventsEncoded {};
+        Nanoseconds mEncodeTime {};
+
+        Milliseconds mHandshakeDuration {};
+
+        // estimated during the handshake as remote clock - local clock (to
+        // within half the round trip it was measured over); a recording of
+        // the remote's events is stamped with the remote clock and offset
+        // back to the local clock (see ITraceFileWriter::setClockOffset)
+        bool mHasRemoteClockOffset {};
+        Microseconds mRemoteClockOffset {};
+        Microseconds mRemoteClockRoundTrip {};
+
+        Nanoseconds averageEncodeTime() const { return (mEventsEncoded > 0 ? Nanoseconds(mEncodeTime.count() / static_cast<Nanoseconds::rep>(mEventsEncoded)) : Nanoseconds()); }
+
+        ElementPtr toDebug() const;
+      };
       
       static const char *toString(States state);
       States toState(const char *state) throw (InvalidArgument);      
@@ -83,10 +143,13 @@ namespace zsLib
 
     interaction IRemoteEventing : public IRemoteEventingTypes
     {
+      // a queue can be supplied so several connections are serviced (and
+      // their events written) in parallel on different threads
       static IRemoteEventingPtr connectToRemote(
                                                 IRemoteEventingDelegatePtr connectionDelegate,
                                                 const IPAddress &serverIP,
-                                                const char *connectionSharedSecret
+                                                const char *connectionSharedSecret,
+                                                IMessageQueuePtr queue = IMessageQueuePtr()
                                                 );
 
       static IRemoteEventingPtr listenForRemote(
@@ -95,16 +158,47 @@ namespace zsLib
                                                 const char *connectionSharedSecret,
                                                 Seconds maxWaitToBindTimeInSeconds = Seconds(60)
                                                 );
+
+      // replays a recorded trace file through the same decoding path used
+      // for a live remote connection; a speed of zero replays as fast as
+      // possible while 1.0 keeps the original pacing (2.0 twice as fast)
+      static IRemoteEventingPtr replayFromFile(
+                                               IRemoteEventingDelegatePtr connectionDelegate,
+                                               const char *fileName,
+                                               double speed = 0.0
+                                               ) throw (StdError);
+
+      // the ID of the remote eventing object whose received event is being
+      // written on the calling thread (or 0 for a locally written event);
+      // only meaningful while an eventing listener is notified of the event
+      static PUID getWritingRemoteID();
+
+      // the time of the event being written on the calling thread in the
+      // local clock: a remote's own write time corrected by its estimated
+      // clock offset (see Statistics), the receive time for a remote too old
+      // to send its write times, the recorded time shifted by the file's
+      // clock offset when replaying, or the current time for a locally
+      // written event
+      static Time getWritingEventTime();
+
       virtual PUID getID() const = 0;
 
       virtual void shutdown() = 0;
 
       virtual States getState() const = 0;
 
+      // snapshot of the transport counters since the object was created;
+      // safe (and cheap) to call from any thread at any time
+      virtual Statistics getStatistics() const = 0;
+
       virtual void setRemoteLevel(
                                   const char *remoteSubsystemName,
                                   Level level
                                   ) = 0;
+
+      // records every notify and trace event received from the remote party
+      // into the trace file (pass NULL to stop recording)
+      virtual void recordTo(ITraceFileWriterPtr writer) = 0;
     };
 
     //-------------------------------------------------------------------------
@@ -118,6 +212,7 @@ namespace zsLib
     interaction IRemoteEventingDelegate
     {
       typedef IRemoteEventingTypes::States States;
+      typedef IRemoteEventingTypes::EventCounterListPtr EventCounterListPtr;
       typedef zsLib::Log::Level Level;
       typedef zsLib::Log::KeywordBitmaskType KeywordBitmaskType;
       
@@ -151,6 +246,18 @@ namespace zsLib
                                                        IRemoteEventingPtr connection,
                                                        size_t totalDropped
                                                        ) {}
+
+      // per provider / event ID counters (totals since the counter was first
+      // used); only counters that changed since the last notification are
+      // included in the list
+      virtual void onRemoteEventingLocalEventCounters(
+                                                      IRemoteEventingPtr connection,
+                                                      EventCounterListPtr counters
+                                                      ) {}
+      virtual void onRemoteEventingRemoteEventCounters(
+                                                       IRemoteEventingPtr connection,
+                                                       EventCounterListPtr counters
+                                                       ) {}
     };
   }
 }
@@ -160,6 +267,7 @@ ZS_DECLARE_PROXY_TYPEDEF(zsLib::eventing::IRemoteEventingPtr, IRemoteEventingPtr
 ZS_DECLARE_PROXY_TYPEDEF(zsLib::eventing::IRemoteEventingTypes::States, States)
 ZS_DECLARE_PROXY_TYPEDEF(std::size_t, size_t)
 ZS_DECLARE_PROXY_TYPEDEF(zsLib::UUID, UUID)
+ZS_DECLARE_PROXY_TYPEDEF(zsLib::eventing::IRemoteEventingTypes::EventCounterListPtr, EventCounterListPtr)
 ZS_DECLARE_PROXY_METHOD_2(onRemoteEventingStateChanged, IRemoteEventingPtr, States)
 ZS_DECLARE_PROXY_METHOD_2(onRemoteEventingRemoteSubsystem, IRemoteEventingPtr, const char *)
 ZS_DECLARE_PROXY_METHOD_3(onRemoteEventingRemoteProvider, UUID, const char *, const char *)
@@ -167,4 +275,6 @@ ZS_DECLARE_PROXY_METHOD_1(onRemoteEventingRemoteProviderGone, const char *)
 ZS_DECLARE_PROXY_METHOD_2(onRemoteEventingRemoteProviderStateChange, const char *, KeywordBitmaskType)
 ZS_DECLARE_PROXY_METHOD_2(onRemoteEventingLocalDroppedEvents, IRemoteEventingPtr, size_t)
 ZS_DECLARE_PROXY_METHOD_2(onRemoteEventingRemoteDroppedEvents, IRemoteEventingPtr, size_t)
+ZS_DECLARE_PROXY_METHOD_2(onRemoteEventingLocalEventCounters, IRemoteEventingPtr, EventCounterListPtr)
+ZS_DECLARE_PROXY_METHOD_2(onRemoteEventingRemoteEventCounters, IRemoteEventingPtr, EventCounterListPtr)
 ZS_DECLARE_PROXY_END()
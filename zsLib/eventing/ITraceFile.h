@@ -0,0 +1,333 @@
+/*
+
+Copyright (c) 2016, Robin Raymond
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are those
+of the authors and should not be interpreted as representing official policies,
+either expressed or implied, of the FreeBSD Project.
+
+*/
+
+
+#pragma once
+
+#include <zsLib/eventing/types.h>
+#include <zsLib/eventing/Log.h>
+
+#include <zsLib/Log.h>
+
+#include <bitset>
+#include <set>
+#include <vector>
+
+#define ZSLIB_EVENTING_TRACE_EVENT_CODEC_MAX_DATA_DESCRIPTORS (80)
+
+namespace zsLib
+{
+  namespace eventing
+  {
+
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    #pragma mark
+    #pragma mark ITraceFileTypes
+    #pragma mark
+
+    interaction ITraceFileTypes
+    {
+      typedef zsLib::Log::Severity Severity;
+      typedef zsLib::Log::Level Level;
+
+      // record types share their values with the remote eventing message
+      // types so recorded streams can be fed through the same decoders
+      enum RecordTypes
+      {
+        RecordType_Notify =     8,
+        RecordType_TraceEvent = 32,
+      };
+
+      enum Bitmaps : size_t
+      {
+        Bitmap_EventIDBits = 1024,
+      };
+
+      typedef std::set<uint64_t> ProviderHandleSet;
+      typedef std::bitset<Bitmap_EventIDBits> EventIDBitmap;
+
+      // bloom filter over the values of the events in a chunk (in the form
+      // returned by valueAsString); a match means the chunk may contain an
+      // event with the value
+      struct ValueFilter
+      {
+        size_t mTotalHashes {};
+        std::vector<BYTE> mBits;              // filter being built (writer)
+
+        // a reader does not copy the filter; it points into the reader's
+        // mapped file and remains valid while the reader is open
+        const BYTE *mMappedBits {};
+        size_t mMappedBitsSize {};
+
+        const BYTE *getBits() const {return (mMappedBits ? mMappedBits : (mBits.size() > 0 ? &(mBits[0]) : NULL));}
+        size_t getBitsSize() const {return (mMappedBits ? mMappedBitsSize : mBits.size());}
+
+        bool hasData() const {return getBitsSize() > 0;}
+
+        bool mightContain(const String &value) const {return mightContainHash(hash(value));}
+
+        bool mightContainHash(uint64_t valueHash) const;
+        void insertHash(uint64_t valueHash);
+
+        static uint64_t hash(const String &value);
+      };
+
+      struct Record
+      {
+        RecordTypes mType {RecordType_Notify};
+        Time mTime {};
+
+        // points into the reader's mapped file or decoded chunk and remains
+        // valid until the reader moves on to another chunk
+        const BYTE *mPayload {};
+        size_t mPayloadSize {};
+      };
+
+      // measured while writing so the compression can be judged on real
+      // traces (the decode figures come from the round trip check)
+      struct CompressionStats
+      {
+        size_t mTotalBlocks {};
+        size_t mTotalCompressedBlocks {};     // the others are stored as is
+        size_t mTotalVerifyFailures {};       // did not decode back (stored as is)
+        uint64_t mInputBytes {};
+        uint64_t mStoredBytes {};
+        Microseconds mCompressTime {};
+        uint64_t mVerifiedBytes {};           // decoded size of the blocks checked
+        Microseconds mVerifyTime {};
+      };
+
+      struct ChunkInfo
+      {
+        size_t mIndex {};
+        uint64_t mOffset {};
+        size_t mDataSize {};          // as stored (i.e. compressed) in the file
+        size_t mTotalRecords {};
+
+        Time mFirstTime {};
+        Time mLastTime {};
+
+        ProviderHandleSet mProviderHandles;
+
+        // event IDs are hashed into the bitmap (modulo the bitmap size) so a
+        // set bit means the chunk may contain the event
+        EventIDBitmap mEventIDs;
+
+        bool mightContainEventID(size_t eventID) const {return mEventIDs.test(eventID % Bitmap_EventIDBits);}
+
+        // empty if the chunk was written without a value index (in which
+        // case any value may be present)
+        ValueFilter mValues;
+
+        ElementPtr toDebug() const;
+      };
+
+      ZS_DECLARE_TYPEDEF_PTR(std::vector<ChunkInfo>, ChunkInfoList);
+
+      // a trace event record decoded in place; the descriptors point into
+      // (and numeric values are in host order within) the decoding buffer
+      struct TraceEvent
+      {
+        uint64_t mHandle {};
+        Severity mSeverity {Log::Severity_First};
+        Level mLevel {Log::Level_First};
+
+        USE_EVENT_DESCRIPTOR mDescriptor {};
+        size_t mDataDescriptorCount {};
+        USE_EVENT_PARAMETER_DESCRIPTOR mParameterDescriptors[ZSLIB_EVENTING_TRACE_EVENT_CODEC_MAX_DATA_DESCRIPTORS];
+        USE_EVENT_DATA_DESCRIPTOR mDataDescriptors[ZSLIB_EVENTING_TRACE_EVENT_CODEC_MAX_DATA_DESCRIPTORS];
+      };
+
+      // event data values (as decoded, i.e. in host order)
+      static uint64_t getUnsignedValue(const USE_EVENT_DATA_DESCRIPTOR &data);
+      static int64_t getSignedValue(const USE_EVENT_DATA_DESCRIPTOR &data);
+      static double getFloatValue(const USE_EVENT_DATA_DESCRIPTOR &data);
+
+      // returns false if the parameter is not a number
+      static bool getNumericValue(
+                                  const USE_EVENT_PARAMETER_DESCRIPTOR &param,
+                                  const USE_EVENT_DATA_DESCRIPTOR &data,
+                                  double &outValue
+                                  );
+
+      static String valueAsString(
+                                  const USE_EVENT_PARAMETER_DESCRIPTOR &param,
+                                  const USE_EVENT_DATA_DESCRIPTOR &data,
+                                  bool &outIsNumber
+                                  );
+    };
+
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    #pragma mark
+    #pragma mark ITraceFileWriter
+    #pragma mark
+
+    // Writes records (json notify or encoded trace event payloads) into a
+    // chunked trace file. Every chunk starts by re-announcing the subsystems
+    // and providers seen so far so each chunk can be decoded on its own, and
+    // ends with a footer indexing its time range, provider handles, event
+    // IDs and (optionally) a filter of its event values. A file level index
+    // of all chunks is written on close. Chunks are compressed independently
+    // against a dictionary trained on the first chunk (see the
+    // "zsLib/eventing/trace-file/..." settings); unless disabled, every
+    // compressed chunk is decoded again and compared before it is written.
+    interaction ITraceFileWriter : public ITraceFileTypes
+    {
+      // a chunk size of zero uses the configured default chunk size
+      static ITraceFileWriterPtr create(
+                                        const char *fileName,
+                                        size_t chunkSizeInBytes = 0
+                                        ) throw (StdError);
+
+      // merges trace files (e.g. recorded from several processes) into one
+      // time ordered file with a streaming k-way merge; record times are
+      // shifted by each file's clock offset and provider handles that collide
+      // between files are remapped (a provider recorded in several files is
+      // announced once); returns the total records written
+      static size_t merge(
+                          const char *outputFileName,
+                          const StringList &inputFileNames
+                          ) throw (StdError);
+
+      virtual PUID getID() const = 0;
+
+      virtual String getFileName() const = 0;
+
+      // offset which must be added to the recorded times to convert them to
+      // the clock the files are merged on; a monitor records a remote's
+      // events in the remote's clock offset to the monitor's own clock (see
+      // IRemoteEventingTypes::Statistics) and a flight recorder uses the
+      // offset given to it (see IFlightRecorder::setClockOffset)
+      virtual void setClockOffset(Microseconds offset) = 0;
+
+      virtual void writeRecord(
+                               RecordTypes type,
+                               Time time,
+                               const BYTE *payload,
+                               size_t payloadSize
+                               ) throw (StdError) = 0;
+
+      // flushes the last chunk and writes the file index; called
+      // automatically (with errors ignored) when the writer is destroyed
+      virtual void close() throw (StdError) = 0;
+
+      virtual size_t getTotalRecords() const = 0;
+
+      virtual CompressionStats getCompressionStats() const = 0;
+    };
+
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    #pragma mark
+    #pragma mark ITraceFileReader
+    #pragma mark
+
+    // Memory maps a trace file and uses the chunk index to seek without
+    // scanning the records. A file that was never closed (e.g. the writing
+    // process terminated) is recovered by walking the completed chunks.
+    interaction ITraceFileReader : public ITraceFileTypes
+    {
+      static ITraceFileReaderPtr open(const char *fileName) throw (StdError);
+
+      // copies a trace event record's payload into the buffer (which grows
+      // as needed) and decodes it there; returns false if not legal
+      static bool decodeEvent(
+                              const Record &record,
+                              SecureByteBlock &ioBuffer,
+                              TraceEvent &outEvent
+                              );
+
+      virtual PUID getID() const = 0;
+
+      virtual String getFileName() const = 0;
+
+      virtual Time getCreationTime() const = 0;
+      virtual Microseconds getClockOffset() const = 0;
+
+      virtual ChunkInfoListPtr getChunks() const = 0;
+
+      // returns the chunks whose index overlaps the time window and (if
+      // specified) may contain the provider handle / event ID
+      virtual ChunkInfoListPtr findChunks(
+                                          Time fromTime,
+                                          Time toTime,
+                                          const Optional<uint64_t> &providerHandle = Optional<uint64_t>(),
+                                          const Optional<size_t> &eventID = Optional<size_t>()
+                                          ) const = 0;
+
+      // positions the reader at the start of a chunk; reading always begins
+      // with the chunk's announcements so the records can be decoded
+      virtual void seekToChunk(size_t chunkIndex) = 0;
+
+      // positions the reader at the start of the first chunk which may hold
+      // records at or after the time specified
+      virtual void seek(Time time) = 0;
+
+      // returns false once the end of the file is reached
+      virtual bool readNext(Record &outRecord) = 0;
+
+      // returns false once the end of the current chunk is reached without
+      // moving on to the next chunk (i.e. to process chunks independently)
+      virtual bool readNextInChunk(Record &outRecord) = 0;
+
+      // creates a read position (with its own decoding buffer) over the
+      // reader's mapped file so several threads can read chunks at once
+      virtual ITraceFileChunkCursorPtr createChunkCursor() = 0;
+    };
+
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    #pragma mark
+    #pragma mark ITraceFileChunkCursor
+    #pragma mark
+
+    // Reads the records of one chunk at a time independently of the reader
+    // and of other cursors; each cursor must only be used by one thread.
+    interaction ITraceFileChunkCursor : public ITraceFileTypes
+    {
+      // positions the cursor at the start of a chunk
+      virtual void seekToChunk(size_t chunkIndex) = 0;
+
+      // returns false once the end of the chunk is reached
+      virtual bool readNextInChunk(Record &outRecord) = 0;
+    };
+  }
+}
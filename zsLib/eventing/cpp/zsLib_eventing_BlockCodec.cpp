@@ -0,0 +1,421 @@
+/*
+
+Copyright (c) 2016, Robin Raymond
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are those
+of the authors and should not be interpreted as representing official policies,
+either expressed or implied, of the FreeBSD Project.
+
+*/
+
+
+
+#include <zsLib/eventing/internal/zsLib_eventing_BlockCodec.h>
+
+#include <zsLib/Log.h>
+
+#include <algorithm>
+#include <vector>
+
+#define ZSLIB_EVENTING_BLOCK_CODEC_HASH_BITS (16)
+#define ZSLIB_EVENTING_BLOCK_CODEC_SKIP_TRIGGER (6)
+#define ZSLIB_EVENTING_BLOCK_CODEC_WILD_COPY_SIZE (16)
+#define ZSLIB_EVENTING_BLOCK_CODEC_DICTIONARY_SEGMENT_SIZE (64)
+#define ZSLIB_EVENTING_BLOCK_CODEC_DICTIONARY_GRAM_SIZE (6)
+
+namespace zsLib { namespace eventing { ZS_DECLARE_SUBSYSTEM(zsLib_eventing); } }
+
+namespace zsLib
+{
+  namespace eventing
+  {
+    namespace internal
+    {
+      //-----------------------------------------------------------------------
+      static inline CryptoPP::word32 read32(const BYTE *pos)
+      {
+        CryptoPP::word32 result {};
+        memcpy(&result, pos, sizeof(result));
+        return result;
+      }
+
+      //-----------------------------------------------------------------------
+      static inline size_t hashPosition(const BYTE *pos)
+      {
+        return static_cast<size_t>((read32(pos) * 2654435761U) >> (32 - ZSLIB_EVENTING_BLOCK_CODEC_HASH_BITS));
+      }
+
+      //-----------------------------------------------------------------------
+      static inline size_t hashGram(const BYTE *pos)
+      {
+        CryptoPP::word32 value = read32(pos) ^ (static_cast<CryptoPP::word32>(pos[4]) << 7) ^ (static_cast<CryptoPP::word32>(pos[5]) << 19);
+        return static_cast<size_t>((value * 2654435761U) >> (32 - ZSLIB_EVENTING_BLOCK_CODEC_HASH_BITS));
+      }
+
+      //-----------------------------------------------------------------------
+      static inline size_t getOffsetSize(size_t offset)
+      {
+        size_t result = 1;
+        while (offset >= 0x80) {
+          offset >>= 7;
+          ++result;
+        }
+        return result;
+      }
+
+      //-----------------------------------------------------------------------
+      static inline BYTE *writeLength(
+                                      BYTE *output,
+                                      size_t length
+                                      )
+      {
+        while (length >= 255) {
+          *output++ = 255;
+          length -= 255;
+        }
+        *output++ = static_cast<BYTE>(length);
+        return output;
+      }
+
+      //-----------------------------------------------------------------------
+      static inline bool readLength(
+                                    const BYTE * &input,
+                                    const BYTE *inputEnd,
+                                    size_t &ioLength
+                                    )
+      {
+        BYTE value {};
+        do {
+          if (input >= inputEnd) return false;
+          value = *input++;
+          ioLength += value;
+        } while (255 == value);
+        return true;
+      }
+
+      //-----------------------------------------------------------------------
+      static inline BYTE *writeSequence(
+                                        BYTE *output,
+                                        const BYTE *literals,
+                                        size_t literalLength,
+                                        size_t offset,
+                                        size_t matchLength
+                                        )
+      {
+        BYTE *token = output++;
+
+        if (literalLength >= 15) {
+          *token = static_cast<BYTE>(15 << 4);
+          output = writeLength(output, literalLength - 15);
+        } else {
+          *token = static_cast<BYTE>(literalLength << 4);
+        }
+
+        memcpy(output, literals, literalLength);
+        output += literalLength;
+
+        if (0 == matchLength) return output;
+
+        while (offset >= 0x80) {
+          *output++ = static_cast<BYTE>((offset & 0x7F) | 0x80);
+          offset >>= 7;
+        }
+        *output++ = static_cast<BYTE>(offset);
+
+        matchLength -= ZSLIB_EVENTING_BLOCK_CODEC_MIN_MATCH;
+        if (matchLength >= 15) {
+          *token |= 15;
+          output = writeLength(output, matchLength - 15);
+        } else {
+          *token |= static_cast<BYTE>(matchLength);
+        }
+
+        return output;
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark BlockCodec
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      size_t BlockCodec::getMaxCompressedSize(size_t inputSize)
+      {
+        return inputSize + (inputSize / 255) + 16;
+      }
+
+      //-----------------------------------------------------------------------
+      size_t BlockCodec::compress(
+                                  const BYTE *window,
+                                  size_t dictionarySize,
+                                  size_t windowSize,
+                                  BYTE *output
+                                  )
+      {
+        typedef std::vector<CryptoPP::word32> HashTable;
+
+        // positions are stored plus one so zero means the slot is empty
+        HashTable table(static_cast<size_t>(1) << ZSLIB_EVENTING_BLOCK_CODEC_HASH_BITS);
+
+        if (dictionarySize >= ZSLIB_EVENTING_BLOCK_CODEC_MIN_MATCH) {
+          for (size_t pos = 0; pos + ZSLIB_EVENTING_BLOCK_CODEC_MIN_MATCH <= dictionarySize; ++pos) {
+            table[hashPosition(&(window[pos]))] = static_cast<CryptoPP::word32>(pos + 1);
+          }
+        }
+
+        BYTE *outputStart = output;
+
+        size_t anchor = dictionarySize;
+        size_t pos = dictionarySize;
+
+        while (pos + ZSLIB_EVENTING_BLOCK_CODEC_MIN_MATCH <= windowSize) {
+          auto &slot = table[hashPosition(&(window[pos]))];
+          size_t candidate = static_cast<size_t>(slot);
+          slot = static_cast<CryptoPP::word32>(pos + 1);
+
+          if ((0 == candidate) ||
+              (read32(&(window[candidate - 1])) != read32(&(window[pos])))) {
+            // step faster through data that does not compress
+            pos += 1 + ((pos - anchor) >> ZSLIB_EVENTING_BLOCK_CODEC_SKIP_TRIGGER);
+            continue;
+          }
+
+          size_t match = candidate - 1;
+          size_t length = ZSLIB_EVENTING_BLOCK_CODEC_MIN_MATCH;
+          while ((pos + length < windowSize) &&
+                 (window[match + length] == window[pos + length])) {
+            ++length;
+          }
+
+          // a match must encode smaller than the literals it replaces
+          // (which also keeps the output within getMaxCompressedSize())
+          if (length < 2 + getOffsetSize(pos - match)) {
+            ++pos;
+            continue;
+          }
+
+          output = writeSequence(output, &(window[anchor]), pos - anchor, pos - match, length);
+
+          pos += length;
+          anchor = pos;
+
+          // keep the table current for data that repeats back to back
+          if (pos + 2 <= windowSize) {
+            table[hashPosition(&(window[pos - 2]))] = static_cast<CryptoPP::word32>(pos - 2 + 1);
+          }
+        }
+
+        output = writeSequence(output, &(window[anchor]), windowSize - anchor, 0, 0);
+
+        return static_cast<size_t>(output - outputStart);
+      }
+
+      //-----------------------------------------------------------------------
+      bool BlockCodec::decompress(
+                                  BYTE *window,
+                                  size_t dictionarySize,
+                                  const BYTE *input,
+                                  size_t inputSize,
+                                  size_t outputSize
+                                  )
+      {
+        const BYTE *inputEnd = input + inputSize;
+
+        BYTE *output = window + dictionarySize;
+        BYTE *outputEnd = output + outputSize;
+
+        while (input < inputEnd) {
+          BYTE token = *input++;
+
+          size_t literalLength = static_cast<size_t>(token >> 4);
+          if (15 == literalLength) {
+            if (!readLength(input, inputEnd, literalLength)) return false;
+          }
+
+          size_t inputAvailable = static_cast<size_t>(inputEnd - input);
+          size_t outputAvailable = static_cast<size_t>(outputEnd - output);
+          if ((inputAvailable < literalLength) ||
+              (outputAvailable < literalLength)) return false;
+
+          // short literal runs are copied as a fixed size block when there
+          // is room for the over-copy (which is overwritten afterwards)
+          if ((literalLength <= ZSLIB_EVENTING_BLOCK_CODEC_WILD_COPY_SIZE) &&
+              (inputAvailable >= ZSLIB_EVENTING_BLOCK_CODEC_WILD_COPY_SIZE) &&
+              (outputAvailable >= ZSLIB_EVENTING_BLOCK_CODEC_WILD_COPY_SIZE)) {
+            memcpy(output, input, ZSLIB_EVENTING_BLOCK_CODEC_WILD_COPY_SIZE);
+          } else {
+            memcpy(output, input, literalLength);
+          }
+          output += literalLength;
+          input += literalLength;
+
+          if (input == inputEnd) break;
+
+          size_t offset {};
+          size_t shift {};
+          BYTE value {};
+          do {
+            if ((input >= inputEnd) || (shift > 28)) return false;
+            value = *input++;
+            offset |= static_cast<size_t>(value & 0x7F) << shift;
+            shift += 7;
+          } while (0 != (value & 0x80));
+
+          size_t matchLength = static_cast<size_t>(token & 0x0F);
+          if (15 == matchLength) {
+            if (!readLength(input, inputEnd, matchLength)) return false;
+          }
+          matchLength += ZSLIB_EVENTING_BLOCK_CODEC_MIN_MATCH;
+
+          if ((0 == offset) ||
+              (offset > static_cast<size_t>(output - window)) ||
+              (static_cast<size_t>(outputEnd - output) < matchLength)) return false;
+
+          const BYTE *match = output - offset;
+          if ((offset >= sizeof(uint64_t)) &&
+              (static_cast<size_t>(outputEnd - output) >= matchLength + sizeof(uint64_t))) {
+            BYTE *matchEnd = output + matchLength;
+            do {
+              memcpy(output, match, sizeof(uint64_t));
+              output += sizeof(uint64_t);
+              match += sizeof(uint64_t);
+            } while (output < matchEnd);
+            output = matchEnd;
+          } else if (offset >= matchLength) {
+            memcpy(output, match, matchLength);
+            output += matchLength;
+          } else {
+            // overlapping match repeats the most recent bytes
+            for (size_t index = 0; index < matchLength; ++index) {
+              *output++ = *match++;
+            }
+          }
+        }
+
+        return output == outputEnd;
+      }
+
+      //-----------------------------------------------------------------------
+      SecureByteBlockPtr BlockCodec::trainDictionary(
+                                                     const BYTE *samples,
+                                                     size_t samplesSize,
+                                                     size_t maxDictionarySize
+                                                     )
+      {
+        typedef std::vector<CryptoPP::word32> CountTable;
+        typedef std::pair<uint64_t, size_t> ScoredSegment;
+        typedef std::vector<ScoredSegment> ScoredSegmentList;
+
+        const size_t segmentSize = ZSLIB_EVENTING_BLOCK_CODEC_DICTIONARY_SEGMENT_SIZE;
+        const size_t gramSize = ZSLIB_EVENTING_BLOCK_CODEC_DICTIONARY_GRAM_SIZE;
+        const size_t gramsPerSegment = segmentSize - gramSize + 1;
+
+        if ((!samples) ||
+            (maxDictionarySize < segmentSize) ||
+            (samplesSize < segmentSize * 2)) return SecureByteBlockPtr();
+
+        if (samplesSize <= maxDictionarySize) {
+          return make_shared<SecureByteBlock>(samples, samplesSize);
+        }
+
+        CountTable counts(static_cast<size_t>(1) << ZSLIB_EVENTING_BLOCK_CODEC_HASH_BITS);
+        for (size_t pos = 0; pos + gramSize <= samplesSize; ++pos) {
+          ++(counts[hashGram(&(samples[pos]))]);
+        }
+
+        // the sample is split into one epoch per dictionary segment and the
+        // segment with the most frequently repeating content is picked from
+        // each; grams already covered by a picked segment stop counting so
+        // later segments favour content the dictionary does not yet hold
+        size_t totalSegments = maxDictionarySize / segmentSize;
+        size_t epochSize = samplesSize / totalSegments;
+        if (epochSize < segmentSize) {
+          epochSize = segmentSize;
+          totalSegments = samplesSize / segmentSize;
+        }
+
+        ScoredSegmentList segments;
+        segments.reserve(totalSegments);
+
+        for (size_t epoch = 0; epoch < totalSegments; ++epoch) {
+          size_t epochStart = epoch * epochSize;
+          size_t epochEnd = std::min(epochStart + epochSize, samplesSize);
+          if (epochEnd - epochStart < segmentSize) break;
+
+          uint64_t score {};
+          for (size_t index = 0; index < gramsPerSegment; ++index) {
+            score += counts[hashGram(&(samples[epochStart + index]))];
+          }
+
+          uint64_t bestScore = score;
+          size_t bestStart = epochStart;
+
+          for (size_t start = epochStart + 1; start + segmentSize <= epochEnd; ++start) {
+            score -= counts[hashGram(&(samples[start - 1]))];
+            score += counts[hashGram(&(samples[start + gramsPerSegment - 1]))];
+            if (score <= bestScore) continue;
+
+            bestScore = score;
+            bestStart = start;
+          }
+
+          if (bestScore <= gramsPerSegment) continue;   // nothing repeats
+
+          segments.push_back(ScoredSegment(bestScore, bestStart));
+
+          for (size_t index = 0; index < gramsPerSegment; ++index) {
+            counts[hashGram(&(samples[bestStart + index]))] = 0;
+          }
+        }
+
+        if (segments.size() < 1) return SecureByteBlockPtr();
+
+        // the most valuable segments go last so they sit closest to the
+        // block data (and encode with the shortest offsets)
+        std::stable_sort(segments.begin(), segments.end(), [](const ScoredSegment &left, const ScoredSegment &right) -> bool {
+          return left.first < right.first;
+        });
+
+        auto result = make_shared<SecureByteBlock>(segments.size() * segmentSize);
+        BYTE *pos = result->BytePtr();
+        for (auto iter = segments.begin(); iter != segments.end(); ++iter, pos += segmentSize) {
+          memcpy(pos, &(samples[(*iter).second]), segmentSize);
+        }
+
+        ZS_LOG_DEBUG(slog("trained dictionary") + ZS_PARAM("samples", samplesSize) + ZS_PARAM("segments", segments.size()) + ZS_PARAM("size", result->SizeInBytes()));
+        return result;
+      }
+
+      //-----------------------------------------------------------------------
+      Log::Params BlockCodec::slog(const char *message)
+      {
+        return Log::Params(message, "eventing::BlockCodec");
+      }
+
+    } // namespace internal
+  } // namespace eventing
+} // namespace zsLib
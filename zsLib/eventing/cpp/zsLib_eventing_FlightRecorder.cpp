@@ -0,0 +1,1252 @@
+/*
+
+Copyright (c) 2016, Robin Raymond
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are those
+of the authors and should not be interpreted as representing official policies,
+either expressed or implied, of the FreeBSD Project.
+
+*/
+
+
+#include <zsLib/eventing/internal/zsLib_eventing_FlightRecorder.h>
+#include <zsLib/eventing/internal/zsLib_eventing_RemoteEventing.h>
+#include <zsLib/eventing/internal/zsLib_eventing_TraceEventCodec.h>
+
+#include <zsLib/eventing/ITraceFile.h>
+
+#include <zsLib/eventing/IHelper.h>
+#include <zsLib/eventing/Log.h>
+
+#include <zsLib/IMessageQueueManager.h>
+#include <zsLib/ISettings.h>
+#include <zsLib/Log.h>
+#include <zsLib/Singleton.h>
+
+#include <errno.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif //ndef _WIN32
+
+namespace zsLib { namespace eventing { ZS_DECLARE_SUBSYSTEM(zsLib_eventing); } }
+
+namespace zsLib
+{
+  namespace eventing
+  {
+    ZS_DECLARE_TYPEDEF_PTR(IHelper, UseEventingHelper);
+
+    namespace internal
+    {
+      ZS_DECLARE_CLASS_PTR(FlightRecorderSettingsDefaults);
+
+      //-------------------------------------------------------------------------
+      //-------------------------------------------------------------------------
+      //-------------------------------------------------------------------------
+      //-------------------------------------------------------------------------
+      #pragma mark
+      #pragma mark FlightRecorderSettingsDefaults
+      #pragma mark
+
+      class FlightRecorderSettingsDefaults : public ISettingsApplyDefaultsDelegate
+      {
+      public:
+        //-----------------------------------------------------------------------
+        ~FlightRecorderSettingsDefaults()
+        {
+          ISettings::removeDefaults(*this);
+        }
+
+        //-----------------------------------------------------------------------
+        static FlightRecorderSettingsDefaultsPtr singleton()
+        {
+          static SingletonLazySharedPtr<FlightRecorderSettingsDefaults> singleton(create());
+          return singleton.singleton();
+        }
+
+        //-----------------------------------------------------------------------
+        static FlightRecorderSettingsDefaultsPtr create()
+        {
+          auto pThis(make_shared<FlightRecorderSettingsDefaults>());
+          ISettings::installDefaults(pThis);
+          return pThis;
+        }
+
+        //-----------------------------------------------------------------------
+        virtual void notifySettingsApplyDefaults() override
+        {
+          ISettings::setUInt(ZSLIB_EVENTING_SETTING_FLIGHT_RECORDER_FILE_SIZE, (16*1024*1024));
+          ISettings::setUInt(ZSLIB_EVENTING_SETTING_FLIGHT_RECORDER_MAX_DATA_SIZE, (2*1024));
+          ISettings::setUInt(ZSLIB_EVENTING_SETTING_FLIGHT_RECORDER_TRIGGER_PRE_WINDOW, 30*1000);
+          ISettings::setUInt(ZSLIB_EVENTING_SETTING_FLIGHT_RECORDER_TRIGGER_POST_WINDOW, 5*1000);
+          ISettings::setString(ZSLIB_EVENTING_SETTING_FLIGHT_RECORDER_TRIGGER_SNAPSHOT_PATH_PREFIX, "");
+        }
+      };
+
+      //-------------------------------------------------------------------------
+      void installFlightRecorderSettingsDefaults()
+      {
+        FlightRecorderSettingsDefaults::singleton();
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark FlightRecorder
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      FlightRecorder::FlightRecorder(
+                                     const make_private &,
+                                     IMessageQueuePtr queue,
+                                     const char *fileName,
+                                     size_t fileSizeInBytes
+                                     ) :
+        MessageQueueAssociator(queue),
+        mFileName(fileName),
+        mMaxDataSize(static_cast<decltype(mMaxDataSize)>(ISettings::getUInt(ZSLIB_EVENTING_SETTING_FLIGHT_RECORDER_MAX_DATA_SIZE))),
+        mPreTriggerWindow(std::chrono::duration_cast<Microseconds>(Milliseconds(ISettings::getUInt(ZSLIB_EVENTING_SETTING_FLIGHT_RECORDER_TRIGGER_PRE_WINDOW)))),
+        mPostTriggerWindow(Milliseconds(ISettings::getUInt(ZSLIB_EVENTING_SETTING_FLIGHT_RECORDER_TRIGGER_POST_WINDOW))),
+        mSnapshotPathPrefix(ISettings::getString(ZSLIB_EVENTING_SETTING_FLIGHT_RECORDER_TRIGGER_SNAPSHOT_PATH_PREFIX))
+      {
+        if (mSnapshotPathPrefix.isEmpty()) {
+          mSnapshotPathPrefix = mFileName;
+        }
+
+        if (0 == fileSizeInBytes) {
+          fileSizeInBytes = static_cast<decltype(fileSizeInBytes)>(ISettings::getUInt(ZSLIB_EVENTING_SETTING_FLIGHT_RECORDER_FILE_SIZE));
+        }
+
+        mDataSize = (fileSizeInBytes > ZSLIB_EVENTING_FLIGHT_RECORDER_HEADER_SIZE ? fileSizeInBytes - ZSLIB_EVENTING_FLIGHT_RECORDER_HEADER_SIZE : 0);
+        if (mDataSize < ZSLIB_EVENTING_FLIGHT_RECORDER_MIN_DATA_SIZE) {
+          mDataSize = ZSLIB_EVENTING_FLIGHT_RECORDER_MIN_DATA_SIZE;
+        }
+
+        mCheckpointInterval = mDataSize / ZSLIB_EVENTING_FLIGHT_RECORDER_TOTAL_CHECKPOINTS;
+
+        // a single record must never overwrite more than a fraction of the
+        // distance between checkpoints
+        mMaxRecordSize = mCheckpointInterval / 2;
+
+        ZS_LOG_DETAIL(log("Created") + ZS_PARAM("file", mFileName) + ZS_PARAM("data size", mDataSize));
+      }
+
+      //-----------------------------------------------------------------------
+      FlightRecorder::~FlightRecorder()
+      {
+        mThisWeak.reset();
+        ZS_LOG_DETAIL(log("Destroyed"));
+        cancel();
+
+        for (auto iter = mCleanUpProviderInfos.begin(); iter != mCleanUpProviderInfos.end(); ++iter)
+        {
+          auto info = (*iter);
+          Log::EventingAtomDataArray providerArray;
+          if (Log::getEventingWriterInfo(info->mHandle, info->mProviderID, info->mProviderName, info->mProviderHash, &providerArray)) {
+            providerArray[mEventingAtomIndex] = 0;
+          }
+          delete info;
+        }
+        mCleanUpProviderInfos.clear();
+      }
+
+      //-----------------------------------------------------------------------
+      void FlightRecorder::init() throw (StdError)
+      {
+        mEventingAtomIndex = zsLib::Log::registerEventingAtom("org.zsLib.eventing.FlightRecorder");
+
+        {
+          AutoRecursiveLock lock(mLock);
+          openFile();
+        }
+
+        auto pThis = mThisWeak.lock();
+        Log::addEventingProviderListener(pThis);
+        Log::addEventingListener(pThis);
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark FlightRecorder => IFlightRecorder
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      FlightRecorderPtr FlightRecorder::create(
+                                               const char *fileName,
+                                               size_t fileSizeInBytes
+                                               ) throw (StdError)
+      {
+        auto queue = IMessageQueueManager::getMessageQueue("org.zsLib.eventing.FlightRecorder");
+        auto pThis = make_shared<FlightRecorder>(make_private{}, queue, fileName, fileSizeInBytes);
+        pThis->mThisWeak = pThis;
+        pThis->init();
+        return pThis;
+      }
+
+      //-----------------------------------------------------------------------
+      size_t FlightRecorder::convert(
+                                     const char *ringFileName,
+                                     const char *traceFileName
+                                     ) throw (StdError)
+      {
+        String pathStr(ringFileName);
+#ifdef _WIN32
+        pathStr.replaceAll("/", "\\");
+#endif //_WIN32
+
+        FILE *file {};
+#ifdef _WIN32
+        int error = fopen_s(&file, pathStr, "rb");
+#else
+        int error = 0;
+        file = fopen(pathStr, "rb");
+        if (!file) {
+          error = errno;
+        }
+#endif //_WIN32
+        if (NULL == file) {
+          ZS_THROW_CUSTOM_PROPERTIES_1(StdError, error, String("Failed to open flight recorder file: ") + pathStr);
+        }
+
+        BYTE header[ZSLIB_EVENTING_FLIGHT_RECORDER_HEADER_SIZE] {};
+        if (1 != fread(&(header[0]), sizeof(header), 1, file)) {
+          fclose(file);
+          ZS_THROW_CUSTOM_PROPERTIES_1(StdError, EINVAL, String("Flight recorder file is truncated: ") + pathStr);
+        }
+
+        if ((0 != memcmp(&(header[0]), ZSLIB_EVENTING_FLIGHT_RECORDER_MAGIC, strlen(ZSLIB_EVENTING_FLIGHT_RECORDER_MAGIC))) ||
+            (ZSLIB_EVENTING_FLIGHT_RECORDER_VERSION != IHelper::getBE32(&(header[4])))) {
+          fclose(file);
+          ZS_THROW_CUSTOM_PROPERTIES_1(StdError, EINVAL, String("Not a flight recorder file: ") + pathStr);
+        }
+
+        size_t headerSize = static_cast<size_t>(IHelper::getBE32(&(header[8])));
+        uint64_t dataSize = IHelper::getBE64(&(header[16]));
+        uint64_t totalWritten = IHelper::getBE64(&(header[24]));
+
+        if ((headerSize < ZSLIB_EVENTING_FLIGHT_RECORDER_HEADER_SIZE) ||
+            (dataSize < 1) ||
+            (static_cast<uint64_t>(static_cast<size_t>(dataSize)) != dataSize)) {
+          fclose(file);
+          ZS_THROW_CUSTOM_PROPERTIES_1(StdError, EINVAL, String("Flight recorder file header is not legal: ") + pathStr);
+        }
+
+        // only the ring data size bytes before the published total survive
+        // (an unused checkpoint slot is zero, i.e. the start of the stream)
+        uint64_t oldestPosition = (totalWritten > dataSize ? totalWritten - dataSize : 0);
+
+        std::set<uint64_t> checkpoints;
+        for (size_t index = 0; index < ZSLIB_EVENTING_FLIGHT_RECORDER_TOTAL_CHECKPOINTS; ++index) {
+          uint64_t position = IHelper::getBE64(&(header[32 + (sizeof(uint64_t) * index)]));
+          if ((position < oldestPosition) ||
+              (position > totalWritten)) continue;
+          checkpoints.insert(position);
+        }
+
+        if (checkpoints.size() < 1) {
+          fclose(file);
+          ZS_THROW_CUSTOM_PROPERTIES_1(StdError, EINVAL, String("No checkpoint survives in flight recorder file: ") + pathStr);
+        }
+
+        SecureByteBlock ring(static_cast<size_t>(dataSize));
+        if ((0 != fseek(file, static_cast<long>(headerSize), SEEK_SET)) ||
+            (1 != fread(ring.BytePtr(), ring.SizeInBytes(), 1, file))) {
+          fclose(file);
+          ZS_THROW_CUSTOM_PROPERTIES_1(StdError, EINVAL, String("Flight recorder file is truncated: ") + pathStr);
+        }
+        fclose(file);
+
+        uint64_t start = *(checkpoints.begin());
+        size_t size = static_cast<size_t>(totalWritten - start);
+
+        SecureByteBlock records(size);
+        readRing(ring.BytePtr(), ring.SizeInBytes(), start, records.BytePtr(), size);
+
+        // the oldest checkpoint keeps the most history but the oldest bytes
+        // may have been torn by a writer that terminated abnormally
+        size_t offset {};
+        size_t legalSize {};
+        for (auto iter = checkpoints.begin(); iter != checkpoints.end(); ++iter) {
+          offset = static_cast<size_t>((*iter) - start);
+          legalSize = getLegalRecordsSize(records.BytePtr() + offset, size - offset);
+          if (offset + legalSize == size) break;
+
+          ZS_LOG_WARNING(Detail, slog("flight recorder checkpoint is not legal (trying next checkpoint)") + ZS_PARAM("file", pathStr) + ZS_PARAM("checkpoint", *iter));
+        }
+
+        if (offset + legalSize != size) {
+          ZS_LOG_WARNING(Detail, slog("flight recorder record is not legal (truncating conversion)") + ZS_PARAM("file", pathStr) + ZS_PARAM("position", start + offset + legalSize));
+        }
+
+        auto writer = ITraceFileWriter::create(traceFileName);
+        writer->setClockOffset(Microseconds(static_cast<Microseconds::rep>(static_cast<int64_t>(IHelper::getBE64(&(header[72]))))));
+        writeRecords(writer, records.BytePtr() + offset, legalSize);
+        writer->close();
+
+        ZS_LOG_BASIC(slog("flight recorder file converted") + ZS_PARAM("file", pathStr) + ZS_PARAM("trace file", traceFileName) + ZS_PARAM("checkpoint", start + offset) + ZS_PARAM("records", writer->getTotalRecords()));
+        return writer->getTotalRecords();
+      }
+
+      //-----------------------------------------------------------------------
+      void FlightRecorder::shutdown()
+      {
+        ZS_LOG_DEBUG(log("shutdown called"));
+        cancel();
+      }
+
+      //-----------------------------------------------------------------------
+      void FlightRecorder::setProviderLogging(
+                                              const char *providerName,
+                                              KeywordBitmaskType keywords
+                                              )
+      {
+        String providerStr(providerName);
+
+        AutoRecursiveLock lock(mLock);
+        if (mShutdown) return;
+
+        if (0 == keywords) {
+          auto found = mRequestedProviderKeywords.find(providerStr);
+          if (found != mRequestedProviderKeywords.end()) mRequestedProviderKeywords.erase(found);
+        } else {
+          mRequestedProviderKeywords[providerStr] = keywords;
+        }
+
+        for (auto iter = mProviders.begin(); iter != mProviders.end(); ++iter) {
+          auto provider = (*iter).second;
+          if (provider->mProviderName != providerStr) continue;
+          updateRecordKeywords(provider);
+        }
+      }
+
+      //-----------------------------------------------------------------------
+      void FlightRecorder::setClockOffset(Microseconds offset)
+      {
+        AutoRecursiveLock lock(mLock);
+        mClockOffset = offset.count();
+
+        if (!mMapped) return;
+        IHelper::setBE64(&(mMapped[72]), static_cast<uint64_t>(static_cast<int64_t>(offset.count())));
+      }
+
+      //-----------------------------------------------------------------------
+      PUID FlightRecorder::addTrigger(const TriggerRule &rule)
+      {
+        AutoPUID triggerID;
+
+        AutoRecursiveLock lock(mLock);
+        mTriggers[triggerID] = rule;
+
+        ZS_LOG_DEBUG(log("trigger added") + ZS_PARAM("trigger id", triggerID) + ZS_PARAM("provider", rule.mProviderName));
+        return triggerID;
+      }
+
+      //-----------------------------------------------------------------------
+      void FlightRecorder::removeTrigger(PUID triggerID)
+      {
+        AutoRecursiveLock lock(mLock);
+
+        auto found = mTriggers.find(triggerID);
+        if (found == mTriggers.end()) return;
+
+        ZS_LOG_DEBUG(log("trigger removed") + ZS_PARAM("trigger id", triggerID));
+        mTriggers.erase(found);
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark FlightRecorder => ILogEventingProviderDelegate
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      void FlightRecorder::notifyNewSubsystem(zsLib::Subsystem &inSubsystem)
+      {
+        String subsystemStr(inSubsystem.getName());
+
+        AutoRecursiveLock lock(mLock);
+        if (mShutdown) return;
+
+        if (mSubsystems.end() != mSubsystems.find(subsystemStr)) return;
+        mSubsystems.insert(subsystemStr);
+
+        recordSubsystem(subsystemStr);
+      }
+
+      //-----------------------------------------------------------------------
+      void FlightRecorder::notifyEventingProviderRegistered(
+                                                            ProviderHandle handle,
+                                                            EventingAtomDataArray eventingAtomDataArray
+                                                            )
+      {
+        ProviderInfo *info = reinterpret_cast<ProviderInfo *>(eventingAtomDataArray[mEventingAtomIndex]);
+
+        bool constructed = false;
+
+        if (info) {
+          if (info->mRelatedToFlightRecorderObjectID != mID) {
+            // ignore provider infos related to other flight recorders running
+            return;
+          }
+        } else {
+          constructed = true;
+          info = new ProviderInfo;
+          info->mHandle = handle;
+          info->mRelatedToFlightRecorderObjectID = mID;
+          if (!Log::getEventingWriterInfo(handle, info->mProviderID, info->mProviderName, info->mProviderHash)) {
+            ZS_LOG_WARNING(Detail, log("told about provider that does not exist") + ZS_PARAM("provider handle", string(handle)));
+            delete info;
+            return;
+          }
+        }
+
+        AutoRecursiveLock lock(mLock);
+        if (constructed) {
+          eventingAtomDataArray[mEventingAtomIndex] = reinterpret_cast<uintptr_t>(info);
+          mCleanUpProviderInfos.insert(info);
+        }
+
+        if (mShutdown) return;
+
+        mProviders[info->mHandle] = info;
+        recordProvider(info);
+        updateRecordKeywords(info);
+      }
+
+      //-----------------------------------------------------------------------
+      void FlightRecorder::notifyEventingProviderUnregistered(
+                                                              ProviderHandle handle,
+                                                              EventingAtomDataArray eventingAtomDataArray
+                                                              )
+      {
+        ProviderInfo *info = reinterpret_cast<ProviderInfo *>(eventingAtomDataArray[mEventingAtomIndex]);
+        if (!info) return;
+
+        if (info->mRelatedToFlightRecorderObjectID != mID) {
+          // ignore provider infos related to other flight recorders running
+          return;
+        }
+
+        eventingAtomDataArray[mEventingAtomIndex] = static_cast<uintptr_t>(0);
+
+        AutoRecursiveLock lock(mLock);
+        info->mRecordKeywords = 0;
+
+        auto found = mProviders.find(info->mHandle);
+        if (found == mProviders.end()) return;
+
+        mProviders.erase(found);
+        recordProvider(info, false);
+      }
+
+      //-----------------------------------------------------------------------
+      void FlightRecorder::notifyEventingProviderLoggingStateChanged(
+                                                                     ProviderHandle handle,
+                                                                     EventingAtomDataArray eventingAtomDataArray,
+                                                                     KeywordBitmaskType keywords
+                                                                     )
+      {
+        ProviderInfo *info = reinterpret_cast<ProviderInfo *>(eventingAtomDataArray[mEventingAtomIndex]);
+        if (!info) return;
+
+        if (info->mRelatedToFlightRecorderObjectID != mID) {
+          // ignore provider infos related to other flight recorders running
+          return;
+        }
+
+        AutoRecursiveLock lock(mLock);
+        if (info->mBitmask == keywords) return;
+
+        info->mBitmask = keywords;
+        recordProviderLoggingState(info);
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark FlightRecorder => ILogEventingDelegate
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      void FlightRecorder::notifyWriteEvent(
+                                            ProviderHandle handle,
+                                            EventingAtomDataArray eventingAtomDataArray,
+                                            Severity severity,
+                                            Level level,
+                                            EVENT_DESCRIPTOR_HANDLE descriptor,
+                                            EVENT_PARAMETER_DESCRIPTOR_HANDLE parameterDescriptor,
+                                            EVENT_DATA_DESCRIPTOR_HANDLE dataDescriptor,
+                                            size_t dataDescriptorCount
+                                            )
+      {
+        ProviderInfo *info = reinterpret_cast<ProviderInfo *>(eventingAtomDataArray[mEventingAtomIndex]);
+        if (!info) return;
+
+        if (info->mRelatedToFlightRecorderObjectID != mID) {
+          // ignore provider infos related to other flight recorders running
+          return;
+        }
+
+        // provider logging may have been enabled by another listener
+        KeywordBitmaskType keywords = info->mRecordKeywords.load(std::memory_order_relaxed);
+        if (0 == keywords) return;
+        if ((0 != descriptor->Keyword) &&
+            (0 == (descriptor->Keyword & keywords))) return;
+
+        if (dataDescriptorCount > ZSLIB_EVENTING_TRACE_EVENT_CODEC_MAX_DATA_DESCRIPTORS) {
+          ++mTotalDroppedEvents;
+          ZS_LOG_WARNING(Debug, log("total descriptors exceed maximum") + ZS_PARAMIZE(dataDescriptorCount));
+          return;
+        }
+
+        size_t payloadSize = TraceEventCodec::getEncodedSize(dataDescriptor, dataDescriptorCount, mMaxDataSize);
+        if (payloadSize > mMaxRecordSize) {
+          ++mTotalDroppedEvents;
+          ZS_LOG_WARNING(Debug, log("event exceeds maximum record size") + ZS_PARAMIZE(payloadSize));
+          return;
+        }
+
+        AutoRecursiveLock lock(mLock);
+        if (!mRing) return;
+
+        TraceEventCodec::encode(mEncodeQueue, handle, severity, level, descriptor, parameterDescriptor, dataDescriptor, dataDescriptorCount, mMaxDataSize);
+
+        uint64_t recordPosition = mTotalWritten;
+        uint64_t recordTime = writeRecord(static_cast<CryptoPP::word32>(RemoteEventing::MessageType_TraceEvent), mEncodeQueue);
+
+        if (mSnapshotActive) return;
+        if (!isTriggered(info, severity, descriptor)) return;
+
+        startSnapshot(recordTime, recordPosition);
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark FlightRecorder => ITimerDelegate
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      void FlightRecorder::onTimer(ITimerPtr timer)
+      {
+        ZS_LOG_TRACE(log("on timer") + ZS_PARAM("timer id", timer->getID()));
+
+        AutoRecursiveLock lock(mLock);
+        if (timer != mSnapshotTimer) return;
+
+        finishSnapshot();
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark FlightRecorder => IFlightRecorderAsyncDelegate
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      void FlightRecorder::onFlightRecorderWriteSnapshot(
+                                                         SecureByteBlockPtr records,
+                                                         size_t triggerOffset,
+                                                         const char *fileName
+                                                         )
+      {
+        writeSnapshot(records, triggerOffset, String(fileName));
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark FlightRecorder => (internal)
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      Log::Params FlightRecorder::slog(const char *message)
+      {
+        return Log::Params(message, "eventing::FlightRecorder");
+      }
+
+      //-----------------------------------------------------------------------
+      Log::Params FlightRecorder::log(const char *message)
+      {
+        ElementPtr objectEl = Element::create("eventing::FlightRecorder");
+        objectEl->adoptAsLastChild(UseEventingHelper::createElementWithNumber("id", string(mID)));
+        return Log::Params(message, objectEl);
+      }
+
+      //-----------------------------------------------------------------------
+      void FlightRecorder::cancel()
+      {
+        ProviderInfoHandleMap providers;
+
+        {
+          AutoRecursiveLock lock(mLock);
+          if (mShutdown) return;
+          mShutdown = true;
+
+          providers = mProviders;
+          for (auto iter = providers.begin(); iter != providers.end(); ++iter) {
+            auto provider = (*iter).second;
+            provider->mRecordKeywords = 0;
+          }
+        }
+
+        auto pThis = mThisWeak.lock();
+        if (pThis) {
+          Log::removeEventingListener(pThis);
+          Log::removeEventingProviderListener(pThis);
+        }
+
+        for (auto iter = providers.begin(); iter != providers.end(); ++iter) {
+          auto provider = (*iter).second;
+          Log::setEventingLogging(provider->mHandle, mID, false);
+        }
+
+        AutoRecursiveLock lock(mLock);
+
+        // whatever portion of the post-trigger window was captured is still
+        // worth keeping
+        finishSnapshot();
+
+        mTriggers.clear();
+        mWindowSamples.clear();
+
+        mProviders.clear();
+        closeFile();
+      }
+
+      //-----------------------------------------------------------------------
+      void FlightRecorder::openFile() throw (StdError)
+      {
+        mMappedSize = ZSLIB_EVENTING_FLIGHT_RECORDER_HEADER_SIZE + mDataSize;
+
+        String pathStr(mFileName);
+
+#ifdef _WIN32
+        pathStr.replaceAll("/", "\\");
+
+        mFile = CreateFileA(pathStr, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (INVALID_HANDLE_VALUE == mFile) {
+          ZS_THROW_CUSTOM_PROPERTIES_1(StdError, static_cast<int>(GetLastError()), String("Failed to create flight recorder file: ") + pathStr);
+        }
+
+        ULARGE_INTEGER mappedSize {};
+        mappedSize.QuadPart = static_cast<decltype(mappedSize.QuadPart)>(mMappedSize);
+
+        mFileMapping = CreateFileMappingA(mFile, NULL, PAGE_READWRITE, mappedSize.HighPart, mappedSize.LowPart, NULL);
+        if (NULL == mFileMapping) {
+          auto error = static_cast<int>(GetLastError());
+          closeFile();
+          ZS_THROW_CUSTOM_PROPERTIES_1(StdError, error, String("Failed to map flight recorder file: ") + pathStr);
+        }
+
+        mMapped = reinterpret_cast<BYTE *>(MapViewOfFile(mFileMapping, FILE_MAP_ALL_ACCESS, 0, 0, mMappedSize));
+        if (NULL == mMapped) {
+          auto error = static_cast<int>(GetLastError());
+          closeFile();
+          ZS_THROW_CUSTOM_PROPERTIES_1(StdError, error, String("Failed to map flight recorder file: ") + pathStr);
+        }
+#else
+        mFile = ::open(pathStr, O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+        if (mFile < 0) {
+          ZS_THROW_CUSTOM_PROPERTIES_1(StdError, errno, String("Failed to create flight recorder file: ") + pathStr);
+        }
+
+        if (0 != ftruncate(mFile, static_cast<off_t>(mMappedSize))) {
+          auto error = errno;
+          closeFile();
+          ZS_THROW_CUSTOM_PROPERTIES_1(StdError, error, String("Failed to size flight recorder file: ") + pathStr + ", size=" + string(mMappedSize));
+        }
+
+        void *mapped = mmap(NULL, mMappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, mFile, 0);
+        if (MAP_FAILED == mapped) {
+          auto error = errno;
+          closeFile();
+          ZS_THROW_CUSTOM_PROPERTIES_1(StdError, error, String("Failed to map flight recorder file: ") + pathStr);
+        }
+        mMapped = reinterpret_cast<BYTE *>(mapped);
+#endif //_WIN32
+
+        memset(mMapped, 0, ZSLIB_EVENTING_FLIGHT_RECORDER_HEADER_SIZE);
+        memcpy(mMapped, ZSLIB_EVENTING_FLIGHT_RECORDER_MAGIC, strlen(ZSLIB_EVENTING_FLIGHT_RECORDER_MAGIC));
+        IHelper::setBE32(&(mMapped[4]), ZSLIB_EVENTING_FLIGHT_RECORDER_VERSION);
+        IHelper::setBE32(&(mMapped[8]), ZSLIB_EVENTING_FLIGHT_RECORDER_HEADER_SIZE);
+        IHelper::setBE64(&(mMapped[16]), static_cast<uint64_t>(mDataSize));
+        IHelper::setBE64(&(mMapped[64]), getCurrentTime());
+        IHelper::setBE64(&(mMapped[72]), static_cast<uint64_t>(static_cast<int64_t>(mClockOffset.load())));
+
+        mRing = &(mMapped[ZSLIB_EVENTING_FLIGHT_RECORDER_HEADER_SIZE]);
+        mTotalWritten = 0;
+
+        // the start of the stream acts as the first checkpoint
+        mLastCheckpoint = 0;
+        mNextCheckpointSlot = 1;
+      }
+
+      //-----------------------------------------------------------------------
+      void FlightRecorder::closeFile()
+      {
+        mRing = NULL;
+
+#ifdef _WIN32
+        if (mMapped) {
+          FlushViewOfFile(mMapped, 0);
+          UnmapViewOfFile(mMapped);
+          mMapped = NULL;
+        }
+        if (NULL != mFileMapping) {
+          CloseHandle(mFileMapping);
+          mFileMapping = NULL;
+        }
+        if (INVALID_HANDLE_VALUE != mFile) {
+          CloseHandle(mFile);
+          mFile = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (mMapped) {
+          msync(mMapped, mMappedSize, MS_SYNC);
+          munmap(mMapped, mMappedSize);
+          mMapped = NULL;
+        }
+        if (mFile >= 0) {
+          ::close(mFile);
+          mFile = -1;
+        }
+#endif //_WIN32
+      }
+
+      //-----------------------------------------------------------------------
+      uint64_t FlightRecorder::getCurrentTime()
+      {
+        return static_cast<uint64_t>(std::chrono::duration_cast<Microseconds>(zsLib::now().time_since_epoch()).count());
+      }
+
+      //-----------------------------------------------------------------------
+      void FlightRecorder::putRecordHeader(
+                                           BYTE *header,
+                                           size_t payloadSize,
+                                           CryptoPP::word32 recordType,
+                                           uint64_t recordTime
+                                           )
+      {
+        size_t recordSize = sizeof(CryptoPP::word32) + sizeof(uint64_t) + payloadSize;
+        IHelper::setBE32(&(header[0]), static_cast<CryptoPP::word32>(recordSize));
+        IHelper::setBE32(&(header[sizeof(CryptoPP::word32)]), recordType);
+        IHelper::setBE64(&(header[sizeof(CryptoPP::word32)*2]), recordTime);
+      }
+
+      //-----------------------------------------------------------------------
+      uint64_t FlightRecorder::writeRecord(
+                                           CryptoPP::word32 recordType,
+                                           ByteQueue &payload
+                                           )
+      {
+        uint64_t recordTime = getCurrentTime();
+
+        if (!mRing) {
+          payload.Clear();
+          return recordTime;
+        }
+
+        if ((!mInCheckpoint) &&
+            (mTotalWritten - mLastCheckpoint >= mCheckpointInterval)) {
+          writeCheckpoint();
+        }
+
+        BYTE header[(sizeof(CryptoPP::word32)*2) + sizeof(uint64_t)] {};
+        size_t payloadSize = static_cast<size_t>(payload.CurrentSize());
+
+        if (mSnapshotActive) {
+          // the snapshot must be frozen before the ring overwrites the start
+          // of the pre-trigger window
+          if (mTotalWritten + sizeof(header) + payloadSize - mSnapshotStart > mDataSize) {
+            ZS_LOG_WARNING(Debug, log("post-trigger window exceeds ring size (snapshot finished early)"));
+            finishSnapshot();
+          }
+        }
+
+        if ((mWindowSamples.size() < 1) ||
+            (recordTime - mWindowSamples.back().mTime >= ZSLIB_EVENTING_FLIGHT_RECORDER_WINDOW_SAMPLE_INTERVAL_IN_MICROSECONDS)) {
+          WindowSample sample;
+          sample.mTime = recordTime;
+          sample.mPosition = mTotalWritten;
+          mWindowSamples.push_back(sample);
+        }
+
+        putRecordHeader(&(header[0]), payloadSize, recordType, recordTime);
+
+        writeRing(&(header[0]), sizeof(header));
+        writeRing(payload);
+
+        // only publish the new total once the entire record is in place
+        IHelper::setBE64(&(mMapped[24]), mTotalWritten);
+
+        // forget samples that were overwritten or that are older than any
+        // future pre-trigger window could reach
+        uint64_t oldestPosition = (mTotalWritten > mDataSize ? mTotalWritten - mDataSize : 0);
+        uint64_t preWindow = static_cast<uint64_t>(mPreTriggerWindow.count());
+        uint64_t oldestTime = (recordTime > preWindow ? recordTime - preWindow : 0);
+        while (mWindowSamples.size() > 0) {
+          auto &front = mWindowSamples.front();
+          if ((front.mPosition >= oldestPosition) &&
+              (front.mTime >= oldestTime)) break;
+          mWindowSamples.pop_front();
+        }
+
+        return recordTime;
+      }
+
+      //-----------------------------------------------------------------------
+      void FlightRecorder::writeNotify(const ElementPtr &rootEl)
+      {
+        auto message = IHelper::toString(rootEl);
+
+        ByteQueue payload;
+        payload.Put(reinterpret_cast<const BYTE *>(message.c_str()), message.length());
+        writeRecord(static_cast<CryptoPP::word32>(RemoteEventing::MessageType_Notify), payload);
+      }
+
+      //-----------------------------------------------------------------------
+      void FlightRecorder::writeRing(
+                                     const BYTE *buffer,
+                                     size_t length
+                                     )
+      {
+        while (length > 0) {
+          size_t offset = static_cast<size_t>(mTotalWritten % mDataSize);
+          size_t available = mDataSize - offset;
+          size_t chunk = (length < available ? length : available);
+
+          memcpy(&(mRing[offset]), buffer, chunk);
+
+          buffer += chunk;
+          length -= chunk;
+          mTotalWritten += chunk;
+        }
+      }
+
+      //-----------------------------------------------------------------------
+      void FlightRecorder::writeRing(ByteQueue &queue)
+      {
+        while (queue.AnyRetrievable()) {
+          size_t offset = static_cast<size_t>(mTotalWritten % mDataSize);
+          size_t available = mDataSize - offset;
+
+          size_t chunk = static_cast<size_t>(queue.Get(&(mRing[offset]), available));
+          if (0 == chunk) break;
+
+          mTotalWritten += chunk;
+        }
+      }
+
+      //-----------------------------------------------------------------------
+      void FlightRecorder::readRing(
+                                    uint64_t position,
+                                    BYTE *buffer,
+                                    size_t length
+                                    )
+      {
+        readRing(mRing, mDataSize, position, buffer, length);
+      }
+
+      //-----------------------------------------------------------------------
+      void FlightRecorder::readRing(
+                                    const BYTE *ring,
+                                    size_t dataSize,
+                                    uint64_t position,
+                                    BYTE *buffer,
+                                    size_t length
+                                    )
+      {
+        while (length > 0) {
+          size_t offset = static_cast<size_t>(position % dataSize);
+          size_t available = dataSize - offset;
+          size_t chunk = (length < available ? length : available);
+
+          memcpy(buffer, &(ring[offset]), chunk);
+
+          buffer += chunk;
+          length -= chunk;
+          position += chunk;
+        }
+      }
+
+      //-----------------------------------------------------------------------
+      void FlightRecorder::writeCheckpoint()
+      {
+        mInCheckpoint = true;
+
+        mLastCheckpoint = mTotalWritten;
+        IHelper::setBE64(&(mMapped[32 + (sizeof(uint64_t) * mNextCheckpointSlot)]), mLastCheckpoint);
+        mNextCheckpointSlot = (mNextCheckpointSlot + 1) % ZSLIB_EVENTING_FLIGHT_RECORDER_TOTAL_CHECKPOINTS;
+
+        for (auto iter = mSubsystems.begin(); iter != mSubsystems.end(); ++iter) {
+          recordSubsystem(*iter);
+        }
+        for (auto iter = mProviders.begin(); iter != mProviders.end(); ++iter) {
+          recordProvider((*iter).second);
+        }
+
+        mInCheckpoint = false;
+      }
+
+      //-----------------------------------------------------------------------
+      ElementPtr FlightRecorder::createSubsystemNotify(const String &subsystemName)
+      {
+        ElementPtr rootEl = Element::create("notify");
+
+        rootEl->adoptAsLastChild(IHelper::createElementWithText("type", ZSLIB_EVENTING_REMOTE_EVENTING_NOTIFY_SUBSYSTEM));
+        rootEl->adoptAsLastChild(IHelper::createElementWithText("name", subsystemName));
+
+        return rootEl;
+      }
+
+      //-----------------------------------------------------------------------
+      ElementPtr FlightRecorder::createProviderNotify(
+                                                      ProviderInfo *provider,
+                                                      bool announceNew
+                                                      )
+      {
+        ElementPtr rootEl = Element::create("notify");
+
+        rootEl->adoptAsLastChild(IHelper::createElementWithText("type", ZSLIB_EVENTING_REMOTE_EVENTING_NOTIFY_PROVIDER));
+        rootEl->adoptAsLastChild(IHelper::createElementWithNumber("handle", string(static_cast<uint64_t>(provider->mHandle))));
+        if (announceNew) {
+          rootEl->adoptAsLastChild(IHelper::createElementWithText("id", string(provider->mProviderID)));
+          rootEl->adoptAsLastChild(IHelper::createElementWithText("name", provider->mProviderName));
+          rootEl->adoptAsLastChild(IHelper::createElementWithText("hash", provider->mProviderHash));
+        } else {
+          rootEl->adoptAsLastChild(IHelper::createElementWithNumber("gone", "true"));
+        }
+
+        return rootEl;
+      }
+
+      //-----------------------------------------------------------------------
+      ElementPtr FlightRecorder::createProviderLoggingStateNotify(ProviderInfo *provider)
+      {
+        ElementPtr rootEl = Element::create("notify");
+
+        rootEl->adoptAsLastChild(IHelper::createElementWithText("type", ZSLIB_EVENTING_REMOTE_EVENTING_NOTIFY_PROVIDER_KEYWORD_LOGGING));
+        rootEl->adoptAsLastChild(IHelper::createElementWithNumber("handle", string(static_cast<uint64_t>(provider->mHandle))));
+        rootEl->adoptAsLastChild(IHelper::createElementWithNumber("bitmask", string(provider->mBitmask)));
+
+        return rootEl;
+      }
+
+      //-----------------------------------------------------------------------
+      void FlightRecorder::appendNotify(
+                                        ByteQueue &outQueue,
+                                        uint64_t recordTime,
+                                        const ElementPtr &rootEl
+                                        )
+      {
+        auto message = IHelper::toString(rootEl);
+
+        BYTE header[(sizeof(CryptoPP::word32)*2) + sizeof(uint64_t)] {};
+        putRecordHeader(&(header[0]), message.length(), static_cast<CryptoPP::word32>(RemoteEventing::MessageType_Notify), recordTime);
+
+        outQueue.Put(&(header[0]), sizeof(header));
+        outQueue.Put(reinterpret_cast<const BYTE *>(message.c_str()), message.length());
+      }
+
+      //-----------------------------------------------------------------------
+      void FlightRecorder::recordSubsystem(const String &subsystemName)
+      {
+        writeNotify(createSubsystemNotify(subsystemName));
+      }
+
+      //-----------------------------------------------------------------------
+      void FlightRecorder::recordProvider(
+                                          ProviderInfo *provider,
+                                          bool announceNew
+                                          )
+      {
+        writeNotify(createProviderNotify(provider, announceNew));
+
+        if ((announceNew) &&
+            (0 != provider->mBitmask)) {
+          recordProviderLoggingState(provider);
+        }
+      }
+
+      //-----------------------------------------------------------------------
+      void FlightRecorder::recordProviderLoggingState(ProviderInfo *provider)
+      {
+        writeNotify(createProviderLoggingStateNotify(provider));
+      }
+
+      //-----------------------------------------------------------------------
+      void FlightRecorder::updateRecordKeywords(ProviderInfo *provider)
+      {
+        KeywordBitmaskType keywords {};
+
+        auto found = mRequestedProviderKeywords.find(provider->mProviderName);
+        if (found != mRequestedProviderKeywords.end()) {
+          keywords = (*found).second;
+        }
+
+        if (provider->mRecordKeywords == keywords) return;
+
+        provider->mRecordKeywords = keywords;
+        Log::setEventingLogging(provider->mHandle, mID, 0 != keywords, keywords);
+      }
+
+      //-----------------------------------------------------------------------
+      bool FlightRecorder::isTriggered(
+                                       ProviderInfo *provider,
+                                       Severity severity,
+                                       EVENT_DESCRIPTOR_HANDLE descriptor
+                                       ) const
+      {
+        for (auto iter = mTriggers.begin(); iter != mTriggers.end(); ++iter) {
+          auto &rule = (*iter).second;
+
+          if ((rule.mProviderName.hasData()) &&
+              (rule.mProviderName != provider->mProviderName)) continue;
+          if ((rule.mMinimumSeverity.hasValue()) &&
+              (severity < rule.mMinimumSeverity.value())) continue;
+          if ((rule.mEventID.hasValue()) &&
+              (static_cast<size_t>(descriptor->Id) != rule.mEventID.value())) continue;
+
+          return true;
+        }
+        return false;
+      }
+
+      //-----------------------------------------------------------------------
+      void FlightRecorder::startSnapshot(
+                                         uint64_t triggerTime,
+                                         uint64_t triggerPosition
+                                         )
+      {
+        mSnapshotActive = true;
+        mSnapshotTriggerTime = triggerTime;
+        mSnapshotTriggerPosition = triggerPosition;
+
+        // samples older than the pre-trigger window are already pruned so
+        // the oldest remaining sample is where the window starts
+        mSnapshotStart = triggerPosition;
+        if (mWindowSamples.size() > 0) {
+          auto &front = mWindowSamples.front();
+          if (front.mPosition < mSnapshotStart) mSnapshotStart = front.mPosition;
+        }
+
+        // the announcements are captured now so the snapshot describes the
+        // providers as they were when the incident happened
+        mSnapshotAnnouncements.Clear();
+        for (auto iter = mSubsystems.begin(); iter != mSubsystems.end(); ++iter) {
+          appendNotify(mSnapshotAnnouncements, triggerTime, createSubsystemNotify(*iter));
+        }
+        for (auto iter = mProviders.begin(); iter != mProviders.end(); ++iter) {
+          auto provider = (*iter).second;
+          appendNotify(mSnapshotAnnouncements, triggerTime, createProviderNotify(provider, true));
+          if (0 == provider->mBitmask) continue;
+          appendNotify(mSnapshotAnnouncements, triggerTime, createProviderLoggingStateNotify(provider));
+        }
+
+        ZS_LOG_DEBUG(log("snapshot triggered") + ZS_PARAM("trigger time", mSnapshotTriggerTime) + ZS_PARAM("pre-trigger bytes", mSnapshotTriggerPosition - mSnapshotStart));
+
+        if (Milliseconds() == mPostTriggerWindow) {
+          finishSnapshot();
+          return;
+        }
+
+        mSnapshotTimer = ITimer::create(mThisWeak.lock(), mPostTriggerWindow, false);
+      }
+
+      //-----------------------------------------------------------------------
+      void FlightRecorder::finishSnapshot()
+      {
+        if (!mSnapshotActive) return;
+        mSnapshotActive = false;
+
+        if (mSnapshotTimer) {
+          mSnapshotTimer->cancel();
+          mSnapshotTimer.reset();
+        }
+
+        if (!mRing) {
+          mSnapshotAnnouncements.Clear();
+          return;
+        }
+
+        size_t announcementSize = static_cast<size_t>(mSnapshotAnnouncements.CurrentSize());
+        size_t windowSize = static_cast<size_t>(mTotalWritten - mSnapshotStart);
+        size_t triggerOffset = announcementSize + static_cast<size_t>(mSnapshotTriggerPosition - mSnapshotStart);
+
+        SecureByteBlockPtr records(make_shared<SecureByteBlock>(announcementSize + windowSize));
+        BYTE *data = records->BytePtr();
+
+        mSnapshotAnnouncements.Get(data, announcementSize);
+        readRing(mSnapshotStart, &(data[announcementSize]), windowSize);
+
+        String fileName = mSnapshotPathPrefix + "-" + string(mSnapshotTriggerTime) + ".trace";
+
+        ZS_LOG_DEBUG(log("snapshot frozen") + ZS_PARAM("file", fileName) + ZS_PARAM("size", records->SizeInBytes()));
+
+        auto pThis = mThisWeak.lock();
+        if (!pThis) {
+          // shutting down from the destructor thus nobody is left to write
+          // the snapshot asynchronously
+          writeSnapshot(records, triggerOffset, fileName);
+          return;
+        }
+
+        // file I/O must never happen on the thread writing the event
+        IFlightRecorderAsyncDelegateProxy::create(pThis)->onFlightRecorderWriteSnapshot(records, triggerOffset, fileName);
+      }
+
+      //-----------------------------------------------------------------------
+      void FlightRecorder::writeSnapshot(
+                                         SecureByteBlockPtr records,
+                                         size_t triggerOffset,
+                                         const String &fileName
+                                         )
+      {
+        size_t legalSize = getLegalRecordsSize(records->BytePtr(), records->SizeInBytes());
+        if (legalSize != records->SizeInBytes()) {
+          ZS_LOG_WARNING(Detail, log("snapshot record is not legal (truncating snapshot)") + ZS_PARAM("offset", legalSize));
+        }
+
+        try {
+          auto writer = ITraceFileWriter::create(fileName);
+          writer->setClockOffset(Microseconds(mClockOffset.load()));
+          writeRecords(writer, records->BytePtr(), legalSize, triggerOffset);
+          writer->close();
+        } catch (const StdError &e) {
+          ZS_LOG_WARNING(Basic, log("failed to write snapshot") + ZS_PARAM("file", fileName) + ZS_PARAM("error", e.result()) + ZS_PARAM("reason", e.message()));
+          return;
+        }
+
+        ++mTotalSnapshots;
+        ZS_LOG_BASIC(log("snapshot written") + ZS_PARAM("file", fileName) + ZS_PARAM("size", records->SizeInBytes()));
+      }
+
+      //-----------------------------------------------------------------------
+      size_t FlightRecorder::getLegalRecordsSize(
+                                                 const BYTE *records,
+                                                 size_t size
+                                                 )
+      {
+        const size_t recordHeaderSize = (sizeof(CryptoPP::word32)*2) + sizeof(uint64_t);
+
+        size_t offset = 0;
+        while (offset + recordHeaderSize <= size) {
+          size_t recordSize = static_cast<size_t>(IHelper::getBE32(&(records[offset])));
+          if ((recordSize < recordHeaderSize - sizeof(CryptoPP::word32)) ||
+              (offset + sizeof(CryptoPP::word32) + recordSize > size)) break;
+
+          auto type = IHelper::getBE32(&(records[offset + sizeof(CryptoPP::word32)]));
+          if ((static_cast<CryptoPP::word32>(ITraceFileWriter::RecordType_Notify) != type) &&
+              (static_cast<CryptoPP::word32>(ITraceFileWriter::RecordType_TraceEvent) != type)) break;
+
+          offset += sizeof(CryptoPP::word32) + recordSize;
+        }
+        return offset;
+      }
+
+      //-----------------------------------------------------------------------
+      void FlightRecorder::writeRecords(
+                                        ITraceFileWriterPtr writer,
+                                        const BYTE *records,
+                                        size_t size,
+                                        const Optional<size_t> &triggerOffset
+                                        ) throw (StdError)
+      {
+        const size_t recordHeaderSize = (sizeof(CryptoPP::word32)*2) + sizeof(uint64_t);
+
+        size_t offset = 0;
+        while (offset + recordHeaderSize <= size) {
+          size_t recordSize = static_cast<size_t>(IHelper::getBE32(&(records[offset])));
+          auto type = static_cast<ITraceFileWriter::RecordTypes>(IHelper::getBE32(&(records[offset + sizeof(CryptoPP::word32)])));
+          uint64_t recordTime = IHelper::getBE64(&(records[offset + (sizeof(CryptoPP::word32)*2)]));
+          Time time(std::chrono::duration_cast<Time::duration>(Microseconds(static_cast<Microseconds::rep>(recordTime))));
+
+          if ((triggerOffset.hasValue()) &&
+              (offset == triggerOffset.value())) {
+            ElementPtr rootEl = Element::create("notify");
+            rootEl->adoptAsLastChild(IHelper::createElementWithText("type", ZSLIB_EVENTING_FLIGHT_RECORDER_NOTIFY_TRIGGER));
+
+            auto message = IHelper::toString(rootEl);
+            writer->writeRecord(ITraceFileWriter::RecordType_Notify, time, reinterpret_cast<const BYTE *>(message.c_str()), message.length());
+          }
+
+          writer->writeRecord(type, time, &(records[offset + recordHeaderSize]), recordSize + sizeof(CryptoPP::word32) - recordHeaderSize);
+
+          offset += sizeof(CryptoPP::word32) + recordSize;
+        }
+      }
+
+    } // namespace internal
+
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    #pragma mark
+    #pragma mark IFlightRecorder
+    #pragma mark
+
+    //-------------------------------------------------------------------------
+    IFlightRecorderPtr IFlightRecorder::create(
+                                               const char *fileName,
+                                               size_t fileSizeInBytes
+                                               ) throw (StdError)
+    {
+      ZS_THROW_INVALID_ARGUMENT_IF(!fileName);
+      return internal::FlightRecorder::create(fileName, fileSizeInBytes);
+    }
+
+    //-------------------------------------------------------------------------
+    size_t IFlightRecorder::convert(
+                                    const char *ringFileName,
+                                    const char *traceFileName
+                                    ) throw (StdError)
+    {
+      ZS_THROW_INVALID_ARGUMENT_IF(!ringFileName);
+      ZS_THROW_INVALID_ARGUMENT_IF(!traceFileName);
+      return internal::FlightRecorder::convert(ringFileName, traceFileName);
+    }
+
+  } // namespace eventing
+} // namespace zsLib
@@ -71,6 +71,8 @@ namespace zsLib
     namespace internal
     {
       void installRemoteEventingSettingsDefaults();
+      void installFlightRecorderSettingsDefaults();
+      void installTraceFileSettingsDefaults();
       
 
       //-----------------------------------------------------------------------
@@ -149,6 +151,8 @@ namespace zsLib
       zsLib::IHelper::setup();
       internal::CryptoPPHelper::singleton();
       internal::installRemoteEventingSettingsDefaults();
+      internal::installFlightRecorderSettingsDefaults();
+      internal::installTraceFileSettingsDefaults();
     }
 
 #ifdef WINRT
@@ -158,6 +162,8 @@ namespace zsLib
       zsLib::IHelper::setup(dispatcher);
       internal::CryptoPPHelper::singleton();
       internal::installRemoteEventingSettingsDefaults();
+      internal::installFlightRecorderSettingsDefaults();
+      internal::installTraceFileSettingsDefaults();
     }
 #endif //WINRT
 
@@ -623,6 +629,42 @@ namespace zsLib
       return output;
     }
 
+    //-------------------------------------------------------------------------
+    SecureByteBlockPtr IHelper::convertToSizePrefixedBuffer(
+                                                            const BYTE *buffer,
+                                                            size_t bufferLengthInBytes
+                                                            )
+    {
+      auto size = static_cast<uint32_t>(bufferLengthInBytes);
+
+      SecureByteBlockPtr output(make_shared<SecureByteBlock>(sizeof(size) + bufferLengthInBytes));
+      BYTE *dest = output->BytePtr();
+      for (size_t index = 0; index < sizeof(size); ++index) {
+        dest[index] = static_cast<BYTE>((size >> (index * 8)) & 0xFF);
+      }
+      if (bufferLengthInBytes > 0) {
+        memcpy(&(dest[sizeof(size)]), buffer, bufferLengthInBytes);
+      }
+      return output;
+    }
+
+    //-------------------------------------------------------------------------
+    const BYTE *IHelper::getSizePrefixedBuffer(
+                                               const BYTE *prefixedBuffer,
+                                               size_t &outBufferLengthInBytes
+                                               )
+    {
+      outBufferLengthInBytes = 0;
+      if (!prefixedBuffer) return NULL;
+
+      uint32_t size = 0;
+      for (size_t index = 0; index < sizeof(size); ++index) {
+        size = size | (static_cast<uint32_t>(prefixedBuffer[index]) << (index * 8));
+      }
+      outBufferLengthInBytes = static_cast<size_t>(size);
+      return &(prefixedBuffer[sizeof(size)]);
+    }
+
     //-------------------------------------------------------------------------
     String IHelper::getDebugString(
                                    const SecureByteBlock &buffer,
@@ -30,6 +30,7 @@ either expressed or implied, of the FreeBSD Project.
 */
 
 #include <zsLib/eventing/internal/zsLib_eventing_RemoteEventing.h>
+#include <zsLib/eventing/internal/zsLib_eventing_TraceEventCodec.h>
 
 #include <zsLib/eventing/IHelper.h>
 #include <zsLib/eventing/IHasher.h>
@@ -45,16 +46,11 @@ either expressed or implied, of the FreeBSD Project.
 namespace zsLib { namespace eventing { ZS_DECLARE_SUBSYSTEM(zsLib_eventing); } }
 
 
-#define ZSLIB_EVENTING_REMOTE_EVENTING_MAX_DATA_DESCRIPTORS (80)
-
-#define ZSLIB_EVENTING_REMOTE_EVENTING_NOTIFY_SUBSYSTEM "subsystem"
-#define ZSLIB_EVENTING_REMOTE_EVENTING_NOTIFY_PROVIDER "provider"
-#define ZSLIB_EVENTING_REMOTE_EVENTING_NOTIFY_PROVIDER_KEYWORD_LOGGING "providerKeywordLogging"
-#define ZSLIB_EVENTING_REMOTE_EVENTING_NOTIFY_GENERAL_INFO "info"
-
 #define ZSLIB_EVENTING_REMOTE_EVENTING_REQUEST_SET_SUBSYSTEM_LEVEL "setSubsystemLevel"
 #define ZSLIB_EVENTING_REMOTE_EVENTING_REQUEST_SET_EVENT_PROVIDER_LOGGING "setEventProviderLogging"
 
+#define ZSLIB_EVENTING_REMOTE_EVENTING_REPLAY_RECORDS_PER_STEP (1000)
+
 namespace zsLib
 {
   namespace eventing
@@ -107,6 +103,7 @@ namespace zsLib
           ISettings::setUInt(ZSLIB_EVENTING_SETTING_REMOTE_EVENTING_MAX_QUEUED_OUTGOING_DATA_BEFORED_EVENTS_DROPPED, (100*1024));
           ISettings::setUInt(ZSLIB_EVENTING_SETTING_REMOTE_EVENTING_NOTIFY_TIMER, 5);
           ISettings::setBool(ZSLIB_EVENTING_SETTING_REMOTE_EVENTING_USE_IPV6, false);
+          ISettings::setBool(ZSLIB_EVENTING_SETTING_REMOTE_EVENTING_NOTIFY_EVENT_COUNTERS, true);
         }
       };
 
@@ -116,6 +113,102 @@ namespace zsLib
         RemoteEventingSettingsDefaults::singleton();
       }
       
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark IRemoteEventingInternalTypes::ProviderInfo
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      static IRemoteEventingInternalTypes::EventCounterTable *getEventCounterTable(
+                                                                                  std::atomic<IRemoteEventingInternalTypes::EventCounterTable *> &ioTable,
+                                                                                  size_t totalSlots
+                                                                                  )
+      {
+        auto table = ioTable.load(std::memory_order_acquire);
+        if (table) return table;
+
+        // another thread may create the table at the same time
+        auto created = new IRemoteEventingInternalTypes::EventCounterTable(totalSlots);
+        if (ioTable.compare_exchange_strong(table, created, std::memory_order_acq_rel)) return created;
+
+        delete created;
+        return table;
+      }
+
+      //-----------------------------------------------------------------------
+      IRemoteEventingInternalTypes::EventCounterSlot &IRemoteEventingInternalTypes::ProviderInfo::getEventCounter(uint32_t eventID)
+      {
+        auto table = getEventCounterTable(mEventCounters, ZSLIB_EVENTING_REMOTE_EVENTING_EVENT_COUNTER_INITIAL_SLOTS);
+
+        // slots are never released so once a table is found full it stays
+        // full and every thread moves on to the same next table
+        while (true) {
+          size_t start = static_cast<size_t>(eventID) % table->mTotalSlots;
+
+          for (size_t loop = 0; loop < table->mTotalSlots; ++loop) {
+            auto &slot = table->mSlots[(start + loop) % table->mTotalSlots];
+
+            uint32_t existingID = slot.mEventID.load(std::memory_order_acquire);
+            if (existingID == eventID) return slot;
+            if (ZSLIB_EVENTING_REMOTE_EVENTING_EVENT_COUNTER_UNUSED != existingID) continue;
+
+            uint32_t unused = ZSLIB_EVENTING_REMOTE_EVENTING_EVENT_COUNTER_UNUSED;
+            if (slot.mEventID.compare_exchange_strong(unused, eventID, std::memory_order_acq_rel)) return slot;
+
+            // another thread claimed the slot first (possibly for the same event ID)
+            if (unused == eventID) return slot;
+          }
+
+          table = getEventCounterTable(table->mNext, table->mTotalSlots * 2);
+        }
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark WritingRemoteScope
+      #pragma mark
+
+      // marks the calling thread as writing a remote's received event (and
+      // the time of the event in the local clock) for the lifetime of the
+      // scope
+      class WritingRemoteScope
+      {
+      public:
+        WritingRemoteScope(
+                           PUID remoteID,
+                           Time eventTime
+                           ) :
+          mPreviousID(sWritingRemoteID),
+          mPreviousTime(sWritingEventTime)
+        {
+          sWritingRemoteID = remoteID;
+          sWritingEventTime = eventTime;
+        }
+        ~WritingRemoteScope()
+        {
+          sWritingRemoteID = mPreviousID;
+          sWritingEventTime = mPreviousTime;
+        }
+
+        static PUID getWritingRemoteID() { return sWritingRemoteID; }
+        static Time getWritingEventTime() { return sWritingEventTime; }
+
+      protected:
+        static thread_local PUID sWritingRemoteID;
+        static thread_local Time sWritingEventTime;
+        PUID mPreviousID {};
+        Time mPreviousTime {};
+      };
+
+      thread_local PUID WritingRemoteScope::sWritingRemoteID {};
+      thread_local Time WritingRemoteScope::sWritingEventTime {};
+
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
@@ -138,6 +231,7 @@ namespace zsLib
           case MessageType_Request:         return "Request";
           case MessageType_RequestAck:      return "Request ack";
           case MessageType_TraceEvent:      return "Trace event";
+          case MessageType_TimedTraceEvent: return "Timed trace event";
         }
         
         return "unknown";
@@ -181,6 +275,7 @@ namespace zsLib
         mMaxQueuedAsyncDataBeforeEventsDropped(static_cast<decltype(mMaxQueuedAsyncDataBeforeEventsDropped)>(ISettings::getUInt(ZSLIB_EVENTING_SETTING_REMOTE_EVENTING_MAX_QUEUED_ASYNC_DATA_BEFORED_EVENTS_DROPPED))),
         mMaxQueuedOutgoingDataBeforeEventsDropped(static_cast<decltype(mMaxQueuedOutgoingDataBeforeEventsDropped)>(ISettings::getUInt(ZSLIB_EVENTING_SETTING_REMOTE_EVENTING_MAX_QUEUED_OUTGOING_DATA_BEFORED_EVENTS_DROPPED))),
         mUseIPv6(ISettings::getBool(ZSLIB_EVENTING_SETTING_REMOTE_EVENTING_USE_IPV6)),
+        mNotifyEventCounters(ISettings::getBool(ZSLIB_EVENTING_SETTING_REMOTE_EVENTING_NOTIFY_EVENT_COUNTERS)),
         mServerIP(serverIP),
         mListenPort(listenPort),
         mSharedSecret(connectionSharedSecret),
@@ -202,6 +297,10 @@ namespace zsLib
           Log::EventingAtomDataArray providerArray;
           if (Log::getEventingWriterInfo(info->mHandle, info->mProviderID, info->mProviderName, info->mProviderHash, &providerArray)) {
             providerArray[mEventingAtomIndex] = 0;
+            if ((info->mSchema) &&
+                (reinterpret_cast<Log::EventingAtomData>(info->mSchema->BytePtr()) == providerArray[mSchemaAtomIndex])) {
+              providerArray[mSchemaAtomIndex] = 0;
+            }
           }
           delete info;
         }
@@ -212,6 +311,7 @@ namespace zsLib
       void RemoteEventing::init()
       {
         mEventingAtomIndex = zsLib::Log::registerEventingAtom("org.zsLib.eventing.RemoteEventing");
+        mSchemaAtomIndex = zsLib::Log::registerEventingAtom(ZS_EVENTING_PROVIDER_SCHEMA_ATOM_NAME);
         IWakeDelegateProxy::create(mThisWeak.lock())->onWake();
       }
 
@@ -227,10 +327,11 @@ namespace zsLib
       RemoteEventingPtr RemoteEventing::connectToRemote(
                                                         IRemoteEventingDelegatePtr connectionDelegate,
                                                         const IPAddress &serverIP,
-                                                        const char *connectionSharedSecret
+                                                        const char *connectionSharedSecret,
+                                                        IMessageQueuePtr queue
                                                         )
       {
-        auto queue = IMessageQueueManager::getMessageQueue("org.zsLib.eventing.RemoteEventing");
+        if (!queue) queue = IMessageQueueManager::getMessageQueue("org.zsLib.eventing.RemoteEventing");
         auto pThis = make_shared<RemoteEventing>(make_private{}, queue, connectionDelegate, connectionSharedSecret, serverIP, static_cast<WORD>(0), Seconds());
         pThis->mThisWeak = pThis;
         pThis->init();
@@ -251,7 +352,25 @@ namespace zsLib
         pThis->init();
         return pThis;
       }
-      
+
+      //-----------------------------------------------------------------------
+      RemoteEventingPtr RemoteEventing::replayFromFile(
+                                                       IRemoteEventingDelegatePtr connectionDelegate,
+                                                       const char *fileName,
+                                                       double speed
+                                                       ) throw (StdError)
+      {
+        auto reader = ITraceFileReader::open(fileName);
+
+        auto queue = IMessageQueueManager::getMessageQueue("org.zsLib.eventing.RemoteEventing");
+        auto pThis = make_shared<RemoteEventing>(make_private{}, queue, connectionDelegate, "", IPAddress(), static_cast<WORD>(0), Seconds());
+        pThis->mThisWeak = pThis;
+        pThis->mReplayReader = reader;
+        pThis->mReplaySpeed = (speed > 0.0 ? speed : 0.0);
+        pThis->init();
+        return pThis;
+      }
+
       //-----------------------------------------------------------------------
       void RemoteEventing::shutdown()
       {
@@ -267,6 +386,37 @@ namespace zsLib
         AutoRecursiveLock lock(mLock);
         return mState;
       }
+
+      //-----------------------------------------------------------------------
+      IRemoteEventing::Statistics RemoteEventing::getStatistics() const
+      {
+        Statistics result;
+
+        result.mEventsSent = mStatEventsSent.load(std::memory_order_relaxed);
+        result.mEventsReceived = mStatEventsReceived.load(std::memory_order_relaxed);
+        result.mEventsDropped = mTotalDroppedEvents.load(std::memory_order_relaxed);
+        result.mBytesSent = mStatBytesSent.load(std::memory_order_relaxed);
+        result.mBytesReceived = mStatBytesReceived.load(std::memory_order_relaxed);
+        result.mFramesSent = mStatFramesSent.load(std::memory_order_relaxed);
+        result.mFramesReceived = mStatFramesReceived.load(std::memory_order_relaxed);
+        result.mSendCalls = mStatSendCalls.load(std::memory_order_relaxed);
+        result.mReceiveCalls = mStatReceiveCalls.load(std::memory_order_relaxed);
+        result.mAsyncQueueHighWaterMark = mStatAsyncQueueHighWaterMark.load(std::memory_order_relaxed);
+        result.mOutgoingQueueHighWaterMark = mStatOutgoingQueueHighWaterMark.load(std::memory_order_relaxed);
+        result.mWriteBlockedTime = Microseconds(mStatWriteBlockedTime.load(std::memory_order_relaxed));
+        result.mEventsEncoded = mStatEventsEncoded.load(std::memory_order_relaxed);
+        result.mEncodeTime = Nanoseconds(mStatEncodeTime.load(std::memory_order_relaxed));
+        result.mHandshakeDuration = Milliseconds(mStatHandshakeDuration.load(std::memory_order_relaxed));
+
+        auto roundTrip = mStatRemoteClockRoundTrip.load(std::memory_order_relaxed);
+        if (roundTrip >= 0) {
+          result.mHasRemoteClockOffset = true;
+          result.mRemoteClockOffset = Microseconds(mStatRemoteClockOffset.load(std::memory_order_relaxed));
+          result.mRemoteClockRoundTrip = Microseconds(roundTrip);
+        }
+
+        return result;
+      }
       
       //-----------------------------------------------------------------------
       void RemoteEventing::setRemoteLevel(
@@ -286,6 +436,26 @@ namespace zsLib
 
         requestSetRemoteSubsystemLevel(info);
       }
+
+      //-----------------------------------------------------------------------
+      void RemoteEventing::recordTo(ITraceFileWriterPtr writer)
+      {
+        ZS_LOG_DEBUG(log("record to") + ZS_PARAM("writer", writer ? writer->getID() : 0));
+
+        AutoRecursiveLock lock(mLock);
+        mRecordWriter = writer;
+        if (!mRecordWriter) return;
+
+        // a replay is recorded with the times (and clock) of the file
+        // replayed; otherwise the estimate is applied once it is known
+        if (isReplayMode()) {
+          mRecordWriter->setClockOffset(mReplayReader->getClockOffset());
+          return;
+        }
+        if (mStatRemoteClockRoundTrip.load(std::memory_order_relaxed) >= 0) {
+          mRecordWriter->setClockOffset(-getRemoteClockOffset());
+        }
+      }
       
 
       //-----------------------------------------------------------------------
@@ -332,6 +502,12 @@ namespace zsLib
             return;
           }
         }
+        if (timer == mReplayTimer) {
+          ZS_LOG_TRACE(log("replay timer"));
+          mReplayTimer.reset();
+          step();
+          return;
+        }
       }
       
       //-----------------------------------------------------------------------
@@ -379,6 +555,8 @@ namespace zsLib
             BYTE buffer[4096];
 
             auto read = activeSocket->receive(&(buffer[0]), sizeof(buffer));
+            mStatReceiveCalls.fetch_add(1, std::memory_order_relaxed);
+            mStatBytesReceived.fetch_add(static_cast<size_t>(read), std::memory_order_relaxed);
             mIncomingQueue.Put(&(buffer[0]), read);
           } catch (const Socket::Exceptions::Unspecified &) {
             ZS_LOG_WARNING(Debug, log("could not read active socket"));
@@ -407,6 +585,12 @@ namespace zsLib
 
         auto activeSocket = getActiveSocket();
         if (socket == activeSocket) {
+          if ((!mWriteReady) &&
+              (SteadyTime() != mWriteBlockedStart)) {
+            auto blocked = std::chrono::duration_cast<Microseconds>(std::chrono::steady_clock::now() - mWriteBlockedStart);
+            mStatWriteBlockedTime.fetch_add(blocked.count(), std::memory_order_relaxed);
+            mWriteBlockedStart = SteadyTime();
+          }
           mWriteReady = true;
           sendOutgoingData();
           return;
@@ -605,8 +789,24 @@ namespace zsLib
           // ignore re-entrant self registered provider infos
           return;
         }
-        if (dataDescriptorCount > ZSLIB_EVENTING_REMOTE_EVENTING_MAX_DATA_DESCRIPTORS) {
+
+        // a generated provider attaches its schema right after registering
+        // so the schema may not have been available when it was announced;
+        // the schema is queued ahead of the provider's first event
+        if ((!info->mSchemaAnnounced.load(std::memory_order_relaxed)) &&
+            (0 != eventingAtomDataArray[mSchemaAtomIndex])) {
+          if (!info->mSchemaAnnounced.exchange(true)) {
+            AutoRecursiveLock lock(mAsyncSelfLock);
+            if (mAsyncSelf) mAsyncSelf->onRemoteEventingProviderSchema(info);
+          }
+        }
+
+        auto &counter = info->getEventCounter(descriptor->Id);
+        ++(counter.mTotalEvents);
+
+        if (dataDescriptorCount > ZSLIB_EVENTING_TRACE_EVENT_CODEC_MAX_DATA_DESCRIPTORS) {
           ++mTotalDroppedEvents;
+          ++(counter.mTotalDropped);
           ZS_LOG_WARNING(Debug, log("total descriptors exceed maximum") + ZS_PARAMIZE(dataDescriptorCount));
           return;
         }
@@ -615,120 +815,43 @@ namespace zsLib
 
         ByteQueue &usePacked = *packed;
 
-        size_t packedSize = (sizeof(CryptoPP::word16)*5) +
-                            (sizeof(uint8_t)*4) +
-                            (sizeof(uint64_t)*2) +
-                            (sizeof(CryptoPP::word16)*dataDescriptorCount) +
-                            (sizeof(CryptoPP::word32)*(1+dataDescriptorCount));
+        // the write time lets a monitor merging several remotes order their
+        // events on one clock (see IRemoteEventing::getWritingEventTime)
+        bool timed = mSendEventTimes.load(std::memory_order_relaxed);
 
-        for (size_t index = 0; index < dataDescriptorCount; ++index) {
-          auto &data = dataDescriptor[index];
-          
-          CryptoPP::word32 dataSize = static_cast<CryptoPP::word32>(data.Size);
-          if (dataSize > mMaxDataSize) {
-            dataSize = static_cast<decltype(dataSize)>(mMaxDataSize);
-          }
-          if (data.Ptr) {
-            packedSize += dataSize;
-          }
-        }
+        // message size does not include itself but does include the message type
+        size_t packedSize = sizeof(CryptoPP::word32) + (timed ? sizeof(uint64_t) : 0) + TraceEventCodec::getEncodedSize(dataDescriptor, dataDescriptorCount, mMaxDataSize);
 
         if (packedSize > mMaxPackedSize) {
           ++mTotalDroppedEvents;
+          ++(counter.mTotalDropped);
           ZS_LOG_WARNING(Debug, log("packed size exceeds maximum size") + ZS_PARAMIZE(packedSize));
           return;
         }
 
+        // only a sample of the encodes are timed to keep the clock off the
+        // hot path; the sampled time is scaled to stand in for the others
+        bool timeEncode = (0 == (mStatEventsEncoded.fetch_add(1, std::memory_order_relaxed) % ZSLIB_EVENTING_REMOTE_EVENTING_ENCODE_TIME_SAMPLE_RATE));
+        SteadyTime encodeStart {};
+        if (timeEncode) encodeStart = std::chrono::steady_clock::now();
+
         size_t putSize = packedSize + (sizeof(CryptoPP::word32)); // message size not included in packedSize
         usePacked.CreatePutSpace(putSize);
         
         usePacked.PutWord32(static_cast<CryptoPP::word32>(packedSize));
-        usePacked.PutWord32(static_cast<CryptoPP::word32>(MessageType_TraceEvent));
-
-        uint64_t data64 {};
-        uint64_t eventingHandle {static_cast<uint64_t>(handle)};
+        usePacked.PutWord32(static_cast<CryptoPP::word32>(timed ? MessageType_TimedTraceEvent : MessageType_TraceEvent));
 
-        IHelper::setBE64(&data64, eventingHandle);
-        usePacked.Put((const BYTE *)(&data64), sizeof(data64));
-
-        usePacked.PutWord16(static_cast<CryptoPP::word16>(severity));
-        usePacked.PutWord16(static_cast<CryptoPP::word16>(level));
-        usePacked.PutWord16(descriptor->Id);
-        usePacked.Put(descriptor->Version);
-        usePacked.Put(descriptor->Channel);
-        usePacked.Put(descriptor->Level);
-        usePacked.Put(descriptor->Opcode);
-        usePacked.PutWord16(descriptor->Task);
-
-        IHelper::setBE64(&data64, descriptor->Keyword);
-        usePacked.Put((const BYTE *)(&data64), sizeof(data64));
-
-        usePacked.PutWord16(static_cast<CryptoPP::word16>(dataDescriptorCount));
-
-        for (size_t index = 0; index < dataDescriptorCount; ++index) {
-          auto &param = parameterDescriptor[index];
-          usePacked.PutWord16(static_cast<uint16_t>(param.Type));
+        if (timed) {
+          uint64_t time64 {};
+          IHelper::setBE64(&time64, static_cast<uint64_t>(getCurrentTime()));
+          usePacked.Put((const BYTE *)(&time64), sizeof(time64));
         }
 
-        for (size_t index = 0; index < dataDescriptorCount; ++index) {
-          auto &data = dataDescriptor[index];
-          
-          uint32_t dataSize = static_cast<uint32_t>(data.Size);
-          if (dataSize > mMaxDataSize) {
-            dataSize = static_cast<decltype(dataSize)>(mMaxDataSize);
-          }
-          
-          if (data.Ptr) {
-            bool endianFlip {true};
-
-            switch (parameterDescriptor[index].Type) {
-              case EventParameterType_Boolean:
-              case EventParameterType_UnsignedInteger:
-              case EventParameterType_SignedInteger:
-              case EventParameterType_Pointer:
-              case EventParameterType_FloatingPoint:  {
-                dataSize |= (1 << 31);
-                break;
-              }
-              default:                                {
-                endianFlip = false;
-                break;
-              }
-            }
-
-            usePacked.PutWord32(dataSize);
+        TraceEventCodec::encode(usePacked, handle, severity, level, descriptor, parameterDescriptor, dataDescriptor, dataDescriptorCount, mMaxDataSize);
 
-            if (endianFlip) {
-              switch (data.Size) {
-                case 2:  {
-                  uint16_t value {};
-                  memcpy(&value, (const void *)(data.Ptr), sizeof(value));
-                  usePacked.PutWord16(value);
-                  break;
-                }
-                case 4:  {
-                  uint32_t value {};
-                  memcpy(&value, (const void *)(data.Ptr), sizeof(value));
-                  usePacked.PutWord32(value);
-                  break;
-                }
-                case 8:  {
-                  memcpy(&data64, (const void *)(data.Ptr), sizeof(data64));
-                  IHelper::setBE64(&data64, data64);
-                  usePacked.Put((const BYTE *)(&data64), sizeof(data64));
-                  break;
-                }
-                default: {
-                  // just put in raw format
-                  usePacked.Put((const BYTE *)(data.Ptr), data.Size);
-                }
-              }
-            } else {
-              usePacked.Put((const BYTE *)(data.Ptr), data.Size);
-            }
-          } else {
-            usePacked.PutWord32(static_cast<CryptoPP::word32>(0));
-          }
+        if (timeEncode) {
+          auto encodeTime = std::chrono::duration_cast<Nanoseconds>(std::chrono::steady_clock::now() - encodeStart);
+          mStatEncodeTime.fetch_add(encodeTime.count() * ZSLIB_EVENTING_REMOTE_EVENTING_ENCODE_TIME_SAMPLE_RATE, std::memory_order_relaxed);
         }
 
         {
@@ -736,6 +859,7 @@ namespace zsLib
           if (!mAsyncSelf) return;
           if (mOutstandingEvents > mMaxOutstandingEvents) {
             ++mTotalDroppedEvents;
+            ++(counter.mTotalDropped);
             ZS_LOG_WARNING(Insane, log("too many outstanding events (event dropped)") + ZS_PARAM("events", mOutstandingEvents));
             return;
           }
@@ -744,13 +868,17 @@ namespace zsLib
 
           if (mEventDataInAsyncQueue + currentSize > mMaxQueuedAsyncDataBeforeEventsDropped) {
             ++mTotalDroppedEvents;
+            ++(counter.mTotalDropped);
             ZS_LOG_WARNING(Insane, log("too many outstanding events (event dropped)") + ZS_PARAM("in queue", mEventDataInAsyncQueue) + ZS_PARAM("size", currentSize));
             return;
           }
 
+          // only events that are queued count towards the bytes
+          counter.mTotalBytes += packedSize;
+
           ++mOutstandingEvents;
-          mEventDataInAsyncQueue += currentSize;
-          mAsyncSelf->onRemoteEventingWriteEvent(packed, currentSize);
+          updateHighWaterMark(mStatAsyncQueueHighWaterMark, mEventDataInAsyncQueue += currentSize);
+          mAsyncSelf->onRemoteEventingWriteEvent(packed, currentSize, &counter, timed);
         }
       }
 
@@ -882,10 +1010,26 @@ namespace zsLib
         }
       }
       
+      //-----------------------------------------------------------------------
+      void RemoteEventing::onRemoteEventingProviderSchema(ProviderInfo *provider)
+      {
+        AutoRecursiveLock lock(mLock);
+
+        // a provider announced later (or again after a reconnect) carries
+        // its schema with the announcement
+        auto found = mLocalAnnouncedProviders.find(provider->mProviderID);
+        if (found == mLocalAnnouncedProviders.end()) return;
+        if (!isAuthorized()) return;
+
+        announceProviderSchemaToRemote(provider);
+      }
+      
       //-----------------------------------------------------------------------
       void RemoteEventing::onRemoteEventingWriteEvent(
                                                       ByteQueuePtr message,
-                                                      size_t currentSize
+                                                      size_t currentSize,
+                                                      EventCounterSlot *counter,
+                                                      bool timed
                                                       )
       {
         --mOutstandingEvents;
@@ -893,6 +1037,7 @@ namespace zsLib
         
         if (mEventDataInOutgoingQueue + currentSize > mMaxQueuedOutgoingDataBeforeEventsDropped) {
           ++mTotalDroppedEvents;
+          if (counter) ++(counter->mTotalDropped);
           ZS_LOG_WARNING(Trace, log("too much data in outgoing queue (event dropped)"));
           return;
         }
@@ -900,12 +1045,23 @@ namespace zsLib
         AutoRecursiveLock lock(mLock);
         if (!isAuthorized()) {
           ++mTotalDroppedEvents;
+          if (counter) ++(counter->mTotalDropped);
           ZS_LOG_WARNING(Insane, log("ignoring event as not in authorized connection state (event dropped)"));
           return;
         }
 
-        mEventDataInOutgoingQueue += currentSize;
+        // encoded for a previous connection whose remote differed in whether
+        // it understands timed events
+        if (timed != mSendEventTimes.load(std::memory_order_relaxed)) {
+          ++mTotalDroppedEvents;
+          if (counter) ++(counter->mTotalDropped);
+          ZS_LOG_WARNING(Insane, log("ignoring event encoded for a previous connection (event dropped)"));
+          return;
+        }
+
+        updateHighWaterMark(mStatOutgoingQueueHighWaterMark, mEventDataInOutgoingQueue += currentSize);
         message->TransferTo(mOutgoingQueue);
+        queuedOutgoingFrame(currentSize, true);
 
         if (mWriteReady) {
           sendOutgoingData();
@@ -1043,6 +1199,15 @@ namespace zsLib
           mRebindTimer->cancel();
           mRebindTimer.reset();
         }
+
+        if (mReplayTimer) {
+          mReplayTimer->cancel();
+          mReplayTimer.reset();
+        }
+
+        mReplayReader.reset();
+        mReplayHasRecord = false;
+        mRecordWriter.reset();
         
         setState(State_Shutdown);
         
@@ -1060,6 +1225,11 @@ namespace zsLib
           return;
         }
         
+        if (isReplayMode()) {
+          stepReplay();
+          return;
+        }
+
         {
           if (isListeningMode()) {
             if (!stepSocketBind()) return;
@@ -1190,12 +1360,15 @@ namespace zsLib
         ElementPtr rootEl = Element::create("hello");
 
         mHelloSalt = IHelper::randomString(IHasher::sha256DigestSize()*8/5);
-        rootEl->adoptAsFirstChild(IHelper::createElementWithNumber("version", "1"));
+        rootEl->adoptAsFirstChild(IHelper::createElementWithNumber("version", string(ZSLIB_EVENTING_REMOTE_EVENTING_PROTOCOL_VERSION)));
         rootEl->adoptAsFirstChild(IHelper::createElementWithText("salt", mHelloSalt));
 
         String helloProof = IHasher::hashAsString("hello:proof:" + mSharedSecret + ":" + mHelloSalt, IHasher::sha256());
         rootEl->adoptAsFirstChild(IHelper::createElementWithText("proof", helloProof));
 
+        mClockRequestTime = getCurrentTime();
+        rootEl->adoptAsFirstChild(IHelper::createElementWithNumber("time", string(mClockRequestTime)));
+
         mExpectingHelloProofInChallenge = IHasher::hashAsString("hello:expecting:" + mSharedSecret + ":" + mHelloSalt, IHasher::sha256());
         mHandshakeState = MessageType_Challenge;
         sendData(MessageType_Hello, rootEl);
@@ -1231,6 +1404,76 @@ namespace zsLib
         return true;
       }
 
+      //-----------------------------------------------------------------------
+      void RemoteEventing::stepReplay()
+      {
+        if (mReplayTimer) {
+          ZS_LOG_TRACE(log("waiting for replay timer"));
+          return;
+        }
+
+        setState(State_Connected);
+
+        for (size_t processed = 0; processed < ZSLIB_EVENTING_REMOTE_EVENTING_REPLAY_RECORDS_PER_STEP; ++processed) {
+          if (!mReplayHasRecord) {
+            if (!mReplayReader->readNext(mReplayRecord)) {
+              ZS_LOG_DEBUG(log("replay complete") + ZS_PARAM("file", mReplayReader->getFileName()));
+              cancel();
+              return;
+            }
+            mReplayHasRecord = true;
+          }
+
+          if (0.0 != mReplaySpeed) {
+            auto tick = zsLib::now();
+            if (Time() == mReplayStartTime) {
+              mReplayStartTime = tick;
+              mReplayFirstRecordTime = mReplayRecord.mTime;
+            }
+
+            auto elapsed = std::chrono::duration_cast<Microseconds>(mReplayRecord.mTime - mReplayFirstRecordTime);
+            auto due = mReplayStartTime + Microseconds(static_cast<Microseconds::rep>(static_cast<double>(elapsed.count()) / mReplaySpeed));
+            if (due > tick) {
+              ZS_LOG_INSANE(log("pacing replay") + ZS_PARAM("wait (us)", std::chrono::duration_cast<Microseconds>(due - tick).count()));
+              mReplayTimer = ITimer::create(mThisWeak.lock(), std::chrono::duration_cast<Microseconds>(due - tick), false);
+              return;
+            }
+          }
+
+          mReplayHasRecord = false;
+
+          mStatFramesReceived.fetch_add(1, std::memory_order_relaxed);
+          mStatBytesReceived.fetch_add(mReplayRecord.mPayloadSize + (sizeof(CryptoPP::word32)*2), std::memory_order_relaxed);
+
+          switch (mReplayRecord.mType) {
+            case ITraceFileReader::RecordType_Notify: {
+              String message(reinterpret_cast<const char *>(mReplayRecord.mPayload), mReplayRecord.mPayloadSize);
+              ElementPtr rootEl = IHelper::toJSON(message.c_str());
+              if (!rootEl) {
+                ZS_LOG_WARNING(Detail, log("replayed notify is not legal (ignored)") + ZS_PARAM("size", mReplayRecord.mPayloadSize));
+                break;
+              }
+              recordIncoming(MessageType_Notify, mReplayRecord.mTime, mReplayRecord.mPayload, mReplayRecord.mPayloadSize);
+              handleNotify(rootEl);
+              break;
+            }
+            case ITraceFileReader::RecordType_TraceEvent: {
+              // the event is decoded in place so it must not point into the
+              // read-only mapped file
+              SecureByteBlock buffer(mReplayRecord.mPayload, mReplayRecord.mPayloadSize);
+              recordIncoming(MessageType_TraceEvent, mReplayRecord.mTime, buffer.BytePtr(), buffer.SizeInBytes());
+              handleEvent(buffer.BytePtr(), buffer.SizeInBytes(), mReplayRecord.mTime + mReplayReader->getClockOffset());
+              break;
+            }
+          }
+
+          if ((isShuttingDown()) ||
+              (isShutdown())) return;
+        }
+
+        IWakeDelegateProxy::create(mThisWeak.lock())->onWake();
+      }
+
       //-----------------------------------------------------------------------
       void RemoteEventing::setState(States state)
       {
@@ -1240,6 +1483,21 @@ namespace zsLib
         
         mState = state;
 
+        switch (mState) {
+          case State_Connecting: {
+            mHandshakeStart = std::chrono::steady_clock::now();
+            break;
+          }
+          case State_Connected: {
+            if (SteadyTime() != mHandshakeStart) {
+              mStatHandshakeDuration = std::chrono::duration_cast<Milliseconds>(std::chrono::steady_clock::now() - mHandshakeStart).count();
+              mHandshakeStart = SteadyTime();
+            }
+            break;
+          }
+          default: break;
+        }
+
         auto pThis = mThisWeak.lock();
         if (pThis) {
           if (mDelegate) {
@@ -1271,9 +1529,32 @@ namespace zsLib
         mAnnouncedLocalDropped = 0;
         mAnnouncedRemoteDropped = 0;
         mTotalDroppedEvents = 0;
+
+        for (auto iter = mLocalAnnouncedProviders.begin(); iter != mLocalAnnouncedProviders.end(); ++iter) {
+          auto provider = (*iter).second;
+          for (auto table = provider->mEventCounters.load(std::memory_order_acquire); NULL != table; table = table->mNext.load(std::memory_order_acquire)) {
+            for (size_t index = 0; index < table->mTotalSlots; ++index) {
+              auto &slot = table->mSlots[index];
+              slot.mAnnouncedEvents = 0;
+              slot.mAnnouncedDropped = 0;
+            }
+          }
+        }
         mIncomingQueue.Clear();
         mOutgoingQueue.Clear();
         mEventDataInOutgoingQueue = 0;
+        mOutgoingFrames.clear();
+        mOutgoingBytesQueued = 0;
+        mOutgoingBytesSent = 0;
+
+        mWriteBlockedStart = SteadyTime();
+        mHandshakeStart = SteadyTime();
+        mStatHandshakeDuration = 0;
+
+        mClockRequestTime = 0;
+        mStatRemoteClockOffset = 0;
+        mStatRemoteClockRoundTrip = -1;
+        mSendEventTimes = false;
 
         mHelloSalt.clear();
         mExpectingHelloProofInChallenge.clear();
@@ -1337,7 +1618,12 @@ namespace zsLib
           SecureByteBlock buffer(messageSize);
           mIncomingQueue.Get(buffer, messageSize);
 
+          mStatFramesReceived.fetch_add(1, std::memory_order_relaxed);
+
           if (MessageType_Welcome == mHandshakeState) {
+            // recorded in the remote's clock (see estimateRemoteClock); a
+            // timed event is recorded with its own time (see handleTimedEvent)
+            recordIncoming(static_cast<MessageTypes>(messageType), zsLib::now() + getRemoteClockOffset(), buffer.BytePtr(), buffer.SizeInBytes());
             handleAuthorizedMessage(static_cast<MessageTypes>(messageType), buffer);
           } else {
             handleHandshakeMessage(static_cast<MessageTypes>(messageType), buffer);
@@ -1381,10 +1667,16 @@ namespace zsLib
 
             bool wouldBlock = false;
             auto written = activeSocket->send(&(buffer[0]), availeable, &wouldBlock);
+            mStatSendCalls.fetch_add(1, std::memory_order_relaxed);
+            mStatBytesSent.fetch_add(static_cast<size_t>(written), std::memory_order_relaxed);
 
             mOutgoingQueue.Skip(written);
             mEventDataInOutgoingQueue -= static_cast<size_t>(written);
-            if (wouldBlock) mWriteReady = false;
+            sentOutgoingData(static_cast<size_t>(written));
+            if (wouldBlock) {
+              mWriteReady = false;
+              mWriteBlockedStart = std::chrono::steady_clock::now();
+            }
           }
         } catch (const Socket::Exceptions::Unspecified &) {
           ZS_LOG_WARNING(Debug, log("could not write to active socket"));
@@ -1396,6 +1688,35 @@ namespace zsLib
         }
       }
 
+      //-----------------------------------------------------------------------
+      void RemoteEventing::queuedOutgoingFrame(
+                                               size_t frameSize,
+                                               bool event
+                                               )
+      {
+        mOutgoingBytesQueued += frameSize;
+
+        OutgoingFrame frame;
+        frame.mEndOffset = mOutgoingBytesQueued;
+        frame.mEvent = event;
+        mOutgoingFrames.push_back(frame);
+      }
+
+      //-----------------------------------------------------------------------
+      void RemoteEventing::sentOutgoingData(size_t sentSize)
+      {
+        mOutgoingBytesSent += sentSize;
+
+        while (mOutgoingFrames.size() > 0) {
+          auto &frame = mOutgoingFrames.front();
+          if (frame.mEndOffset > mOutgoingBytesSent) break;
+
+          mStatFramesSent.fetch_add(1, std::memory_order_relaxed);
+          if (frame.mEvent) mStatEventsSent.fetch_add(1, std::memory_order_relaxed);
+          mOutgoingFrames.pop_front();
+        }
+      }
+
       //-----------------------------------------------------------------------
       void RemoteEventing::sendData(
                                     MessageTypes messageType,
@@ -1409,7 +1730,8 @@ namespace zsLib
         mOutgoingQueue.PutWord32(type);
         mOutgoingQueue.Put(buffer, buffer.SizeInBytes());
         
-        mEventDataInOutgoingQueue += static_cast<size_t>((sizeof(uint32_t)*2) + buffer.SizeInBytes());
+        updateHighWaterMark(mStatOutgoingQueueHighWaterMark, mEventDataInOutgoingQueue += static_cast<size_t>((sizeof(uint32_t)*2) + buffer.SizeInBytes()));
+        queuedOutgoingFrame(static_cast<size_t>((sizeof(uint32_t)*2) + buffer.SizeInBytes()));
         
         if (mWriteReady) {
           sendOutgoingData();
@@ -1439,7 +1761,8 @@ namespace zsLib
         mOutgoingQueue.PutWord32(type);
         mOutgoingQueue.Put(reinterpret_cast<const BYTE *>(message.c_str()), message.length());
 
-        mEventDataInOutgoingQueue += static_cast<size_t>((sizeof(uint32_t)*2) + message.length());
+        updateHighWaterMark(mStatOutgoingQueueHighWaterMark, mEventDataInOutgoingQueue += static_cast<size_t>((sizeof(uint32_t)*2) + message.length()));
+        queuedOutgoingFrame(static_cast<size_t>((sizeof(uint32_t)*2) + message.length()));
 
         if (mWriteReady) {
           sendOutgoingData();
@@ -1514,7 +1837,11 @@ namespace zsLib
       {
         switch (messageType) {
           case MessageType_TraceEvent: {
-            handleEvent(buffer);
+            handleEvent(buffer.BytePtr(), buffer.SizeInBytes(), zsLib::now());
+            return;
+          }
+          case MessageType_TimedTraceEvent: {
+            handleTimedEvent(buffer);
             return;
           }
           case MessageType_Goodbye: {
@@ -1579,6 +1906,8 @@ namespace zsLib
           return;
         }
 
+        handleRemoteVersion(rootEl);
+
         mHandshakeState = MessageType_Challenge;
         
         mExpectingHelloProofInChallenge = IHasher::hashAsString("hello:expecting:" + mSharedSecret + ":" + mHelloSalt, IHasher::sha256());
@@ -1586,10 +1915,13 @@ namespace zsLib
         ElementPtr challengeEl = Element::create("challenge");
 
         mChallengeSalt = IHelper::randomString(IHasher::sha256DigestSize() * 8 / 5);
-        challengeEl->adoptAsFirstChild(IHelper::createElementWithNumber("version", "1"));
+        challengeEl->adoptAsFirstChild(IHelper::createElementWithNumber("version", string(ZSLIB_EVENTING_REMOTE_EVENTING_PROTOCOL_VERSION)));
         challengeEl->adoptAsFirstChild(IHelper::createElementWithText("salt", mChallengeSalt));
         challengeEl->adoptAsFirstChild(IHelper::createElementWithText("proof", mExpectingHelloProofInChallenge));
 
+        mClockRequestTime = getCurrentTime();
+        challengeEl->adoptAsFirstChild(IHelper::createElementWithNumber("time", string(mClockRequestTime)));
+
         mExpectingChallengeProofInReply = IHasher::hashAsString("challenge:expecting:" + mSharedSecret + ":" + mHelloSalt + ":" + mChallengeSalt, IHasher::sha256());
         sendData(MessageType_Challenge, challengeEl);
       }
@@ -1613,7 +1945,11 @@ namespace zsLib
           return;
         }
 
+        handleRemoteVersion(rootEl);
+        estimateRemoteClock(rootEl);
+
         ElementPtr challengeReplyEl = Element::create("challengeReply");
+        challengeReplyEl->adoptAsFirstChild(IHelper::createElementWithNumber("time", string(getCurrentTime())));
 
         mExpectingChallengeProofInReply = IHasher::hashAsString("challenge:expecting:" + mSharedSecret + ":" + mHelloSalt + ":" + mChallengeSalt, IHasher::sha256());
         challengeReplyEl->adoptAsFirstChild(IHelper::createElementWithText("proof", mExpectingChallengeProofInReply));
@@ -1639,6 +1975,8 @@ namespace zsLib
           return;
         }
 
+        estimateRemoteClock(rootEl);
+
         mHandshakeState = MessageType_ChallengeReply;
         sendWelcome();
       }
@@ -1724,6 +2062,14 @@ namespace zsLib
           handleNotifyRemoteProviderKeywordLogging(rootEl);
           return;
         }
+        if (ZSLIB_EVENTING_REMOTE_EVENTING_NOTIFY_PROVIDER_SCHEMA == typeStr) {
+          handleNotifyRemoteProviderSchema(rootEl);
+          return;
+        }
+        if (ZSLIB_EVENTING_REMOTE_EVENTING_NOTIFY_EVENT_COUNTERS == typeStr) {
+          handleNotifyEventCounters(rootEl);
+          return;
+        }
         ZS_LOG_WARNING(Detail, log("remote notify is not understood (ignored)") + ZS_PARAMIZE(typeStr));
       }
 
@@ -1837,6 +2183,7 @@ namespace zsLib
         String providerIDStr = IHelper::getElementText(rootEl->findLastChildElement("id"));
         String providerNameStr = IHelper::getElementText(rootEl->findLastChildElement("name"));
         String providerHashStr = IHelper::getElementText(rootEl->findLastChildElement("hash"));
+        String schemaStr = IHelper::getElementText(rootEl->findLastChildElement("schema"));
         
         ProviderInfo *provider {};
         
@@ -1884,6 +2231,8 @@ namespace zsLib
         } else {
           atomArray[mEventingAtomIndex] = reinterpret_cast<Log::EventingAtomData>(provider);
         }
+
+        attachRemoteProviderSchema(provider, schemaStr);
         
         if (mDelegate) {
           try {
@@ -1943,7 +2292,124 @@ namespace zsLib
           mDelegate.reset();
         }
       }
+
+      //-----------------------------------------------------------------------
+      void RemoteEventing::handleNotifyRemoteProviderSchema(const ElementPtr &rootEl)
+      {
+        String remoteHandleStr = IHelper::getElementText(rootEl->findLastChildElement("handle"));
+        String schemaStr = IHelper::getElementText(rootEl->findLastChildElement("schema"));
+
+        ProviderHandle remoteHandle = 0;
+        try {
+          remoteHandle = Numeric<ProviderHandle>(remoteHandleStr);
+        } catch (const Numeric<ProviderHandle>::ValueOutOfRange &) {
+          ZS_LOG_WARNING(Detail, log("remote handle is not valid") + ZS_PARAMIZE(remoteHandleStr));
+          return;
+        }
+
+        auto found = mRemoteRegisteredProvidersByRemoteHandle.find(remoteHandle);
+        if (found == mRemoteRegisteredProvidersByRemoteHandle.end()) {
+          ZS_LOG_WARNING(Debug, log("told schema of unknown provider") + ZS_PARAMIZE(remoteHandle));
+          return;
+        }
+
+        attachRemoteProviderSchema((*found).second, schemaStr);
+      }
+
+      //-----------------------------------------------------------------------
+      void RemoteEventing::attachRemoteProviderSchema(
+                                                      ProviderInfo *provider,
+                                                      const String &schemaStr
+                                                      )
+      {
+        if (schemaStr.isEmpty()) return;
+        if (provider->mSchema) return;  // already shipped with the announcement
+
+        auto schema = IHelper::convertFromBase64(schemaStr);
+        if ((!schema) ||
+            (schema->SizeInBytes() < 1)) {
+          ZS_LOG_WARNING(Debug, log("remote provider schema is not valid") + ZS_PARAM("provider name", provider->mProviderName));
+          return;
+        }
+
+        UUID providerID;
+        String providerName;
+        String providerHash;
+        EventingAtomDataArray atomArray {};
+        if (!Log::getEventingWriterInfo(provider->mHandle, providerID, providerName, providerHash, &atomArray)) {
+          ZS_LOG_WARNING(Detail, log("remote provider schema for provider without eventing writer") + ZS_PARAM("provider name", provider->mProviderName));
+          return;
+        }
+
+        // the shipped schema stays owned by the provider info
+        provider->mSchema = IHelper::convertToSizePrefixedBuffer(schema->BytePtr(), schema->SizeInBytes());
+        if (0 == atomArray[mSchemaAtomIndex]) {
+          atomArray[mSchemaAtomIndex] = reinterpret_cast<Log::EventingAtomData>(provider->mSchema->BytePtr());
+        }
+      }
       
+      //-----------------------------------------------------------------------
+      void RemoteEventing::handleNotifyEventCounters(const ElementPtr &rootEl)
+      {
+        ElementPtr providersEl = rootEl->findFirstChildElement("providers");
+        if (!providersEl) {
+          ZS_LOG_WARNING(Debug, log("event counters notification is missing providers"));
+          return;
+        }
+
+        EventCounterListPtr counters(make_shared<EventCounterList>());
+
+        for (ElementPtr providerEl = providersEl->findFirstChildElement("provider"); providerEl; providerEl = providerEl->findNextSiblingElement("provider")) {
+          String remoteHandleStr = IHelper::getElementText(providerEl->findFirstChildElement("handle"));
+
+          ProviderHandle remoteHandle {};
+          try {
+            remoteHandle = Numeric<ProviderHandle>(remoteHandleStr);
+          } catch (const Numeric<ProviderHandle>::ValueOutOfRange &) {
+            ZS_LOG_WARNING(Detail, log("remote handle is not valid") + ZS_PARAMIZE(remoteHandleStr));
+            continue;
+          }
+
+          auto found = mRemoteRegisteredProvidersByRemoteHandle.find(remoteHandle);
+          if (found == mRemoteRegisteredProvidersByRemoteHandle.end()) {
+            ZS_LOG_WARNING(Trace, log("told event counters about unknown provider") + ZS_PARAMIZE(remoteHandle));
+            continue;
+          }
+
+          auto provider = (*found).second;
+
+          ElementPtr countersEl = providerEl->findFirstChildElement("counters");
+          if (!countersEl) continue;
+
+          for (ElementPtr counterEl = countersEl->findFirstChildElement("counter"); counterEl; counterEl = counterEl->findNextSiblingElement("counter")) {
+            EventCounter counter;
+            counter.mProviderID = provider->mProviderID;
+            counter.mProviderName = provider->mProviderName;
+            try {
+              counter.mEventID = Numeric<size_t>(IHelper::getElementText(counterEl->findFirstChildElement("id")));
+              counter.mTotalEvents = Numeric<size_t>(IHelper::getElementText(counterEl->findFirstChildElement("events")));
+              counter.mTotalBytes = Numeric<size_t>(IHelper::getElementText(counterEl->findFirstChildElement("bytes")));
+              counter.mTotalDropped = Numeric<size_t>(IHelper::getElementText(counterEl->findFirstChildElement("dropped")));
+            } catch (const Numeric<size_t>::ValueOutOfRange &) {
+              ZS_LOG_WARNING(Detail, log("event counter value is not valid") + ZS_PARAMIZE(remoteHandle));
+              continue;
+            }
+            counters->push_back(counter);
+          }
+        }
+
+        if (counters->size() < 1) return;
+
+        if (mDelegate) {
+          try {
+            mDelegate->onRemoteEventingRemoteEventCounters(mThisWeak.lock(), counters);
+          } catch (const IRemoteEventingDelegateProxy::Exceptions::DelegateGone &) {
+            ZS_LOG_WARNING(Detail, log("delegate gone (probably okay)"));
+            mDelegate.reset();
+          }
+        }
+      }
+
       //-----------------------------------------------------------------------
       void RemoteEventing::handleRequest(const ElementPtr &rootEl)
       {
@@ -2003,22 +2469,20 @@ namespace zsLib
       }
 
       //-----------------------------------------------------------------------
-      void RemoteEventing::handleEvent(SecureByteBlock &buffer)
+      void RemoteEventing::handleEvent(
+                                       BYTE *buffer,
+                                       size_t bufferSize,
+                                       Time eventTime
+                                       )
       {
-        size_t expectingBasicSize = (sizeof(CryptoPP::word16)*5) +
-                                    (sizeof(uint8_t)*4) +
-                                    (sizeof(uint64_t)*2);
-        
-        if (buffer.SizeInBytes() < expectingBasicSize) {
-          ZS_LOG_WARNING(Debug, log("event message did not contain enough header data") + ZS_PARAMIZE(expectingBasicSize) + ZS_PARAM("actual size", buffer.SizeInBytes()));
+        TraceEventCodec::DecodedEvent event;
+        if (!TraceEventCodec::decode(buffer, bufferSize, event)) {
+          ZS_LOG_WARNING(Debug, log("remote event could not be decoded") + ZS_PARAM("size", bufferSize));
           return;
         }
-        
-        const BYTE *pos = buffer.BytePtr();
-        
-        uint64_t remoteHandle = IHelper::getBE64(pos);
-        pos += sizeof(remoteHandle);
-        
+
+        auto remoteHandle = event.mHandle;
+
         auto found = mRemoteRegisteredProvidersByRemoteHandle.find(remoteHandle);
         if (found == mRemoteRegisteredProvidersByRemoteHandle.end()) {
           ZS_LOG_WARNING(Trace, log("event about provider that was never announced") + ZS_PARAMIZE(remoteHandle));
@@ -2030,135 +2494,136 @@ namespace zsLib
           ZS_LOG_ERROR(Debug, log("event about provider that was not registered from remote party") + ZS_PARAMIZE(remoteHandle));
           return;
         }
-        
-        Log::Severity severity = static_cast<Log::Severity>(IHelper::getBE16(pos));
-        pos += sizeof(uint16_t);
-        Log::Level level = static_cast<Log::Level>(IHelper::getBE16(pos));
-        pos += sizeof(uint16_t);
-        
-        if ((severity < Log::Severity_First) ||
-            (severity > Log::Severity_Last)) {
-          ZS_LOG_WARNING(Debug, log("illegal severity") + ZS_PARAMIZE(severity));
+
+        mStatEventsReceived.fetch_add(1, std::memory_order_relaxed);
+
+        // listeners can tell which remote the event came from (and when it
+        // happened) while it is written (see IRemoteEventing::getWritingRemoteID)
+        WritingRemoteScope writingRemote(mID, eventTime);
+
+        // write the remote event as if it was generated locally
+        Log::writeEvent(
+                        provider->mHandle,
+                        event.mSeverity,
+                        event.mLevel,
+                        (&(event.mDescriptor)),
+                        (&(event.mParameterDescriptors[0])),
+                        (&(event.mDataDescriptors[0])),
+                        event.mDataDescriptorCount
+                        );
+      }
+
+      //-----------------------------------------------------------------------
+      void RemoteEventing::handleTimedEvent(SecureByteBlock &buffer)
+      {
+        if (buffer.SizeInBytes() < sizeof(uint64_t)) {
+          ZS_LOG_WARNING(Debug, log("timed remote event is missing its time") + ZS_PARAM("size", buffer.SizeInBytes()));
           return;
         }
-        if ((level < Log::Level_First) ||
-            (level > Log::Level_Last)) {
-          ZS_LOG_WARNING(Debug, log("illegal level") + ZS_PARAMIZE(level));
+
+        // the time is in the remote's clock, which is the clock recordings
+        // are kept in; listeners are given it in the local clock
+        Microseconds::rep remoteTime = static_cast<Microseconds::rep>(IHelper::getBE64(buffer.BytePtr()));
+        Time eventTime(std::chrono::duration_cast<Time::duration>(Microseconds(remoteTime)));
+
+        BYTE *event = buffer.BytePtr() + sizeof(uint64_t);
+        size_t eventSize = buffer.SizeInBytes() - sizeof(uint64_t);
+
+        recordIncoming(MessageType_TraceEvent, eventTime, event, eventSize);
+        handleEvent(event, eventSize, eventTime - getRemoteClockOffset());
+      }
+
+      //-----------------------------------------------------------------------
+      Microseconds::rep RemoteEventing::getCurrentTime()
+      {
+        return std::chrono::duration_cast<Microseconds>(zsLib::now().time_since_epoch()).count();
+      }
+
+      //-----------------------------------------------------------------------
+      void RemoteEventing::estimateRemoteClock(const ElementPtr &rootEl)
+      {
+        Microseconds::rep replyTime = getCurrentTime();
+        Microseconds::rep requestTime = mClockRequestTime;
+        mClockRequestTime = 0;
+
+        String timeStr = IHelper::getElementText(rootEl->findFirstChildElement("time"));
+        if ((timeStr.isEmpty()) ||
+            (0 == requestTime)) {
+          ZS_LOG_DEBUG(log("remote did not send its time (clock offset not estimated)"));
           return;
         }
-        
-        USE_EVENT_DESCRIPTOR descriptor {};
-        descriptor.Id = IHelper::getBE16(pos);
-        pos += sizeof(uint16_t);
-        descriptor.Version = *pos;
-        pos += sizeof(uint8_t);
-        descriptor.Channel = *pos;
-        pos += sizeof(uint8_t);
-        descriptor.Level = *pos;
-        pos += sizeof(uint8_t);
-        descriptor.Opcode = *pos;
-        pos += sizeof(uint8_t);
-        descriptor.Task = IHelper::getBE16(pos);
-        pos += sizeof(uint16_t);
-        descriptor.Keyword = IHelper::getBE64(pos);
-        pos += sizeof(uint64_t);
 
-        size_t descriptorCount = IHelper::getBE16(pos);
-        pos += sizeof(uint16_t);
-        
-        if (descriptorCount > ZSLIB_EVENTING_REMOTE_EVENTING_MAX_DATA_DESCRIPTORS) {
-          ZS_LOG_WARNING(Debug, log("remote event contains too many data descriptors") + ZS_PARAMIZE(descriptorCount));
+        Microseconds::rep remoteTime {};
+        try {
+          remoteTime = Numeric<Microseconds::rep>(timeStr);
+        } catch (const Numeric<Microseconds::rep>::ValueOutOfRange &) {
+          ZS_LOG_WARNING(Detail, log("remote time is not legal (clock offset not estimated)") + ZS_PARAMIZE(timeStr));
           return;
         }
 
-        USE_EVENT_DATA_DESCRIPTOR dataDescriptors[ZSLIB_EVENTING_REMOTE_EVENTING_MAX_DATA_DESCRIPTORS];
-        USE_EVENT_PARAMETER_DESCRIPTOR paramDescriptors[ZSLIB_EVENTING_REMOTE_EVENTING_MAX_DATA_DESCRIPTORS];
+        // the remote is assumed to have stamped its reply half way through
+        // the round trip
+        Microseconds::rep roundTrip = (replyTime > requestTime ? replyTime - requestTime : 0);
+        Microseconds::rep offset = remoteTime - (requestTime + (roundTrip / 2));
 
-        size_t remaining = buffer.SizeInBytes() - expectingBasicSize;
-        
-        size_t expecting = (sizeof(uint16_t)*descriptorCount);
-        if (remaining < expecting) {
-          ZS_LOG_WARNING(Debug, log("event message did not contain enough data") + ZS_PARAMIZE(expecting) + ZS_PARAMIZE(remaining) + ZS_PARAM("actual size", buffer.SizeInBytes()));
-          return;
-        }
+        mStatRemoteClockOffset = offset;
+        mStatRemoteClockRoundTrip = roundTrip;
 
-        for (size_t index = 0; index < descriptorCount; ++index) {
-          paramDescriptors[index].Type = static_cast<EventParameterTypes>(IHelper::getBE16(pos));
-          pos += sizeof(uint16_t);
-          remaining -= sizeof(uint16_t);
+        if (mRecordWriter) {
+          mRecordWriter->setClockOffset(Microseconds(-offset));
         }
 
-        for (size_t index = 0; index < descriptorCount; ++index) {
-          
-          {
-            expecting = sizeof(uint32_t);
-            if (remaining < expecting) goto not_enough_data;
+        ZS_LOG_DEBUG(log("estimated remote clock offset") + ZS_PARAM("offset (us)", offset) + ZS_PARAM("round trip (us)", roundTrip));
+      }
 
-            uint32_t dataTypeSize = IHelper::getBE32(pos);
-            pos += sizeof(dataTypeSize);
-            remaining -= sizeof(dataTypeSize);
-            
-            bool endianFlip {false};
-            if (0 != (dataTypeSize & (1 << 31))) {
-              endianFlip = true;
-              dataTypeSize = dataTypeSize & (0x7FFFFFFF);
-            }
-            
-            expecting = dataTypeSize;
-            if (remaining < expecting) goto not_enough_data;
-            
-            dataDescriptors[index].Size = dataTypeSize;
-            if (0 != dataDescriptors[index].Size) {
-              dataDescriptors[index].Ptr = reinterpret_cast<uintptr_t>(pos);
-            }
+      //-----------------------------------------------------------------------
+      Microseconds RemoteEventing::getRemoteClockOffset() const
+      {
+        return Microseconds(mStatRemoteClockOffset.load(std::memory_order_relaxed));
+      }
 
-            if (endianFlip) {
-              switch (dataTypeSize) {
-                case 2: {
-                  uint16_t value = IHelper::getBE16(pos);
-                  memcpy(const_cast<BYTE *>(pos), &value, sizeof(value));
-                  break;
-                }
-                case 4: {
-                  uint32_t value = IHelper::getBE32(pos);
-                  memcpy(const_cast<BYTE *>(pos), &value, sizeof(value));
-                  break;
-                }
-                case 8: {
-                  uint64_t value = IHelper::getBE64(pos);
-                  memcpy(const_cast<BYTE *>(pos), &value, sizeof(value));
-                  break;
-                }
-                default:  {
-                  // just leave in original format
-                  break;
-                }
-              }
-            }
+      //-----------------------------------------------------------------------
+      void RemoteEventing::handleRemoteVersion(const ElementPtr &rootEl)
+      {
+        // a version 1 remote neither sends timed events nor understands them
+        String versionStr = IHelper::getElementText(rootEl->findFirstChildElement("version"));
 
-            pos += dataTypeSize;
-            remaining -= dataTypeSize;
-            
-            continue;
-          }
-          
-        not_enough_data:
-          {
-            ZS_LOG_WARNING(Debug, log("event message did not contain enough data") + ZS_PARAMIZE(index) + ZS_PARAMIZE(expecting) + ZS_PARAMIZE(remaining) + ZS_PARAM("actual size", buffer.SizeInBytes()));
-            return;
+        int version {1};
+        if (versionStr.hasData()) {
+          try {
+            version = Numeric<int>(versionStr);
+          } catch (const Numeric<int>::ValueOutOfRange &) {
+            ZS_LOG_WARNING(Detail, log("remote version is not legal") + ZS_PARAMIZE(versionStr));
           }
         }
 
-        // write the remote event as if it was generated locally
-        Log::writeEvent(
-                        provider->mHandle,
-                        severity,
-                        level,
-                        (&descriptor),
-                        (&(paramDescriptors[0])),
-                        (&(dataDescriptors[0])),
-                        descriptorCount
-                        );
+        mSendEventTimes = (version >= ZSLIB_EVENTING_REMOTE_EVENTING_TIMED_EVENTS_VERSION);
+        ZS_LOG_DEBUG(log("remote protocol version") + ZS_PARAMIZE(version) + ZS_PARAM("timed events", mSendEventTimes.load()));
+      }
+
+      //-----------------------------------------------------------------------
+      void RemoteEventing::recordIncoming(
+                                          MessageTypes messageType,
+                                          Time time,
+                                          const BYTE *buffer,
+                                          size_t bufferSize
+                                          )
+      {
+        if (!mRecordWriter) return;
+
+        ITraceFileWriter::RecordTypes recordType {};
+        switch (messageType) {
+          case MessageType_Notify:      recordType = ITraceFileWriter::RecordType_Notify; break;
+          case MessageType_TraceEvent:  recordType = ITraceFileWriter::RecordType_TraceEvent; break;
+          default:                      return;
+        }
+
+        try {
+          mRecordWriter->writeRecord(recordType, time, buffer, bufferSize);
+        } catch (const StdError &e) {
+          ZS_LOG_WARNING(Basic, log("failed to record incoming data (recording stopped)") + ZS_PARAM("file", mRecordWriter->getFileName()) + ZS_PARAM("error", e.result()) + ZS_PARAM("reason", e.message()));
+          mRecordWriter.reset();
+        }
       }
 
       //-----------------------------------------------------------------------
@@ -2221,6 +2686,93 @@ namespace zsLib
             }
           }
         }
+
+        if (mNotifyEventCounters) {
+          sendNotifyEventCounters();
+        }
+      }
+
+      //-----------------------------------------------------------------------
+      void RemoteEventing::sendNotifyEventCounters()
+      {
+        EventCounterListPtr counters(make_shared<EventCounterList>());
+
+        ElementPtr rootEl = Element::create("notify");
+        rootEl->adoptAsLastChild(IHelper::createElementWithText("type", ZSLIB_EVENTING_REMOTE_EVENTING_NOTIFY_EVENT_COUNTERS));
+
+        ElementPtr providersEl = Element::create("providers");
+
+        for (auto iter = mLocalAnnouncedProviders.begin(); iter != mLocalAnnouncedProviders.end(); ++iter) {
+          auto provider = (*iter).second;
+
+          ElementPtr countersEl;
+
+          for (auto table = provider->mEventCounters.load(std::memory_order_acquire); NULL != table; table = table->mNext.load(std::memory_order_acquire)) {
+            for (size_t index = 0; index < table->mTotalSlots; ++index) {
+              auto &slot = table->mSlots[index];
+
+              uint32_t eventID = slot.mEventID.load(std::memory_order_acquire);
+              if (ZSLIB_EVENTING_REMOTE_EVENTING_EVENT_COUNTER_UNUSED == eventID) continue;
+
+              EventCounter counter;
+              counter.mProviderID = provider->mProviderID;
+              counter.mProviderName = provider->mProviderName;
+              counter.mEventID = eventID;
+              counter.mTotalEvents = slot.mTotalEvents;
+              counter.mTotalBytes = slot.mTotalBytes;
+              counter.mTotalDropped = slot.mTotalDropped;
+
+              if ((counter.mTotalEvents == slot.mAnnouncedEvents) &&
+                  (counter.mTotalDropped == slot.mAnnouncedDropped)) continue;
+
+              slot.mAnnouncedEvents = counter.mTotalEvents;
+              slot.mAnnouncedDropped = counter.mTotalDropped;
+
+              if (!countersEl) {
+                ElementPtr providerEl = Element::create("provider");
+                providerEl->adoptAsLastChild(IHelper::createElementWithNumber("handle", string(static_cast<uint64_t>(provider->mHandle))));
+                countersEl = Element::create("counters");
+                providerEl->adoptAsLastChild(countersEl);
+                providersEl->adoptAsLastChild(providerEl);
+              }
+
+              ElementPtr counterEl = Element::create("counter");
+              counterEl->adoptAsLastChild(IHelper::createElementWithNumber("id", string(counter.mEventID)));
+              counterEl->adoptAsLastChild(IHelper::createElementWithNumber("events", string(counter.mTotalEvents)));
+              counterEl->adoptAsLastChild(IHelper::createElementWithNumber("bytes", string(counter.mTotalBytes)));
+              counterEl->adoptAsLastChild(IHelper::createElementWithNumber("dropped", string(counter.mTotalDropped)));
+              countersEl->adoptAsLastChild(counterEl);
+
+              counters->push_back(counter);
+            }
+          }
+        }
+
+        if (counters->size() < 1) return;
+
+        rootEl->adoptAsLastChild(providersEl);
+        sendData(MessageType_Notify, rootEl);
+
+        if (mDelegate) {
+          try {
+            mDelegate->onRemoteEventingLocalEventCounters(mThisWeak.lock(), counters);
+          } catch (const IRemoteEventingDelegateProxy::Exceptions::DelegateGone &) {
+            ZS_LOG_WARNING(Detail, log("delegate gone (probably okay)"));
+            mDelegate.reset();
+          }
+        }
+      }
+
+      //-----------------------------------------------------------------------
+      void RemoteEventing::updateHighWaterMark(
+                                               std::atomic<size_t> &mark,
+                                               size_t value
+                                               )
+      {
+        size_t existing = mark.load(std::memory_order_relaxed);
+        while (value > existing) {
+          if (mark.compare_exchange_weak(existing, value, std::memory_order_relaxed)) break;
+        }
       }
 
       //-----------------------------------------------------------------------
@@ -2264,6 +2816,15 @@ namespace zsLib
           rootEl->adoptAsLastChild(IHelper::createElementWithText("id", string(provider->mProviderID)));
           rootEl->adoptAsLastChild(IHelper::createElementWithText("name", provider->mProviderName));
           rootEl->adoptAsLastChild(IHelper::createElementWithText("hash", provider->mProviderHash));
+
+          // the schema goes with the announcement when it is already
+          // attached, otherwise it follows ahead of the provider's first
+          // event (see notifyWriteEvent)
+          String schemaStr = getProviderSchema(provider);
+          if (schemaStr.hasData()) {
+            rootEl->adoptAsLastChild(IHelper::createElementWithText("schema", schemaStr));
+            provider->mSchemaAnnounced = true;
+          }
         } else {
           rootEl->adoptAsLastChild(IHelper::createElementWithNumber("gone", (!announceNew) ? "true" : "false"));
         }
@@ -2290,6 +2851,37 @@ namespace zsLib
         
         sendData(MessageType_Notify, rootEl);
       }
+
+      //-----------------------------------------------------------------------
+      void RemoteEventing::announceProviderSchemaToRemote(ProviderInfo *provider)
+      {
+        String schemaStr = getProviderSchema(provider);
+        if (schemaStr.isEmpty()) return;
+
+        ElementPtr rootEl = Element::create("notify");
+
+        rootEl->adoptAsLastChild(IHelper::createElementWithText("type", ZSLIB_EVENTING_REMOTE_EVENTING_NOTIFY_PROVIDER_SCHEMA));
+        rootEl->adoptAsLastChild(IHelper::createElementWithNumber("handle", string(static_cast<uint64_t>(provider->mHandle))));
+        rootEl->adoptAsLastChild(IHelper::createElementWithText("schema", schemaStr));
+
+        sendData(MessageType_Notify, rootEl);
+      }
+
+      //-----------------------------------------------------------------------
+      String RemoteEventing::getProviderSchema(ProviderInfo *provider) const
+      {
+        UUID providerID;
+        String providerName;
+        String providerHash;
+        EventingAtomDataArray atomArray {};
+        if (!Log::getEventingWriterInfo(provider->mHandle, providerID, providerName, providerHash, &atomArray)) return String();
+
+        size_t size {};
+        const BYTE *schema = IHelper::getSizePrefixedBuffer(reinterpret_cast<const BYTE *>(atomArray[mSchemaAtomIndex]), size);
+        if ((!schema) || (0 == size)) return String();
+
+        return IHelper::convertToBase64(schema, size);
+      }
       
       //-----------------------------------------------------------------------
       void RemoteEventing::announceSubsystemToRemote(SubsystemInfoPtr info)
@@ -2339,6 +2931,34 @@ namespace zsLib
       ZS_THROW_INVALID_ARGUMENT(String("Not a state: ") + str);
       return State_First;
     }
+
+    //-------------------------------------------------------------------------
+    ElementPtr IRemoteEventingTypes::Statistics::toDebug() const
+    {
+      ElementPtr resultEl = Element::create("zsLib::eventing::IRemoteEventingTypes::Statistics");
+
+      resultEl->adoptAsLastChild(IHelper::createElementWithNumber("events sent", string(mEventsSent)));
+      resultEl->adoptAsLastChild(IHelper::createElementWithNumber("events received", string(mEventsReceived)));
+      resultEl->adoptAsLastChild(IHelper::createElementWithNumber("events dropped", string(mEventsDropped)));
+      resultEl->adoptAsLastChild(IHelper::createElementWithNumber("bytes sent", string(mBytesSent)));
+      resultEl->adoptAsLastChild(IHelper::createElementWithNumber("bytes received", string(mBytesReceived)));
+      resultEl->adoptAsLastChild(IHelper::createElementWithNumber("frames sent", string(mFramesSent)));
+      resultEl->adoptAsLastChild(IHelper::createElementWithNumber("frames received", string(mFramesReceived)));
+      resultEl->adoptAsLastChild(IHelper::createElementWithNumber("send calls", string(mSendCalls)));
+      resultEl->adoptAsLastChild(IHelper::createElementWithNumber("receive calls", string(mReceiveCalls)));
+      resultEl->adoptAsLastChild(IHelper::createElementWithNumber("async queue high water mark", string(mAsyncQueueHighWaterMark)));
+      resultEl->adoptAsLastChild(IHelper::createElementWithNumber("outgoing queue high water mark", string(mOutgoingQueueHighWaterMark)));
+      resultEl->adoptAsLastChild(IHelper::createElementWithNumber("write blocked (us)", string(mWriteBlockedTime.count())));
+      resultEl->adoptAsLastChild(IHelper::createElementWithNumber("events encoded", string(mEventsEncoded)));
+      resultEl->adoptAsLastChild(IHelper::createElementWithNumber("average encode (ns)", string(averageEncodeTime().count())));
+      resultEl->adoptAsLastChild(IHelper::createElementWithNumber("handshake (ms)", string(mHandshakeDuration.count())));
+      if (mHasRemoteClockOffset) {
+        resultEl->adoptAsLastChild(IHelper::createElementWithNumber("remote clock offset (us)", string(mRemoteClockOffset.count())));
+        resultEl->adoptAsLastChild(IHelper::createElementWithNumber("remote clock round trip (us)", string(mRemoteClockRoundTrip.count())));
+      }
+
+      return resultEl;
+    }
     
     //-------------------------------------------------------------------------
     //-------------------------------------------------------------------------
@@ -2352,11 +2972,12 @@ namespace zsLib
     IRemoteEventingPtr IRemoteEventing::connectToRemote(
                                                         IRemoteEventingDelegatePtr connectionDelegate,
                                                         const IPAddress &serverIP,
-                                                        const char *connectionSharedSecret
+                                                        const char *connectionSharedSecret,
+                                                        IMessageQueuePtr queue
                                                         )
     {
       ZS_THROW_INVALID_ARGUMENT_IF(serverIP.isEmpty());
-      return internal::RemoteEventing::connectToRemote(connectionDelegate, serverIP, connectionSharedSecret);
+      return internal::RemoteEventing::connectToRemote(connectionDelegate, serverIP, connectionSharedSecret, queue);
     }
 
     //-------------------------------------------------------------------------
@@ -2370,5 +2991,29 @@ namespace zsLib
       return internal::RemoteEventing::listenForRemote(connectionDelegate, localPort, connectionSharedSecret, maxWaitToBindTimeInSeconds);
     }
 
+    //-------------------------------------------------------------------------
+    IRemoteEventingPtr IRemoteEventing::replayFromFile(
+                                                       IRemoteEventingDelegatePtr connectionDelegate,
+                                                       const char *fileName,
+                                                       double speed
+                                                       ) throw (StdError)
+    {
+      ZS_THROW_INVALID_ARGUMENT_IF(!fileName);
+      return internal::RemoteEventing::replayFromFile(connectionDelegate, fileName, speed);
+    }
+
+    //-------------------------------------------------------------------------
+    PUID IRemoteEventing::getWritingRemoteID()
+    {
+      return internal::WritingRemoteScope::getWritingRemoteID();
+    }
+
+    //-------------------------------------------------------------------------
+    Time IRemoteEventing::getWritingEventTime()
+    {
+      if (0 == internal::WritingRemoteScope::getWritingRemoteID()) return zsLib::now();
+      return internal::WritingRemoteScope::getWritingEventTime();
+    }
+
   } // namespace eventing
 } // namespace zsLib
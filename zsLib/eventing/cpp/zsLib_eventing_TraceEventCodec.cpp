@@ -0,0 +1,342 @@
+/*
+
+Copyright (c) 2016, Robin Raymond
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are those
+of the authors and should not be interpreted as representing official policies,
+either expressed or implied, of the FreeBSD Project.
+
+*/
+
+
+#include <zsLib/eventing/internal/zsLib_eventing_TraceEventCodec.h>
+
+#include <zsLib/eventing/IHelper.h>
+#include <zsLib/eventing/Log.h>
+
+#include <zsLib/Log.h>
+
+namespace zsLib { namespace eventing { ZS_DECLARE_SUBSYSTEM(zsLib_eventing); } }
+
+namespace zsLib
+{
+  namespace eventing
+  {
+    namespace internal
+    {
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark TraceEventCodec
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      size_t TraceEventCodec::getEncodedSize(
+                                             EVENT_DATA_DESCRIPTOR_HANDLE dataDescriptor,
+                                             size_t dataDescriptorCount,
+                                             size_t maxDataSize
+                                             )
+      {
+        size_t result = (sizeof(CryptoPP::word16)*5) +
+                        (sizeof(uint8_t)*4) +
+                        (sizeof(uint64_t)*2) +
+                        (sizeof(CryptoPP::word16)*dataDescriptorCount) +
+                        (sizeof(CryptoPP::word32)*dataDescriptorCount);
+
+        for (size_t index = 0; index < dataDescriptorCount; ++index) {
+          auto &data = dataDescriptor[index];
+          if (!data.Ptr) continue;
+
+          size_t dataSize = static_cast<size_t>(data.Size);
+          if (dataSize > maxDataSize) dataSize = maxDataSize;
+          result += dataSize;
+        }
+
+        return result;
+      }
+
+      //-----------------------------------------------------------------------
+      void TraceEventCodec::encode(
+                                   ByteQueue &outQueue,
+                                   ProviderHandle handle,
+                                   Severity severity,
+                                   Level level,
+                                   EVENT_DESCRIPTOR_HANDLE descriptor,
+                                   EVENT_PARAMETER_DESCRIPTOR_HANDLE parameterDescriptor,
+                                   EVENT_DATA_DESCRIPTOR_HANDLE dataDescriptor,
+                                   size_t dataDescriptorCount,
+                                   size_t maxDataSize
+                                   )
+      {
+        uint64_t data64 {};
+        uint64_t eventingHandle {static_cast<uint64_t>(handle)};
+
+        IHelper::setBE64(&data64, eventingHandle);
+        outQueue.Put((const BYTE *)(&data64), sizeof(data64));
+
+        outQueue.PutWord16(static_cast<CryptoPP::word16>(severity));
+        outQueue.PutWord16(static_cast<CryptoPP::word16>(level));
+        outQueue.PutWord16(descriptor->Id);
+        outQueue.Put(descriptor->Version);
+        outQueue.Put(descriptor->Channel);
+        outQueue.Put(descriptor->Level);
+        outQueue.Put(descriptor->Opcode);
+        outQueue.PutWord16(descriptor->Task);
+
+        IHelper::setBE64(&data64, descriptor->Keyword);
+        outQueue.Put((const BYTE *)(&data64), sizeof(data64));
+
+        outQueue.PutWord16(static_cast<CryptoPP::word16>(dataDescriptorCount));
+
+        for (size_t index = 0; index < dataDescriptorCount; ++index) {
+          auto &param = parameterDescriptor[index];
+          outQueue.PutWord16(static_cast<uint16_t>(param.Type));
+        }
+
+        for (size_t index = 0; index < dataDescriptorCount; ++index) {
+          auto &data = dataDescriptor[index];
+
+          if (!data.Ptr) {
+            outQueue.PutWord32(static_cast<CryptoPP::word32>(0));
+            continue;
+          }
+
+          uint32_t dataSize = static_cast<uint32_t>(data.Size);
+          if (dataSize > maxDataSize) {
+            dataSize = static_cast<decltype(dataSize)>(maxDataSize);
+          }
+
+          bool endianFlip {true};
+
+          switch (parameterDescriptor[index].Type) {
+            case EventParameterType_Boolean:
+            case EventParameterType_UnsignedInteger:
+            case EventParameterType_SignedInteger:
+            case EventParameterType_Pointer:
+            case EventParameterType_FloatingPoint:  {
+              break;
+            }
+            default:                                {
+              endianFlip = false;
+              break;
+            }
+          }
+
+          if (endianFlip) {
+            switch (dataSize) {
+              case 2:
+              case 4:
+              case 8:   break;
+              default:  endianFlip = false; break;  // just put in raw format
+            }
+          }
+
+          outQueue.PutWord32(dataSize | (endianFlip ? (1 << 31) : 0));
+
+          if (!endianFlip) {
+            outQueue.Put((const BYTE *)(data.Ptr), dataSize);
+            continue;
+          }
+
+          switch (dataSize) {
+            case 2:  {
+              uint16_t value {};
+              memcpy(&value, (const void *)(data.Ptr), sizeof(value));
+              outQueue.PutWord16(value);
+              break;
+            }
+            case 4:  {
+              uint32_t value {};
+              memcpy(&value, (const void *)(data.Ptr), sizeof(value));
+              outQueue.PutWord32(value);
+              break;
+            }
+            case 8:  {
+              memcpy(&data64, (const void *)(data.Ptr), sizeof(data64));
+              IHelper::setBE64(&data64, data64);
+              outQueue.Put((const BYTE *)(&data64), sizeof(data64));
+              break;
+            }
+          }
+        }
+      }
+
+      //-----------------------------------------------------------------------
+      bool TraceEventCodec::peek(
+                                 const BYTE *buffer,
+                                 size_t bufferSize,
+                                 uint64_t &outHandle,
+                                 size_t &outEventID
+                                 )
+      {
+        if (bufferSize < sizeof(uint64_t) + (sizeof(CryptoPP::word16)*3)) return false;
+
+        outHandle = IHelper::getBE64(buffer);
+        outEventID = static_cast<size_t>(IHelper::getBE16(&(buffer[sizeof(uint64_t) + (sizeof(CryptoPP::word16)*2)])));
+        return true;
+      }
+
+      //-----------------------------------------------------------------------
+      bool TraceEventCodec::decode(
+                                   BYTE *buffer,
+                                   size_t bufferSize,
+                                   DecodedEvent &outEvent
+                                   )
+      {
+        size_t expectingBasicSize = (sizeof(CryptoPP::word16)*5) +
+                                    (sizeof(uint8_t)*4) +
+                                    (sizeof(uint64_t)*2);
+
+        if (bufferSize < expectingBasicSize) {
+          ZS_LOG_WARNING(Debug, slog("event did not contain enough header data") + ZS_PARAMIZE(expectingBasicSize) + ZS_PARAM("actual size", bufferSize));
+          return false;
+        }
+
+        BYTE *pos = buffer;
+
+        outEvent.mHandle = IHelper::getBE64(pos);
+        pos += sizeof(uint64_t);
+
+        outEvent.mSeverity = static_cast<Log::Severity>(IHelper::getBE16(pos));
+        pos += sizeof(uint16_t);
+        outEvent.mLevel = static_cast<Log::Level>(IHelper::getBE16(pos));
+        pos += sizeof(uint16_t);
+
+        if ((outEvent.mSeverity < Log::Severity_First) ||
+            (outEvent.mSeverity > Log::Severity_Last)) {
+          ZS_LOG_WARNING(Debug, slog("illegal severity") + ZS_PARAM("severity", outEvent.mSeverity));
+          return false;
+        }
+        if ((outEvent.mLevel < Log::Level_First) ||
+            (outEvent.mLevel > Log::Level_Last)) {
+          ZS_LOG_WARNING(Debug, slog("illegal level") + ZS_PARAM("level", outEvent.mLevel));
+          return false;
+        }
+
+        auto &descriptor = outEvent.mDescriptor;
+        descriptor.Id = IHelper::getBE16(pos);
+        pos += sizeof(uint16_t);
+        descriptor.Version = *pos;
+        pos += sizeof(uint8_t);
+        descriptor.Channel = *pos;
+        pos += sizeof(uint8_t);
+        descriptor.Level = *pos;
+        pos += sizeof(uint8_t);
+        descriptor.Opcode = *pos;
+        pos += sizeof(uint8_t);
+        descriptor.Task = IHelper::getBE16(pos);
+        pos += sizeof(uint16_t);
+        descriptor.Keyword = IHelper::getBE64(pos);
+        pos += sizeof(uint64_t);
+
+        size_t descriptorCount = IHelper::getBE16(pos);
+        pos += sizeof(uint16_t);
+
+        if (descriptorCount > ZSLIB_EVENTING_TRACE_EVENT_CODEC_MAX_DATA_DESCRIPTORS) {
+          ZS_LOG_WARNING(Debug, slog("event contains too many data descriptors") + ZS_PARAMIZE(descriptorCount));
+          return false;
+        }
+
+        outEvent.mDataDescriptorCount = descriptorCount;
+
+        size_t remaining = bufferSize - expectingBasicSize;
+
+        size_t expecting = (sizeof(uint16_t)*descriptorCount);
+        if (remaining < expecting) goto not_enough_data;
+
+        for (size_t index = 0; index < descriptorCount; ++index) {
+          outEvent.mParameterDescriptors[index].Type = static_cast<EventParameterTypes>(IHelper::getBE16(pos));
+          pos += sizeof(uint16_t);
+          remaining -= sizeof(uint16_t);
+        }
+
+        for (size_t index = 0; index < descriptorCount; ++index) {
+          expecting = sizeof(uint32_t);
+          if (remaining < expecting) goto not_enough_data;
+
+          uint32_t dataTypeSize = IHelper::getBE32(pos);
+          pos += sizeof(dataTypeSize);
+          remaining -= sizeof(dataTypeSize);
+
+          bool endianFlip {false};
+          if (0 != (dataTypeSize & (1 << 31))) {
+            endianFlip = true;
+            dataTypeSize = dataTypeSize & (0x7FFFFFFF);
+          }
+
+          expecting = dataTypeSize;
+          if (remaining < expecting) goto not_enough_data;
+
+          auto &data = outEvent.mDataDescriptors[index];
+          data.Size = dataTypeSize;
+          data.Ptr = (0 != dataTypeSize ? reinterpret_cast<uintptr_t>(pos) : 0);
+
+          if (endianFlip) {
+            switch (dataTypeSize) {
+              case 2: {
+                uint16_t value = IHelper::getBE16(pos);
+                memcpy(pos, &value, sizeof(value));
+                break;
+              }
+              case 4: {
+                uint32_t value = IHelper::getBE32(pos);
+                memcpy(pos, &value, sizeof(value));
+                break;
+              }
+              case 8: {
+                uint64_t value = IHelper::getBE64(pos);
+                memcpy(pos, &value, sizeof(value));
+                break;
+              }
+              default:  {
+                // just leave in original format
+                break;
+              }
+            }
+          }
+
+          pos += dataTypeSize;
+          remaining -= dataTypeSize;
+        }
+
+        return true;
+
+      not_enough_data:
+        {
+          ZS_LOG_WARNING(Debug, slog("event did not contain enough data") + ZS_PARAMIZE(expecting) + ZS_PARAMIZE(remaining) + ZS_PARAMIZE(bufferSize));
+        }
+        return false;
+      }
+
+      //-----------------------------------------------------------------------
+      Log::Params TraceEventCodec::slog(const char *message)
+      {
+        return Log::Params(message, "eventing::TraceEventCodec");
+      }
+
+    } // namespace internal
+  } // namespace eventing
+} // namespace zsLib
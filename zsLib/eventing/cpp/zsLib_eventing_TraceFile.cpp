@@ -0,0 +1,1544 @@
+/*
+
+Copyright (c) 2016, Robin Raymond
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are those
+of the authors and should not be interpreted as representing official policies,
+either expressed or implied, of the FreeBSD Project.
+
+*/
+
+
+#include <zsLib/eventing/internal/zsLib_eventing_TraceFile.h>
+#include <zsLib/eventing/internal/zsLib_eventing_TraceFileMerger.h>
+#include <zsLib/eventing/internal/zsLib_eventing_BlockCodec.h>
+#include <zsLib/eventing/internal/zsLib_eventing_RemoteEventing.h>
+#include <zsLib/eventing/internal/zsLib_eventing_TraceEventCodec.h>
+
+#include <zsLib/eventing/IHelper.h>
+
+#include <zsLib/ISettings.h>
+#include <zsLib/Log.h>
+#include <zsLib/Numeric.h>
+#include <zsLib/Singleton.h>
+
+#include <algorithm>
+
+#include <errno.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif //ndef _WIN32
+
+#define ZSLIB_EVENTING_TRACE_FILE_MAX_RECORD_SIZE (0x10000000)
+#define ZSLIB_EVENTING_TRACE_FILE_FOOTER_BASIC_SIZE ((sizeof(CryptoPP::word32)*2) + (sizeof(uint64_t)*3) + (sizeof(CryptoPP::word32)*2))
+#define ZSLIB_EVENTING_TRACE_FILE_EVENT_ID_BITMAP_SIZE (ITraceFileTypes::Bitmap_EventIDBits / 8)
+
+namespace zsLib { namespace eventing { ZS_DECLARE_SUBSYSTEM(zsLib_eventing); } }
+
+namespace zsLib
+{
+  namespace eventing
+  {
+    ZS_DECLARE_TYPEDEF_PTR(IHelper, UseEventingHelper);
+
+    namespace internal
+    {
+      ZS_DECLARE_CLASS_PTR(TraceFileSettingsDefaults);
+
+      //-------------------------------------------------------------------------
+      //-------------------------------------------------------------------------
+      //-------------------------------------------------------------------------
+      //-------------------------------------------------------------------------
+      #pragma mark
+      #pragma mark TraceFileSettingsDefaults
+      #pragma mark
+
+      class TraceFileSettingsDefaults : public ISettingsApplyDefaultsDelegate
+      {
+      public:
+        //-----------------------------------------------------------------------
+        ~TraceFileSettingsDefaults()
+        {
+          ISettings::removeDefaults(*this);
+        }
+
+        //-----------------------------------------------------------------------
+        static TraceFileSettingsDefaultsPtr singleton()
+        {
+          static SingletonLazySharedPtr<TraceFileSettingsDefaults> singleton(create());
+          return singleton.singleton();
+        }
+
+        //-----------------------------------------------------------------------
+        static TraceFileSettingsDefaultsPtr create()
+        {
+          auto pThis(make_shared<TraceFileSettingsDefaults>());
+          ISettings::installDefaults(pThis);
+          return pThis;
+        }
+
+        //-----------------------------------------------------------------------
+        virtual void notifySettingsApplyDefaults() override
+        {
+          ISettings::setUInt(ZSLIB_EVENTING_SETTING_TRACE_FILE_CHUNK_SIZE, (1024*1024));
+          ISettings::setBool(ZSLIB_EVENTING_SETTING_TRACE_FILE_COMPRESS, true);
+          ISettings::setUInt(ZSLIB_EVENTING_SETTING_TRACE_FILE_DICTIONARY_SIZE, (32*1024));
+          ISettings::setBool(ZSLIB_EVENTING_SETTING_TRACE_FILE_VERIFY_COMPRESSION, false);
+          ISettings::setBool(ZSLIB_EVENTING_SETTING_TRACE_FILE_INDEX_VALUES, false);
+        }
+      };
+
+      //-------------------------------------------------------------------------
+      void installTraceFileSettingsDefaults()
+      {
+        TraceFileSettingsDefaults::singleton();
+      }
+
+      //-------------------------------------------------------------------------
+      static uint64_t toMicroseconds(Time time)
+      {
+        return static_cast<uint64_t>(std::chrono::duration_cast<Microseconds>(time.time_since_epoch()).count());
+      }
+
+      //-------------------------------------------------------------------------
+      static Time fromMicroseconds(uint64_t value)
+      {
+        return Time(std::chrono::duration_cast<Time::duration>(Microseconds(static_cast<Microseconds::rep>(value))));
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark TraceFileWriter
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      TraceFileWriter::TraceFileWriter(
+                                       const make_private &,
+                                       const char *fileName,
+                                       size_t chunkSizeInBytes
+                                       ) :
+        mFileName(fileName),
+        mChunkSize(chunkSizeInBytes),
+        mCompress(ISettings::getBool(ZSLIB_EVENTING_SETTING_TRACE_FILE_COMPRESS)),
+        mMaxDictionarySize(static_cast<decltype(mMaxDictionarySize)>(ISettings::getUInt(ZSLIB_EVENTING_SETTING_TRACE_FILE_DICTIONARY_SIZE))),
+        mVerifyCompression(ISettings::getBool(ZSLIB_EVENTING_SETTING_TRACE_FILE_VERIFY_COMPRESSION)),
+        mIndexValues(ISettings::getBool(ZSLIB_EVENTING_SETTING_TRACE_FILE_INDEX_VALUES))
+      {
+        if (0 == mChunkSize) {
+          mChunkSize = static_cast<decltype(mChunkSize)>(ISettings::getUInt(ZSLIB_EVENTING_SETTING_TRACE_FILE_CHUNK_SIZE));
+        }
+        if (mChunkSize < ZSLIB_EVENTING_TRACE_FILE_MIN_CHUNK_SIZE) {
+          mChunkSize = ZSLIB_EVENTING_TRACE_FILE_MIN_CHUNK_SIZE;
+        }
+
+        ZS_LOG_DETAIL(log("Created") + ZS_PARAM("file", mFileName) + ZS_PARAM("chunk size", mChunkSize) + ZS_PARAM("compress", mCompress));
+      }
+
+      //-----------------------------------------------------------------------
+      TraceFileWriter::~TraceFileWriter()
+      {
+        mThisWeak.reset();
+        ZS_LOG_DETAIL(log("Destroyed"));
+
+        try {
+          close();
+        } catch (const StdError &e) {
+          ZS_LOG_WARNING(Basic, log("failed to close trace file") + ZS_PARAM("error", e.result()) + ZS_PARAM("reason", e.message()));
+        }
+      }
+
+      //-----------------------------------------------------------------------
+      void TraceFileWriter::init() throw (StdError)
+      {
+        String pathStr(mFileName);
+#ifdef _WIN32
+        pathStr.replaceAll("/", "\\");
+#endif //_WIN32
+
+        AutoRecursiveLock lock(mLock);
+
+#ifdef _WIN32
+        int error = fopen_s(&mFile, pathStr, "wb");
+#else
+        int error = 0;
+        mFile = fopen(pathStr, "wb");
+        if (!mFile) {
+          error = errno;
+        }
+#endif //_WIN32
+        if (NULL == mFile) {
+          ZS_THROW_CUSTOM_PROPERTIES_1(StdError, error, String("Failed to create trace file: ") + pathStr);
+        }
+
+        // the header is written with the first chunk once the dictionary
+        // can be trained from it
+        mCreationTime = zsLib::now();
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark TraceFileWriter => ITraceFileWriter
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      TraceFileWriterPtr TraceFileWriter::create(
+                                                 const char *fileName,
+                                                 size_t chunkSizeInBytes
+                                                 ) throw (StdError)
+      {
+        auto pThis = make_shared<TraceFileWriter>(make_private{}, fileName, chunkSizeInBytes);
+        pThis->mThisWeak = pThis;
+        pThis->init();
+        return pThis;
+      }
+
+      //-----------------------------------------------------------------------
+      void TraceFileWriter::setClockOffset(Microseconds offset)
+      {
+        AutoRecursiveLock lock(mLock);
+        mClockOffset = offset;
+      }
+
+      //-----------------------------------------------------------------------
+      void TraceFileWriter::writeRecord(
+                                        RecordTypes type,
+                                        Time time,
+                                        const BYTE *payload,
+                                        size_t payloadSize
+                                        ) throw (StdError)
+      {
+        if (payloadSize > ZSLIB_EVENTING_TRACE_FILE_MAX_RECORD_SIZE) {
+          ZS_THROW_CUSTOM_PROPERTIES_1(StdError, EINVAL, String("Trace file record is too large: ") + string(payloadSize));
+        }
+
+        uint64_t recordTime = toMicroseconds(time);
+        size_t recordSize = ZSLIB_EVENTING_TRACE_FILE_RECORD_HEADER_SIZE + payloadSize;
+
+        AutoRecursiveLock lock(mLock);
+        if (!mFile) {
+          ZS_THROW_CUSTOM_PROPERTIES_1(StdError, EBADF, String("Trace file is closed: ") + mFileName);
+        }
+
+        if ((mChunkRecords > 0) &&
+            (static_cast<size_t>(mChunk.CurrentSize()) + recordSize > mChunkSize)) {
+          flushChunk();
+        }
+
+        if (0 == mChunkRecords) {
+          // every chunk must be decodable on its own
+          appendAnnouncements(recordTime);
+        }
+
+        if (RecordType_Notify == type) {
+          updateAnnouncements(payload, payloadSize);
+        }
+
+        appendRecord(type, recordTime, payload, payloadSize);
+        ++mTotalRecords;
+      }
+
+      //-----------------------------------------------------------------------
+      void TraceFileWriter::close() throw (StdError)
+      {
+        AutoRecursiveLock lock(mLock);
+        if (!mFile) return;
+
+        try {
+          flushChunk();
+
+          if (!mWroteHeader) {
+            writeHeader(NULL, 0);
+          }
+
+          uint64_t indexOffset = mOffset;
+          size_t indexSize = (sizeof(CryptoPP::word32)*2) + (sizeof(uint64_t) * mFooterOffsets.size());
+
+          SecureByteBlock index(indexSize + ZSLIB_EVENTING_TRACE_FILE_TRAILER_SIZE);
+          BYTE *pos = index.BytePtr();
+
+          memcpy(pos, ZSLIB_EVENTING_TRACE_FILE_INDEX_MAGIC, strlen(ZSLIB_EVENTING_TRACE_FILE_INDEX_MAGIC));
+          pos += sizeof(CryptoPP::word32);
+          IHelper::setBE32(pos, static_cast<CryptoPP::word32>(mFooterOffsets.size()));
+          pos += sizeof(CryptoPP::word32);
+
+          for (auto iter = mFooterOffsets.begin(); iter != mFooterOffsets.end(); ++iter) {
+            IHelper::setBE64(pos, *iter);
+            pos += sizeof(uint64_t);
+          }
+
+          IHelper::setBE64(pos, indexOffset);
+          pos += sizeof(uint64_t);
+          IHelper::setBE32(pos, static_cast<CryptoPP::word32>(indexSize));
+          pos += sizeof(CryptoPP::word32);
+          memcpy(pos, ZSLIB_EVENTING_TRACE_FILE_MAGIC, strlen(ZSLIB_EVENTING_TRACE_FILE_MAGIC));
+
+          writeFile(index.BytePtr(), index.SizeInBytes());
+
+          // the clock offset is often only known after recording started
+          BYTE clockOffset[sizeof(uint64_t)] {};
+          IHelper::setBE64(&(clockOffset[0]), static_cast<uint64_t>(static_cast<int64_t>(mClockOffset.count())));
+          if ((0 != fseek(mFile, 24, SEEK_SET)) ||
+              (sizeof(clockOffset) != fwrite(&(clockOffset[0]), sizeof(BYTE), sizeof(clockOffset), mFile))) {
+            ZS_THROW_CUSTOM_PROPERTIES_1(StdError, errno, String("Failed to write trace file header: ") + mFileName);
+          }
+        } catch (const StdError &) {
+          fclose(mFile);
+          mFile = NULL;
+          throw;
+        }
+
+        auto result = fclose(mFile);
+        mFile = NULL;
+        if (0 != result) {
+          ZS_THROW_CUSTOM_PROPERTIES_1(StdError, errno, String("Failed to close trace file: ") + mFileName);
+        }
+
+        ZS_LOG_DEBUG(log("closed") + ZS_PARAM("records", mTotalRecords) + ZS_PARAM("chunks", mFooterOffsets.size()) + ZS_PARAM("size", mOffset));
+      }
+
+      //-----------------------------------------------------------------------
+      size_t TraceFileWriter::getTotalRecords() const
+      {
+        AutoRecursiveLock lock(mLock);
+        return mTotalRecords;
+      }
+
+      //-----------------------------------------------------------------------
+      TraceFileWriter::CompressionStats TraceFileWriter::getCompressionStats() const
+      {
+        AutoRecursiveLock lock(mLock);
+        return mCompressionStats;
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark TraceFileWriter => (internal)
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      Log::Params TraceFileWriter::log(const char *message) const
+      {
+        ElementPtr objectEl = Element::create("eventing::TraceFileWriter");
+        objectEl->adoptAsLastChild(UseEventingHelper::createElementWithNumber("id", string(mID)));
+        return Log::Params(message, objectEl);
+      }
+
+      //-----------------------------------------------------------------------
+      void TraceFileWriter::appendRecord(
+                                         RecordTypes type,
+                                         uint64_t time,
+                                         const BYTE *payload,
+                                         size_t payloadSize
+                                         )
+      {
+        BYTE header[ZSLIB_EVENTING_TRACE_FILE_RECORD_HEADER_SIZE] {};
+        IHelper::setBE32(&(header[0]), static_cast<CryptoPP::word32>(sizeof(CryptoPP::word32) + sizeof(uint64_t) + payloadSize));
+        IHelper::setBE32(&(header[sizeof(CryptoPP::word32)]), static_cast<CryptoPP::word32>(type));
+        IHelper::setBE64(&(header[sizeof(CryptoPP::word32)*2]), time);
+
+        mChunk.Put(&(header[0]), sizeof(header));
+        if (payloadSize > 0) {
+          mChunk.Put(payload, payloadSize);
+        }
+
+        // records from several sources are not guaranteed to be in order
+        if ((0 == mChunkRecords) || (time < mChunkFirstTime)) mChunkFirstTime = time;
+        if ((0 == mChunkRecords) || (time > mChunkLastTime)) mChunkLastTime = time;
+        ++mChunkRecords;
+
+        if (RecordType_TraceEvent != type) return;
+
+        uint64_t handle {};
+        size_t eventID {};
+        if (!TraceEventCodec::peek(payload, payloadSize, handle, eventID)) return;
+
+        mChunkProviderHandles.insert(handle);
+        mChunkEventIDs.set(eventID % Bitmap_EventIDBits);
+
+        if (mIndexValues) {
+          indexValues(payload, payloadSize);
+        }
+      }
+
+      //-----------------------------------------------------------------------
+      void TraceFileWriter::indexValues(
+                                        const BYTE *payload,
+                                        size_t payloadSize
+                                        )
+      {
+        // the payload is decoded within a copy as decoding is done in place
+        if (mDecodeBuffer.SizeInBytes() < payloadSize) {
+          mDecodeBuffer.New(payloadSize);
+        }
+        memcpy(mDecodeBuffer.BytePtr(), payload, payloadSize);
+
+        TraceEvent event;
+        if (!TraceEventCodec::decode(mDecodeBuffer.BytePtr(), payloadSize, event)) return;
+
+        for (size_t index = 0; index < event.mDataDescriptorCount; ++index) {
+          bool isNumber = false;
+          String value = valueAsString(event.mParameterDescriptors[index], event.mDataDescriptors[index], isNumber);
+          mChunkValueHashes.insert(ValueFilter::hash(value));
+        }
+      }
+
+      //-----------------------------------------------------------------------
+      void TraceFileWriter::appendAnnouncements(uint64_t time)
+      {
+        for (auto iter = mSubsystemAnnouncements.begin(); iter != mSubsystemAnnouncements.end(); ++iter) {
+          auto &message = (*iter).second;
+          appendRecord(RecordType_Notify, time, reinterpret_cast<const BYTE *>(message.c_str()), message.length());
+        }
+        for (auto iter = mProviderAnnouncements.begin(); iter != mProviderAnnouncements.end(); ++iter) {
+          auto &message = (*iter).second;
+          appendRecord(RecordType_Notify, time, reinterpret_cast<const BYTE *>(message.c_str()), message.length());
+        }
+        for (auto iter = mProviderLoggingAnnouncements.begin(); iter != mProviderLoggingAnnouncements.end(); ++iter) {
+          auto &message = (*iter).second;
+          appendRecord(RecordType_Notify, time, reinterpret_cast<const BYTE *>(message.c_str()), message.length());
+        }
+      }
+
+      //-----------------------------------------------------------------------
+      void TraceFileWriter::updateAnnouncements(
+                                                const BYTE *payload,
+                                                size_t payloadSize
+                                                )
+      {
+        String message(std::string(reinterpret_cast<const char *>(payload), payloadSize));
+
+        ElementPtr rootEl = IHelper::toJSON(message);
+        if (!rootEl) return;
+
+        String typeStr = IHelper::getElementText(rootEl->findFirstChildElement("type"));
+
+        if (ZSLIB_EVENTING_REMOTE_EVENTING_NOTIFY_SUBSYSTEM == typeStr) {
+          String nameStr = IHelper::getElementText(rootEl->findFirstChildElement("name"));
+          mSubsystemAnnouncements[nameStr] = message;
+          return;
+        }
+
+        bool isProvider = (ZSLIB_EVENTING_REMOTE_EVENTING_NOTIFY_PROVIDER == typeStr);
+        bool isProviderLogging = (ZSLIB_EVENTING_REMOTE_EVENTING_NOTIFY_PROVIDER_KEYWORD_LOGGING == typeStr);
+        if ((!isProvider) && (!isProviderLogging)) return;
+
+        String handleStr = IHelper::getElementText(rootEl->findLastChildElement("handle"));
+
+        uint64_t handle {};
+        try {
+          handle = Numeric<uint64_t>(handleStr);
+        } catch (const Numeric<uint64_t>::ValueOutOfRange &) {
+          ZS_LOG_WARNING(Debug, log("provider handle is not valid") + ZS_PARAMIZE(handleStr));
+          return;
+        }
+
+        if (isProviderLogging) {
+          mProviderLoggingAnnouncements[handle] = message;
+          return;
+        }
+
+        if (IHelper::getElementText(rootEl->findLastChildElement("gone")).hasData()) {
+          mProviderAnnouncements.erase(handle);
+          mProviderLoggingAnnouncements.erase(handle);
+          return;
+        }
+
+        mProviderAnnouncements[handle] = message;
+      }
+
+      //-----------------------------------------------------------------------
+      void TraceFileWriter::writeHeader(
+                                        const BYTE *samples,
+                                        size_t samplesSize
+                                        ) throw (StdError)
+      {
+        mWroteHeader = true;
+
+        if ((mCompress) &&
+            (samples) &&
+            (0 != mMaxDictionarySize)) {
+          // a small first chunk must not produce a dictionary that outweighs
+          // the data it helps to compress
+          mDictionary = BlockCodec::trainDictionary(samples, samplesSize, std::min(mMaxDictionarySize, samplesSize / 8));
+        }
+
+        size_t dictionarySize = (mDictionary ? mDictionary->SizeInBytes() : 0);
+        size_t headerSize = ZSLIB_EVENTING_TRACE_FILE_HEADER_SIZE + dictionarySize;
+
+        SecureByteBlock header(headerSize);
+        memset(header.BytePtr(), 0, headerSize);
+
+        memcpy(&(header[0]), ZSLIB_EVENTING_TRACE_FILE_MAGIC, strlen(ZSLIB_EVENTING_TRACE_FILE_MAGIC));
+        IHelper::setBE32(&(header[4]), ZSLIB_EVENTING_TRACE_FILE_VERSION);
+        IHelper::setBE32(&(header[8]), static_cast<CryptoPP::word32>(headerSize));
+        IHelper::setBE64(&(header[16]), toMicroseconds(mCreationTime));
+        IHelper::setBE64(&(header[32]), static_cast<uint64_t>(mChunkSize));
+        IHelper::setBE32(&(header[40]), static_cast<CryptoPP::word32>(dictionarySize));
+        if (0 != dictionarySize) {
+          memcpy(&(header[ZSLIB_EVENTING_TRACE_FILE_HEADER_SIZE]), mDictionary->BytePtr(), dictionarySize);
+        }
+
+        writeFile(header.BytePtr(), header.SizeInBytes());
+      }
+
+      //-----------------------------------------------------------------------
+      void TraceFileWriter::flushChunk() throw (StdError)
+      {
+        if (0 == mChunkRecords) return;
+
+        size_t recordsSize = static_cast<size_t>(mChunk.CurrentSize());
+        SecureByteBlock records(recordsSize);
+        mChunk.Get(records.BytePtr(), recordsSize);
+
+        if (!mWroteHeader) {
+          writeHeader(records.BytePtr(), recordsSize);
+        }
+
+        uint64_t chunkOffset = mOffset;
+        writeBlock(records.BytePtr(), recordsSize);
+        uint64_t dataSize = mOffset - chunkOffset;
+
+        ValueFilter values;
+        if (mChunkValueHashes.size() > 0) {
+          size_t totalBits = mChunkValueHashes.size() * ZSLIB_EVENTING_TRACE_FILE_VALUE_FILTER_BITS_PER_VALUE;
+          values.mTotalHashes = ZSLIB_EVENTING_TRACE_FILE_VALUE_FILTER_HASHES;
+          values.mBits.resize((totalBits + 7) / 8);
+          for (auto iter = mChunkValueHashes.begin(); iter != mChunkValueHashes.end(); ++iter) {
+            values.insertHash(*iter);
+          }
+        }
+
+        size_t footerSize = ZSLIB_EVENTING_TRACE_FILE_FOOTER_BASIC_SIZE +
+                            (sizeof(uint64_t) * mChunkProviderHandles.size()) +
+                            ZSLIB_EVENTING_TRACE_FILE_EVENT_ID_BITMAP_SIZE +
+                            (values.hasData() ? ((sizeof(CryptoPP::word32)*2) + values.mBits.size()) : 0);
+
+        SecureByteBlock footer(footerSize);
+        BYTE *pos = footer.BytePtr();
+        memset(pos, 0, footerSize);
+
+        memcpy(pos, ZSLIB_EVENTING_TRACE_FILE_CHUNK_MAGIC, strlen(ZSLIB_EVENTING_TRACE_FILE_CHUNK_MAGIC));
+        pos += sizeof(CryptoPP::word32);
+        IHelper::setBE32(pos, static_cast<CryptoPP::word32>(footerSize));
+        pos += sizeof(CryptoPP::word32);
+        IHelper::setBE64(pos, dataSize);
+        pos += sizeof(uint64_t);
+        IHelper::setBE64(pos, mChunkFirstTime);
+        pos += sizeof(uint64_t);
+        IHelper::setBE64(pos, mChunkLastTime);
+        pos += sizeof(uint64_t);
+        IHelper::setBE32(pos, static_cast<CryptoPP::word32>(mChunkRecords));
+        pos += sizeof(CryptoPP::word32);
+        IHelper::setBE32(pos, static_cast<CryptoPP::word32>(mChunkProviderHandles.size()));
+        pos += sizeof(CryptoPP::word32);
+
+        for (auto iter = mChunkProviderHandles.begin(); iter != mChunkProviderHandles.end(); ++iter) {
+          IHelper::setBE64(pos, *iter);
+          pos += sizeof(uint64_t);
+        }
+
+        for (size_t index = 0; index < Bitmap_EventIDBits; ++index) {
+          if (!mChunkEventIDs.test(index)) continue;
+          pos[index / 8] |= static_cast<BYTE>(1 << (index % 8));
+        }
+        pos += ZSLIB_EVENTING_TRACE_FILE_EVENT_ID_BITMAP_SIZE;
+
+        if (values.hasData()) {
+          IHelper::setBE32(pos, static_cast<CryptoPP::word32>(values.mTotalHashes));
+          pos += sizeof(CryptoPP::word32);
+          IHelper::setBE32(pos, static_cast<CryptoPP::word32>(values.mBits.size()));
+          pos += sizeof(CryptoPP::word32);
+          memcpy(pos, &(values.mBits[0]), values.mBits.size());
+        }
+
+        uint64_t footerOffset = mOffset;
+        writeFile(footer.BytePtr(), footer.SizeInBytes());
+        mFooterOffsets.push_back(footerOffset);
+
+        mChunkRecords = 0;
+        mChunkFirstTime = 0;
+        mChunkLastTime = 0;
+        mChunkProviderHandles.clear();
+        mChunkEventIDs.reset();
+        mChunkValueHashes.clear();
+      }
+
+      //-----------------------------------------------------------------------
+      void TraceFileWriter::writeBlock(
+                                       const BYTE *data,
+                                       size_t dataSize
+                                       ) throw (StdError)
+      {
+        BlockCodecs codec = BlockCodec_Stored;
+        const BYTE *stored = data;
+        size_t storedSize = dataSize;
+
+        SecureByteBlock compressed;
+
+        if (mCompress) {
+          size_t dictionarySize = (mDictionary ? mDictionary->SizeInBytes() : 0);
+
+          SecureByteBlock window(dictionarySize + dataSize);
+          if (0 != dictionarySize) {
+            memcpy(window.BytePtr(), mDictionary->BytePtr(), dictionarySize);
+          }
+          memcpy(window.BytePtr() + dictionarySize, data, dataSize);
+
+          auto compressStart = std::chrono::steady_clock::now();
+
+          compressed.New(BlockCodec::getMaxCompressedSize(dataSize));
+          size_t compressedSize = BlockCodec::compress(window.BytePtr(), dictionarySize, window.SizeInBytes(), compressed.BytePtr());
+
+          mCompressionStats.mCompressTime += std::chrono::duration_cast<Microseconds>(std::chrono::steady_clock::now() - compressStart);
+
+          // data that does not compress is kept as is
+          bool useCompressed = (compressedSize < dataSize);
+
+          // the block must decode back to exactly what was given before it
+          // can replace the data in the file
+          if ((useCompressed) &&
+              (mVerifyCompression)) {
+            if (mVerifyWindow.SizeInBytes() < window.SizeInBytes()) {
+              mVerifyWindow.New(window.SizeInBytes());
+            }
+            if (0 != dictionarySize) {
+              memcpy(mVerifyWindow.BytePtr(), mDictionary->BytePtr(), dictionarySize);
+            }
+
+            auto verifyStart = std::chrono::steady_clock::now();
+            bool decoded = BlockCodec::decompress(mVerifyWindow.BytePtr(), dictionarySize, compressed.BytePtr(), compressedSize, dataSize);
+            mCompressionStats.mVerifyTime += std::chrono::duration_cast<Microseconds>(std::chrono::steady_clock::now() - verifyStart);
+            mCompressionStats.mVerifiedBytes += dataSize;
+
+            if ((!decoded) ||
+                (0 != memcmp(mVerifyWindow.BytePtr() + dictionarySize, data, dataSize))) {
+              ZS_LOG_WARNING(Detail, log("compressed block does not decode to its data (stored uncompressed)") + ZS_PARAM("size", dataSize) + ZS_PARAM("compressed size", compressedSize));
+              ++(mCompressionStats.mTotalVerifyFailures);
+              useCompressed = false;
+            }
+          }
+
+          if (useCompressed) {
+            codec = BlockCodec_LZ;
+            stored = compressed.BytePtr();
+            storedSize = compressedSize;
+            ++(mCompressionStats.mTotalCompressedBlocks);
+          }
+        }
+
+        ++(mCompressionStats.mTotalBlocks);
+        mCompressionStats.mInputBytes += dataSize;
+        mCompressionStats.mStoredBytes += storedSize;
+
+        BYTE header[ZSLIB_EVENTING_TRACE_FILE_BLOCK_HEADER_SIZE] {};
+        memcpy(&(header[0]), ZSLIB_EVENTING_TRACE_FILE_BLOCK_MAGIC, strlen(ZSLIB_EVENTING_TRACE_FILE_BLOCK_MAGIC));
+        IHelper::setBE32(&(header[sizeof(CryptoPP::word32)]), static_cast<CryptoPP::word32>(codec));
+        IHelper::setBE32(&(header[sizeof(CryptoPP::word32)*2]), static_cast<CryptoPP::word32>(dataSize));
+        IHelper::setBE32(&(header[sizeof(CryptoPP::word32)*3]), static_cast<CryptoPP::word32>(storedSize));
+
+        writeFile(&(header[0]), sizeof(header));
+        writeFile(stored, storedSize);
+      }
+
+      //-----------------------------------------------------------------------
+      void TraceFileWriter::writeFile(
+                                      const BYTE *buffer,
+                                      size_t length
+                                      ) throw (StdError)
+      {
+        auto written = fwrite(buffer, sizeof(BYTE), length, mFile);
+        if (written != length) {
+          ZS_THROW_CUSTOM_PROPERTIES_1(StdError, ferror(mFile), String("Failed to write trace file: ") + mFileName + ", written=" + string(written) + ", buffer size=" + string(length));
+        }
+        mOffset += length;
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark TraceFileReader
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      TraceFileReader::TraceFileReader(
+                                       const make_private &,
+                                       const char *fileName
+                                       ) :
+        mFileName(fileName),
+        mChunks(make_shared<ChunkInfoList>())
+      {
+        ZS_LOG_DETAIL(log("Created") + ZS_PARAM("file", mFileName));
+      }
+
+      //-----------------------------------------------------------------------
+      TraceFileReader::~TraceFileReader()
+      {
+        mThisWeak.reset();
+        ZS_LOG_DETAIL(log("Destroyed"));
+        unmapFile();
+      }
+
+      //-----------------------------------------------------------------------
+      void TraceFileReader::init() throw (StdError)
+      {
+        AutoRecursiveLock lock(mLock);
+
+        mapFile();
+
+        if ((mMappedSize < ZSLIB_EVENTING_TRACE_FILE_HEADER_SIZE) ||
+            (0 != memcmp(mMapped, ZSLIB_EVENTING_TRACE_FILE_MAGIC, strlen(ZSLIB_EVENTING_TRACE_FILE_MAGIC)))) {
+          unmapFile();
+          ZS_THROW_CUSTOM_PROPERTIES_1(StdError, EINVAL, String("Not a trace file: ") + mFileName);
+        }
+
+        auto version = IHelper::getBE32(&(mMapped[4]));
+        auto headerSize = IHelper::getBE32(&(mMapped[8]));
+        if ((version != ZSLIB_EVENTING_TRACE_FILE_VERSION) ||
+            (headerSize < ZSLIB_EVENTING_TRACE_FILE_HEADER_SIZE) ||
+            (headerSize > mMappedSize)) {
+          unmapFile();
+          ZS_THROW_CUSTOM_PROPERTIES_1(StdError, EINVAL, String("Trace file version is not supported: ") + mFileName + ", version=" + string(version));
+        }
+
+        mHeaderSize = static_cast<size_t>(headerSize);
+
+        mDictionarySize = static_cast<size_t>(IHelper::getBE32(&(mMapped[40])));
+        if (ZSLIB_EVENTING_TRACE_FILE_HEADER_SIZE + mDictionarySize > mHeaderSize) {
+          unmapFile();
+          ZS_THROW_CUSTOM_PROPERTIES_1(StdError, EINVAL, String("Trace file header is not legal: ") + mFileName + ", dictionary size=" + string(mDictionarySize));
+        }
+        mDictionary = (0 != mDictionarySize ? &(mMapped[ZSLIB_EVENTING_TRACE_FILE_HEADER_SIZE]) : NULL);
+
+        mCreationTime = fromMicroseconds(IHelper::getBE64(&(mMapped[16])));
+        mClockOffset = Microseconds(static_cast<Microseconds::rep>(static_cast<int64_t>(IHelper::getBE64(&(mMapped[24])))));
+
+        if (!readIndex()) {
+          recoverIndex();
+        }
+
+        ZS_LOG_DEBUG(log("opened") + ZS_PARAM("chunks", mChunks->size()) + ZS_PARAM("size", mMappedSize));
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark TraceFileReader => ITraceFileReader
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      TraceFileReaderPtr TraceFileReader::open(const char *fileName) throw (StdError)
+      {
+        auto pThis = make_shared<TraceFileReader>(make_private{}, fileName);
+        pThis->mThisWeak = pThis;
+        pThis->init();
+        return pThis;
+      }
+
+      //-----------------------------------------------------------------------
+      TraceFileReader::ChunkInfoListPtr TraceFileReader::findChunks(
+                                                                    Time fromTime,
+                                                                    Time toTime,
+                                                                    const Optional<uint64_t> &providerHandle,
+                                                                    const Optional<size_t> &eventID
+                                                                    ) const
+      {
+        ChunkInfoListPtr result(make_shared<ChunkInfoList>());
+
+        for (auto iter = mChunks->begin(); iter != mChunks->end(); ++iter) {
+          auto &chunk = (*iter);
+
+          if (chunk.mLastTime < fromTime) continue;
+          if (chunk.mFirstTime > toTime) continue;
+
+          if ((providerHandle.hasValue()) &&
+              (chunk.mProviderHandles.end() == chunk.mProviderHandles.find(providerHandle.value()))) continue;
+          if ((eventID.hasValue()) &&
+              (!chunk.mightContainEventID(eventID.value()))) continue;
+
+          result->push_back(chunk);
+        }
+
+        return result;
+      }
+
+      //-----------------------------------------------------------------------
+      void TraceFileReader::seekToChunk(size_t chunkIndex)
+      {
+        AutoRecursiveLock lock(mLock);
+        mState.seekToChunk(chunkIndex);
+      }
+
+      //-----------------------------------------------------------------------
+      void TraceFileReader::seek(Time time)
+      {
+        size_t chunkIndex = 0;
+        for (; chunkIndex < mChunks->size(); ++chunkIndex) {
+          if ((*mChunks)[chunkIndex].mLastTime >= time) break;
+        }
+        seekToChunk(chunkIndex);
+      }
+
+      //-----------------------------------------------------------------------
+      bool TraceFileReader::readNext(Record &outRecord)
+      {
+        AutoRecursiveLock lock(mLock);
+
+        while (mState.mCurrentChunk < mChunks->size()) {
+          if (readRecord(mState, outRecord)) return true;
+          mState.seekToChunk(mState.mCurrentChunk + 1);
+        }
+
+        return false;
+      }
+
+      //-----------------------------------------------------------------------
+      bool TraceFileReader::readNextInChunk(Record &outRecord)
+      {
+        AutoRecursiveLock lock(mLock);
+
+        if (mState.mCurrentChunk >= mChunks->size()) return false;
+        return readRecord(mState, outRecord);
+      }
+
+      //-----------------------------------------------------------------------
+      ITraceFileChunkCursorPtr TraceFileReader::createChunkCursor()
+      {
+        return TraceFileChunkCursor::create(mThisWeak.lock());
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark TraceFileReader => (internal)
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      Log::Params TraceFileReader::log(const char *message) const
+      {
+        ElementPtr objectEl = Element::create("eventing::TraceFileReader");
+        objectEl->adoptAsLastChild(UseEventingHelper::createElementWithNumber("id", string(mID)));
+        return Log::Params(message, objectEl);
+      }
+
+      //-----------------------------------------------------------------------
+      void TraceFileReader::mapFile() throw (StdError)
+      {
+        String pathStr(mFileName);
+
+#ifdef _WIN32
+        pathStr.replaceAll("/", "\\");
+
+        mFile = CreateFileA(pathStr, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (INVALID_HANDLE_VALUE == mFile) {
+          ZS_THROW_CUSTOM_PROPERTIES_1(StdError, static_cast<int>(GetLastError()), String("Failed to open trace file: ") + pathStr);
+        }
+
+        LARGE_INTEGER fileSize {};
+        if (!GetFileSizeEx(mFile, &fileSize)) {
+          auto error = static_cast<int>(GetLastError());
+          unmapFile();
+          ZS_THROW_CUSTOM_PROPERTIES_1(StdError, error, String("Failed to size trace file: ") + pathStr);
+        }
+        mMappedSize = static_cast<size_t>(fileSize.QuadPart);
+        if (0 == mMappedSize) return;
+
+        mFileMapping = CreateFileMappingA(mFile, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (NULL == mFileMapping) {
+          auto error = static_cast<int>(GetLastError());
+          unmapFile();
+          ZS_THROW_CUSTOM_PROPERTIES_1(StdError, error, String("Failed to map trace file: ") + pathStr);
+        }
+
+        mMapped = reinterpret_cast<const BYTE *>(MapViewOfFile(mFileMapping, FILE_MAP_READ, 0, 0, mMappedSize));
+        if (NULL == mMapped) {
+          auto error = static_cast<int>(GetLastError());
+          unmapFile();
+          ZS_THROW_CUSTOM_PROPERTIES_1(StdError, error, String("Failed to map trace file: ") + pathStr);
+        }
+#else
+        mFile = ::open(pathStr, O_RDONLY);
+        if (mFile < 0) {
+          ZS_THROW_CUSTOM_PROPERTIES_1(StdError, errno, String("Failed to open trace file: ") + pathStr);
+        }
+
+        struct stat fileStat {};
+        if (0 != fstat(mFile, &fileStat)) {
+          auto error = errno;
+          unmapFile();
+          ZS_THROW_CUSTOM_PROPERTIES_1(StdError, error, String("Failed to size trace file: ") + pathStr);
+        }
+        mMappedSize = static_cast<size_t>(fileStat.st_size);
+        if (0 == mMappedSize) return;
+
+        void *mapped = mmap(NULL, mMappedSize, PROT_READ, MAP_SHARED, mFile, 0);
+        if (MAP_FAILED == mapped) {
+          auto error = errno;
+          unmapFile();
+          ZS_THROW_CUSTOM_PROPERTIES_1(StdError, error, String("Failed to map trace file: ") + pathStr);
+        }
+        mMapped = reinterpret_cast<const BYTE *>(mapped);
+#endif //_WIN32
+      }
+
+      //-----------------------------------------------------------------------
+      void TraceFileReader::unmapFile()
+      {
+#ifdef _WIN32
+        if (mMapped) {
+          UnmapViewOfFile(mMapped);
+          mMapped = NULL;
+        }
+        if (NULL != mFileMapping) {
+          CloseHandle(mFileMapping);
+          mFileMapping = NULL;
+        }
+        if (INVALID_HANDLE_VALUE != mFile) {
+          CloseHandle(mFile);
+          mFile = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (mMapped) {
+          munmap(const_cast<BYTE *>(mMapped), mMappedSize);
+          mMapped = NULL;
+        }
+        if (mFile >= 0) {
+          ::close(mFile);
+          mFile = -1;
+        }
+#endif //_WIN32
+        mMappedSize = 0;
+      }
+
+      //-----------------------------------------------------------------------
+      bool TraceFileReader::loadChunk(ChunkState &ioState) const
+      {
+        if (ioState.mChunkData) return true;
+
+        auto &chunk = (*mChunks)[ioState.mCurrentChunk];
+        const BYTE *data = &(mMapped[chunk.mOffset]);
+
+        if ((chunk.mDataSize < ZSLIB_EVENTING_TRACE_FILE_BLOCK_HEADER_SIZE) ||
+            (0 != memcmp(data, ZSLIB_EVENTING_TRACE_FILE_BLOCK_MAGIC, strlen(ZSLIB_EVENTING_TRACE_FILE_BLOCK_MAGIC)))) {
+          ZS_LOG_WARNING(Detail, log("chunk block is not legal (skipping chunk)") + ZS_PARAM("chunk", ioState.mCurrentChunk));
+          return false;
+        }
+
+        auto codec = IHelper::getBE32(&(data[sizeof(CryptoPP::word32)]));
+        size_t decodedSize = static_cast<size_t>(IHelper::getBE32(&(data[sizeof(CryptoPP::word32)*2])));
+        size_t storedSize = static_cast<size_t>(IHelper::getBE32(&(data[sizeof(CryptoPP::word32)*3])));
+        const BYTE *stored = &(data[ZSLIB_EVENTING_TRACE_FILE_BLOCK_HEADER_SIZE]);
+
+        if (ZSLIB_EVENTING_TRACE_FILE_BLOCK_HEADER_SIZE + storedSize > chunk.mDataSize) {
+          ZS_LOG_WARNING(Detail, log("chunk block size is not legal (skipping chunk)") + ZS_PARAM("chunk", ioState.mCurrentChunk) + ZS_PARAM("stored size", storedSize));
+          return false;
+        }
+
+        switch (codec) {
+          case BlockCodec_Stored: {
+            if (storedSize != decodedSize) break;
+            ioState.mChunkData = stored;
+            ioState.mChunkDataSize = storedSize;
+            return true;
+          }
+          case BlockCodec_LZ: {
+            // the window keeps the dictionary in front of the decoded data
+            // and is only rebuilt when a larger chunk is found
+            size_t windowSize = mDictionarySize + decodedSize;
+            if (ioState.mChunkWindow.SizeInBytes() < windowSize) {
+              ioState.mChunkWindow.New(windowSize);
+              if (0 != mDictionarySize) {
+                memcpy(ioState.mChunkWindow.BytePtr(), mDictionary, mDictionarySize);
+              }
+            }
+
+            if (!BlockCodec::decompress(ioState.mChunkWindow.BytePtr(), mDictionarySize, stored, storedSize, decodedSize)) break;
+
+            ioState.mChunkData = ioState.mChunkWindow.BytePtr() + mDictionarySize;
+            ioState.mChunkDataSize = decodedSize;
+            return true;
+          }
+          default: break;
+        }
+
+        ZS_LOG_WARNING(Detail, log("chunk block could not be decoded (skipping chunk)") + ZS_PARAM("chunk", ioState.mCurrentChunk) + ZS_PARAM("codec", codec));
+        return false;
+      }
+
+      //-----------------------------------------------------------------------
+      bool TraceFileReader::readRecord(
+                                       ChunkState &ioState,
+                                       Record &outRecord
+                                       ) const
+      {
+        if (!loadChunk(ioState)) return false;
+
+        if (ioState.mPosition + ZSLIB_EVENTING_TRACE_FILE_RECORD_HEADER_SIZE > ioState.mChunkDataSize) return false;
+
+        const BYTE *record = &(ioState.mChunkData[ioState.mPosition]);
+        size_t recordSize = static_cast<size_t>(IHelper::getBE32(record));
+
+        if ((recordSize < sizeof(CryptoPP::word32) + sizeof(uint64_t)) ||
+            (ioState.mPosition + sizeof(CryptoPP::word32) + recordSize > ioState.mChunkDataSize)) {
+          ZS_LOG_WARNING(Detail, log("record size is not legal (skipping remainder of chunk)") + ZS_PARAM("chunk", ioState.mCurrentChunk) + ZS_PARAM("position", ioState.mPosition));
+          ioState.mPosition = ioState.mChunkDataSize;
+          return false;
+        }
+
+        outRecord.mType = static_cast<RecordTypes>(IHelper::getBE32(&(record[sizeof(CryptoPP::word32)])));
+        outRecord.mTime = fromMicroseconds(IHelper::getBE64(&(record[sizeof(CryptoPP::word32)*2])));
+        outRecord.mPayload = &(record[ZSLIB_EVENTING_TRACE_FILE_RECORD_HEADER_SIZE]);
+        outRecord.mPayloadSize = recordSize - sizeof(CryptoPP::word32) - sizeof(uint64_t);
+
+        ioState.mPosition += sizeof(CryptoPP::word32) + recordSize;
+        return true;
+      }
+
+      //-----------------------------------------------------------------------
+      bool TraceFileReader::readIndex()
+      {
+        size_t headerSize = static_cast<size_t>(IHelper::getBE32(&(mMapped[8])));
+        if (mMappedSize < headerSize + ZSLIB_EVENTING_TRACE_FILE_TRAILER_SIZE) return false;
+
+        const BYTE *trailer = &(mMapped[mMappedSize - ZSLIB_EVENTING_TRACE_FILE_TRAILER_SIZE]);
+        if (0 != memcmp(&(trailer[sizeof(uint64_t) + sizeof(CryptoPP::word32)]), ZSLIB_EVENTING_TRACE_FILE_MAGIC, strlen(ZSLIB_EVENTING_TRACE_FILE_MAGIC))) {
+          ZS_LOG_WARNING(Detail, log("trace file has no index (file was not closed)"));
+          return false;
+        }
+
+        uint64_t indexOffset = IHelper::getBE64(trailer);
+        size_t indexSize = static_cast<size_t>(IHelper::getBE32(&(trailer[sizeof(uint64_t)])));
+
+        if ((indexOffset < headerSize) ||
+            (indexSize < sizeof(CryptoPP::word32)*2) ||
+            (indexOffset + indexSize != mMappedSize - ZSLIB_EVENTING_TRACE_FILE_TRAILER_SIZE)) {
+          ZS_LOG_WARNING(Detail, log("trace file index location is not legal") + ZS_PARAM("offset", indexOffset) + ZS_PARAM("size", indexSize));
+          return false;
+        }
+
+        const BYTE *index = &(mMapped[indexOffset]);
+        if (0 != memcmp(index, ZSLIB_EVENTING_TRACE_FILE_INDEX_MAGIC, strlen(ZSLIB_EVENTING_TRACE_FILE_INDEX_MAGIC))) return false;
+
+        size_t totalChunks = static_cast<size_t>(IHelper::getBE32(&(index[sizeof(CryptoPP::word32)])));
+        if ((sizeof(CryptoPP::word32)*2) + (sizeof(uint64_t) * totalChunks) != indexSize) return false;
+
+        ChunkInfoListPtr chunks(make_shared<ChunkInfoList>());
+        chunks->reserve(totalChunks);
+
+        const BYTE *pos = &(index[sizeof(CryptoPP::word32)*2]);
+        uint64_t minimumOffset = headerSize;
+        for (size_t loop = 0; loop < totalChunks; ++loop, pos += sizeof(uint64_t)) {
+          ChunkInfo info;
+          if (!readFooter(IHelper::getBE64(pos), info)) return false;
+          if (info.mOffset < minimumOffset) return false;
+
+          minimumOffset = info.mOffset + info.mDataSize;
+          info.mIndex = chunks->size();
+          chunks->push_back(info);
+        }
+
+        mChunks = chunks;
+        return true;
+      }
+
+      //-----------------------------------------------------------------------
+      void TraceFileReader::recoverIndex()
+      {
+        ChunkInfoListPtr chunks(make_shared<ChunkInfoList>());
+
+        uint64_t position = static_cast<uint64_t>(IHelper::getBE32(&(mMapped[8])));
+        uint64_t chunkStart = position;
+
+        while (position + sizeof(CryptoPP::word32) <= mMappedSize) {
+          const BYTE *pos = &(mMapped[position]);
+
+          if (0 == memcmp(pos, ZSLIB_EVENTING_TRACE_FILE_CHUNK_MAGIC, strlen(ZSLIB_EVENTING_TRACE_FILE_CHUNK_MAGIC))) {
+            ChunkInfo info;
+            if (!readFooter(position, info)) break;
+            if (info.mOffset != chunkStart) break;
+
+            info.mIndex = chunks->size();
+            chunks->push_back(info);
+
+            position += static_cast<uint64_t>(IHelper::getBE32(&(pos[sizeof(CryptoPP::word32)])));
+            chunkStart = position;
+            continue;
+          }
+
+          if ((position + ZSLIB_EVENTING_TRACE_FILE_BLOCK_HEADER_SIZE > mMappedSize) ||
+              (0 != memcmp(pos, ZSLIB_EVENTING_TRACE_FILE_BLOCK_MAGIC, strlen(ZSLIB_EVENTING_TRACE_FILE_BLOCK_MAGIC)))) break;
+
+          size_t storedSize = static_cast<size_t>(IHelper::getBE32(&(pos[sizeof(CryptoPP::word32)*3])));
+          if (position + ZSLIB_EVENTING_TRACE_FILE_BLOCK_HEADER_SIZE + storedSize > mMappedSize) break;
+
+          position += ZSLIB_EVENTING_TRACE_FILE_BLOCK_HEADER_SIZE + storedSize;
+        }
+
+        ZS_LOG_WARNING(Detail, log("recovered trace file chunks") + ZS_PARAM("chunks", chunks->size()) + ZS_PARAM("unrecoverable bytes", mMappedSize - chunkStart));
+        mChunks = chunks;
+      }
+
+      //-----------------------------------------------------------------------
+      bool TraceFileReader::readFooter(
+                                       uint64_t footerOffset,
+                                       ChunkInfo &outInfo
+                                       ) const
+      {
+        size_t headerSize = static_cast<size_t>(IHelper::getBE32(&(mMapped[8])));
+
+        if ((footerOffset < headerSize) ||
+            (footerOffset + ZSLIB_EVENTING_TRACE_FILE_FOOTER_BASIC_SIZE > mMappedSize)) return false;
+
+        const BYTE *pos = &(mMapped[footerOffset]);
+        if (0 != memcmp(pos, ZSLIB_EVENTING_TRACE_FILE_CHUNK_MAGIC, strlen(ZSLIB_EVENTING_TRACE_FILE_CHUNK_MAGIC))) return false;
+        pos += sizeof(CryptoPP::word32);
+
+        size_t footerSize = static_cast<size_t>(IHelper::getBE32(pos));
+        pos += sizeof(CryptoPP::word32);
+        if (footerOffset + footerSize > mMappedSize) return false;
+
+        uint64_t dataSize = IHelper::getBE64(pos);
+        pos += sizeof(uint64_t);
+        if (dataSize > footerOffset - headerSize) return false;
+
+        outInfo.mOffset = footerOffset - dataSize;
+        outInfo.mDataSize = static_cast<size_t>(dataSize);
+        outInfo.mFirstTime = fromMicroseconds(IHelper::getBE64(pos));
+        pos += sizeof(uint64_t);
+        outInfo.mLastTime = fromMicroseconds(IHelper::getBE64(pos));
+        pos += sizeof(uint64_t);
+        outInfo.mTotalRecords = static_cast<size_t>(IHelper::getBE32(pos));
+        pos += sizeof(CryptoPP::word32);
+
+        size_t totalHandles = static_cast<size_t>(IHelper::getBE32(pos));
+        pos += sizeof(CryptoPP::word32);
+
+        if (ZSLIB_EVENTING_TRACE_FILE_FOOTER_BASIC_SIZE + (sizeof(uint64_t) * totalHandles) + ZSLIB_EVENTING_TRACE_FILE_EVENT_ID_BITMAP_SIZE > footerSize) return false;
+
+        outInfo.mProviderHandles.clear();
+        for (size_t loop = 0; loop < totalHandles; ++loop, pos += sizeof(uint64_t)) {
+          outInfo.mProviderHandles.insert(IHelper::getBE64(pos));
+        }
+
+        outInfo.mEventIDs.reset();
+        for (size_t index = 0; index < Bitmap_EventIDBits; ++index) {
+          if (0 == (pos[index / 8] & static_cast<BYTE>(1 << (index % 8)))) continue;
+          outInfo.mEventIDs.set(index);
+        }
+        pos += ZSLIB_EVENTING_TRACE_FILE_EVENT_ID_BITMAP_SIZE;
+
+        outInfo.mValues = ValueFilter();
+
+        size_t remaining = footerSize - static_cast<size_t>(pos - &(mMapped[footerOffset]));
+        if (remaining < sizeof(CryptoPP::word32)*2) return true;
+
+        size_t totalHashes = static_cast<size_t>(IHelper::getBE32(pos));
+        size_t filterSize = static_cast<size_t>(IHelper::getBE32(&(pos[sizeof(CryptoPP::word32)])));
+        pos += sizeof(CryptoPP::word32)*2;
+
+        // a filter that cannot be read is treated as if it was never written
+        if ((0 == totalHashes) || (totalHashes > ZSLIB_EVENTING_TRACE_FILE_VALUE_FILTER_MAX_HASHES) || (0 == filterSize) || (filterSize > remaining - (sizeof(CryptoPP::word32)*2))) return true;
+
+        outInfo.mValues.mTotalHashes = totalHashes;
+        outInfo.mValues.mMappedBits = pos;
+        outInfo.mValues.mMappedBitsSize = filterSize;
+
+        return true;
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark TraceFileReader::ChunkState
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      void TraceFileReader::ChunkState::seekToChunk(size_t chunkIndex)
+      {
+        mCurrentChunk = chunkIndex;
+        mChunkData = NULL;
+        mChunkDataSize = 0;
+        mPosition = 0;
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark TraceFileChunkCursor
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      TraceFileChunkCursor::TraceFileChunkCursor(
+                                                 const make_private &,
+                                                 TraceFileReaderPtr reader
+                                                 ) :
+        mReader(reader)
+      {
+      }
+
+      //-----------------------------------------------------------------------
+      TraceFileChunkCursorPtr TraceFileChunkCursor::create(TraceFileReaderPtr reader)
+      {
+        return make_shared<TraceFileChunkCursor>(make_private{}, reader);
+      }
+
+      //-----------------------------------------------------------------------
+      void TraceFileChunkCursor::seekToChunk(size_t chunkIndex)
+      {
+        mState.seekToChunk(chunkIndex);
+      }
+
+      //-----------------------------------------------------------------------
+      bool TraceFileChunkCursor::readNextInChunk(Record &outRecord)
+      {
+        // the reader's chunk list and mapping never change once it is open
+        // so no lock is needed
+        if (mState.mCurrentChunk >= mReader->mChunks->size()) return false;
+        return mReader->readRecord(mState, outRecord);
+      }
+
+    } // namespace internal
+
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    #pragma mark
+    #pragma mark ITraceFileTypes
+    #pragma mark
+
+    //-------------------------------------------------------------------------
+    uint64_t ITraceFileTypes::getUnsignedValue(const USE_EVENT_DATA_DESCRIPTOR &data)
+    {
+      if (!data.Ptr) return 0;
+      
+      switch (data.Size) {
+        case 1: {
+          uint8_t value = 0;
+          memcpy(&value, (const void *)(data.Ptr), sizeof(uint8_t));
+          return value;
+        }
+        case 2: {
+          uint16_t value = 0;
+          memcpy(&value, (const void *)(data.Ptr), sizeof(uint16_t));
+          return value;
+        }
+        case 4: {
+          uint32_t value = 0;
+          memcpy(&value, (const void *)(data.Ptr), sizeof(uint32_t));
+          return value;
+        }
+        case 8: {
+          uint64_t value = 0;
+          memcpy(&value, (const void *)(data.Ptr), sizeof(uint64_t));
+          return value;
+        }
+        default: {
+          uint64_t value = 0;
+          memcpy(&value, (const void *)(data.Ptr), sizeof(uint64_t) > data.Size ? data.Size : sizeof(uint64_t));
+          return value;
+        }
+      }
+      return 0;
+    }
+    
+    //-------------------------------------------------------------------------
+    int64_t ITraceFileTypes::getSignedValue(const USE_EVENT_DATA_DESCRIPTOR &data)
+    {
+      if (!data.Ptr) return 0;
+      
+      switch (data.Size) {
+        case 1: {
+          int8_t value = 0;
+          memcpy(&value, (const void *)(data.Ptr), sizeof(int8_t));
+          return value;
+        }
+        case 2: {
+          int16_t value = 0;
+          memcpy(&value, (const void *)(data.Ptr), sizeof(int16_t));
+          return value;
+        }
+        case 4: {
+          int32_t value = 0;
+          memcpy(&value, (const void *)(data.Ptr), sizeof(int32_t));
+          return value;
+        }
+        case 8: {
+          int64_t value = 0;
+          memcpy(&value, (const void *)(data.Ptr), sizeof(int64_t));
+          return value;
+        }
+        default: {
+          int64_t value = 0;
+          memcpy(&value, (const void *)(data.Ptr), sizeof(int64_t) > data.Size ? data.Size : sizeof(int64_t));
+          return value;
+        }
+      }
+      return 0;
+    }
+    
+    //-------------------------------------------------------------------------
+    double ITraceFileTypes::getFloatValue(const USE_EVENT_DATA_DESCRIPTOR &data)
+    {
+      if (!data.Ptr) return 0.0f;
+      
+      if (sizeof(float) == data.Size) {
+        float value {};
+        memcpy(&value, (const void *)(data.Ptr), sizeof(value));
+        return value;
+      }
+      if (sizeof(double) == data.Size) {
+        double value ={};
+        memcpy(&value, (const void *)(data.Ptr), sizeof(value));
+        return value;
+      }
+      
+      double value = 0;
+      memcpy(&value, (const void *)(data.Ptr), sizeof(double) > data.Size ? data.Size : sizeof(double));
+      return value;
+    }
+
+    //-------------------------------------------------------------------------
+    bool ITraceFileTypes::getNumericValue(
+                                          const USE_EVENT_PARAMETER_DESCRIPTOR &param,
+                                          const USE_EVENT_DATA_DESCRIPTOR &data,
+                                          double &outValue
+                                          )
+    {
+      switch (param.Type) {
+        case EventParameterType_UnsignedInteger:  outValue = static_cast<double>(getUnsignedValue(data)); return true;
+        case EventParameterType_SignedInteger:    outValue = static_cast<double>(getSignedValue(data)); return true;
+        case EventParameterType_FloatingPoint:    outValue = getFloatValue(data); return true;
+        default:                                  break;
+      }
+      return false;
+    }
+    
+    //-------------------------------------------------------------------------
+    String ITraceFileTypes::valueAsString(
+                                          const USE_EVENT_PARAMETER_DESCRIPTOR &param,
+                                          const USE_EVENT_DATA_DESCRIPTOR &data,
+                                          bool &outIsNumber
+                                          )
+    {
+      outIsNumber = true;
+      
+      switch (param.Type) {
+        case EventParameterType_Boolean:          {
+          outIsNumber = false;
+          if (0 != getUnsignedValue(data)) return "true";
+          return "false";
+        }
+        case EventParameterType_UnsignedInteger:  return string(getUnsignedValue(data));
+        case EventParameterType_SignedInteger:    return string(getSignedValue(data));
+        
+        case EventParameterType_FloatingPoint:    return string(getFloatValue(data));
+        case EventParameterType_Pointer:          return string(getUnsignedValue(data));
+        case EventParameterType_AString:          {
+          outIsNumber = false;
+          if (!data.Ptr) return String();
+          if (0 == data.Size) return String();
+          auto temp = IHelper::convertToBuffer(reinterpret_cast<const BYTE *>(data.Ptr), data.Size);
+          return String(reinterpret_cast<const char *>(temp->BytePtr()));
+        }
+        case EventParameterType_WString:          {
+          outIsNumber = false;
+          if (!data.Ptr) return String();
+          if (0 == data.Size) return String();
+          size_t total = data.Size / sizeof(wchar_t);
+          
+          if (0 == total) return String();
+          
+          wchar_t *temp = new wchar_t[total+1] {};
+          memcpy(temp, (const void *)(data.Ptr), data.Size);
+          
+          String result(&(temp[0]));
+          
+          delete [] temp;
+          temp = NULL;
+          
+          return result;
+        }
+        case EventParameterType_Binary:
+        default:
+        {
+          break;
+        }
+      }
+
+      outIsNumber = false;
+      if (!data.Ptr) return String();
+      if (0 == data.Size) return String();
+      return IHelper::convertToHex(reinterpret_cast<const BYTE *>(data.Ptr), data.Size);
+    }
+
+    //-------------------------------------------------------------------------
+    bool ITraceFileTypes::ValueFilter::mightContainHash(uint64_t valueHash) const
+    {
+      if (!hasData()) return true;
+
+      const BYTE *bits = getBits();
+      uint64_t totalBits = static_cast<uint64_t>(getBitsSize()) * 8;
+      uint64_t step = (valueHash >> 32) | 1;
+
+      for (size_t loop = 0; loop < mTotalHashes; ++loop, valueHash += step) {
+        uint64_t bit = valueHash % totalBits;
+        if (0 == (bits[static_cast<size_t>(bit / 8)] & static_cast<BYTE>(1 << (bit % 8)))) return false;
+      }
+      return true;
+    }
+
+    //-------------------------------------------------------------------------
+    void ITraceFileTypes::ValueFilter::insertHash(uint64_t valueHash)
+    {
+      if (mBits.size() < 1) return;
+
+      uint64_t totalBits = static_cast<uint64_t>(mBits.size()) * 8;
+      uint64_t step = (valueHash >> 32) | 1;
+
+      for (size_t loop = 0; loop < mTotalHashes; ++loop, valueHash += step) {
+        uint64_t bit = valueHash % totalBits;
+        mBits[static_cast<size_t>(bit / 8)] |= static_cast<BYTE>(1 << (bit % 8));
+      }
+    }
+
+    //-------------------------------------------------------------------------
+    uint64_t ITraceFileTypes::ValueFilter::hash(const String &value)
+    {
+      // FNV-1a followed by a finalizer to spread the bits used for probing
+      uint64_t result = 0xcbf29ce484222325ULL;
+      for (size_t index = 0; index < value.length(); ++index) {
+        result ^= static_cast<uint64_t>(static_cast<BYTE>(value[index]));
+        result *= 0x100000001b3ULL;
+      }
+
+      result ^= (result >> 33);
+      result *= 0xff51afd7ed558ccdULL;
+      result ^= (result >> 33);
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    ElementPtr ITraceFileTypes::ChunkInfo::toDebug() const
+    {
+      ElementPtr resultEl = Element::create("zsLib::eventing::ITraceFileTypes::ChunkInfo");
+
+      resultEl->adoptAsLastChild(IHelper::createElementWithNumber("index", string(mIndex)));
+      resultEl->adoptAsLastChild(IHelper::createElementWithNumber("offset", string(mOffset)));
+      resultEl->adoptAsLastChild(IHelper::createElementWithNumber("data size", string(mDataSize)));
+      resultEl->adoptAsLastChild(IHelper::createElementWithNumber("records", string(mTotalRecords)));
+      resultEl->adoptAsLastChild(IHelper::createElementWithText("first time", IHelper::timeToString(mFirstTime)));
+      resultEl->adoptAsLastChild(IHelper::createElementWithText("last time", IHelper::timeToString(mLastTime)));
+      resultEl->adoptAsLastChild(IHelper::createElementWithNumber("providers", string(mProviderHandles.size())));
+      resultEl->adoptAsLastChild(IHelper::createElementWithNumber("event ids", string(mEventIDs.count())));
+      resultEl->adoptAsLastChild(IHelper::createElementWithNumber("value filter size", string(mValues.getBitsSize())));
+
+      return resultEl;
+    }
+
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    #pragma mark
+    #pragma mark ITraceFileWriter
+    #pragma mark
+
+    //-------------------------------------------------------------------------
+    ITraceFileWriterPtr ITraceFileWriter::create(
+                                                 const char *fileName,
+                                                 size_t chunkSizeInBytes
+                                                 ) throw (StdError)
+    {
+      ZS_THROW_INVALID_ARGUMENT_IF(!fileName);
+      return internal::TraceFileWriter::create(fileName, chunkSizeInBytes);
+    }
+
+    //-------------------------------------------------------------------------
+    size_t ITraceFileWriter::merge(
+                                   const char *outputFileName,
+                                   const StringList &inputFileNames
+                                   ) throw (StdError)
+    {
+      ZS_THROW_INVALID_ARGUMENT_IF(!outputFileName);
+      return internal::TraceFileMerger::merge(outputFileName, inputFileNames);
+    }
+
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    #pragma mark
+    #pragma mark ITraceFileReader
+    #pragma mark
+
+    //-------------------------------------------------------------------------
+    ITraceFileReaderPtr ITraceFileReader::open(const char *fileName) throw (StdError)
+    {
+      ZS_THROW_INVALID_ARGUMENT_IF(!fileName);
+      return internal::TraceFileReader::open(fileName);
+    }
+
+    //-------------------------------------------------------------------------
+    bool ITraceFileReader::decodeEvent(
+                                       const Record &record,
+                                       SecureByteBlock &ioBuffer,
+                                       TraceEvent &outEvent
+                                       )
+    {
+      if (RecordType_TraceEvent != record.mType) return false;
+      if ((!record.mPayload) || (0 == record.mPayloadSize)) return false;
+
+      if (ioBuffer.SizeInBytes() < record.mPayloadSize) {
+        ioBuffer.New(record.mPayloadSize);
+      }
+      memcpy(ioBuffer.BytePtr(), record.mPayload, record.mPayloadSize);
+
+      return internal::TraceEventCodec::decode(ioBuffer.BytePtr(), record.mPayloadSize, outEvent);
+    }
+
+  } // namespace eventing
+} // namespace zsLib
@@ -0,0 +1,409 @@
+/*
+
+Copyright (c) 2016, Robin Raymond
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are those
+of the authors and should not be interpreted as representing official policies,
+either expressed or implied, of the FreeBSD Project.
+
+*/
+
+
+
+#include <zsLib/eventing/internal/zsLib_eventing_TraceFileMerger.h>
+#include <zsLib/eventing/internal/zsLib_eventing_RemoteEventing.h>
+
+#include <zsLib/eventing/IHelper.h>
+
+#include <zsLib/Log.h>
+#include <zsLib/Numeric.h>
+
+#include <algorithm>
+#include <functional>
+
+namespace zsLib { namespace eventing { ZS_DECLARE_SUBSYSTEM(zsLib_eventing); } }
+
+namespace zsLib
+{
+  namespace eventing
+  {
+    ZS_DECLARE_TYPEDEF_PTR(IHelper, UseEventingHelper);
+
+    namespace internal
+    {
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark TraceFileMerger
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      TraceFileMerger::TraceFileMerger(
+                                       const make_private &,
+                                       const char *outputFileName,
+                                       const StringList &inputFileNames
+                                       ) :
+        mOutputFileName(outputFileName),
+        mInputFileNames(inputFileNames)
+      {
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark TraceFileMerger => ITraceFileWriter
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      size_t TraceFileMerger::merge(
+                                    const char *outputFileName,
+                                    const StringList &inputFileNames
+                                    ) throw (StdError)
+      {
+        TraceFileMerger merger(make_private{}, outputFileName, inputFileNames);
+        merger.process();
+        return merger.mWriter->getTotalRecords();
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark TraceFileMerger => (internal)
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      Log::Params TraceFileMerger::log(const char *message) const
+      {
+        ElementPtr objectEl = Element::create("eventing::TraceFileMerger");
+        objectEl->adoptAsLastChild(UseEventingHelper::createElementWithNumber("id", string(mID)));
+        return Log::Params(message, objectEl);
+      }
+
+      //-----------------------------------------------------------------------
+      void TraceFileMerger::process() throw (StdError)
+      {
+        mInputs.resize(mInputFileNames.size());
+
+        size_t index = 0;
+        for (auto iter = mInputFileNames.begin(); iter != mInputFileNames.end(); ++iter, ++index) {
+          auto &input = mInputs[index];
+          input.mReader = ITraceFileReader::open(*iter);
+          input.mClockOffset = input.mReader->getClockOffset();
+        }
+
+        // record times are converted to a common clock so the merged file
+        // needs no offset of its own
+        mWriter = ITraceFileWriter::create(mOutputFileName);
+
+        PendingRecordList pending;
+        pending.reserve(mInputs.size());
+
+        for (index = 0; index < mInputs.size(); ++index) {
+          if (!readNext(index)) continue;
+          pending.push_back(PendingRecord(mInputs[index].mTime, index));
+        }
+
+        // the pending list is a min heap ordered by time (then input order)
+        std::make_heap(pending.begin(), pending.end(), std::greater<PendingRecord>());
+
+        while (pending.size() > 0) {
+          std::pop_heap(pending.begin(), pending.end(), std::greater<PendingRecord>());
+          index = pending.back().second;
+          pending.pop_back();
+
+          auto &input = mInputs[index];
+
+          switch (input.mRecord.mType) {
+            case RecordType_Notify:     mergeNotify(input); break;
+            case RecordType_TraceEvent: mergeEvent(input); break;
+          }
+
+          if (!readNext(index)) continue;
+
+          pending.push_back(PendingRecord(input.mTime, index));
+          std::push_heap(pending.begin(), pending.end(), std::greater<PendingRecord>());
+        }
+
+        mWriter->close();
+
+        ZS_LOG_DEBUG(log("merged trace files") + ZS_PARAM("output", mOutputFileName) + ZS_PARAM("inputs", mInputs.size()) + ZS_PARAM("records", mWriter->getTotalRecords()) + ZS_PARAM("remapped handles", mTotalRemappedHandles));
+      }
+
+      //-----------------------------------------------------------------------
+      bool TraceFileMerger::readNext(size_t inputIndex)
+      {
+        auto &input = mInputs[inputIndex];
+        if (!input.mReader) return false;
+
+        if (!input.mReader->readNext(input.mRecord)) {
+          // release the mapping as soon as the input is exhausted
+          input.mReader.reset();
+          return false;
+        }
+
+        input.mTime = input.mRecord.mTime + input.mClockOffset;
+        return true;
+      }
+
+      //-----------------------------------------------------------------------
+      void TraceFileMerger::mergeNotify(Input &input) throw (StdError)
+      {
+        String message(std::string(reinterpret_cast<const char *>(input.mRecord.mPayload), input.mRecord.mPayloadSize));
+
+        ElementPtr rootEl = IHelper::toJSON(message);
+        if (!rootEl) {
+          writeNotify(input, message);
+          return;
+        }
+
+        String typeStr = IHelper::getElementText(rootEl->findFirstChildElement("type"));
+
+        if (ZSLIB_EVENTING_REMOTE_EVENTING_NOTIFY_PROVIDER == typeStr) {
+          mergeProvider(input, rootEl);
+          return;
+        }
+        if (ZSLIB_EVENTING_REMOTE_EVENTING_NOTIFY_PROVIDER_KEYWORD_LOGGING == typeStr) {
+          mergeProviderKeywordLogging(input, rootEl);
+          return;
+        }
+        if (ZSLIB_EVENTING_REMOTE_EVENTING_NOTIFY_EVENT_COUNTERS == typeStr) {
+          mergeEventCounters(input, rootEl);
+          return;
+        }
+        if (ZSLIB_EVENTING_REMOTE_EVENTING_NOTIFY_SUBSYSTEM == typeStr) {
+          // subsystems are re-announced by every chunk of every input
+          if (mSubsystemAnnouncements.end() != mSubsystemAnnouncements.find(message)) return;
+          mSubsystemAnnouncements.insert(message);
+        }
+
+        writeNotify(input, message);
+      }
+
+      //-----------------------------------------------------------------------
+      void TraceFileMerger::mergeProvider(
+                                          Input &input,
+                                          ElementPtr rootEl
+                                          ) throw (StdError)
+      {
+        ElementPtr handleEl = rootEl->findLastChildElement("handle");
+        String handleStr = IHelper::getElementText(handleEl);
+
+        uint64_t handle {};
+        try {
+          handle = Numeric<uint64_t>(handleStr);
+        } catch (const Numeric<uint64_t>::ValueOutOfRange &) {
+          ZS_LOG_WARNING(Debug, log("provider handle is not valid (ignored)") + ZS_PARAMIZE(handleStr));
+          return;
+        }
+
+        auto found = input.mHandles.find(handle);
+
+        if (IHelper::getElementText(rootEl->findLastChildElement("gone")).hasData()) {
+          if (found == input.mHandles.end()) return;
+
+          uint64_t mergedHandle = (*found).second;
+          input.mHandles.erase(found);
+
+          // the provider remains for as long as any input still has it
+          auto &references = mHandleReferences[mergedHandle];
+          if (references > 1) {
+            --references;
+            return;
+          }
+          mHandleReferences.erase(mergedHandle);
+
+          auto foundID = mProviderIDsByHandle.find(mergedHandle);
+          if (foundID != mProviderIDsByHandle.end()) {
+            mHandlesByProviderID.erase((*foundID).second);
+            mProviderIDsByHandle.erase(foundID);
+          }
+          mKeywordLoggingAnnouncements.erase(mergedHandle);
+
+          handleEl->adoptAsNextSibling(IHelper::createElementWithNumber("handle", string(mergedHandle)));
+          handleEl->orphan();
+
+          writeNotify(input, IHelper::toString(rootEl));
+          return;
+        }
+
+        // providers are re-announced at the start of every chunk
+        if (found != input.mHandles.end()) return;
+
+        String providerID = IHelper::getElementText(rootEl->findLastChildElement("id"));
+
+        auto foundProvider = mHandlesByProviderID.find(providerID);
+        if (foundProvider != mHandlesByProviderID.end()) {
+          // the same provider was already announced by another input
+          uint64_t mergedHandle = (*foundProvider).second;
+          input.mHandles[handle] = mergedHandle;
+          ++(mHandleReferences[mergedHandle]);
+          return;
+        }
+
+        uint64_t mergedHandle = allocateHandle(handle);
+
+        input.mHandles[handle] = mergedHandle;
+        mHandleReferences[mergedHandle] = 1;
+        mHandlesByProviderID[providerID] = mergedHandle;
+        mProviderIDsByHandle[mergedHandle] = providerID;
+
+        remapHandle(input, handleEl);
+        writeNotify(input, IHelper::toString(rootEl));
+      }
+
+      //-----------------------------------------------------------------------
+      void TraceFileMerger::mergeProviderKeywordLogging(
+                                                        Input &input,
+                                                        ElementPtr rootEl
+                                                        ) throw (StdError)
+      {
+        ElementPtr handleEl = rootEl->findLastChildElement("handle");
+        if (!remapHandle(input, handleEl)) {
+          ZS_LOG_WARNING(Trace, log("keyword logging for provider that was never announced (ignored)"));
+          return;
+        }
+
+        uint64_t mergedHandle {};
+        try {
+          mergedHandle = Numeric<uint64_t>(IHelper::getElementText(rootEl->findLastChildElement("handle")));
+        } catch (const Numeric<uint64_t>::ValueOutOfRange &) {
+          return;
+        }
+
+        String message = IHelper::toString(rootEl);
+
+        // logging states are re-announced at the start of every chunk
+        auto &existing = mKeywordLoggingAnnouncements[mergedHandle];
+        if (existing == message) return;
+        existing = message;
+
+        writeNotify(input, message);
+      }
+
+      //-----------------------------------------------------------------------
+      void TraceFileMerger::mergeEventCounters(
+                                               Input &input,
+                                               ElementPtr rootEl
+                                               ) throw (StdError)
+      {
+        ElementPtr providersEl = rootEl->findFirstChildElement("providers");
+        if (providersEl) {
+          for (ElementPtr providerEl = providersEl->findFirstChildElement("provider"); providerEl; providerEl = providerEl->findNextSiblingElement("provider")) {
+            remapHandle(input, providerEl->findFirstChildElement("handle"));
+          }
+        }
+
+        writeNotify(input, IHelper::toString(rootEl));
+      }
+
+      //-----------------------------------------------------------------------
+      void TraceFileMerger::mergeEvent(Input &input) throw (StdError)
+      {
+        auto &record = input.mRecord;
+
+        // an encoded trace event always starts with its provider handle
+        if (record.mPayloadSize >= sizeof(uint64_t)) {
+          uint64_t handle = IHelper::getBE64(record.mPayload);
+
+          auto found = input.mHandles.find(handle);
+          if ((found != input.mHandles.end()) &&
+              ((*found).second != handle)) {
+            if (mEventBuffer.SizeInBytes() < record.mPayloadSize) {
+              mEventBuffer.New(record.mPayloadSize);
+            }
+            memcpy(mEventBuffer.BytePtr(), record.mPayload, record.mPayloadSize);
+            IHelper::setBE64(mEventBuffer.BytePtr(), (*found).second);
+
+            mWriter->writeRecord(RecordType_TraceEvent, input.mTime, mEventBuffer.BytePtr(), record.mPayloadSize);
+            return;
+          }
+        }
+
+        mWriter->writeRecord(RecordType_TraceEvent, input.mTime, record.mPayload, record.mPayloadSize);
+      }
+
+      //-----------------------------------------------------------------------
+      bool TraceFileMerger::remapHandle(
+                                        const Input &input,
+                                        ElementPtr handleEl
+                                        ) const
+      {
+        if (!handleEl) return false;
+
+        uint64_t handle {};
+        try {
+          handle = Numeric<uint64_t>(IHelper::getElementText(handleEl));
+        } catch (const Numeric<uint64_t>::ValueOutOfRange &) {
+          return false;
+        }
+
+        auto found = input.mHandles.find(handle);
+        if (found == input.mHandles.end()) return false;
+
+        uint64_t mergedHandle = (*found).second;
+        if (mergedHandle == handle) return true;
+
+        handleEl->adoptAsNextSibling(IHelper::createElementWithNumber("handle", string(mergedHandle)));
+        handleEl->orphan();
+        return true;
+      }
+
+      //-----------------------------------------------------------------------
+      uint64_t TraceFileMerger::allocateHandle(uint64_t preferredHandle)
+      {
+        if ((0 != preferredHandle) &&
+            (mUsedHandles.end() == mUsedHandles.find(preferredHandle))) {
+          mUsedHandles.insert(preferredHandle);
+          return preferredHandle;
+        }
+
+        // the handle is already used by a different provider from another
+        // input so a new (otherwise unused) handle is assigned
+        while (mUsedHandles.end() != mUsedHandles.find(mNextHandle)) {
+          ++mNextHandle;
+        }
+
+        ++mTotalRemappedHandles;
+        mUsedHandles.insert(mNextHandle);
+        return mNextHandle++;
+      }
+
+      //-----------------------------------------------------------------------
+      void TraceFileMerger::writeNotify(
+                                        const Input &input,
+                                        const String &message
+                                        ) throw (StdError)
+      {
+        mWriter->writeRecord(RecordType_Notify, input.mTime, reinterpret_cast<const BYTE *>(message.c_str()), message.length());
+      }
+
+    } // namespace internal
+  } // namespace eventing
+} // namespace zsLib
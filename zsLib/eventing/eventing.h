@@ -33,6 +33,8 @@ either expressed or implied, of the FreeBSD Project.
 
 #include <zsLib/eventing/types.h>
 #include <zsLib/eventing/IEventingTypes.h>
+#include <zsLib/eventing/IFlightRecorder.h>
 #include <zsLib/eventing/IHasher.h>
 #include <zsLib/eventing/IHelper.h>
 #include <zsLib/eventing/IRemoteEventing.h>
+#include <zsLib/eventing/ITraceFile.h>
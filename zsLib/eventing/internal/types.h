@@ -39,11 +39,17 @@ namespace zsLib
   {
     namespace internal
     {
+      ZS_DECLARE_INTERACTION_PROXY(IFlightRecorderAsyncDelegate);
       ZS_DECLARE_INTERACTION_PROXY(IRemoteEventingAsyncDelegate);
       
       ZS_DECLARE_CLASS_PTR(Helper);
+      ZS_DECLARE_CLASS_PTR(FlightRecorder);
       ZS_DECLARE_CLASS_PTR(Hasher);
       ZS_DECLARE_CLASS_PTR(RemoteEventing);
+      ZS_DECLARE_CLASS_PTR(TraceFileChunkCursor);
+      ZS_DECLARE_CLASS_PTR(TraceFileMerger);
+      ZS_DECLARE_CLASS_PTR(TraceFileReader);
+      ZS_DECLARE_CLASS_PTR(TraceFileWriter);
     }
   }
 }
@@ -0,0 +1,110 @@
+/*
+
+Copyright (c) 2016, Robin Raymond
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are those
+of the authors and should not be interpreted as representing official policies,
+either expressed or implied, of the FreeBSD Project.
+
+*/
+
+
+
+#pragma once
+
+#include <zsLib/eventing/internal/types.h>
+
+#include <zsLib/Log.h>
+
+#define ZSLIB_EVENTING_BLOCK_CODEC_MIN_MATCH (4)
+
+namespace zsLib
+{
+  namespace eventing
+  {
+    namespace internal
+    {
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark BlockCodec
+      #pragma mark
+
+      // Byte oriented LZ77 block codec (in the spirit of LZ4) used for trace
+      // file chunks. Each block is compressed independently but may refer
+      // back into a shared dictionary which is treated as if it immediately
+      // preceded the block, so both calls operate on a "window" that starts
+      // with the dictionary followed by the block data.
+      //
+      // A block is a series of sequences: a token byte (high nibble literal
+      // length, low nibble match length minus ZSLIB_EVENTING_BLOCK_CODEC_MIN_MATCH,
+      // a nibble of 15 is followed by 255 terminated length bytes), the
+      // literals, then the match offset as a 7-bit variable length integer
+      // and any extended match length. The final sequence only has literals.
+      class BlockCodec
+      {
+      public:
+        // the worst case size of a compressed block
+        static size_t getMaxCompressedSize(size_t inputSize);
+
+        // compresses window[dictionarySize..windowSize) into the output
+        // buffer (which must be at least getMaxCompressedSize() bytes) and
+        // returns the size of the compressed block
+        static size_t compress(
+                               const BYTE *window,
+                               size_t dictionarySize,
+                               size_t windowSize,
+                               BYTE *output
+                               );
+
+        // decompresses a block into window[dictionarySize..dictionarySize+outputSize),
+        // the dictionary must already be at the start of the window; returns
+        // false if the block is corrupt or does not decode to exactly
+        // outputSize bytes
+        static bool decompress(
+                               BYTE *window,
+                               size_t dictionarySize,
+                               const BYTE *input,
+                               size_t inputSize,
+                               size_t outputSize
+                               );
+
+        // builds a dictionary of at most maxDictionarySize bytes from the
+        // most frequently repeating segments of the sample data (e.g. event
+        // descriptor headers and commonly logged strings)
+        static SecureByteBlockPtr trainDictionary(
+                                                  const BYTE *samples,
+                                                  size_t samplesSize,
+                                                  size_t maxDictionarySize
+                                                  );
+
+      protected:
+        static Log::Params slog(const char *message);
+      };
+
+    }
+  }
+}
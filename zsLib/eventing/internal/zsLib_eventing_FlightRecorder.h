@@ -0,0 +1,439 @@
+/*
+
+Copyright (c) 2016, Robin Raymond
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are those
+of the authors and should not be interpreted as representing official policies,
+either expressed or implied, of the FreeBSD Project.
+
+*/
+
+
+#pragma once
+
+#include <zsLib/eventing/internal/types.h>
+
+#include <zsLib/eventing/IFlightRecorder.h>
+
+#include <zsLib/ITimer.h>
+#include <zsLib/Log.h>
+
+#include <cryptopp/queue.h>
+
+#include <deque>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif //_WIN32
+
+#define ZSLIB_EVENTING_SETTING_FLIGHT_RECORDER_FILE_SIZE                                        "zsLib/eventing/flight-recorder/file-size-in-bytes"
+#define ZSLIB_EVENTING_SETTING_FLIGHT_RECORDER_MAX_DATA_SIZE                                    "zsLib/eventing/flight-recorder/max-data-size-in-bytes"
+#define ZSLIB_EVENTING_SETTING_FLIGHT_RECORDER_TRIGGER_PRE_WINDOW                               "zsLib/eventing/flight-recorder/trigger/pre-window-in-milliseconds"
+#define ZSLIB_EVENTING_SETTING_FLIGHT_RECORDER_TRIGGER_POST_WINDOW                              "zsLib/eventing/flight-recorder/trigger/post-window-in-milliseconds"
+#define ZSLIB_EVENTING_SETTING_FLIGHT_RECORDER_TRIGGER_SNAPSHOT_PATH_PREFIX                     "zsLib/eventing/flight-recorder/trigger/snapshot-path-prefix"
+
+#define ZSLIB_EVENTING_FLIGHT_RECORDER_MAGIC "zsFR"
+#define ZSLIB_EVENTING_FLIGHT_RECORDER_VERSION (1)
+#define ZSLIB_EVENTING_FLIGHT_RECORDER_HEADER_SIZE (128)
+#define ZSLIB_EVENTING_FLIGHT_RECORDER_TOTAL_CHECKPOINTS (4)
+#define ZSLIB_EVENTING_FLIGHT_RECORDER_MIN_DATA_SIZE (64*1024)
+#define ZSLIB_EVENTING_FLIGHT_RECORDER_WINDOW_SAMPLE_INTERVAL_IN_MICROSECONDS (10*1000)
+
+#define ZSLIB_EVENTING_FLIGHT_RECORDER_NOTIFY_TRIGGER "trigger"
+
+namespace zsLib
+{
+  namespace eventing
+  {
+    namespace internal
+    {
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark IFlightRecorderAsyncDelegate
+      #pragma mark
+
+      interaction IFlightRecorderAsyncDelegate
+      {
+        virtual void onFlightRecorderWriteSnapshot(
+                                                   SecureByteBlockPtr records,
+                                                   size_t triggerOffset,
+                                                   const char *fileName
+                                                   ) = 0;
+      };
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark FlightRecorder
+      #pragma mark
+
+      // File layout (all multi-byte values are big endian):
+      //
+      //   header (ZSLIB_EVENTING_FLIGHT_RECORDER_HEADER_SIZE bytes)
+      //     [0]   magic (4 bytes)
+      //     [4]   version (32 bits)
+      //     [8]   header size (32 bits)
+      //     [16]  ring data size (64 bits)
+      //     [24]  total bytes ever written to the ring (64 bits)
+      //     [32]  logical position of the last checkpoints (4 x 64 bits)
+      //     [64]  creation time in microseconds since epoch (64 bits)
+      //     [72]  clock offset in microseconds (64 bits, signed, see
+      //           IFlightRecorder::setClockOffset)
+      //   ring data
+      //
+      // The ring is a stream of records that wraps at the ring data size:
+      //   size (32 bits, includes type + time + payload), type (32 bits,
+      //   remote eventing message type), time (64 bits, microseconds since
+      //   epoch), payload (json notify or encoded trace event).
+      //
+      // A checkpoint re-announces every known subsystem and provider so a
+      // reader can start decoding at the oldest checkpoint still present.
+      // A reader (see IFlightRecorder::convert) takes the published total as
+      // the end of the stream; only the bytes from total - ring data size
+      // onward survive so it starts at the oldest checkpoint slot at or after
+      // that position (moving on to the next checkpoint if a writer that
+      // terminated abnormally left a torn record there).
+      //
+      // A snapshot is written as a trace file (see ITraceFileWriter): an
+      // announcement of every known subsystem and provider followed by the
+      // records copied out of the ring from the start of the pre-trigger
+      // window until the end of the post-trigger window, with a "trigger"
+      // notify record placed just before the triggering event.
+      class FlightRecorder : public MessageQueueAssociator,
+                             public IFlightRecorder,
+                             public ILogEventingProviderDelegate,
+                             public ILogEventingDelegate,
+                             public ITimerDelegate,
+                             public IFlightRecorderAsyncDelegate
+      {
+      protected:
+        struct make_private {};
+
+      public:
+        friend interaction IFlightRecorder;
+        ZS_DECLARE_TYPEDEF_PTR(CryptoPP::ByteQueue, ByteQueue);
+
+        typedef zsLib::Log::Severity Severity;
+        typedef zsLib::Log::Level Level;
+        typedef zsLib::Log::ProviderHandle ProviderHandle;
+        typedef zsLib::Log::EventingAtomDataArray EventingAtomDataArray;
+        typedef zsLib::Log::EventingAtomIndex EventingAtomIndex;
+
+        struct ProviderInfo
+        {
+          PUID mRelatedToFlightRecorderObjectID {};
+          ProviderHandle mHandle {};
+          UUID mProviderID {};
+          String mProviderName;
+          String mProviderHash;
+          KeywordBitmaskType mBitmask {};
+          std::atomic<KeywordBitmaskType> mRecordKeywords {};
+        };
+
+        typedef std::set<ProviderInfo *> ProviderInfoSet;
+        typedef std::map<ProviderHandle, ProviderInfo *> ProviderInfoHandleMap;
+        typedef std::set<String> SubsystemSet;
+        typedef std::map<String, KeywordBitmaskType> KeywordLogLevelMap;
+        typedef std::map<PUID, TriggerRule> TriggerMap;
+
+        struct WindowSample
+        {
+          uint64_t mTime {};
+          uint64_t mPosition {};
+        };
+
+        typedef std::deque<WindowSample> WindowSampleQueue;
+
+      public:
+        FlightRecorder(
+                       const make_private &,
+                       IMessageQueuePtr queue,
+                       const char *fileName,
+                       size_t fileSizeInBytes
+                       );
+        ~FlightRecorder();
+
+      protected:
+        void init() throw (StdError);
+
+      protected:
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark FlightRecorder => IFlightRecorder
+        #pragma mark
+
+        static FlightRecorderPtr create(
+                                        const char *fileName,
+                                        size_t fileSizeInBytes
+                                        ) throw (StdError);
+
+        static size_t convert(
+                              const char *ringFileName,
+                              const char *traceFileName
+                              ) throw (StdError);
+
+        virtual PUID getID() const override {return mID;}
+
+        virtual void shutdown() override;
+
+        virtual String getFileName() const override {return mFileName;}
+
+        virtual void setProviderLogging(
+                                        const char *providerName,
+                                        KeywordBitmaskType keywords
+                                        ) override;
+
+        virtual size_t getTotalDroppedEvents() const override {return mTotalDroppedEvents;}
+
+        virtual PUID addTrigger(const TriggerRule &rule) override;
+        virtual void removeTrigger(PUID triggerID) override;
+
+        virtual size_t getTotalSnapshots() const override {return mTotalSnapshots;}
+
+        virtual void setClockOffset(Microseconds offset) override;
+
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark FlightRecorder => ILogEventingProviderDelegate
+        #pragma mark
+
+        virtual void notifyNewSubsystem(zsLib::Subsystem &inSubsystem) override;
+
+        virtual void notifyEventingProviderRegistered(
+                                                      ProviderHandle handle,
+                                                      EventingAtomDataArray eventingAtomDataArray
+                                                      ) override;
+        virtual void notifyEventingProviderUnregistered(
+                                                        ProviderHandle handle,
+                                                        EventingAtomDataArray eventingAtomDataArray
+                                                        ) override;
+
+        virtual void notifyEventingProviderLoggingStateChanged(
+                                                               ProviderHandle handle,
+                                                               EventingAtomDataArray eventingAtomDataArray,
+                                                               KeywordBitmaskType keywords
+                                                               ) override;
+
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark FlightRecorder => ILogEventingDelegate
+        #pragma mark
+
+        virtual void notifyWriteEvent(
+                                      ProviderHandle handle,
+                                      EventingAtomDataArray eventingAtomDataArray,
+                                      Severity severity,
+                                      Level level,
+                                      EVENT_DESCRIPTOR_HANDLE descriptor,
+                                      EVENT_PARAMETER_DESCRIPTOR_HANDLE parameterDescriptor,
+                                      EVENT_DATA_DESCRIPTOR_HANDLE dataDescriptor,
+                                      size_t dataDescriptorCount
+                                      ) override;
+
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark FlightRecorder => ITimerDelegate
+        #pragma mark
+
+        virtual void onTimer(ITimerPtr timer) override;
+
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark FlightRecorder => IFlightRecorderAsyncDelegate
+        #pragma mark
+
+        virtual void onFlightRecorderWriteSnapshot(
+                                                   SecureByteBlockPtr records,
+                                                   size_t triggerOffset,
+                                                   const char *fileName
+                                                   ) override;
+
+      protected:
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark FlightRecorder => (internal)
+        #pragma mark
+
+        static Log::Params slog(const char *message);
+        Log::Params log(const char *message);
+
+        void cancel();
+
+        void openFile() throw (StdError);
+        void closeFile();
+
+        static uint64_t getCurrentTime();
+        static void putRecordHeader(
+                                    BYTE *header,
+                                    size_t payloadSize,
+                                    CryptoPP::word32 recordType,
+                                    uint64_t recordTime
+                                    );
+
+        uint64_t writeRecord(
+                             CryptoPP::word32 recordType,
+                             ByteQueue &payload
+                             );
+        void writeNotify(const ElementPtr &rootEl);
+        void writeRing(
+                       const BYTE *buffer,
+                       size_t length
+                       );
+        void writeRing(ByteQueue &queue);
+        void readRing(
+                      uint64_t position,
+                      BYTE *buffer,
+                      size_t length
+                      );
+        static void readRing(
+                             const BYTE *ring,
+                             size_t dataSize,
+                             uint64_t position,
+                             BYTE *buffer,
+                             size_t length
+                             );
+        void writeCheckpoint();
+
+        static ElementPtr createSubsystemNotify(const String &subsystemName);
+        static ElementPtr createProviderNotify(
+                                               ProviderInfo *provider,
+                                               bool announceNew
+                                               );
+        static ElementPtr createProviderLoggingStateNotify(ProviderInfo *provider);
+        static void appendNotify(
+                                 ByteQueue &outQueue,
+                                 uint64_t recordTime,
+                                 const ElementPtr &rootEl
+                                 );
+
+        void recordSubsystem(const String &subsystemName);
+        void recordProvider(
+                            ProviderInfo *provider,
+                            bool announceNew = true
+                            );
+        void recordProviderLoggingState(ProviderInfo *provider);
+
+        bool isTriggered(
+                         ProviderInfo *provider,
+                         Severity severity,
+                         EVENT_DESCRIPTOR_HANDLE descriptor
+                         ) const;
+        void startSnapshot(
+                           uint64_t triggerTime,
+                           uint64_t triggerPosition
+                           );
+        void finishSnapshot();
+        void writeSnapshot(
+                           SecureByteBlockPtr records,
+                           size_t triggerOffset,
+                           const String &fileName
+                           );
+
+        static size_t getLegalRecordsSize(
+                                          const BYTE *records,
+                                          size_t size
+                                          );
+        static void writeRecords(
+                                 ITraceFileWriterPtr writer,
+                                 const BYTE *records,
+                                 size_t size,
+                                 const Optional<size_t> &triggerOffset = Optional<size_t>()
+                                 ) throw (StdError);
+
+        void updateRecordKeywords(ProviderInfo *provider);
+
+      protected:
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark FlightRecorder => (data)
+        #pragma mark
+
+        mutable RecursiveLock mLock;
+        AutoPUID mID;
+        FlightRecorderWeakPtr mThisWeak;
+
+        String mFileName;
+        size_t mDataSize {};
+        size_t mMaxDataSize {};
+        size_t mMaxRecordSize {};
+        size_t mCheckpointInterval {};
+
+        Microseconds mPreTriggerWindow {};
+        Milliseconds mPostTriggerWindow {};
+        String mSnapshotPathPrefix;
+
+        EventingAtomIndex mEventingAtomIndex {};
+
+#ifdef _WIN32
+        HANDLE mFile {INVALID_HANDLE_VALUE};
+        HANDLE mFileMapping {NULL};
+#else
+        int mFile {-1};
+#endif //_WIN32
+        BYTE *mMapped {};
+        size_t mMappedSize {};
+
+        BYTE *mRing {};
+        uint64_t mTotalWritten {};
+        uint64_t mLastCheckpoint {};
+        size_t mNextCheckpointSlot {};
+        bool mInCheckpoint {};
+
+        ByteQueue mEncodeQueue;
+
+        SubsystemSet mSubsystems;
+        ProviderInfoHandleMap mProviders;
+        ProviderInfoSet mCleanUpProviderInfos;
+        KeywordLogLevelMap mRequestedProviderKeywords;
+
+        TriggerMap mTriggers;
+        WindowSampleQueue mWindowSamples;
+
+        bool mSnapshotActive {};
+        uint64_t mSnapshotStart {};
+        uint64_t mSnapshotTriggerTime {};
+        uint64_t mSnapshotTriggerPosition {};
+        ByteQueue mSnapshotAnnouncements;
+        ITimerPtr mSnapshotTimer;
+
+        bool mShutdown {};
+        std::atomic<size_t> mTotalDroppedEvents {};
+        std::atomic<size_t> mTotalSnapshots {};
+        std::atomic<Microseconds::rep> mClockOffset {};
+      };
+
+    }
+  }
+}
+
+ZS_DECLARE_PROXY_BEGIN(zsLib::eventing::internal::IFlightRecorderAsyncDelegate)
+ZS_DECLARE_PROXY_TYPEDEF(zsLib::eventing::SecureByteBlockPtr, SecureByteBlockPtr)
+ZS_DECLARE_PROXY_TYPEDEF(std::size_t, size_t)
+ZS_DECLARE_PROXY_METHOD_3(onFlightRecorderWriteSnapshot, SecureByteBlockPtr, size_t, const char *)
+ZS_DECLARE_PROXY_END()
@@ -34,6 +34,7 @@ either expressed or implied, of the FreeBSD Project.
 #include <zsLib/eventing/internal/types.h>
 
 #include <zsLib/eventing/IRemoteEventing.h>
+#include <zsLib/eventing/ITraceFile.h>
 
 #include <zsLib/IPAddress.h>
 #include <zsLib/ITimer.h>
@@ -43,6 +44,8 @@ either expressed or implied, of the FreeBSD Project.
 
 #include <cryptopp/queue.h>
 
+#include <deque>
+
 #define ZSLIB_EVENTING_SETTING_REMOTE_EVENTING_MAX_DATA_SIZE                                    "zsLib/eventing/remote-eventing/max-data-size-in-bytes"
 #define ZSLIB_EVENTING_SETTING_REMOTE_EVENTING_MAX_PACKED_SIZE                                  "zsLib/eventing/remote-eventing/max-packed-data-size-in-bytes"
 #define ZSLIB_EVENTING_SETTING_REMOTE_EVENTING_MAX_OUTSTANDING_EVENTS                           "zsLib/eventing/remote-eventing/max-outstanding-events-in-bytes"
@@ -50,6 +53,23 @@ either expressed or implied, of the FreeBSD Project.
 #define ZSLIB_EVENTING_SETTING_REMOTE_EVENTING_MAX_QUEUED_OUTGOING_DATA_BEFORED_EVENTS_DROPPED  "zsLib/eventing/remote-eventing/max-queued-outgoing-data-before-events-dropped"
 #define ZSLIB_EVENTING_SETTING_REMOTE_EVENTING_NOTIFY_TIMER                                     "zsLib/eventing/remote-eventing/notify-timer-in-seconds"
 #define ZSLIB_EVENTING_SETTING_REMOTE_EVENTING_USE_IPV6                                         "zsLib/eventing/remote-eventing/use-ipv6"
+#define ZSLIB_EVENTING_SETTING_REMOTE_EVENTING_NOTIFY_EVENT_COUNTERS                            "zsLib/eventing/remote-eventing/notify-event-counters"
+
+#define ZSLIB_EVENTING_REMOTE_EVENTING_NOTIFY_SUBSYSTEM "subsystem"
+#define ZSLIB_EVENTING_REMOTE_EVENTING_NOTIFY_PROVIDER "provider"
+#define ZSLIB_EVENTING_REMOTE_EVENTING_NOTIFY_PROVIDER_KEYWORD_LOGGING "providerKeywordLogging"
+#define ZSLIB_EVENTING_REMOTE_EVENTING_NOTIFY_PROVIDER_SCHEMA "providerSchema"
+#define ZSLIB_EVENTING_REMOTE_EVENTING_NOTIFY_GENERAL_INFO "info"
+#define ZSLIB_EVENTING_REMOTE_EVENTING_NOTIFY_EVENT_COUNTERS "eventCounters"
+
+#define ZSLIB_EVENTING_REMOTE_EVENTING_EVENT_COUNTER_INITIAL_SLOTS (64)
+#define ZSLIB_EVENTING_REMOTE_EVENTING_EVENT_COUNTER_UNUSED (0xFFFFFFFF)
+
+#define ZSLIB_EVENTING_REMOTE_EVENTING_ENCODE_TIME_SAMPLE_RATE (16)
+
+// version 2 remotes accept events stamped with the time they were written
+#define ZSLIB_EVENTING_REMOTE_EVENTING_PROTOCOL_VERSION (2)
+#define ZSLIB_EVENTING_REMOTE_EVENTING_TIMED_EVENTS_VERSION (2)
 
 namespace zsLib
 {
@@ -69,6 +89,33 @@ namespace zsLib
       {
         typedef zsLib::Log::ProviderHandle ProviderHandle;
         typedef zsLib::Log::KeywordBitmaskType KeywordBitmaskType;
+        typedef std::chrono::steady_clock::time_point SteadyTime;
+
+        struct EventCounterSlot
+        {
+          std::atomic<uint32_t> mEventID {ZSLIB_EVENTING_REMOTE_EVENTING_EVENT_COUNTER_UNUSED};
+
+          std::atomic<size_t> mTotalEvents {};
+          std::atomic<size_t> mTotalBytes {};
+          std::atomic<size_t> mTotalDropped {};
+
+          // only accessed from within the remote eventing object lock
+          size_t mAnnouncedEvents {};
+          size_t mAnnouncedDropped {};
+        };
+
+        // open addressing table of counters by event ID (slots are claimed
+        // with a compare and swap so writers never need to take a lock); a
+        // full table chains to a new table twice its size
+        struct EventCounterTable
+        {
+          EventCounterTable(size_t totalSlots) : mTotalSlots(totalSlots), mSlots(new EventCounterSlot[totalSlots]) {}
+          ~EventCounterTable() {delete mNext.load();}
+
+          const size_t mTotalSlots {};
+          std::unique_ptr<EventCounterSlot[]> mSlots;
+          std::atomic<EventCounterTable *> mNext {};
+        };
         
         struct ProviderInfo
         {
@@ -80,6 +127,15 @@ namespace zsLib
           String mProviderName;
           String mProviderHash;
           KeywordBitmaskType mBitmask {};
+          SecureByteBlockPtr mSchema;             // size prefixed schema shipped by the remote party
+          std::atomic<bool> mSchemaAnnounced {};  // local provider's schema was sent to the remote party
+
+          // created with the provider's first event
+          std::atomic<EventCounterTable *> mEventCounters {};
+
+          ~ProviderInfo() {delete mEventCounters.load();}
+
+          EventCounterSlot &getEventCounter(uint32_t eventID);
         };
       };
 
@@ -107,10 +163,13 @@ namespace zsLib
                                                                  ProviderInfo *info,
                                                                  KeywordBitmaskType keyword
                                                                  ) = 0;
+        virtual void onRemoteEventingProviderSchema(ProviderInfo *info) = 0;
 
         virtual void onRemoteEventingWriteEvent(
                                                 ByteQueuePtr message,
-                                                size_t currentSize
+                                                size_t currentSize,
+                                                EventCounterSlot *counter,
+                                                bool timed
                                                 ) = 0;
       };
       
@@ -161,8 +220,9 @@ namespace zsLib
           MessageType_RequestAck      = 17,
           
           MessageType_TraceEvent      = 32,
+          MessageType_TimedTraceEvent = 33,   // 64 bit write time (us) followed by the trace event
           
-          MessageType_Last            = MessageType_TraceEvent
+          MessageType_Last            = MessageType_TimedTraceEvent
         };
         
         static const char *toString(MessageTypes messageType);
@@ -173,7 +233,16 @@ namespace zsLib
           String mName;
           Log::Level mLevel {Log::Level_First};
         };
-        
+
+        // a frame waiting in the outgoing queue, ending at mEndOffset bytes
+        // after everything ever queued
+        struct OutgoingFrame
+        {
+          size_t mEndOffset {};
+          bool mEvent {};
+        };
+
+        typedef std::deque<OutgoingFrame> OutgoingFrameList;
         typedef std::set<ProviderInfo *> ProviderInfoSet;
         typedef std::map<UUID, ProviderInfo *> ProviderInfoUUIDMap;
         typedef std::map<ProviderHandle, ProviderInfo *> ProviderInfoHandleMap;
@@ -204,7 +273,8 @@ namespace zsLib
         static RemoteEventingPtr connectToRemote(
                                                  IRemoteEventingDelegatePtr connectionDelegate,
                                                  const IPAddress &serverIP,
-                                                 const char *connectionSharedSecret
+                                                 const char *connectionSharedSecret,
+                                                 IMessageQueuePtr queue
                                                  );
         
         static RemoteEventingPtr listenForRemote(
@@ -214,17 +284,27 @@ namespace zsLib
                                                  Seconds maxWaitToBindTimeInSeconds
                                                  );
 
+        static RemoteEventingPtr replayFromFile(
+                                                IRemoteEventingDelegatePtr connectionDelegate,
+                                                const char *fileName,
+                                                double speed
+                                                ) throw (StdError);
+
         virtual PUID getID() const override { return mID; }
 
         virtual void shutdown() override;
 
         virtual States getState() const override;
 
+        virtual Statistics getStatistics() const override;
+
         virtual void setRemoteLevel(
                                     const char *remoteSubsystemName,
                                     Level level
                                     ) override;
 
+        virtual void recordTo(ITraceFileWriterPtr writer) override;
+
         //---------------------------------------------------------------------
         #pragma mark
         #pragma mark RemoteEventing => IWakeDelegate
@@ -303,10 +383,13 @@ namespace zsLib
                                                                  ProviderInfo *info,
                                                                  KeywordBitmaskType keyword
                                                                  ) override;
+        virtual void onRemoteEventingProviderSchema(ProviderInfo *info) override;
 
         virtual void onRemoteEventingWriteEvent(
                                                 ByteQueuePtr message,
-                                                size_t currentSize
+                                                size_t currentSize,
+                                                EventCounterSlot *counter,
+                                                bool timed
                                                 ) override;
         
       protected:
@@ -324,6 +407,7 @@ namespace zsLib
         bool isConnectingMode() const     { return 0 == mListenPort; }
         SocketPtr getActiveSocket() const { if (isListeningMode()) return mAcceptedSocket; return mConnectSocket; }
         bool isAuthorized() const         { return MessageType_Welcome == mHandshakeState; }
+        bool isReplayMode() const         { return (bool)mReplayReader; }
 
         void disconnect();
         void cancel();
@@ -338,12 +422,19 @@ namespace zsLib
         
         bool stepNotifyTimer();
         bool stepAuthorized();
+
+        void stepReplay();
         
         void setState(States state);
         void resetConnection();
         void prepareNewConnection();
         void readIncomingMessage();
         void sendOutgoingData();
+        void queuedOutgoingFrame(
+                                 size_t frameSize,
+                                 bool event = false
+                                 );
+        void sentOutgoingData(size_t sentSize);
 
         void sendData(
                       MessageTypes messageType,
@@ -382,13 +473,41 @@ namespace zsLib
         void handleNotifyRemoteSubsystem(const ElementPtr &rootEl);
         void handleNotifyRemoteProvider(const ElementPtr &rootEl);
         void handleNotifyRemoteProviderKeywordLogging(const ElementPtr &rootEl);
+        void handleNotifyRemoteProviderSchema(const ElementPtr &rootEl);
+        void attachRemoteProviderSchema(
+                                        ProviderInfo *provider,
+                                        const String &schemaStr
+                                        );
+        void handleNotifyEventCounters(const ElementPtr &rootEl);
         void handleRequest(const ElementPtr &rootEl);
         void handleRequestAck(const ElementPtr &rootEl);
         
-        void handleEvent(SecureByteBlock &buffer);
+        void handleEvent(
+                         BYTE *buffer,
+                         size_t bufferSize,
+                         Time eventTime
+                         );
+        void handleTimedEvent(SecureByteBlock &buffer);
+
+        static Microseconds::rep getCurrentTime();
+        void estimateRemoteClock(const ElementPtr &rootEl);
+        Microseconds getRemoteClockOffset() const;
+        void handleRemoteVersion(const ElementPtr &rootEl);
+
+        void recordIncoming(
+                            MessageTypes messageType,
+                            Time time,
+                            const BYTE *buffer,
+                            size_t bufferSize
+                            );
         
         void sendWelcome();
         void sendNotify();
+        void sendNotifyEventCounters();
+        static void updateHighWaterMark(
+                                        std::atomic<size_t> &mark,
+                                        size_t value
+                                        );
         void requestSetRemoteSubsystemLevel(SubsystemInfoPtr info);
         void requestSetRemoteEventProviderLogging(
                                                   const String &providerName,
@@ -402,6 +521,8 @@ namespace zsLib
                                                          ProviderInfo *info,
                                                          KeywordBitmaskType bitmask
                                                          );
+        void announceProviderSchemaToRemote(ProviderInfo *info);
+        String getProviderSchema(ProviderInfo *info) const;
         
         void announceSubsystemToRemote(SubsystemInfoPtr info);
 
@@ -424,8 +545,10 @@ namespace zsLib
         size_t mMaxQueuedAsyncDataBeforeEventsDropped {};
         size_t mMaxQueuedOutgoingDataBeforeEventsDropped {};
         bool mUseIPv6 {};
+        bool mNotifyEventCounters {};
         
         EventingAtomIndex mEventingAtomIndex {};
+        EventingAtomIndex mSchemaAtomIndex {};
 
         States mState {State_Pending};
 
@@ -436,6 +559,16 @@ namespace zsLib
         Time mBindFailureTime {};
         
         ITimerPtr mRebindTimer;
+
+        ITraceFileReaderPtr mReplayReader;
+        double mReplaySpeed {};
+        bool mReplayHasRecord {};
+        ITraceFileReader::Record mReplayRecord;
+        Time mReplayFirstRecordTime {};
+        Time mReplayStartTime {};
+        ITimerPtr mReplayTimer;
+
+        ITraceFileWriterPtr mRecordWriter;
         SocketPtr mBindSocket;
         SocketPtr mAcceptedSocket;
         IPAddress mRemoteIP;
@@ -480,6 +613,41 @@ namespace zsLib
         std::atomic<size_t> mOutstandingEvents {};
         std::atomic<size_t> mEventDataInAsyncQueue {};
         std::atomic<size_t> mEventDataInOutgoingQueue {};
+
+        // frames are counted as sent once their last byte is written
+        OutgoingFrameList mOutgoingFrames;
+        size_t mOutgoingBytesQueued {};
+        size_t mOutgoingBytesSent {};
+
+        // transport statistics (relaxed atomics so the snapshot never
+        // contends with the write path)
+        std::atomic<size_t> mStatEventsSent {};
+        std::atomic<size_t> mStatEventsReceived {};
+        std::atomic<size_t> mStatBytesSent {};
+        std::atomic<size_t> mStatBytesReceived {};
+        std::atomic<size_t> mStatFramesSent {};
+        std::atomic<size_t> mStatFramesReceived {};
+        std::atomic<size_t> mStatSendCalls {};
+        std::atomic<size_t> mStatReceiveCalls {};
+        std::atomic<size_t> mStatAsyncQueueHighWaterMark {};
+        std::atomic<size_t> mStatOutgoingQueueHighWaterMark {};
+        std::atomic<Microseconds::rep> mStatWriteBlockedTime {};
+        std::atomic<size_t> mStatEventsEncoded {};
+        std::atomic<Nanoseconds::rep> mStatEncodeTime {};   // estimated from the sampled encodes
+        std::atomic<Milliseconds::rep> mStatHandshakeDuration {};
+
+        SteadyTime mWriteBlockedStart {};
+        SteadyTime mHandshakeStart {};
+
+        // each side stamps its handshake messages with its clock; the reply
+        // to the message sent at this time yields the remote clock offset
+        Microseconds::rep mClockRequestTime {};
+        std::atomic<Microseconds::rep> mStatRemoteClockOffset {};
+        std::atomic<Microseconds::rep> mStatRemoteClockRoundTrip {-1};  // not estimated
+
+        // events are sent as MessageType_TimedTraceEvent once the remote is
+        // known to understand them
+        std::atomic<bool> mSendEventTimes {};
       };
     }
   }
@@ -487,6 +655,7 @@ namespace zsLib
 
 ZS_DECLARE_PROXY_BEGIN(zsLib::eventing::internal::IRemoteEventingAsyncDelegate)
 ZS_DECLARE_PROXY_TYPEDEF(zsLib::eventing::internal::IRemoteEventingInternalTypes::ProviderInfo, ProviderInfo)
+ZS_DECLARE_PROXY_TYPEDEF(zsLib::eventing::internal::IRemoteEventingInternalTypes::EventCounterSlot, EventCounterSlot)
 ZS_DECLARE_PROXY_TYPEDEF(zsLib::eventing::internal::IRemoteEventingAsyncDelegate::KeywordBitmaskType, KeywordBitmaskType)
 ZS_DECLARE_PROXY_TYPEDEF(zsLib::eventing::internal::IRemoteEventingAsyncDelegate::ByteQueuePtr, ByteQueuePtr)
 ZS_DECLARE_PROXY_TYPEDEF(std::size_t, size_t)
@@ -496,5 +665,6 @@ ZS_DECLARE_PROXY_METHOD_1(onRemoteEventingNewSubsystem, const char *)
 ZS_DECLARE_PROXY_METHOD_1(onRemoteEventingProviderRegistered, ProviderInfo *)
 ZS_DECLARE_PROXY_METHOD_1(onRemoteEventingProviderUnregistered, ProviderInfo *)
 ZS_DECLARE_PROXY_METHOD_2(onRemoteEventingProviderLoggingStateChanged, ProviderInfo *, KeywordBitmaskType)
-ZS_DECLARE_PROXY_METHOD_2(onRemoteEventingWriteEvent, ByteQueuePtr, size_t)
+ZS_DECLARE_PROXY_METHOD_1(onRemoteEventingProviderSchema, ProviderInfo *)
+ZS_DECLARE_PROXY_METHOD_4(onRemoteEventingWriteEvent, ByteQueuePtr, size_t, EventCounterSlot *, bool)
 ZS_DECLARE_PROXY_END()
@@ -0,0 +1,114 @@
+/*
+
+Copyright (c) 2016, Robin Raymond
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are those
+of the authors and should not be interpreted as representing official policies,
+either expressed or implied, of the FreeBSD Project.
+
+*/
+
+
+#pragma once
+
+#include <zsLib/eventing/internal/types.h>
+#include <zsLib/eventing/ITraceFile.h>
+#include <zsLib/eventing/Log.h>
+
+#include <zsLib/Log.h>
+
+#include <cryptopp/queue.h>
+
+namespace zsLib
+{
+  namespace eventing
+  {
+    namespace internal
+    {
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark TraceEventCodec
+      #pragma mark
+
+      // Encodes / decodes the "trace event" payload shared by the remote
+      // eventing wire protocol and the on disk recorder formats. Multi-byte
+      // header values are big endian; numeric parameter data is flagged (bit
+      // 31 of the data size) so a reader on a different endian host can flip.
+      class TraceEventCodec
+      {
+      public:
+        ZS_DECLARE_TYPEDEF_PTR(CryptoPP::ByteQueue, ByteQueue);
+
+        typedef zsLib::Log::ProviderHandle ProviderHandle;
+        typedef zsLib::Log::Severity Severity;
+        typedef zsLib::Log::Level Level;
+
+        typedef ITraceFileTypes::TraceEvent DecodedEvent;
+
+        // size of the encoded payload (not including any outer framing)
+        static size_t getEncodedSize(
+                                     EVENT_DATA_DESCRIPTOR_HANDLE dataDescriptor,
+                                     size_t dataDescriptorCount,
+                                     size_t maxDataSize
+                                     );
+
+        static void encode(
+                           ByteQueue &outQueue,
+                           ProviderHandle handle,
+                           Severity severity,
+                           Level level,
+                           EVENT_DESCRIPTOR_HANDLE descriptor,
+                           EVENT_PARAMETER_DESCRIPTOR_HANDLE parameterDescriptor,
+                           EVENT_DATA_DESCRIPTOR_HANDLE dataDescriptor,
+                           size_t dataDescriptorCount,
+                           size_t maxDataSize
+                           );
+
+        // decodes in place; the data descriptors point into (and numeric
+        // values are flipped to host order within) the supplied buffer
+        static bool decode(
+                           BYTE *buffer,
+                           size_t bufferSize,
+                           DecodedEvent &outEvent
+                           );
+
+        // reads only the leading handle / event ID of an encoded event
+        // without validating (or touching) the remainder of the payload
+        static bool peek(
+                         const BYTE *buffer,
+                         size_t bufferSize,
+                         uint64_t &outHandle,
+                         size_t &outEventID
+                         );
+
+      protected:
+        static Log::Params slog(const char *message);
+      };
+
+    }
+  }
+}
@@ -0,0 +1,436 @@
+/*
+
+Copyright (c) 2016, Robin Raymond
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are those
+of the authors and should not be interpreted as representing official policies,
+either expressed or implied, of the FreeBSD Project.
+
+*/
+
+
+
+#pragma once
+
+#include <zsLib/eventing/internal/types.h>
+
+#include <zsLib/eventing/ITraceFile.h>
+
+#include <cryptopp/queue.h>
+
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif //_WIN32
+
+#define ZSLIB_EVENTING_SETTING_TRACE_FILE_CHUNK_SIZE                                            "zsLib/eventing/trace-file/chunk-size-in-bytes"
+#define ZSLIB_EVENTING_SETTING_TRACE_FILE_COMPRESS                                              "zsLib/eventing/trace-file/compress"
+#define ZSLIB_EVENTING_SETTING_TRACE_FILE_DICTIONARY_SIZE                                       "zsLib/eventing/trace-file/dictionary-size-in-bytes"
+#define ZSLIB_EVENTING_SETTING_TRACE_FILE_VERIFY_COMPRESSION                                    "zsLib/eventing/trace-file/verify-compression"
+#define ZSLIB_EVENTING_SETTING_TRACE_FILE_INDEX_VALUES                                          "zsLib/eventing/trace-file/index-values"
+
+#define ZSLIB_EVENTING_TRACE_FILE_MAGIC "zsTF"
+#define ZSLIB_EVENTING_TRACE_FILE_CHUNK_MAGIC "zsTC"
+#define ZSLIB_EVENTING_TRACE_FILE_INDEX_MAGIC "zsTI"
+#define ZSLIB_EVENTING_TRACE_FILE_BLOCK_MAGIC "zsTB"
+#define ZSLIB_EVENTING_TRACE_FILE_VERSION (2)
+#define ZSLIB_EVENTING_TRACE_FILE_HEADER_SIZE (64)
+#define ZSLIB_EVENTING_TRACE_FILE_BLOCK_HEADER_SIZE (sizeof(CryptoPP::word32)*4)
+#define ZSLIB_EVENTING_TRACE_FILE_TRAILER_SIZE (16)
+#define ZSLIB_EVENTING_TRACE_FILE_RECORD_HEADER_SIZE ((sizeof(CryptoPP::word32)*2) + sizeof(uint64_t))
+#define ZSLIB_EVENTING_TRACE_FILE_MIN_CHUNK_SIZE (4*1024)
+#define ZSLIB_EVENTING_TRACE_FILE_VALUE_FILTER_BITS_PER_VALUE (10)
+#define ZSLIB_EVENTING_TRACE_FILE_VALUE_FILTER_HASHES (7)
+#define ZSLIB_EVENTING_TRACE_FILE_VALUE_FILTER_MAX_HASHES (32)
+
+namespace zsLib
+{
+  namespace eventing
+  {
+    namespace internal
+    {
+      // File layout (all multi-byte values are big endian):
+      //
+      //   header (ZSLIB_EVENTING_TRACE_FILE_HEADER_SIZE bytes)
+      //     [0]   magic "zsTF"
+      //     [4]   version (32 bits)
+      //     [8]   header size (32 bits)
+      //     [16]  creation time in microseconds since epoch (64 bits)
+      //     [24]  clock offset in microseconds (64 bits, signed)
+      //     [32]  chunk size the writer aimed for (64 bits)
+      //     [40]  dictionary size (32 bits)
+      //     [64]  dictionary, the header size includes it
+      //   chunk (repeated)
+      //     block:   magic "zsTB", codec (32 bits), decoded size (32 bits),
+      //              stored size (32 bits), stored data; the decoded data
+      //              is the chunk's records
+      //     records: size (32 bits, includes type + time + payload),
+      //              type (32 bits), time (64 bits, microseconds since
+      //              epoch), payload
+      //     footer:  magic "zsTC", footer size (32 bits), record data size
+      //              (64 bits), first time (64 bits), last time (64 bits),
+      //              total records (32 bits), total handles (32 bits),
+      //              handles (n x 64 bits), event ID bitmap, optionally
+      //              followed by the value filter: total hashes (32 bits),
+      //              filter size (32 bits), filter bits
+      //   index
+      //     magic "zsTI", total chunks (32 bits), footer offsets (n x 64 bits)
+      //   trailer (ZSLIB_EVENTING_TRACE_FILE_TRAILER_SIZE bytes)
+      //     index offset (64 bits), index size (32 bits), magic "zsTF"
+      //
+      // A block can never start with the chunk magic which allows a reader
+      // to find the chunk footers by skipping the blocks when the index was
+      // never written.
+      //
+      // The footer size covers any value filter so readers that predate it
+      // skip it and a footer without one means the values were not indexed.
+      //
+      // Blocks are compressed independently with the BlockCodec using the
+      // dictionary from the header (trained on the first chunk written) so
+      // any chunk can still be decoded on its own after a seek.
+
+      enum BlockCodecs
+      {
+        BlockCodec_Stored =   0,
+        BlockCodec_LZ =       1,
+      };
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark TraceFileWriter
+      #pragma mark
+
+      class TraceFileWriter : public ITraceFileWriter
+      {
+      protected:
+        struct make_private {};
+
+      public:
+        friend interaction ITraceFileWriter;
+        ZS_DECLARE_TYPEDEF_PTR(CryptoPP::ByteQueue, ByteQueue);
+
+        typedef std::map<String, String> SubsystemAnnouncementMap;
+        typedef std::map<uint64_t, String> ProviderAnnouncementMap;
+        typedef std::list<uint64_t> FooterOffsetList;
+        typedef std::set<uint64_t> ValueHashSet;
+
+      public:
+        TraceFileWriter(
+                        const make_private &,
+                        const char *fileName,
+                        size_t chunkSizeInBytes
+                        );
+        ~TraceFileWriter();
+
+      protected:
+        void init() throw (StdError);
+
+      protected:
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark TraceFileWriter => ITraceFileWriter
+        #pragma mark
+
+        static TraceFileWriterPtr create(
+                                         const char *fileName,
+                                         size_t chunkSizeInBytes
+                                         ) throw (StdError);
+
+        virtual PUID getID() const override {return mID;}
+
+        virtual String getFileName() const override {return mFileName;}
+
+        virtual void setClockOffset(Microseconds offset) override;
+
+        virtual void writeRecord(
+                                 RecordTypes type,
+                                 Time time,
+                                 const BYTE *payload,
+                                 size_t payloadSize
+                                 ) throw (StdError) override;
+
+        virtual void close() throw (StdError) override;
+
+        virtual size_t getTotalRecords() const override;
+
+        virtual CompressionStats getCompressionStats() const override;
+
+      protected:
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark TraceFileWriter => (internal)
+        #pragma mark
+
+        Log::Params log(const char *message) const;
+
+        void appendRecord(
+                          RecordTypes type,
+                          uint64_t time,
+                          const BYTE *payload,
+                          size_t payloadSize
+                          );
+        void indexValues(
+                         const BYTE *payload,
+                         size_t payloadSize
+                         );
+        void appendAnnouncements(uint64_t time);
+        void updateAnnouncements(
+                                 const BYTE *payload,
+                                 size_t payloadSize
+                                 );
+
+        void writeHeader(
+                         const BYTE *samples,
+                         size_t samplesSize
+                         ) throw (StdError);
+        void flushChunk() throw (StdError);
+        void writeBlock(
+                        const BYTE *data,
+                        size_t dataSize
+                        ) throw (StdError);
+        void writeFile(
+                       const BYTE *buffer,
+                       size_t length
+                       ) throw (StdError);
+
+      protected:
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark TraceFileWriter => (data)
+        #pragma mark
+
+        mutable RecursiveLock mLock;
+        AutoPUID mID;
+        TraceFileWriterWeakPtr mThisWeak;
+
+        String mFileName;
+        size_t mChunkSize {};
+        bool mCompress {};
+        size_t mMaxDictionarySize {};
+        bool mVerifyCompression {};
+        bool mIndexValues {};
+
+        FILE *mFile {};
+        Time mCreationTime {};
+        bool mWroteHeader {};
+        SecureByteBlockPtr mDictionary;
+        uint64_t mOffset {};
+        Microseconds mClockOffset {};
+
+        ByteQueue mChunk;
+        size_t mChunkRecords {};
+        uint64_t mChunkFirstTime {};
+        uint64_t mChunkLastTime {};
+        ProviderHandleSet mChunkProviderHandles;
+        EventIDBitmap mChunkEventIDs;
+        ValueHashSet mChunkValueHashes;
+        SecureByteBlock mDecodeBuffer;
+
+        FooterOffsetList mFooterOffsets;
+        size_t mTotalRecords {};
+        CompressionStats mCompressionStats;
+        SecureByteBlock mVerifyWindow;
+
+        SubsystemAnnouncementMap mSubsystemAnnouncements;
+        ProviderAnnouncementMap mProviderAnnouncements;
+        ProviderAnnouncementMap mProviderLoggingAnnouncements;
+      };
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark TraceFileReader
+      #pragma mark
+
+      class TraceFileReader : public ITraceFileReader
+      {
+      protected:
+        struct make_private {};
+
+      public:
+        friend interaction ITraceFileReader;
+        friend class TraceFileChunkCursor;
+
+        // where reading is up to in the chunks (the reader has its own and
+        // so does every cursor)
+        struct ChunkState
+        {
+          size_t mCurrentChunk {};
+          SecureByteBlock mChunkWindow;
+          const BYTE *mChunkData {};
+          size_t mChunkDataSize {};
+          size_t mPosition {};
+
+          void seekToChunk(size_t chunkIndex);
+        };
+
+      public:
+        TraceFileReader(
+                        const make_private &,
+                        const char *fileName
+                        );
+        ~TraceFileReader();
+
+      protected:
+        void init() throw (StdError);
+
+      protected:
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark TraceFileReader => ITraceFileReader
+        #pragma mark
+
+        static TraceFileReaderPtr open(const char *fileName) throw (StdError);
+
+        virtual PUID getID() const override {return mID;}
+
+        virtual String getFileName() const override {return mFileName;}
+
+        virtual Time getCreationTime() const override {return mCreationTime;}
+        virtual Microseconds getClockOffset() const override {return mClockOffset;}
+
+        virtual ChunkInfoListPtr getChunks() const override {return mChunks;}
+
+        virtual ChunkInfoListPtr findChunks(
+                                            Time fromTime,
+                                            Time toTime,
+                                            const Optional<uint64_t> &providerHandle = Optional<uint64_t>(),
+                                            const Optional<size_t> &eventID = Optional<size_t>()
+                                            ) const override;
+
+        virtual void seekToChunk(size_t chunkIndex) override;
+        virtual void seek(Time time) override;
+
+        virtual bool readNext(Record &outRecord) override;
+        virtual bool readNextInChunk(Record &outRecord) override;
+
+        virtual ITraceFileChunkCursorPtr createChunkCursor() override;
+
+      protected:
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark TraceFileReader => (internal)
+        #pragma mark
+
+        Log::Params log(const char *message) const;
+
+        void mapFile() throw (StdError);
+        void unmapFile();
+
+        // (only reads the mapped file which never changes once opened)
+        bool loadChunk(ChunkState &ioState) const;
+        bool readRecord(
+                        ChunkState &ioState,
+                        Record &outRecord
+                        ) const;
+
+        bool readIndex();
+        void recoverIndex();
+        bool readFooter(
+                        uint64_t footerOffset,
+                        ChunkInfo &outInfo
+                        ) const;
+
+      protected:
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark TraceFileReader => (data)
+        #pragma mark
+
+        mutable RecursiveLock mLock;
+        AutoPUID mID;
+        TraceFileReaderWeakPtr mThisWeak;
+
+        String mFileName;
+
+#ifdef _WIN32
+        HANDLE mFile {INVALID_HANDLE_VALUE};
+        HANDLE mFileMapping {NULL};
+#else
+        int mFile {-1};
+#endif //_WIN32
+        const BYTE *mMapped {};
+        size_t mMappedSize {};
+
+        size_t mHeaderSize {};
+        const BYTE *mDictionary {};
+        size_t mDictionarySize {};
+
+        Time mCreationTime {};
+        Microseconds mClockOffset {};
+
+        ChunkInfoListPtr mChunks;
+
+        ChunkState mState;
+      };
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark TraceFileChunkCursor
+      #pragma mark
+
+      class TraceFileChunkCursor : public ITraceFileChunkCursor
+      {
+      protected:
+        struct make_private {};
+
+      public:
+        TraceFileChunkCursor(
+                             const make_private &,
+                             TraceFileReaderPtr reader
+                             );
+
+        static TraceFileChunkCursorPtr create(TraceFileReaderPtr reader);
+
+      protected:
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark TraceFileChunkCursor => ITraceFileChunkCursor
+        #pragma mark
+
+        virtual void seekToChunk(size_t chunkIndex) override;
+        virtual bool readNextInChunk(Record &outRecord) override;
+
+      protected:
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark TraceFileChunkCursor => (data)
+        #pragma mark
+
+        TraceFileReaderPtr mReader;               // keeps the file mapped
+        TraceFileReader::ChunkState mState;
+      };
+
+    }
+  }
+}
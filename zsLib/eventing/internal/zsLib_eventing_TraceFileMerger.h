@@ -0,0 +1,178 @@
+/*
+
+Copyright (c) 2016, Robin Raymond
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are those
+of the authors and should not be interpreted as representing official policies,
+either expressed or implied, of the FreeBSD Project.
+
+*/
+
+
+
+#pragma once
+
+#include <zsLib/eventing/internal/types.h>
+
+#include <zsLib/eventing/ITraceFile.h>
+
+#include <zsLib/Log.h>
+
+namespace zsLib
+{
+  namespace eventing
+  {
+    namespace internal
+    {
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark TraceFileMerger
+      #pragma mark
+
+      // Streaming k-way merge of trace files. Only the current record of each
+      // input is held (the readers map the files and decode a single chunk at
+      // a time) so memory use does not depend on the size of the inputs.
+      // Each input is expected to be in time order as written by its
+      // recorder; any local disorder within an input is passed through.
+      class TraceFileMerger : public ITraceFileTypes
+      {
+      protected:
+        struct make_private {};
+
+      public:
+        friend interaction ITraceFileWriter;
+
+        typedef std::map<uint64_t, uint64_t> HandleMap;
+        typedef std::map<uint64_t, size_t> HandleReferenceMap;
+        typedef std::map<String, uint64_t> ProviderHandleMap;
+        typedef std::map<uint64_t, String> ProviderIDMap;
+        typedef std::map<uint64_t, String> NotifyMap;
+        typedef std::set<uint64_t> HandleSet;
+        typedef std::set<String> StringSet;
+
+        struct Input
+        {
+          ITraceFileReaderPtr mReader;
+          Microseconds mClockOffset {};
+
+          Record mRecord;
+          Time mTime {};
+
+          // input provider handle -> merged provider handle
+          HandleMap mHandles;
+        };
+
+        typedef std::vector<Input> InputList;
+
+        typedef std::pair<Time, size_t> PendingRecord;
+        typedef std::vector<PendingRecord> PendingRecordList;
+
+      public:
+        TraceFileMerger(
+                        const make_private &,
+                        const char *outputFileName,
+                        const StringList &inputFileNames
+                        );
+
+      protected:
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark TraceFileMerger => ITraceFileWriter
+        #pragma mark
+
+        static size_t merge(
+                            const char *outputFileName,
+                            const StringList &inputFileNames
+                            ) throw (StdError);
+
+      protected:
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark TraceFileMerger => (internal)
+        #pragma mark
+
+        Log::Params log(const char *message) const;
+
+        void process() throw (StdError);
+        bool readNext(size_t inputIndex);
+
+        void mergeNotify(Input &input) throw (StdError);
+        void mergeProvider(
+                           Input &input,
+                           ElementPtr rootEl
+                           ) throw (StdError);
+        void mergeProviderKeywordLogging(
+                                         Input &input,
+                                         ElementPtr rootEl
+                                         ) throw (StdError);
+        void mergeEventCounters(
+                                Input &input,
+                                ElementPtr rootEl
+                                ) throw (StdError);
+        void mergeEvent(Input &input) throw (StdError);
+
+        bool remapHandle(
+                         const Input &input,
+                         ElementPtr handleEl
+                         ) const;
+        uint64_t allocateHandle(uint64_t preferredHandle);
+
+        void writeNotify(
+                         const Input &input,
+                         const String &message
+                         ) throw (StdError);
+
+      protected:
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark TraceFileMerger => (data)
+        #pragma mark
+
+        AutoPUID mID;
+
+        String mOutputFileName;
+        StringList mInputFileNames;
+
+        ITraceFileWriterPtr mWriter;
+        InputList mInputs;
+
+        HandleSet mUsedHandles;
+        uint64_t mNextHandle {1};
+        HandleReferenceMap mHandleReferences;
+        ProviderHandleMap mHandlesByProviderID;
+        ProviderIDMap mProviderIDsByHandle;
+
+        StringSet mSubsystemAnnouncements;
+        NotifyMap mKeywordLoggingAnnouncements;
+
+        SecureByteBlock mEventBuffer;
+        size_t mTotalRemappedHandles {};
+      };
+
+    }
+  }
+}
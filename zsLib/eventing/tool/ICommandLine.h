@@ -56,6 +56,7 @@ namespace zsLib
       interaction ICommandLineTypes
       {
         ZS_DECLARE_TYPEDEF_PTR(std::list<String>, StringList);
+        ZS_DECLARE_TYPEDEF_PTR(std::list<IPAddress>, IPAddressList);
         ZS_DECLARE_CUSTOM_EXCEPTION(NoopException);
 
         enum Flags
@@ -78,27 +79,105 @@ namespace zsLib
           Flag_MonitorIP,
           Flag_MonitorTimeout,
           Flag_MonitorJMAN,
+          Flag_MonitorJMANFolder,
+          Flag_MonitorSchemaCache,
           Flag_MonitorJSON,
+          Flag_MonitorNDJSON,
+          Flag_MonitorCSV,
+          Flag_MonitorBinary,
+          Flag_MonitorOutputFile,
+          Flag_MonitorRotateSize,
+          Flag_MonitorRotateTime,
+          Flag_MonitorRetain,
+          Flag_MonitorCompress,
+          Flag_MonitorStats,
+          Flag_MonitorLatency,
+          Flag_MonitorCorrelate,
+          Flag_MonitorHeavyHitters,
+          Flag_MonitorHeavyHittersTop,
+          Flag_MonitorFilter,
           Flag_MonitorProvider,
           Flag_MonitorSecret,
-
-          Flag_Last = Flag_MonitorSecret,
+          Flag_MonitorTopTalkers,
+          Flag_MonitorReplay,
+          Flag_MonitorReplaySpeed,
+          Flag_MonitorRecord,
+          Flag_TraceMerge,
+          Flag_TraceSummarize,
+          Flag_TraceQuery,
+          Flag_TraceFrom,
+          Flag_TraceTo,
+          Flag_TraceExport,
+          Flag_TraceConvert,
+          Flag_SelfTest,
+          Flag_Benchmark,
+
+          Flag_Last = Flag_Benchmark,
         };
 
         static Flags toFlag(const char *str);
         static const char *toString(Flags flag);
-        
+
+        enum OutputFormats
+        {
+          OutputFormat_None,
+          OutputFormat_JSON,      // one json document (complete once the monitor quits)
+          OutputFormat_NDJSON,    // one json event per line
+          OutputFormat_CSV,       // one file per event type (in the output path folder)
+          OutputFormat_Binary,    // compact binary events (to the output path file)
+        };
+
         struct MonitorInfo
         {
           bool mMonitor {};
           bool mQuietMode {};
-          IPAddress mIPAddress;
+          IPAddressList mIPAddresses;             // events from every connected remote are merged in event time order
           WORD mPort {IRemoteEventingTypes::Port_Default};
           Seconds mTimeout {};
           StringList mJMANFiles;
-          bool mOutputJSON {};
+          String mJMANFolder;                     // jman files loaded only once a remote has their provider
+          String mSchemaCacheFile;                // compiled jman schemas (rebuilt when missing or stale)
+          OutputFormats mOutputFormat {OutputFormat_None};
+          String mOutputPath;
+          ULONGLONG mRotateSize {};               // output files are rotated by size
+          Seconds mRotateTime {};                 // and/or by age
+          size_t mRetainFiles {};                 // rotated files kept per output file (0 = all)
+          bool mCompressRotated {};
+          Seconds mStatsInterval {};              // aggregate events instead of outputting them
+          Seconds mLatencyInterval {};            // measure start/stop task spans instead of outputting events
+          String mCorrelationField;               // pairs start/stop events with the same field value
+          StringList mHeavyHitterFields;          // approximate most frequent values (output with the stats)
+          size_t mHeavyHittersTop {10};
+          String mFilter;                         // only events matching this expression are monitored
           String mSecret;
           StringList mSubscribeProviders;
+          size_t mTopTalkers {};
+          String mReplayFile;
+          double mReplaySpeed {};
+          String mRecordFile;
+        };
+
+        typedef std::pair<String, String> QueryCondition;     // value name, value
+        typedef std::list<QueryCondition> QueryConditionList;
+
+        struct TraceInfo
+        {
+          String mMergeOutputFile;
+          StringList mMergeFiles;
+          String mSummarizeFile;
+          String mQueryFile;
+          QueryConditionList mQueryConditions;
+          Time mFrom {};
+          Time mTo {};
+          String mExportFile;
+          String mExportDirectory;
+          String mConvertRingFile;                // flight recorder ring file
+          String mConvertOutputFile;
+          StringList mJMANFiles;
+          bool mSelfTest {};                      // check the codecs against known results
+          bool mBenchmark {};                     // time the json output against the element tree path
+
+          bool hasCommand() const {return mMergeOutputFile.hasData() || mSummarizeFile.hasData() || mQueryFile.hasData() || mExportFile.hasData() || mConvertRingFile.hasData() || mSelfTest || mBenchmark;}
         };
       };
 
@@ -129,17 +208,20 @@ namespace zsLib
         static void prepare(
                             StringList arguments,
                             MonitorInfo &outMonitor,
+                            TraceInfo &outTrace,
                             ICompilerTypes::Config &outConfig,
                             bool &outDidOutputHelp
                             ) throw (InvalidArgument);
 
         static void validate(
                              MonitorInfo &monitor,
+                             TraceInfo &trace,
                              ICompilerTypes::Config &config,
                              bool didOutputHelp
                              ) throw (InvalidArgument, NoopException);
         static void process(
                             MonitorInfo &monitor,
+                            TraceInfo &trace,
                             ICompilerTypes::Config &config
                             ) throw (Failure);
         
@@ -35,8 +35,16 @@ either expressed or implied, of the FreeBSD Project.
 
 #include <vector>
 #include <map>
+#include <list>
 
+#include <chrono>
+#include <condition_variable>
 #include <iostream>
+#include <thread>
+
+#define ZS_EVENTING_TOOL_OUTPUT_LINE_BUFFER_SIZE (256)
+#define ZS_EVENTING_TOOL_OUTPUT_BLOCK_SIZE (64*1024)
+#define ZS_EVENTING_TOOL_OUTPUT_DEFAULT_FLUSH_INTERVAL_IN_MILLISECONDS (100)
 
 #ifndef _WIN32
 #define TEXT(xText) xText
@@ -121,6 +129,11 @@ namespace zsLib
       #pragma mark tool_basic_streambuf
       #pragma mark
 
+      // Output is collected per insertion (not per character) and handed to
+      // the output delegates on each newline. In block buffered mode it is
+      // only handed over once a block is full, the flush interval passes or
+      // on an explicit flush; with a background writer the delegates are
+      // called from a separate thread so writers never wait on them.
       template < typename T, class CharTraits = std::char_traits< T > >
       class tool_basic_streambuf : private std::basic_streambuf< T, CharTraits >
       {
@@ -129,6 +142,7 @@ namespace zsLib
         typedef typename CharTraits::char_type char_type;
         typedef typename CharTraits::int_type int_type;
         typedef std::vector<T> BufferType;
+        typedef std::list<BufferType> BufferList;
 
       public:
         //---------------------------------------------------------------------
@@ -138,39 +152,234 @@ namespace zsLib
 #ifdef _WIN32
           _Init(NULL, NULL, NULL, &pBegin, &pCurrent, &pLength);
 #endif //_WIN32
-          m_outputBuffer.reserve(32);
+          m_outputBuffer.reserve(ZS_EVENTING_TOOL_OUTPUT_LINE_BUFFER_SIZE);
         }
 
-      protected:
         //---------------------------------------------------------------------
-        virtual int_type overflow(int_type c = CharTraits::eof())
+        ~tool_basic_streambuf()
         {
+          close();
+        }
+
+        //---------------------------------------------------------------------
+        void setBlockBuffering(
+                               bool enabled,
+                               bool backgroundWriter = true,
+                               Milliseconds flushInterval = Milliseconds(ZS_EVENTING_TOOL_OUTPUT_DEFAULT_FLUSH_INTERVAL_IN_MILLISECONDS)
+                               )
+        {
+          stopWriter();
+
           AutoRecursiveLock lock(mLock);
 
+          writeBuffer();
+
+          mBlockBuffered = enabled;
+          mFlushInterval = flushInterval;
+          mLastFlush = std::chrono::steady_clock::now();
+
+          if (enabled) {
+            m_outputBuffer.reserve(ZS_EVENTING_TOOL_OUTPUT_BLOCK_SIZE);
+          }
+
+          if ((enabled) &&
+              (backgroundWriter)) {
+            {
+              AutoLock writerLock(mWriterLock);
+              mWriterShutdown = false;
+            }
+            mBackgroundWriter = true;
+            mWriter = std::thread(&tool_basic_streambuf::runWriter, this);
+          }
+        }
+
+        //---------------------------------------------------------------------
+        // output everything and return to line buffering
+        void close()
+        {
+          setBlockBuffering(false);
+        }
+
+      protected:
+        //---------------------------------------------------------------------
+        virtual int_type overflow(int_type c = CharTraits::eof())
+        {
           if (c == CharTraits::eof())
             return CharTraits::not_eof(c);
 
-          m_outputBuffer.push_back(static_cast<char_type>(c));
-          if (c == TEXT('\n'))
-            sync();
-
+          char_type value = static_cast<char_type>(c);
+          xsputn(&value, 1);
           return c;
         }
 
         //---------------------------------------------------------------------
-        int sync()
+        virtual std::streamsize xsputn(
+                                       const char_type *s,
+                                       std::streamsize count
+                                       )
         {
+          if (count < 1) return 0;
+
           AutoRecursiveLock lock(mLock);
 
-          m_outputBuffer.push_back(TEXT('\0'));
+          m_outputBuffer.insert(m_outputBuffer.end(), s, s + count);
 
-          mOutputer.output(reinterpret_cast<const T*>(&m_outputBuffer[0]));
+          if (!mBlockBuffered) {
+            if (CharTraits::find(s, static_cast<size_t>(count), TEXT('\n'))) writeBuffer();
+            return count;
+          }
 
-          m_outputBuffer.clear();
-          m_outputBuffer.reserve(32);
+          if (m_outputBuffer.size() >= ZS_EVENTING_TOOL_OUTPUT_BLOCK_SIZE) {
+            handOff();
+            return count;
+          }
+
+          // without a background writer the flush interval is checked as
+          // output is written
+          if (!mBackgroundWriter) {
+            auto now = std::chrono::steady_clock::now();
+            if (now - mLastFlush >= mFlushInterval) {
+              writeBuffer();
+              mLastFlush = now;
+            }
+          }
+          return count;
+        }
+
+        //---------------------------------------------------------------------
+        virtual int sync()
+        {
+          uint64_t target {};
+
+          {
+            AutoRecursiveLock lock(mLock);
+            if (!mBackgroundWriter) {
+              writeBuffer();
+              return 0;
+            }
+            handOff();
+
+            AutoLock writerLock(mWriterLock);
+            target = mTotalBlocksQueued;
+          }
+
+          mWriterWake.notify_one();
+
+          std::unique_lock<Lock> writerLock(mWriterLock);
+          while ((mTotalBlocksWritten < target) &&
+                 (!mWriterShutdown)) {
+            mWriterIdle.wait(writerLock);
+          }
           return 0;
         }
 
+        //---------------------------------------------------------------------
+        // (must be called while holding mLock)
+        void handOff()
+        {
+          if (m_outputBuffer.size() < 1) return;
+
+          if (!mBackgroundWriter) {
+            writeBuffer();
+            return;
+          }
+
+          {
+            AutoLock writerLock(mWriterLock);
+            mPendingBlocks.push_back(BufferType());
+            mPendingBlocks.back().swap(m_outputBuffer);
+            ++mTotalBlocksQueued;
+          }
+          m_outputBuffer.reserve(ZS_EVENTING_TOOL_OUTPUT_BLOCK_SIZE);
+
+          mWriterWake.notify_one();
+        }
+
+        //---------------------------------------------------------------------
+        // (must be called while holding mLock)
+        void writeBuffer()
+        {
+          if (m_outputBuffer.size() < 1) return;
+          writeBlock(m_outputBuffer);
+          m_outputBuffer.clear();
+        }
+
+        //---------------------------------------------------------------------
+        void writeBlock(BufferType &block)
+        {
+          block.push_back(TEXT('\0'));
+          mOutputer.output(reinterpret_cast<const T*>(&block[0]));
+        }
+
+        //---------------------------------------------------------------------
+        void runWriter()
+        {
+          while (true) {
+            {
+              std::unique_lock<Lock> writerLock(mWriterLock);
+              if ((mPendingBlocks.size() < 1) &&
+                  (!mWriterShutdown)) {
+                mWriterWake.wait_for(writerLock, mFlushInterval);
+              }
+            }
+
+            {
+              // anything left in the current block is output once the flush
+              // interval passes
+              AutoRecursiveLock lock(mLock);
+              handOff();
+            }
+
+            BufferList blocks;
+            bool shutdown {};
+
+            {
+              AutoLock writerLock(mWriterLock);
+              blocks.swap(mPendingBlocks);
+              shutdown = mWriterShutdown;
+            }
+
+            for (auto iter = blocks.begin(); iter != blocks.end(); ++iter) {
+              writeBlock(*iter);
+            }
+
+            {
+              AutoLock writerLock(mWriterLock);
+              mTotalBlocksWritten += blocks.size();
+            }
+            mWriterIdle.notify_all();
+
+            if (shutdown) return;
+          }
+        }
+
+        //---------------------------------------------------------------------
+        void stopWriter()
+        {
+          {
+            AutoLock writerLock(mWriterLock);
+            mWriterShutdown = true;
+          }
+          mWriterWake.notify_one();
+          mWriterIdle.notify_all();
+
+          if (mWriter.joinable()) mWriter.join();
+
+          AutoRecursiveLock lock(mLock);
+          mBackgroundWriter = false;
+
+          // blocks handed off after the writer's last pass
+          BufferList blocks;
+          {
+            AutoLock writerLock(mWriterLock);
+            blocks.swap(mPendingBlocks);
+            mTotalBlocksWritten += blocks.size();
+          }
+          for (auto iter = blocks.begin(); iter != blocks.end(); ++iter) {
+            writeBlock(*iter);
+          }
+        }
+
       protected:
         //---------------------------------------------------------------------
         RecursiveLock mLock;
@@ -181,6 +390,20 @@ namespace zsLib
         int_type pLength;
         BufferType m_outputBuffer;
         IOutputDelegate &mOutputer;
+
+        bool mBlockBuffered {};
+        bool mBackgroundWriter {};
+        Milliseconds mFlushInterval {ZS_EVENTING_TOOL_OUTPUT_DEFAULT_FLUSH_INTERVAL_IN_MILLISECONDS};
+        std::chrono::steady_clock::time_point mLastFlush {};
+
+        Lock mWriterLock;
+        std::condition_variable mWriterWake;
+        std::condition_variable mWriterIdle;
+        BufferList mPendingBlocks;
+        uint64_t mTotalBlocksQueued {};
+        uint64_t mTotalBlocksWritten {};
+        bool mWriterShutdown {};
+        std::thread mWriter;
       };
 
       //-----------------------------------------------------------------------
@@ -214,6 +437,24 @@ namespace zsLib
 #endif //_WIN32
         }
 
+        //---------------------------------------------------------------------
+        ~tool_basic_ostream()
+        {
+          // output what is buffered while the output delegates still exist
+          mStreamBuffer.close();
+        }
+
+        //---------------------------------------------------------------------
+        // see tool_basic_streambuf
+        void setBlockBuffering(
+                               bool enabled,
+                               bool backgroundWriter = true,
+                               Milliseconds flushInterval = Milliseconds(ZS_EVENTING_TOOL_OUTPUT_DEFAULT_FLUSH_INTERVAL_IN_MILLISECONDS)
+                               )
+        {
+          mStreamBuffer.setBlockBuffering(enabled, backgroundWriter, flushInterval);
+        }
+
         //---------------------------------------------------------------------
         void install(
                      PUID installID,
@@ -278,7 +519,7 @@ namespace zsLib
             AutoRecursiveLock lock(mLock);
             temp = mOutputs;
           }
-          for (auto iter = mOutputs->begin(); iter != mOutputs->end(); ++iter)
+          for (auto iter = temp->begin(); iter != temp->end(); ++iter)
           {
             (*iter).second->output(str);
           }
@@ -292,7 +533,7 @@ namespace zsLib
             AutoRecursiveLock lock(mLock);
             temp = mOutputs;
           }
-          for (auto iter = mOutputs->begin(); iter != mOutputs->end(); ++iter)
+          for (auto iter = temp->begin(); iter != temp->end(); ++iter)
           {
             (*iter).second->output(str);
           }
@@ -0,0 +1,470 @@
+/*
+
+Copyright (c) 2016, Robin Raymond
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are those
+of the authors and should not be interpreted as representing official policies,
+either expressed or implied, of the FreeBSD Project.
+
+*/
+
+
+#include <zsLib/eventing/tool/internal/zsLib_eventing_tool_BufferedWriter.h>
+#include <zsLib/eventing/tool/internal/zsLib_eventing_tool_Helper.h>
+
+#include <zsLib/Numeric.h>
+#include <zsLib/Singleton.h>
+
+#include <cryptopp/files.h>
+#include <cryptopp/gzip.h>
+
+#include <map>
+#include <thread>
+
+#include <stdio.h>
+
+namespace zsLib { namespace eventing { namespace tool { ZS_DECLARE_SUBSYSTEM(zsLib_eventing_tool) } } }
+
+namespace zsLib
+{
+  namespace eventing
+  {
+    namespace tool
+    {
+      namespace internal
+      {
+        ZS_DECLARE_CLASS_PTR(RotatedFilesWorker);
+
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark RotatedFilesWorker
+        #pragma mark
+
+        // one thread compresses and prunes rotated files for every writer
+        class RotatedFilesWorker
+        {
+        public:
+          //-------------------------------------------------------------------
+          ~RotatedFilesWorker()
+          {
+            // rotated files still waiting are processed before exiting
+            {
+              AutoLock lock(mLock);
+              mShutdown = true;
+            }
+            mAvailable.notify_all();
+            if (mThread.joinable()) mThread.join();
+          }
+
+          //-------------------------------------------------------------------
+          static RotatedFilesWorkerPtr singleton()
+          {
+            static SingletonLazySharedPtr<RotatedFilesWorker> singleton(make_shared<RotatedFilesWorker>());
+            return singleton.singleton();
+          }
+
+          //-------------------------------------------------------------------
+          static void post(
+                           BufferedWriter::RotatedFilesPtr files,
+                           const String &fileName
+                           )
+          {
+            {
+              AutoLock lock(files->mLock);
+              ++(files->mPending);
+            }
+
+            auto pThis = singleton();
+            if (pThis) {
+              AutoLock lock(pThis->mLock);
+              if (!pThis->mShutdown) {
+                pThis->mPending.push_back(Job(files, fileName));
+                if (!pThis->mThread.joinable()) {
+                  pThis->mThread = std::thread(&RotatedFilesWorker::run, pThis.get());
+                }
+                pThis->mAvailable.notify_one();
+                return;
+              }
+            }
+
+            // the worker is gone (shutting down) so the file is handled here
+            files->process(fileName);
+          }
+
+        private:
+          typedef std::pair<BufferedWriter::RotatedFilesPtr, String> Job;
+          typedef std::list<Job> JobList;
+
+          //-------------------------------------------------------------------
+          void run()
+          {
+            while (true) {
+              Job job;
+
+              {
+                std::unique_lock<Lock> lock(mLock);
+                while ((mPending.size() < 1) &&
+                       (!mShutdown)) {
+                  mAvailable.wait(lock);
+                }
+                if (mPending.size() < 1) return;
+
+                job = mPending.front();
+                mPending.pop_front();
+              }
+
+              job.first->process(job.second);
+            }
+          }
+
+        private:
+          Lock mLock;
+          std::condition_variable mAvailable;
+          JobList mPending;
+          bool mShutdown {};
+          std::thread mThread;
+        };
+
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark BufferedWriter::RotatedFiles
+        #pragma mark
+
+        //---------------------------------------------------------------------
+        void BufferedWriter::RotatedFiles::process(const String &fileName)
+        {
+          keep(mCompress ? compressFile(fileName) : fileName);
+
+          {
+            AutoLock lock(mLock);
+            --mPending;
+          }
+          mCompleted.notify_all();
+        }
+
+        //---------------------------------------------------------------------
+        void BufferedWriter::RotatedFiles::keep(const String &fileName)
+        {
+          StringList removeFiles;
+
+          {
+            AutoLock lock(mLock);
+            mKept.push_back(fileName);
+            while ((0 != mMaxRotatedFiles) &&
+                   (mKept.size() > mMaxRotatedFiles)) {
+              removeFiles.push_back(mKept.front());
+              mKept.pop_front();
+            }
+          }
+
+          for (auto iter = removeFiles.begin(); iter != removeFiles.end(); ++iter) {
+            ::remove(toPath(*iter));
+          }
+        }
+
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark BufferedWriter
+        #pragma mark
+
+        //---------------------------------------------------------------------
+        BufferedWriter::BufferedWriter(
+                                       const make_private &,
+                                       const String &fileName,
+                                       const RotationOptions &rotation,
+                                       const String &fileHeader
+                                       ) :
+          mFileName(fileName),
+          mStandardOutput("-" == fileName),
+          mRotation(rotation),
+          mFileHeader(fileHeader),
+          mLastFlush(std::chrono::steady_clock::now()),
+          mRotatedFiles(make_shared<RotatedFiles>())
+        {
+          mBuffer.reserve(ZS_EVENTING_TOOL_BUFFERED_WRITER_BLOCK_SIZE);
+
+          mRotatedFiles->mCompress = rotation.mCompress;
+          mRotatedFiles->mMaxRotatedFiles = rotation.mMaxRotatedFiles;
+        }
+
+        //---------------------------------------------------------------------
+        BufferedWriter::~BufferedWriter()
+        {
+          try {
+            flush();
+          } catch (const Failure &) {
+          }
+
+          // rotated files still waiting are compressed before exiting
+          std::unique_lock<Lock> lock(mRotatedFiles->mLock);
+          while (mRotatedFiles->mPending > 0) {
+            mRotatedFiles->mCompleted.wait(lock);
+          }
+        }
+
+        //---------------------------------------------------------------------
+        BufferedWriterPtr BufferedWriter::create(
+                                                 const String &fileName,
+                                                 const RotationOptions &rotation,
+                                                 const String &fileHeader
+                                                 ) throw (Failure)
+        {
+          auto pThis(make_shared<BufferedWriter>(make_private{}, fileName, rotation, fileHeader));
+          AutoLock lock(pThis->mLock);
+          if ((rotation.hasRotation()) &&
+              (!pThis->mStandardOutput)) {
+            pThis->resumeRotation();
+          }
+          pThis->startFile();
+          return pThis;
+        }
+
+        //---------------------------------------------------------------------
+        bool BufferedWriter::rotateIfNeeded() throw (Failure)
+        {
+          if (!mRotation.hasRotation()) return false;
+
+          AutoLock lock(mLock);
+
+          if (mStandardOutput) return false;
+          if (mFileSize <= mFileHeader.length()) return false;   // nothing written since the last rotation
+
+          auto now = std::chrono::steady_clock::now();
+
+          bool rotate = false;
+          if ((0 != mRotation.mMaxFileSize) &&
+              (mFileSize >= mRotation.mMaxFileSize)) rotate = true;
+          if ((Seconds() != mRotation.mMaxFileAge) &&
+              (now - mFileStarted >= mRotation.mMaxFileAge)) rotate = true;
+          if (!rotate) return false;
+
+          internalFlush();
+
+          ++mTotalRotations;
+          String rotatedFileName = mFileName + "." + string(mTotalRotations);
+
+          if (0 != ::rename(toPath(mFileName), toPath(rotatedFileName))) {
+            ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_SYSTEM_ERROR, String("Failed to rotate output file: ") + toPath(mFileName) + " to: " + toPath(rotatedFileName));
+          }
+
+          startFile();
+
+          RotatedFilesWorker::post(mRotatedFiles, rotatedFileName);
+          return true;
+        }
+
+        //---------------------------------------------------------------------
+        void BufferedWriter::write(
+                                   const void *buffer,
+                                   size_t size
+                                   ) throw (Failure)
+        {
+          AutoLock lock(mLock);
+
+          const BYTE *data = reinterpret_cast<const BYTE *>(buffer);
+          mBuffer.insert(mBuffer.end(), data, data + size);
+          mFileSize += size;
+
+          if (mBuffer.size() >= ZS_EVENTING_TOOL_BUFFERED_WRITER_BLOCK_SIZE) {
+            internalFlush();
+            return;
+          }
+
+          if (std::chrono::steady_clock::now() - mLastFlush >= Milliseconds(ZS_EVENTING_TOOL_BUFFERED_WRITER_FLUSH_INTERVAL_IN_MILLISECONDS)) {
+            internalFlush();
+          }
+        }
+
+        //---------------------------------------------------------------------
+        void BufferedWriter::flush() throw (Failure)
+        {
+          AutoLock lock(mLock);
+          internalFlush();
+        }
+
+        //---------------------------------------------------------------------
+        void BufferedWriter::internalFlush() throw (Failure)
+        {
+          mLastFlush = std::chrono::steady_clock::now();
+          if (mBuffer.size() < 1) return;
+
+          // the buffer is emptied even if writing fails so a failing file
+          // does not grow without limit
+          std::vector<BYTE> buffer;
+          buffer.reserve(ZS_EVENTING_TOOL_BUFFERED_WRITER_BLOCK_SIZE);
+          buffer.swap(mBuffer);
+
+          writeFile("ab", &(buffer[0]), buffer.size());
+        }
+
+        //---------------------------------------------------------------------
+        void BufferedWriter::writeFile(
+                                       const char *mode,
+                                       const BYTE *buffer,
+                                       size_t size
+                                       ) throw (Failure)
+        {
+          if (mStandardOutput) {
+            size_t written = (size > 0 ? fwrite(buffer, size, 1, stdout) : 1);
+            fflush(stdout);
+            if (1 != written) {
+              ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_SYSTEM_ERROR, "Failed to write to the standard output");
+            }
+            return;
+          }
+
+          String pathStr = toPath(mFileName);
+
+          FILE *file = NULL;
+#ifdef _WIN32
+          fopen_s(&file, pathStr, mode);
+#else
+          file = fopen(pathStr, mode);
+#endif //_WIN32
+          if (NULL == file) {
+            ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_SYSTEM_ERROR, String("Failed to open output file: ") + pathStr);
+          }
+
+          size_t written = (size > 0 ? fwrite(buffer, size, 1, file) : 1);
+          fclose(file);
+
+          if (1 != written) {
+            ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_SYSTEM_ERROR, String("Failed to write output file: ") + pathStr);
+          }
+        }
+
+        //---------------------------------------------------------------------
+        void BufferedWriter::startFile() throw (Failure)
+        {
+          if (!mStandardOutput) {
+            writeFile("wb", NULL, 0);
+          }
+
+          mFileSize = 0;
+          mFileStarted = std::chrono::steady_clock::now();
+
+          if (mFileHeader.hasData()) {
+            mBuffer.insert(mBuffer.end(), mFileHeader.begin(), mFileHeader.end());
+            mFileSize += mFileHeader.length();
+          }
+        }
+
+        //---------------------------------------------------------------------
+        void BufferedWriter::resumeRotation()
+        {
+          // look for "<file name>.<n>" and "<file name>.<n>.gz" left behind
+          // by an earlier run
+          String path(mFileName);
+          path.replaceAll("\\", "/");
+
+          String folder;
+          auto pos = path.rfind('/');
+          if (String::npos != pos) folder = path.substr(0, pos + 1);
+
+          String prefix = Helper::fileNameAfterPath(path) + ".";
+
+          StringList files;
+          try {
+            files = Helper::listFiles(folder, NULL);
+          } catch (const StdError &) {
+            return;
+          }
+
+          typedef std::map<size_t, StringList> RotatedMap;
+          RotatedMap rotated;
+
+          for (auto iter = files.begin(); iter != files.end(); ++iter) {
+            auto &filePath = (*iter);
+            String name = Helper::fileNameAfterPath(filePath);
+            if (name.length() <= prefix.length()) continue;
+            if (0 != name.compare(0, prefix.length(), prefix)) continue;
+
+            String numberStr = name.substr(prefix.length());
+            if ((numberStr.length() > 3) &&
+                (0 == numberStr.substr(numberStr.length() - 3).compareNoCase(".gz"))) {
+              numberStr = numberStr.substr(0, numberStr.length() - 3);
+            }
+            if (numberStr.isEmpty()) continue;
+            if (String::npos != numberStr.find_first_not_of("0123456789")) continue;
+
+            try {
+              rotated[Numeric<size_t>(numberStr)].push_back(folder + name);
+            } catch (const Numeric<size_t>::ValueOutOfRange &) {
+            }
+          }
+
+          if (rotated.size() < 1) return;
+
+          mTotalRotations = rotated.rbegin()->first;
+
+          // earlier files are kept as found (oldest first) and count towards
+          // the retention limit
+          for (auto iter = rotated.begin(); iter != rotated.end(); ++iter) {
+            auto &names = (*iter).second;
+            for (auto iterName = names.begin(); iterName != names.end(); ++iterName) {
+              mRotatedFiles->keep(*iterName);
+            }
+          }
+        }
+
+        //---------------------------------------------------------------------
+        String BufferedWriter::compressFile(const String &fileName)
+        {
+          String compressedFileName = fileName + ".gz";
+
+          try {
+            CryptoPP::FileSource source(toPath(fileName).c_str(), true, new CryptoPP::Gzip(new CryptoPP::FileSink(toPath(compressedFileName).c_str(), true)), true);
+          } catch (const CryptoPP::Exception &) {
+            // the rotated file is kept uncompressed
+            ::remove(toPath(compressedFileName));
+            return fileName;
+          }
+
+          ::remove(toPath(fileName));
+          return compressedFileName;
+        }
+
+        //---------------------------------------------------------------------
+        String BufferedWriter::toPath(const String &fileName)
+        {
+          String pathStr(fileName);
+#ifdef _WIN32
+          pathStr.replaceAll("/", "\\");
+#endif //_WIN32
+          return pathStr;
+        }
+
+      } // namespace internal
+    } // namespace tool
+  } // namespace eventing
+} // namespace zsLib
@@ -30,7 +30,10 @@ either expressed or implied, of the FreeBSD Project.
 */
 
 #include <zsLib/eventing/tool/internal/zsLib_eventing_tool_CommandLine.h>
+#include <zsLib/eventing/tool/internal/zsLib_eventing_tool_EventFilter.h>
 #include <zsLib/eventing/tool/internal/zsLib_eventing_tool_Monitor.h>
+#include <zsLib/eventing/tool/internal/zsLib_eventing_tool_SelfTest.h>
+#include <zsLib/eventing/tool/internal/zsLib_eventing_tool_TraceTool.h>
 #include <zsLib/eventing/tool/internal/zsLib_eventing_tool_IDLCompiler.h>
 
 #include <zsLib/eventing/tool/ICompiler.h>
@@ -131,9 +134,38 @@ namespace zsLib
           case Flag_MonitorIP:        return "connect";
           case Flag_MonitorTimeout:   return "timeout";
           case Flag_MonitorJMAN:      return "jman";
+          case Flag_MonitorJMANFolder: return "jman-dir";
+          case Flag_MonitorSchemaCache: return "schema-cache";
           case Flag_MonitorJSON:      return "output-json";
+          case Flag_MonitorNDJSON:    return "output-ndjson";
+          case Flag_MonitorCSV:       return "output-csv";
+          case Flag_MonitorBinary:    return "output-binary";
+          case Flag_MonitorOutputFile: return "output-file";
+          case Flag_MonitorRotateSize: return "rotate-size";
+          case Flag_MonitorRotateTime: return "rotate-time";
+          case Flag_MonitorRetain:    return "retain";
+          case Flag_MonitorCompress:  return "compress";
+          case Flag_MonitorStats:     return "stats";
+          case Flag_MonitorLatency:   return "latency";
+          case Flag_MonitorCorrelate: return "correlate";
+          case Flag_MonitorHeavyHitters: return "heavy-hitters";
+          case Flag_MonitorHeavyHittersTop: return "heavy-hitters-top";
+          case Flag_MonitorFilter:    return "filter";
           case Flag_MonitorProvider:  return "provider";
           case Flag_MonitorSecret:    return "secret";
+          case Flag_MonitorTopTalkers: return "top-talkers";
+          case Flag_MonitorReplay:    return "replay";
+          case Flag_MonitorReplaySpeed: return "replay-speed";
+          case Flag_MonitorRecord:    return "record";
+          case Flag_TraceMerge:       return "merge";
+          case Flag_TraceSummarize:   return "summarize";
+          case Flag_TraceQuery:       return "query";
+          case Flag_TraceFrom:        return "from";
+          case Flag_TraceTo:          return "to";
+          case Flag_TraceExport:      return "export";
+          case Flag_TraceConvert:     return "convert";
+          case Flag_SelfTest:         return "selftest";
+          case Flag_Benchmark:        return "benchmark";
         }
         return "unknown";
       }
@@ -174,13 +206,43 @@ namespace zsLib
           "                                           android - Java on Android\n"
           " -author       \"John Q Public\"           - manifest author.\n"
           " -monitor                                - monitor for remote events\n"
-          " -connect      ip                        - create an outgoing connection to eventing server IP\n"
+          " -connect      ip1 ... ipn               - create outgoing connections to eventing server IPs\n"
           " -port         listen_port               - listening port for server\n"
           " -timeout      n_seconds                 - how long to monitor before quitting\n"
           " -jman         jman_file_name_1...n      - input jman provider file\n"
+          " -jman-dir     jman_folder               - index the folder's jman files and load each when a remote has its provider\n"
+          " -schema-cache cache_file_name           - load the jman files from a compiled schema cache (updated when stale)\n"
           " -output-json                            - output events as json events to command line\n"
+          " -output-ndjson                          - output events to command line as one json event per line\n"
+          " -output-csv   output_folder             - output events as one csv file per event type (see -jman for names)\n"
+          " -output-binary output_file              - output events in a compact binary form (\"-\" for command line with -q)\n"
+          " -output-file  output_file               - output the -output-ndjson events to a file instead of the command line\n"
+          " -rotate-size  n_bytes                   - start a new output file once an output file reaches this size\n"
+          " -rotate-time  n_seconds                 - start a new output file once an output file is this old\n"
+          " -retain       n                         - keep only the n most recent rotated files of each output file\n"
+          " -compress                               - gzip rotated output files in the background\n"
+          " -stats        n_seconds                 - output event rates and value statistics every n seconds instead of events\n"
+          " -latency      n_seconds                 - output start/stop task span latency percentiles every n seconds instead of events\n"
+          " -correlate    field_name                - pair start/stop task events by this field's value (default: by task only)\n"
+          " -heavy-hitters field_name1...n          - with -stats, output the approximate most frequent values of these fields\n"
+          " -heavy-hitters-top n                    - number of most frequent values output per field (default 10)\n"
+          " -filter       expression                - only monitor events matching the expression, e.g. \"name==CallStart && durationMs>500\"\n"
+          "                                           (name, severity, level, subsystem or a jman field; == != < <= > >=, && || ! and parentheses)\n"
           " -provider     provider_name1...n        - subscribe to provider events by name\n"
           " -secret       connection_secret         - shared secret between client and server\n"
+          " -top-talkers  n                         - periodically output the n busiest events (by volume and drops)\n"
+          " -replay       trace_file_name           - monitor events from a recorded trace file instead of a remote\n"
+          " -replay-speed n                         - replay pacing multiplier (1 = original pace, 0 = as fast as possible)\n"
+          " -record       trace_file_name           - record the received events into a trace file\n"
+          " -merge        output_file input_1...n   - merge recorded trace files into one time ordered trace file\n"
+          " -summarize    trace_file_name           - summarize a recorded trace file using all cores (see -jman for names)\n"
+          " -query        trace_file name=value...n - output the recorded events whose values all match (see -jman for names)\n"
+          " -from         n_microseconds            - only query or export events at or after this time (since epoch)\n"
+          " -to           n_microseconds            - only query or export events at or before this time (since epoch)\n"
+          " -export       trace_file output_folder  - export the recorded events as one columnar table file per event type\n"
+          " -convert      ring_file trace_file      - convert a flight recorder ring file into a trace file (e.g. after a crash)\n"
+          " -selftest                               - check the trace file and output encoders against known results\n"
+          " -benchmark                              - time the streamed json output against the element tree output\n"
           "\n";
       }
 
@@ -229,6 +291,7 @@ namespace zsLib
         try
         {
           MonitorInfo monitorInfo;
+          TraceInfo traceInfo;
           ICompilerTypes::Config config;
           bool didOutputHelp {false};
           String searchQuiet = String("-") + toString(Flag_Quiet);
@@ -244,9 +307,9 @@ namespace zsLib
           if (!quietMode) {
             ICommandLine::outputHeader();
           }
-          prepare(arguments, monitorInfo, config, didOutputHelp);
-          validate(monitorInfo, config, didOutputHelp);
-          process(monitorInfo, config);
+          prepare(arguments, monitorInfo, traceInfo, config, didOutputHelp);
+          validate(monitorInfo, traceInfo, config, didOutputHelp);
+          process(monitorInfo, traceInfo, config);
         } catch (const InvalidArgument &e) {
           output() << "[Error] " << e.message() << "\n\n";
           result = -1;
@@ -267,6 +330,7 @@ namespace zsLib
       void ICommandLine::prepare(
                                  StringList arguments,
                                  MonitorInfo &outMonitor,
+                                 TraceInfo &outTrace,
                                  ICompilerTypes::Config &outConfig,
                                  bool &outDidOutputHelp
                                  ) throw (InvalidArgument)
@@ -275,6 +339,7 @@ namespace zsLib
         internal::IDLTargets::getTargets(idlTargets);
 
         MonitorInfo monitorInfo;
+        TraceInfo traceInfo;
         ICompilerTypes::Config config;
 
         ICommandLine::Flags flag {ICommandLine::Flag_None};
@@ -303,9 +368,13 @@ namespace zsLib
             switch (flag)
             {
               case ICommandLine::Flag_Source:
+              case ICommandLine::Flag_MonitorIP:
               case ICommandLine::Flag_MonitorJMAN:
               case ICommandLine::Flag_MonitorProvider:
+              case ICommandLine::Flag_MonitorHeavyHitters:
               case ICommandLine::Flag_IDL:
+              case ICommandLine::Flag_TraceMerge:
+              case ICommandLine::Flag_TraceQuery:
               {
                 flag = ICommandLine::Flag_None;
                 break;
@@ -350,12 +419,57 @@ namespace zsLib
               case ICommandLine::Flag_MonitorIP:        goto process_flag;
               case ICommandLine::Flag_MonitorTimeout:   goto process_flag;
               case ICommandLine::Flag_MonitorJMAN:      goto process_flag;
-              case ICommandLine::Flag_MonitorJSON:      {
-                monitorInfo.mOutputJSON = true;
+              case ICommandLine::Flag_MonitorJMANFolder: goto process_flag;
+              case ICommandLine::Flag_MonitorSchemaCache: goto process_flag;
+              case ICommandLine::Flag_MonitorJSON:
+              case ICommandLine::Flag_MonitorNDJSON:
+              case ICommandLine::Flag_MonitorCSV:
+              case ICommandLine::Flag_MonitorBinary:    {
+                if (OutputFormat_None != monitorInfo.mOutputFormat) {
+                  ZS_THROW_INVALID_ARGUMENT(String("Only one output format can be specified: ") + processedThusFar);
+                }
+                switch (flag) {
+                  case ICommandLine::Flag_MonitorNDJSON:  monitorInfo.mOutputFormat = OutputFormat_NDJSON; goto processed_flag;
+                  case ICommandLine::Flag_MonitorCSV:     monitorInfo.mOutputFormat = OutputFormat_CSV; goto process_flag;
+                  case ICommandLine::Flag_MonitorBinary:  monitorInfo.mOutputFormat = OutputFormat_Binary; goto process_flag;
+                  default:                                monitorInfo.mOutputFormat = OutputFormat_JSON; goto processed_flag;
+                }
+              }
+              case ICommandLine::Flag_MonitorOutputFile: goto process_flag;
+              case ICommandLine::Flag_MonitorRotateSize: goto process_flag;
+              case ICommandLine::Flag_MonitorRotateTime: goto process_flag;
+              case ICommandLine::Flag_MonitorRetain:    goto process_flag;
+              case ICommandLine::Flag_MonitorCompress:  {
+                monitorInfo.mCompressRotated = true;
                 goto processed_flag;
               }
+              case ICommandLine::Flag_MonitorStats:     goto process_flag;
+              case ICommandLine::Flag_MonitorLatency:   goto process_flag;
+              case ICommandLine::Flag_MonitorCorrelate: goto process_flag;
+              case ICommandLine::Flag_MonitorHeavyHitters: goto process_flag;
+              case ICommandLine::Flag_MonitorHeavyHittersTop: goto process_flag;
+              case ICommandLine::Flag_MonitorFilter:    goto process_flag;
               case ICommandLine::Flag_MonitorProvider:  goto process_flag;
               case ICommandLine::Flag_MonitorSecret:    goto process_flag;
+              case ICommandLine::Flag_MonitorTopTalkers: goto process_flag;
+              case ICommandLine::Flag_MonitorReplay:    goto process_flag;
+              case ICommandLine::Flag_MonitorReplaySpeed: goto process_flag;
+              case ICommandLine::Flag_MonitorRecord:    goto process_flag;
+              case ICommandLine::Flag_TraceMerge:       goto process_flag;
+              case ICommandLine::Flag_TraceSummarize:   goto process_flag;
+              case ICommandLine::Flag_TraceQuery:       goto process_flag;
+              case ICommandLine::Flag_TraceFrom:        goto process_flag;
+              case ICommandLine::Flag_TraceTo:          goto process_flag;
+              case ICommandLine::Flag_TraceExport:      goto process_flag;
+              case ICommandLine::Flag_TraceConvert:     goto process_flag;
+              case ICommandLine::Flag_SelfTest:         {
+                traceInfo.mSelfTest = true;
+                goto processed_flag;
+              }
+              case ICommandLine::Flag_Benchmark:        {
+                traceInfo.mBenchmark = true;
+                goto processed_flag;
+              }
             }
             ZS_THROW_INVALID_ARGUMENT("Internal error when processing argument: " + arg + " within context: " + processedThusFar);
           }
@@ -403,11 +517,11 @@ namespace zsLib
               case ICommandLine::Flag_MonitorIP:      {
                 try {
                   IPAddress temp(arg);
-                  monitorInfo.mIPAddress = temp;
+                  monitorInfo.mIPAddresses.push_back(temp);
                 } catch (const IPAddress::Exceptions::ParseError &) {
                   ZS_THROW_INVALID_ARGUMENT(String("Cannot parse IP address: ") + arg);
                 }
-                goto processed_flag;
+                goto process_flag;  // process next IP address in the list (maintain same flag)
               }
               case ICommandLine::Flag_MonitorTimeout: {
                 try {
@@ -421,6 +535,14 @@ namespace zsLib
                 monitorInfo.mJMANFiles.push_back(arg);
                 goto process_flag;  // process next source file in the list (maintain same flag)
               }
+              case ICommandLine::Flag_MonitorJMANFolder: {
+                monitorInfo.mJMANFolder = arg;
+                goto processed_flag;
+              }
+              case ICommandLine::Flag_MonitorSchemaCache: {
+                monitorInfo.mSchemaCacheFile = arg;
+                goto processed_flag;
+              }
               case ICommandLine::Flag_MonitorProvider: {
                 monitorInfo.mSubscribeProviders.push_back(arg);
                 goto process_flag;
@@ -429,6 +551,170 @@ namespace zsLib
                 monitorInfo.mSecret = arg;
                 goto processed_flag;
               }
+              case ICommandLine::Flag_MonitorTopTalkers: {
+                try {
+                  monitorInfo.mTopTalkers = Numeric<decltype(monitorInfo.mTopTalkers)>(arg);
+                } catch (Numeric<decltype(monitorInfo.mTopTalkers)>::ValueOutOfRange &) {
+                  ZS_THROW_INVALID_ARGUMENT(String("Cannot parse top talkers: ") + arg);
+                }
+                goto processed_flag;
+              }
+              case ICommandLine::Flag_MonitorReplay:    {
+                monitorInfo.mMonitor = true;
+                monitorInfo.mReplayFile = arg;
+                goto processed_flag;
+              }
+              case ICommandLine::Flag_MonitorReplaySpeed: {
+                try {
+                  monitorInfo.mReplaySpeed = Numeric<decltype(monitorInfo.mReplaySpeed)>(arg);
+                } catch (Numeric<decltype(monitorInfo.mReplaySpeed)>::ValueOutOfRange &) {
+                  ZS_THROW_INVALID_ARGUMENT(String("Cannot parse replay speed: ") + arg);
+                }
+                if (monitorInfo.mReplaySpeed < 0.0) {
+                  ZS_THROW_INVALID_ARGUMENT(String("Replay speed cannot be negative: ") + arg);
+                }
+                goto processed_flag;
+              }
+              case ICommandLine::Flag_MonitorRecord:    {
+                monitorInfo.mRecordFile = arg;
+                goto processed_flag;
+              }
+              case ICommandLine::Flag_MonitorCSV:
+              case ICommandLine::Flag_MonitorBinary:
+              case ICommandLine::Flag_MonitorOutputFile: {
+                if (monitorInfo.mOutputPath.hasData()) {
+                  ZS_THROW_INVALID_ARGUMENT(String("Only one output path can be specified: ") + processedThusFar);
+                }
+                monitorInfo.mOutputPath = arg;
+                goto processed_flag;
+              }
+              case ICommandLine::Flag_MonitorRotateSize: {
+                try {
+                  monitorInfo.mRotateSize = Numeric<decltype(monitorInfo.mRotateSize)>(arg);
+                } catch (Numeric<decltype(monitorInfo.mRotateSize)>::ValueOutOfRange &) {
+                  ZS_THROW_INVALID_ARGUMENT(String("Cannot parse rotate size: ") + arg);
+                }
+                goto processed_flag;
+              }
+              case ICommandLine::Flag_MonitorRotateTime: {
+                try {
+                  monitorInfo.mRotateTime = Seconds(Numeric<Seconds::rep>(arg));
+                } catch (Numeric<Seconds::rep>::ValueOutOfRange &) {
+                  ZS_THROW_INVALID_ARGUMENT(String("Cannot parse rotate time: ") + arg);
+                }
+                goto processed_flag;
+              }
+              case ICommandLine::Flag_MonitorStats:     {
+                try {
+                  monitorInfo.mStatsInterval = Seconds(Numeric<Seconds::rep>(arg));
+                } catch (Numeric<Seconds::rep>::ValueOutOfRange &) {
+                  ZS_THROW_INVALID_ARGUMENT(String("Cannot parse stats interval: ") + arg);
+                }
+                if (monitorInfo.mStatsInterval <= Seconds()) {
+                  ZS_THROW_INVALID_ARGUMENT(String("Stats interval must be at least one second: ") + arg);
+                }
+                goto processed_flag;
+              }
+              case ICommandLine::Flag_MonitorLatency:   {
+                try {
+                  monitorInfo.mLatencyInterval = Seconds(Numeric<Seconds::rep>(arg));
+                } catch (Numeric<Seconds::rep>::ValueOutOfRange &) {
+                  ZS_THROW_INVALID_ARGUMENT(String("Cannot parse latency interval: ") + arg);
+                }
+                if (monitorInfo.mLatencyInterval <= Seconds()) {
+                  ZS_THROW_INVALID_ARGUMENT(String("Latency interval must be at least one second: ") + arg);
+                }
+                goto processed_flag;
+              }
+              case ICommandLine::Flag_MonitorCorrelate: {
+                monitorInfo.mCorrelationField = arg;
+                goto processed_flag;
+              }
+              case ICommandLine::Flag_MonitorHeavyHitters: {
+                monitorInfo.mHeavyHitterFields.push_back(arg);
+                goto process_flag;
+              }
+              case ICommandLine::Flag_MonitorHeavyHittersTop: {
+                try {
+                  monitorInfo.mHeavyHittersTop = Numeric<decltype(monitorInfo.mHeavyHittersTop)>(arg);
+                } catch (Numeric<decltype(monitorInfo.mHeavyHittersTop)>::ValueOutOfRange &) {
+                  ZS_THROW_INVALID_ARGUMENT(String("Cannot parse heavy hitters top: ") + arg);
+                }
+                if (0 == monitorInfo.mHeavyHittersTop) {
+                  ZS_THROW_INVALID_ARGUMENT(String("Heavy hitters top must be at least one: ") + arg);
+                }
+                goto processed_flag;
+              }
+              case ICommandLine::Flag_MonitorFilter:    {
+                monitorInfo.mFilter = arg;
+                goto processed_flag;
+              }
+              case ICommandLine::Flag_MonitorRetain:    {
+                try {
+                  monitorInfo.mRetainFiles = Numeric<decltype(monitorInfo.mRetainFiles)>(arg);
+                } catch (Numeric<decltype(monitorInfo.mRetainFiles)>::ValueOutOfRange &) {
+                  ZS_THROW_INVALID_ARGUMENT(String("Cannot parse retain: ") + arg);
+                }
+                goto processed_flag;
+              }
+              case ICommandLine::Flag_TraceMerge:       {
+                if (traceInfo.mMergeOutputFile.isEmpty()) {
+                  traceInfo.mMergeOutputFile = arg;
+                } else {
+                  traceInfo.mMergeFiles.push_back(arg);
+                }
+                goto process_flag;  // process next input file in the list (maintain same flag)
+              }
+              case ICommandLine::Flag_TraceSummarize:   {
+                traceInfo.mSummarizeFile = arg;
+                goto processed_flag;
+              }
+              case ICommandLine::Flag_TraceQuery:       {
+                if (traceInfo.mQueryFile.isEmpty()) {
+                  traceInfo.mQueryFile = arg;
+                  goto process_flag;
+                }
+
+                auto pos = arg.find('=');
+                if ((String::npos == pos) ||
+                    (0 == pos)) {
+                  ZS_THROW_INVALID_ARGUMENT(String("Query condition must be in the form name=value: ") + arg);
+                }
+                traceInfo.mQueryConditions.push_back(QueryCondition(arg.substr(0, pos), arg.substr(pos + 1)));
+                goto process_flag;  // process next condition in the list (maintain same flag)
+              }
+              case ICommandLine::Flag_TraceExport:      {
+                if (traceInfo.mExportFile.isEmpty()) {
+                  traceInfo.mExportFile = arg;
+                  goto process_flag;  // process the output folder (maintain same flag)
+                }
+                traceInfo.mExportDirectory = arg;
+                goto processed_flag;
+              }
+              case ICommandLine::Flag_TraceConvert:     {
+                if (traceInfo.mConvertRingFile.isEmpty()) {
+                  traceInfo.mConvertRingFile = arg;
+                  goto process_flag;  // process the output file (maintain same flag)
+                }
+                traceInfo.mConvertOutputFile = arg;
+                goto processed_flag;
+              }
+              case ICommandLine::Flag_TraceFrom:
+              case ICommandLine::Flag_TraceTo:          {
+                uint64_t value {};
+                try {
+                  value = Numeric<uint64_t>(arg);
+                } catch (Numeric<uint64_t>::ValueOutOfRange &) {
+                  ZS_THROW_INVALID_ARGUMENT(String("Cannot parse time: ") + arg);
+                }
+                Time time = Time(std::chrono::duration_cast<Time::duration>(Microseconds(static_cast<Microseconds::rep>(value))));
+                if (ICommandLine::Flag_TraceFrom == flag) {
+                  traceInfo.mFrom = time;
+                } else {
+                  traceInfo.mTo = time;
+                }
+                goto processed_flag;
+              }
               default: break;
             }
 
@@ -447,22 +733,96 @@ namespace zsLib
           }
         }
 
+        traceInfo.mJMANFiles = monitorInfo.mJMANFiles;
+
         outMonitor = monitorInfo;
+        outTrace = traceInfo;
         outConfig = config;
       }
 
       //-----------------------------------------------------------------------
       void ICommandLine::validate(
                                   MonitorInfo &monitorInfo,
+                                  TraceInfo &traceInfo,
                                   ICompilerTypes::Config &config,
                                   bool didOutputHelp
                                   ) throw (InvalidArgument, NoopException)
       {
+        if (traceInfo.hasCommand()) {
+          if ((traceInfo.mMergeOutputFile.hasData()) &&
+              (traceInfo.mMergeFiles.size() < 1)) {
+            ZS_THROW_INVALID_ARGUMENT("At least one trace file must be specified to merge.");
+          }
+          if ((traceInfo.mExportFile.hasData()) &&
+              (traceInfo.mExportDirectory.isEmpty())) {
+            ZS_THROW_INVALID_ARGUMENT("An output folder must be specified to export into.");
+          }
+          if ((traceInfo.mConvertRingFile.hasData()) &&
+              (traceInfo.mConvertOutputFile.isEmpty())) {
+            ZS_THROW_INVALID_ARGUMENT("An output trace file must be specified to convert into.");
+          }
+          return;
+        }
+
         if (monitorInfo.mMonitor) {
-          if (!monitorInfo.mIPAddress.isAddressEmpty()) {
-            if (0 == monitorInfo.mIPAddress.getPort()) {
-              monitorInfo.mIPAddress.setPort(monitorInfo.mPort);
-              if (0 == monitorInfo.mIPAddress.getPort()) {
+          if (((OutputFormat_CSV == monitorInfo.mOutputFormat) ||
+               (OutputFormat_Binary == monitorInfo.mOutputFormat)) &&
+              (monitorInfo.mOutputPath.isEmpty())) {
+            ZS_THROW_INVALID_ARGUMENT("An output path must be specified for csv or binary output.");
+          }
+          if ((OutputFormat_Binary == monitorInfo.mOutputFormat) &&
+              ("-" == monitorInfo.mOutputPath) &&
+              (!monitorInfo.mQuietMode)) {
+            ZS_THROW_INVALID_ARGUMENT("Binary output to the command line requires quiet mode (-q).");
+          }
+          if ((Seconds() != monitorInfo.mStatsInterval) &&
+              (OutputFormat_None != monitorInfo.mOutputFormat)) {
+            ZS_THROW_INVALID_ARGUMENT("Stats cannot be combined with an event output format.");
+          }
+          if ((Seconds() != monitorInfo.mLatencyInterval) &&
+              (OutputFormat_None != monitorInfo.mOutputFormat)) {
+            ZS_THROW_INVALID_ARGUMENT("Latency cannot be combined with an event output format.");
+          }
+          if ((monitorInfo.mCorrelationField.hasData()) &&
+              (Seconds() == monitorInfo.mLatencyInterval)) {
+            ZS_THROW_INVALID_ARGUMENT("A correlation field can only be used with -latency.");
+          }
+          if ((monitorInfo.mHeavyHitterFields.size() > 0) &&
+              (Seconds() == monitorInfo.mStatsInterval)) {
+            ZS_THROW_INVALID_ARGUMENT("Heavy hitters can only be used with -stats.");
+          }
+          if ((monitorInfo.mSchemaCacheFile.hasData()) &&
+              (monitorInfo.mJMANFiles.size() < 1) &&
+              (monitorInfo.mJMANFolder.isEmpty())) {
+            ZS_THROW_INVALID_ARGUMENT("A schema cache can only be used with -jman files or -jman-dir.");
+          }
+          if (monitorInfo.mFilter.hasData()) {
+            internal::EventFilter::create(monitorInfo.mFilter);   // throws if the expression is invalid
+          }
+          if ((monitorInfo.mOutputPath.hasData()) &&
+              ((OutputFormat_None == monitorInfo.mOutputFormat) ||
+               (OutputFormat_JSON == monitorInfo.mOutputFormat))) {
+            ZS_THROW_INVALID_ARGUMENT("An output file can only be used with -output-ndjson, -output-csv or -output-binary.");
+          }
+          if (((0 != monitorInfo.mRotateSize) ||
+               (Seconds() != monitorInfo.mRotateTime)) &&
+              ((monitorInfo.mOutputPath.isEmpty()) ||
+               ("-" == monitorInfo.mOutputPath))) {
+            ZS_THROW_INVALID_ARGUMENT("Output rotation requires output to a file.");
+          }
+
+          if (monitorInfo.mReplayFile.hasData()) return;
+
+          if (monitorInfo.mIPAddresses.size() > 0) {
+            if ((monitorInfo.mIPAddresses.size() > 1) &&
+                (monitorInfo.mRecordFile.hasData())) {
+              ZS_THROW_INVALID_ARGUMENT("Recording can only be used with a single remote connection.");
+            }
+            for (auto iter = monitorInfo.mIPAddresses.begin(); iter != monitorInfo.mIPAddresses.end(); ++iter) {
+              auto &ipAddress = (*iter);
+              if (0 != ipAddress.getPort()) continue;
+              ipAddress.setPort(monitorInfo.mPort);
+              if (0 == ipAddress.getPort()) {
                 ZS_THROW_INVALID_ARGUMENT("Remote connection port must be specified.");
               }
             }
@@ -483,9 +843,19 @@ namespace zsLib
       //-----------------------------------------------------------------------
       void ICommandLine::process(
                                  MonitorInfo &monitor,
+                                 TraceInfo &trace,
                                  ICompilerTypes::Config &config
                                  ) throw (Failure)
       {
+        if ((trace.mSelfTest) ||
+            (trace.mBenchmark)) {
+          internal::SelfTest::process(trace);
+          return;
+        }
+        if (trace.hasCommand()) {
+          internal::TraceTool::process(trace);
+          return;
+        }
         if (monitor.mMonitor) {
           internal::Monitor::monitor(monitor);
           return;
@@ -0,0 +1,498 @@
+/*
+
+Copyright (c) 2016, Robin Raymond
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are those
+of the authors and should not be interpreted as representing official policies,
+either expressed or implied, of the FreeBSD Project.
+
+*/
+
+
+#include <zsLib/eventing/tool/internal/zsLib_eventing_tool_EventFilter.h>
+
+#include <zsLib/eventing/ITraceFile.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace zsLib { namespace eventing { namespace tool { ZS_DECLARE_SUBSYSTEM(zsLib_eventing_tool) } } }
+
+namespace zsLib
+{
+  namespace eventing
+  {
+    namespace tool
+    {
+      namespace internal
+      {
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark (helpers)
+        #pragma mark
+
+        //---------------------------------------------------------------------
+        static bool isIdentifierChar(char value)
+        {
+          return (isalnum(static_cast<unsigned char>(value))) ||
+                 ('_' == value) ||
+                 ('.' == value);
+        }
+
+        //---------------------------------------------------------------------
+        static bool isValueChar(char value)
+        {
+          if (isspace(static_cast<unsigned char>(value))) return false;
+          return (NULL == strchr("()&|!<>=", value));
+        }
+
+        //---------------------------------------------------------------------
+        static bool toNumber(
+                             const String &value,
+                             double &outNumber
+                             )
+        {
+          if (value.isEmpty()) return false;
+
+          char *end = NULL;
+          outNumber = strtod(value.c_str(), &end);
+          return ((end) && ('\0' == *end));
+        }
+
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark EventFilter
+        #pragma mark
+
+        //---------------------------------------------------------------------
+        EventFilter::EventFilter(
+                                 const make_private &,
+                                 const String &expression
+                                 ) throw (InvalidArgument) :
+          mExpression(expression)
+        {
+          skipWhiteSpace();
+          if (mPos >= mExpression.length()) {
+            ZS_THROW_INVALID_ARGUMENT(getParseError("empty expression"));
+          }
+
+          mRoot = parseOr();
+
+          skipWhiteSpace();
+          if (mPos < mExpression.length()) {
+            ZS_THROW_INVALID_ARGUMENT(getParseError("unexpected text"));
+          }
+        }
+
+        //---------------------------------------------------------------------
+        EventFilterPtr EventFilter::create(const String &expression) throw (InvalidArgument)
+        {
+          return make_shared<EventFilter>(make_private{}, expression);
+        }
+
+        //---------------------------------------------------------------------
+        EventFilter::BoundFilterPtr EventFilter::bind(
+                                                      const String &eventName,
+                                                      const FieldIndexMap &fields
+                                                      ) const
+        {
+          auto filter = make_shared<BoundFilter>();
+          filter->mNodes = mNodes;
+          filter->mRoot = mRoot;
+          filter->mResult = bindNode(filter->mNodes, filter->mRoot, eventName, fields);
+          return filter;
+        }
+
+        //---------------------------------------------------------------------
+        bool EventFilter::matches(
+                                  const BoundFilter &filter,
+                                  Severity severity,
+                                  Level level,
+                                  EVENT_PARAMETER_DESCRIPTOR_HANDLE paramDescriptor,
+                                  EVENT_DATA_DESCRIPTOR_HANDLE dataDescriptor,
+                                  size_t dataDescriptorCount
+                                  )
+        {
+          switch (filter.mResult) {
+            case Result_Never:    return false;
+            case Result_Always:   return true;
+            case Result_Evaluate: break;
+          }
+          return evaluate(filter.mNodes, filter.mRoot, severity, level, paramDescriptor, dataDescriptor, dataDescriptorCount);
+        }
+
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark EventFilter => (internal)
+        #pragma mark
+
+        //---------------------------------------------------------------------
+        size_t EventFilter::parseOr() throw (InvalidArgument)
+        {
+          size_t left = parseAnd();
+          while (consume("||")) {
+            Node node;
+            node.mType = NodeType_Or;
+            node.mLeft = left;
+            node.mRight = parseAnd();
+            mNodes.push_back(node);
+            left = mNodes.size() - 1;
+          }
+          return left;
+        }
+
+        //---------------------------------------------------------------------
+        size_t EventFilter::parseAnd() throw (InvalidArgument)
+        {
+          size_t left = parseUnary();
+          while (consume("&&")) {
+            Node node;
+            node.mType = NodeType_And;
+            node.mLeft = left;
+            node.mRight = parseUnary();
+            mNodes.push_back(node);
+            left = mNodes.size() - 1;
+          }
+          return left;
+        }
+
+        //---------------------------------------------------------------------
+        size_t EventFilter::parseUnary() throw (InvalidArgument)
+        {
+          if (consume("!")) {
+            Node node;
+            node.mType = NodeType_Not;
+            node.mLeft = parseUnary();
+            mNodes.push_back(node);
+            return mNodes.size() - 1;
+          }
+
+          if (consume("(")) {
+            size_t result = parseOr();
+            if (!consume(")")) {
+              ZS_THROW_INVALID_ARGUMENT(getParseError("expected \")\""));
+            }
+            return result;
+          }
+
+          return parseCompare();
+        }
+
+        //---------------------------------------------------------------------
+        size_t EventFilter::parseCompare() throw (InvalidArgument)
+        {
+          Node node;
+          node.mType = NodeType_Compare;
+
+          node.mFieldName = parseIdentifier();
+          if (node.mFieldName.isEmpty()) {
+            ZS_THROW_INVALID_ARGUMENT(getParseError("expected a field name"));
+          }
+
+          // longer operators are matched first
+          if (consume("==")) node.mOperator = Operator_Equal;
+          else if (consume("!=")) node.mOperator = Operator_NotEqual;
+          else if (consume("<=")) node.mOperator = Operator_LessOrEqual;
+          else if (consume(">=")) node.mOperator = Operator_GreaterOrEqual;
+          else if (consume("<")) node.mOperator = Operator_Less;
+          else if (consume(">")) node.mOperator = Operator_Greater;
+          else if (consume("=")) node.mOperator = Operator_Equal;
+          else {
+            ZS_THROW_INVALID_ARGUMENT(getParseError("expected a comparison operator"));
+          }
+
+          node.mValue = parseValue();
+          node.mIsNumber = toNumber(node.mValue, node.mNumber);
+
+          if (0 == node.mFieldName.compareNoCase("name")) {
+            node.mField = Field_Name;
+          } else if (0 == node.mFieldName.compareNoCase("severity")) {
+            node.mField = Field_Severity;
+            if (!node.mIsNumber) {
+              try {
+                node.mNumber = static_cast<double>(Log::toSeverity(node.mValue.c_str()));
+              } catch (const InvalidArgument &) {
+                ZS_THROW_INVALID_ARGUMENT(getParseError("unknown severity"));
+              }
+              node.mIsNumber = true;
+            }
+          } else if (0 == node.mFieldName.compareNoCase("level")) {
+            node.mField = Field_Level;
+            if (!node.mIsNumber) {
+              try {
+                node.mNumber = static_cast<double>(Log::toLevel(node.mValue.c_str()));
+              } catch (const InvalidArgument &) {
+                ZS_THROW_INVALID_ARGUMENT(getParseError("unknown level"));
+              }
+              node.mIsNumber = true;
+            }
+          } else if (0 == node.mFieldName.compareNoCase("subsystem")) {
+            node.mField = Field_Subsystem;
+          } else {
+            node.mField = Field_Data;
+          }
+
+          mNodes.push_back(node);
+          return mNodes.size() - 1;
+        }
+
+        //---------------------------------------------------------------------
+        void EventFilter::skipWhiteSpace()
+        {
+          while ((mPos < mExpression.length()) &&
+                 (isspace(static_cast<unsigned char>(mExpression[mPos])))) {
+            ++mPos;
+          }
+        }
+
+        //---------------------------------------------------------------------
+        bool EventFilter::consume(const char *token)
+        {
+          skipWhiteSpace();
+
+          size_t length = strlen(token);
+          if (0 != mExpression.compare(mPos, length, token)) return false;
+
+          mPos += length;
+          return true;
+        }
+
+        //---------------------------------------------------------------------
+        String EventFilter::parseIdentifier()
+        {
+          skipWhiteSpace();
+
+          size_t start = mPos;
+          while ((mPos < mExpression.length()) &&
+                 (isIdentifierChar(mExpression[mPos]))) {
+            ++mPos;
+          }
+          return mExpression.substr(start, mPos - start);
+        }
+
+        //---------------------------------------------------------------------
+        String EventFilter::parseValue() throw (InvalidArgument)
+        {
+          skipWhiteSpace();
+
+          if (mPos >= mExpression.length()) {
+            ZS_THROW_INVALID_ARGUMENT(getParseError("expected a value"));
+          }
+
+          char quote = mExpression[mPos];
+          if (('"' == quote) || ('\'' == quote)) {
+            String result;
+            ++mPos;
+            while (mPos < mExpression.length()) {
+              char value = mExpression[mPos];
+              ++mPos;
+              if (quote == value) return result;
+              if (('\\' == value) && (mPos < mExpression.length())) {
+                value = mExpression[mPos];
+                ++mPos;
+              }
+              result += value;
+            }
+            ZS_THROW_INVALID_ARGUMENT(getParseError("unterminated quoted value"));
+          }
+
+          size_t start = mPos;
+          while ((mPos < mExpression.length()) &&
+                 (isValueChar(mExpression[mPos]))) {
+            ++mPos;
+          }
+          if (start == mPos) {
+            ZS_THROW_INVALID_ARGUMENT(getParseError("expected a value"));
+          }
+          return mExpression.substr(start, mPos - start);
+        }
+
+        //---------------------------------------------------------------------
+        String EventFilter::getParseError(const char *reason) const
+        {
+          return String("Invalid filter expression (") + reason + " at position " + string(mPos) + "): " + mExpression;
+        }
+
+        //---------------------------------------------------------------------
+        EventFilter::Results EventFilter::bindNode(
+                                                   NodeList &nodes,
+                                                   size_t index,
+                                                   const String &eventName,
+                                                   const FieldIndexMap &fields
+                                                   )
+        {
+          Results result = Result_Evaluate;
+
+          switch (nodes[index].mType) {
+            case NodeType_And:      {
+              Results left = bindNode(nodes, nodes[index].mLeft, eventName, fields);
+              Results right = bindNode(nodes, nodes[index].mRight, eventName, fields);
+              if ((Result_Never == left) || (Result_Never == right)) result = Result_Never;
+              else if ((Result_Always == left) && (Result_Always == right)) result = Result_Always;
+              break;
+            }
+            case NodeType_Or:       {
+              Results left = bindNode(nodes, nodes[index].mLeft, eventName, fields);
+              Results right = bindNode(nodes, nodes[index].mRight, eventName, fields);
+              if ((Result_Always == left) || (Result_Always == right)) result = Result_Always;
+              else if ((Result_Never == left) && (Result_Never == right)) result = Result_Never;
+              break;
+            }
+            case NodeType_Not:      {
+              Results operand = bindNode(nodes, nodes[index].mLeft, eventName, fields);
+              if (Result_Always == operand) result = Result_Never;
+              else if (Result_Never == operand) result = Result_Always;
+              break;
+            }
+            case NodeType_Compare:  {
+              auto &node = nodes[index];
+              switch (node.mField) {
+                case Field_Name:      {
+                  result = (compare(node.mOperator, eventName.compare(node.mValue)) ? Result_Always : Result_Never);
+                  break;
+                }
+                case Field_Severity:
+                case Field_Level:     break;
+                case Field_Subsystem: {
+                  node.mIndex = 0;
+                  break;
+                }
+                case Field_Data:      {
+                  auto found = fields.find(node.mFieldName);
+                  if (found == fields.end()) {
+                    // the event does not have the field
+                    result = Result_Never;
+                    break;
+                  }
+                  node.mIndex = (*found).second;
+                  break;
+                }
+              }
+              break;
+            }
+          }
+
+          nodes[index].mResult = result;
+          return result;
+        }
+
+        //---------------------------------------------------------------------
+        bool EventFilter::evaluate(
+                                   const NodeList &nodes,
+                                   size_t index,
+                                   Severity severity,
+                                   Level level,
+                                   EVENT_PARAMETER_DESCRIPTOR_HANDLE paramDescriptor,
+                                   EVENT_DATA_DESCRIPTOR_HANDLE dataDescriptor,
+                                   size_t dataDescriptorCount
+                                   )
+        {
+          auto &node = nodes[index];
+
+          switch (node.mResult) {
+            case Result_Never:    return false;
+            case Result_Always:   return true;
+            case Result_Evaluate: break;
+          }
+
+          switch (node.mType) {
+            case NodeType_And:      return (evaluate(nodes, node.mLeft, severity, level, paramDescriptor, dataDescriptor, dataDescriptorCount)) &&
+                                           (evaluate(nodes, node.mRight, severity, level, paramDescriptor, dataDescriptor, dataDescriptorCount));
+            case NodeType_Or:       return (evaluate(nodes, node.mLeft, severity, level, paramDescriptor, dataDescriptor, dataDescriptorCount)) ||
+                                           (evaluate(nodes, node.mRight, severity, level, paramDescriptor, dataDescriptor, dataDescriptorCount));
+            case NodeType_Not:      return !evaluate(nodes, node.mLeft, severity, level, paramDescriptor, dataDescriptor, dataDescriptorCount);
+            case NodeType_Compare:  break;
+          }
+
+          switch (node.mField) {
+            case Field_Name:        return false;   // always resolved when bound
+            case Field_Severity:    return compare(node.mOperator, static_cast<double>(severity), node.mNumber);
+            case Field_Level:       return compare(node.mOperator, static_cast<double>(level), node.mNumber);
+            case Field_Subsystem:
+            case Field_Data:        break;
+          }
+
+          if (node.mIndex >= dataDescriptorCount) return false;
+
+          auto &param = paramDescriptor[node.mIndex];
+          auto &data = dataDescriptor[node.mIndex];
+
+          if (node.mIsNumber) {
+            double value {};
+            if (ITraceFileTypes::getNumericValue(param, data, value)) return compare(node.mOperator, value, node.mNumber);
+          }
+
+          if (EventParameterType_AString == param.Type) {
+            // compared in place without copying the string
+            const char *value = reinterpret_cast<const char *>(data.Ptr);
+            size_t length = (value ? strnlen(value, static_cast<size_t>(data.Size)) : 0);
+            int result = node.mValue.compare(0, node.mValue.length(), (value ? value : ""), length);
+            return compare(node.mOperator, (result < 0 ? 1 : (result > 0 ? -1 : 0)));
+          }
+
+          bool isNumber {};
+          String value = ITraceFileTypes::valueAsString(param, data, isNumber);
+          return compare(node.mOperator, value.compare(node.mValue));
+        }
+
+        //---------------------------------------------------------------------
+        bool EventFilter::compare(
+                                  Operators op,
+                                  int result
+                                  )
+        {
+          switch (op) {
+            case Operator_Equal:          return 0 == result;
+            case Operator_NotEqual:       return 0 != result;
+            case Operator_Less:           return result < 0;
+            case Operator_LessOrEqual:    return result <= 0;
+            case Operator_Greater:        return result > 0;
+            case Operator_GreaterOrEqual: return result >= 0;
+          }
+          return false;
+        }
+
+        //---------------------------------------------------------------------
+        bool EventFilter::compare(
+                                  Operators op,
+                                  double left,
+                                  double right
+                                  )
+        {
+          return compare(op, (left < right ? -1 : (left > right ? 1 : 0)));
+        }
+
+      } // namespace internal
+    } // namespace tool
+  } // namespace eventing
+} // namespace zsLib
@@ -33,12 +33,14 @@ either expressed or implied, of the FreeBSD Project.
 #include <zsLib/eventing/tool/internal/zsLib_eventing_tool_CommandLine.h>
 #include <zsLib/eventing/tool/internal/zsLib_eventing_tool_IDLCompiler.h>
 #include <zsLib/eventing/tool/internal/zsLib_eventing_tool_Helper.h>
+#include <zsLib/eventing/tool/internal/zsLib_eventing_tool_SchemaCache.h>
 
 #include <zsLib/eventing/tool/OutputStream.h>
 
 #include <zsLib/eventing/IHelper.h>
 #include <zsLib/eventing/IHasher.h>
 #include <zsLib/eventing/IEventingTypes.h>
+#include <zsLib/eventing/IRemoteEventing.h>
 
 #include <zsLib/Exception.h>
 #include <zsLib/Numeric.h>
@@ -2243,6 +2245,45 @@ namespace zsLib
           return functions;
         }
 
+        //---------------------------------------------------------------------
+        static String getSchemaFunctions(const IEventingTypes::Provider &provider)
+        {
+          std::stringstream ss;
+
+          // the compiled schema is embedded so a remote monitor can decode the
+          // provider's events without its jman file
+          String schema = SchemaCache::compile(provider);
+          auto buffer = UseEventingHelper::convertToSizePrefixedBuffer(reinterpret_cast<const BYTE *>(schema.c_str()), schema.length());
+
+          ss << "    inline const uint8_t *getEventingSchema_" << provider.mName << "()\n";
+          ss << "    {\n";
+          ss << "      // compiled schema prefixed with its size (32 bit little endian)\n";
+          ss << "      static const uint8_t gSchema[] =\n";
+          ss << "      {";
+          for (size_t index = 0; index < buffer->SizeInBytes(); ++index) {
+            if (0 != index) ss << ",";
+            if (0 == (index % 16)) ss << "\n        ";
+            else ss << " ";
+            ss << "0x" << UseEventingHelper::convertToHex(&(buffer->BytePtr()[index]), sizeof(BYTE));
+          }
+          ss << "\n";
+          ss << "      };\n";
+          ss << "      return &(gSchema[0]);\n";
+          ss << "    }\n\n";
+
+          ss << "    inline void registerEventingSchema_" << provider.mName << "()\n";
+          ss << "    {\n";
+          ss << "      ::zsLib::UUID providerID;\n";
+          ss << "      ::zsLib::String providerName;\n";
+          ss << "      ::zsLib::String providerHash;\n";
+          ss << "      ::zsLib::Log::EventingAtomDataArray atomArray {};\n";
+          ss << "      if (!::zsLib::Log::getEventingWriterInfo(getEventHandle_" << provider.mName << "(), providerID, providerName, providerHash, &atomArray)) return;\n";
+          ss << "      atomArray[::zsLib::Log::registerEventingAtom(\"" ZS_EVENTING_PROVIDER_SCHEMA_ATOM_NAME "\")] = reinterpret_cast< ::zsLib::Log::EventingAtomData>(getEventingSchema_" << provider.mName << "());\n";
+          ss << "    }\n\n";
+
+          return ss.str();
+        }
+
         //---------------------------------------------------------------------
         SecureByteBlockPtr EventingCompiler::generateXPlatformEventsHeader(
                                                                            const String &outputNameXPlatform,
@@ -2275,6 +2316,8 @@ namespace zsLib
             "      return gHandle;\n"
             "    }\n\n";
 
+          ss << getSchemaFunctions(*provider);
+
           ss << "#define ZS_INTERNAL_REGISTER_EVENTING_" << provider->mName << "() \\\n";
           ss << "    { \\\n";
           ss << "      ZS_EVENTING_REGISTER_EVENT_WRITER(" << getEventingHandleFunctionWithNamespace << ", \"" << string(provider->mID) << "\", \"" << provider->mName << "\", \"" << provider->mUniqueHash << "\"); \\\n";
@@ -2282,6 +2325,7 @@ namespace zsLib
             auto subsystem = (*iter).second;
             ss << "      ZS_EVENTING_REGISTER_SUBSYSTEM_DEFAULT_LEVEL(" << subsystem->mName << ", " << zsLib::Log::toString(subsystem->mLevel) << "); \\\n";
           }
+          ss << "      ::zsLib::eventing::registerEventingSchema_" << provider->mName << "(); \\\n";
           ss << "    }\n";
           ss << "\n";
 
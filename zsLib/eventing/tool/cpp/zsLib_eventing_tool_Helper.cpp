@@ -36,6 +36,15 @@ either expressed or implied, of the FreeBSD Project.
 
 #include <sstream>
 
+#include <errno.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif //_WIN32
+
 namespace zsLib { namespace eventing { namespace tool { ZS_DECLARE_SUBSYSTEM(zsLib_eventing_tool) } } }
 
 namespace zsLib
@@ -85,6 +94,145 @@ namespace zsLib
           return result;
         }
 
+        //---------------------------------------------------------------------
+        String Helper::toFileNamePart(const String &value)
+        {
+          String result(value);
+          for (auto iter = result.begin(); iter != result.end(); ++iter) {
+            char &letter = (*iter);
+            if (isalnum(static_cast<unsigned char>(letter))) continue;
+            if (('-' == letter) || ('_' == letter)) continue;
+            letter = '_';
+          }
+          return result;
+        }
+
+        //---------------------------------------------------------------------
+        String Helper::toUniqueFileName(
+                                        const String &baseName,
+                                        const char *extension,
+                                        FileNameSet &ioUsedFileNames
+                                        )
+        {
+          String result = baseName + extension;
+          for (size_t suffix = 2; true; ++suffix) {
+            String key(result);
+            key.toLower();
+            if (ioUsedFileNames.find(key) == ioUsedFileNames.end()) {
+              ioUsedFileNames.insert(key);
+              return result;
+            }
+            result = baseName + "." + string(suffix) + extension;
+          }
+          return result;
+        }
+
+        //---------------------------------------------------------------------
+        void Helper::appendLittleEndian(
+                                        String &output,
+                                        uint64_t value,
+                                        size_t size
+                                        )
+        {
+          for (size_t index = 0; index < size; ++index) {
+            output.append(1, static_cast<char>(value & 0xFF));
+            value >>= 8;
+          }
+        }
+
+        //---------------------------------------------------------------------
+        void Helper::appendLittleEndian(
+                                        std::vector<BYTE> &output,
+                                        uint64_t value,
+                                        size_t size
+                                        )
+        {
+          for (size_t index = 0; index < size; ++index) {
+            output.push_back(static_cast<BYTE>(value & 0xFF));
+            value >>= 8;
+          }
+        }
+
+        //---------------------------------------------------------------------
+        void Helper::appendString(
+                                  String &output,
+                                  const String &value
+                                  )
+        {
+          appendLittleEndian(output, value.length(), sizeof(uint32_t));
+          output.append(value);
+        }
+
+        //---------------------------------------------------------------------
+        void Helper::appendString(
+                                  std::vector<BYTE> &output,
+                                  const String &value
+                                  )
+        {
+          appendLittleEndian(output, value.length(), sizeof(uint32_t));
+          output.insert(output.end(), value.begin(), value.end());
+        }
+
+        //---------------------------------------------------------------------
+        StringList Helper::listFiles(
+                                     const String &folder,
+                                     const char *extension
+                                     ) throw (StdError)
+        {
+          StringList result;
+
+          String path(folder);
+          path.replaceAll("\\", "/");
+          if ((path.hasData()) && ('/' != path[path.length() - 1])) path.append("/");
+
+          String ending(extension ? extension : "");
+
+#ifdef _WIN32
+          String searchStr(path + "*");
+          searchStr.replaceAll("/", "\\");
+
+          WIN32_FIND_DATAA data {};
+          HANDLE find = FindFirstFileA(searchStr, &data);
+          if (INVALID_HANDLE_VALUE == find) {
+            auto error = static_cast<int>(GetLastError());
+            if (ERROR_FILE_NOT_FOUND == error) return result;
+            ZS_THROW_CUSTOM_PROPERTIES_1(StdError, error, String("Failed to list folder: ") + folder);
+          }
+
+          do {
+            if (0 != (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) continue;
+            String name(data.cFileName);
+            if (name.length() < ending.length()) continue;
+            if (0 != name.substr(name.length() - ending.length()).compareNoCase(ending)) continue;
+            result.push_back(path + name);
+          } while (FindNextFileA(find, &data));
+
+          FindClose(find);
+#else
+          DIR *dir = opendir(path.hasData() ? path.c_str() : ".");
+          if (NULL == dir) {
+            ZS_THROW_CUSTOM_PROPERTIES_1(StdError, errno, String("Failed to list folder: ") + folder);
+          }
+
+          while (struct dirent *entry = readdir(dir)) {
+            String name(entry->d_name);
+            if (name.length() < ending.length()) continue;
+            if (0 != name.substr(name.length() - ending.length()).compareNoCase(ending)) continue;
+
+            struct stat fileStat {};
+            if (0 != stat(path + name, &fileStat)) continue;
+            if (!S_ISREG(fileStat.st_mode)) continue;
+
+            result.push_back(path + name);
+          }
+
+          closedir(dir);
+#endif //_WIN32
+
+          result.sort();
+          return result;
+        }
+
         //-----------------------------------------------------------------------
         bool Helper::isLikelyJSON(const char *p)
         {
@@ -0,0 +1,189 @@
+/*
+
+Copyright (c) 2016, Robin Raymond
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are those
+of the authors and should not be interpreted as representing official policies,
+either expressed or implied, of the FreeBSD Project.
+
+*/
+
+
+#include <zsLib/eventing/tool/internal/zsLib_eventing_tool_JSONWriter.h>
+
+namespace zsLib { namespace eventing { namespace tool { ZS_DECLARE_SUBSYSTEM(zsLib_eventing_tool) } } }
+
+namespace zsLib
+{
+  namespace eventing
+  {
+    namespace tool
+    {
+      namespace internal
+      {
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark JSONWriter
+        #pragma mark
+
+        //---------------------------------------------------------------------
+        void JSONWriter::clear()
+        {
+          // the capacity is kept so writing the next event does not allocate
+          mBuffer.clear();
+          mNeedsSeparator = false;
+        }
+
+        //---------------------------------------------------------------------
+        void JSONWriter::beginObject(const char *name)
+        {
+          if (name) writeName(name);
+          mBuffer.append(1, '{');
+          mNeedsSeparator = false;
+        }
+
+        //---------------------------------------------------------------------
+        void JSONWriter::endObject()
+        {
+          mBuffer.append(1, '}');
+          mNeedsSeparator = true;
+        }
+
+        //---------------------------------------------------------------------
+        void JSONWriter::writeString(
+                                     const char *name,
+                                     const String &value
+                                     )
+        {
+          writeName(name);
+          mBuffer.append(1, '\"');
+          writeEncoded(value.c_str(), value.length());
+          mBuffer.append(1, '\"');
+          mNeedsSeparator = true;
+        }
+
+        //---------------------------------------------------------------------
+        void JSONWriter::writeNumber(
+                                     const char *name,
+                                     const String &value
+                                     )
+        {
+          writeName(name);
+          mBuffer.append(value);
+          mNeedsSeparator = true;
+        }
+
+        //---------------------------------------------------------------------
+        String JSONWriter::encodeName(const String &name)
+        {
+          JSONWriter writer;
+          writer.writeName(name.c_str());
+          return String(writer.mBuffer);
+        }
+
+        //---------------------------------------------------------------------
+        void JSONWriter::writeValue(
+                                    const String &encodedName,
+                                    const String &value,
+                                    bool isNumber
+                                    )
+        {
+          if (mNeedsSeparator) mBuffer.append(1, ',');
+          mBuffer.append(encodedName);
+          if (isNumber) {
+            mBuffer.append(value);
+          } else {
+            mBuffer.append(1, '\"');
+            writeEncoded(value.c_str(), value.length());
+            mBuffer.append(1, '\"');
+          }
+          mNeedsSeparator = true;
+        }
+
+        //---------------------------------------------------------------------
+        void JSONWriter::writeMembers(const String &encodedMembers)
+        {
+          if (encodedMembers.isEmpty()) return;
+          if (mNeedsSeparator) mBuffer.append(1, ',');
+          mBuffer.append(encodedMembers);
+          mNeedsSeparator = true;
+        }
+
+        //---------------------------------------------------------------------
+        void JSONWriter::writeName(const char *name)
+        {
+          if (mNeedsSeparator) mBuffer.append(1, ',');
+          mBuffer.append(1, '\"');
+          writeEncoded(name, strlen(name));
+          mBuffer.append("\":");
+        }
+
+        //---------------------------------------------------------------------
+        void JSONWriter::writeEncoded(
+                                      const char *value,
+                                      size_t length
+                                      )
+        {
+          // escaped exactly as zsLib's JSON encoder does (lowercase hex, '/'
+          // escaped and the value ends at a nul) so the output is byte
+          // identical to IHelper::toString
+          static const char *hexDigits = "0123456789abcdef";
+
+          // unescaped runs are appended as a whole
+          size_t start = 0;
+          for (size_t index = 0; index < length; ++index) {
+            unsigned char letter = static_cast<unsigned char>(value[index]);
+            if ((letter >= 0x20) && ('\"' != letter) && ('\\' != letter) && ('/' != letter)) continue;
+
+            mBuffer.append(value + start, index - start);
+            start = index + 1;
+
+            switch (letter) {
+              case 0:     return;
+              case '\"':  mBuffer.append("\\\""); break;
+              case '\\':  mBuffer.append("\\\\"); break;
+              case '/':   mBuffer.append("\\/"); break;
+              case '\b':  mBuffer.append("\\b"); break;
+              case '\f':  mBuffer.append("\\f"); break;
+              case '\n':  mBuffer.append("\\n"); break;
+              case '\r':  mBuffer.append("\\r"); break;
+              case '\t':  mBuffer.append("\\t"); break;
+              default:    {
+                mBuffer.append("\\u00");
+                mBuffer.append(1, hexDigits[(letter >> 4) & 0xF]);
+                mBuffer.append(1, hexDigits[letter & 0xF]);
+                break;
+              }
+            }
+          }
+          mBuffer.append(value + start, length - start);
+        }
+
+      } // namespace internal
+    } // namespace tool
+  } // namespace eventing
+} // namespace zsLib
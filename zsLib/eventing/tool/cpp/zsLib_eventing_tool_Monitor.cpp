@@ -30,14 +30,23 @@ either expressed or implied, of the FreeBSD Project.
 */
 
 #include <zsLib/eventing/tool/internal/zsLib_eventing_tool_Monitor.h>
+#include <zsLib/eventing/tool/internal/zsLib_eventing_tool_Helper.h>
 
 #include <zsLib/eventing/tool/OutputStream.h>
 #include <zsLib/eventing/IHelper.h>
+#include <zsLib/eventing/ITraceFile.h>
 #include <zsLib/eventing/Log.h>
 
 #include <zsLib/IMessageQueueManager.h>
 #include <zsLib/Numeric.h>
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+#include <stdio.h>
+
 namespace zsLib { namespace eventing { namespace tool { ZS_DECLARE_SUBSYSTEM(zsLib_eventing_tool) } } }
 
 namespace zsLib
@@ -69,156 +78,386 @@ namespace zsLib
           if (nowHaveSingle) hasSingleton = true;
           return hasSingleton;
         }
-        
+
         //---------------------------------------------------------------------
-        static uint64_t getUnsignedValue(const USE_EVENT_DATA_DESCRIPTOR &data)
+        static const char *getBuiltInName(size_t index)
         {
-          if (!data.Ptr) return 0;
-          
-          switch (data.Size) {
-            case 1: {
-              uint8_t value = 0;
-              memcpy(&value, (const void *)(data.Ptr), sizeof(uint8_t));
-              return value;
-            }
-            case 2: {
-              uint16_t value = 0;
-              memcpy(&value, (const void *)(data.Ptr), sizeof(uint16_t));
-              return value;
-            }
-            case 4: {
-              uint32_t value = 0;
-              memcpy(&value, (const void *)(data.Ptr), sizeof(uint32_t));
-              return value;
-            }
-            case 8: {
-              uint64_t value = 0;
-              memcpy(&value, (const void *)(data.Ptr), sizeof(uint64_t));
-              return value;
-            }
-            default: {
-              uint64_t value = 0;
-              memcpy(&value, (const void *)(data.Ptr), sizeof(uint64_t) > data.Size ? data.Size : sizeof(uint64_t));
-              return value;
-            }
+          static const char *names[ZS_EVENTING_TOTAL_BUILT_IN_EVENT_DATA + 1] = {
+            "_subsystemName",
+            "_function",
+            "_line",
+            "unknown"
+          };
+          if (index >= ZS_EVENTING_TOTAL_BUILT_IN_EVENT_DATA) return names[ZS_EVENTING_TOTAL_BUILT_IN_EVENT_DATA];
+          return names[index];
+        }
+
+        //---------------------------------------------------------------------
+        static const String &getBuiltInEncodedName(size_t index)
+        {
+          static const String names[ZS_EVENTING_TOTAL_BUILT_IN_EVENT_DATA + 1] = {
+            JSONWriter::encodeName(getBuiltInName(0)),
+            JSONWriter::encodeName(getBuiltInName(1)),
+            JSONWriter::encodeName(getBuiltInName(2)),
+            JSONWriter::encodeName(getBuiltInName(ZS_EVENTING_TOTAL_BUILT_IN_EVENT_DATA))
+          };
+          if (index >= ZS_EVENTING_TOTAL_BUILT_IN_EVENT_DATA) return names[ZS_EVENTING_TOTAL_BUILT_IN_EVENT_DATA];
+          return names[index];
+        }
+
+        //---------------------------------------------------------------------
+        static void appendCSVValue(
+                                   String &output,
+                                   const String &value
+                                   )
+        {
+          if (String::npos == value.find_first_of(",\"\r\n")) {
+            output.append(value);
+            return;
+          }
+
+          output.append("\"");
+          for (auto iter = value.begin(); iter != value.end(); ++iter) {
+            if ('\"' == (*iter)) output.append("\"");
+            output.append(1, (*iter));
           }
-          return 0;
+          output.append("\"");
         }
-        
+
         //---------------------------------------------------------------------
-        static int64_t getSignedValue(const USE_EVENT_DATA_DESCRIPTOR &data)
+        static void appendCSVValue(
+                                   String &output,
+                                   const USE_EVENT_PARAMETER_DESCRIPTOR &param,
+                                   const USE_EVENT_DATA_DESCRIPTOR &data
+                                   )
         {
-          if (!data.Ptr) return 0;
-          
-          switch (data.Size) {
-            case 1: {
-              int8_t value = 0;
-              memcpy(&value, (const void *)(data.Ptr), sizeof(int8_t));
-              return value;
-            }
-            case 2: {
-              int16_t value = 0;
-              memcpy(&value, (const void *)(data.Ptr), sizeof(int16_t));
-              return value;
-            }
-            case 4: {
-              int32_t value = 0;
-              memcpy(&value, (const void *)(data.Ptr), sizeof(int32_t));
-              return value;
-            }
-            case 8: {
-              int64_t value = 0;
-              memcpy(&value, (const void *)(data.Ptr), sizeof(int64_t));
-              return value;
-            }
-            default: {
-              int64_t value = 0;
-              memcpy(&value, (const void *)(data.Ptr), sizeof(int64_t) > data.Size ? data.Size : sizeof(int64_t));
-              return value;
-            }
+          bool isNumber = false;
+          appendCSVValue(output, ITraceFileTypes::valueAsString(param, data, isNumber));
+        }
+
+        //---------------------------------------------------------------------
+        static size_t beginBinaryRecord(
+                                        String &output,
+                                        Monitor::BinaryRecordTypes type
+                                        )
+        {
+          Helper::appendLittleEndian(output, static_cast<uint64_t>(type), sizeof(uint8_t));
+          size_t offset = output.length();
+          Helper::appendLittleEndian(output, 0, sizeof(uint32_t));
+          return offset;
+        }
+
+        //---------------------------------------------------------------------
+        static void endBinaryRecord(
+                                    String &output,
+                                    size_t recordOffset
+                                    )
+        {
+          // fill in the size of the record now that it is known
+          uint64_t size = static_cast<uint64_t>(output.length() - recordOffset - sizeof(uint32_t));
+          for (size_t index = 0; index < sizeof(uint32_t); ++index) {
+            output[recordOffset + index] = static_cast<char>(size & 0xFF);
+            size >>= 8;
           }
-          return 0;
         }
-        
+
         //---------------------------------------------------------------------
-        static double getFloatValue(const USE_EVENT_DATA_DESCRIPTOR &data)
+        static BufferedWriter::RotationOptions toRotationOptions(const ICommandLineTypes::MonitorInfo &monitorInfo)
         {
-          if (!data.Ptr) return 0.0f;
-          
-          if (sizeof(float) == data.Size) {
-            float value {};
-            memcpy(&value, (const void *)(data.Ptr), sizeof(value));
-            return value;
+          BufferedWriter::RotationOptions result;
+          result.mMaxFileSize = monitorInfo.mRotateSize;
+          result.mMaxFileAge = monitorInfo.mRotateTime;
+          result.mMaxRotatedFiles = monitorInfo.mRetainFiles;
+          result.mCompress = monitorInfo.mCompressRotated;
+          return result;
+        }
+
+        //---------------------------------------------------------------------
+        static String findSchemaHeaderValue(
+                                            const std::string &header,
+                                            const char *name
+                                            )
+        {
+          std::string search = std::string("\"") + name + "\"";
+
+          auto pos = header.find(search);
+          if (std::string::npos == pos) return String();
+
+          pos = header.find_first_not_of(" \t\r\n", pos + search.length());
+          if ((std::string::npos == pos) || (':' != header[pos])) return String();
+
+          pos = header.find_first_not_of(" \t\r\n", pos + 1);
+          if ((std::string::npos == pos) || ('\"' != header[pos])) return String();
+
+          auto endPos = header.find('\"', pos + 1);
+          if (std::string::npos == endPos) return String();
+
+          return String(header.substr(pos + 1, endPos - (pos + 1)));
+        }
+
+        //---------------------------------------------------------------------
+        static bool scanSchemaHeader(
+                                     const String &fileName,
+                                     UUID &outProviderID,
+                                     String &outUniqueHash
+                                     )
+        {
+          // a compiled jman file starts with the provider's ID and unique
+          // hash so only the start of the file needs to be read to index it
+          FILE *file = NULL;
+#ifdef _WIN32
+          fopen_s(&file, fileName, "rb");
+#else
+          file = fopen(fileName, "rb");
+#endif //_WIN32
+          if (NULL == file) return false;
+
+          std::string header(ZS_EVENTING_TOOL_MONITOR_SCHEMA_HEADER_SCAN_SIZE, '\0');
+          size_t read = fread(&(header[0]), 1, header.size(), file);
+          fclose(file);
+          header.resize(read);
+
+          String providerID = findSchemaHeaderValue(header, "id");
+          outUniqueHash = findSchemaHeaderValue(header, "uniqueHash");
+          if ((providerID.isEmpty()) ||
+              (outUniqueHash.isEmpty())) return false;
+
+          try {
+            outProviderID = Numeric<UUID>(providerID);
+          } catch (const Numeric<UUID>::ValueOutOfRange &) {
+            return false;
+          }
+          return true;
+        }
+
+        //---------------------------------------------------------------------
+        static void writeValue(
+                               JSONWriter &writer,
+                               const String &encodedName,
+                               const USE_EVENT_PARAMETER_DESCRIPTOR &param,
+                               const USE_EVENT_DATA_DESCRIPTOR &data
+                               )
+        {
+          bool isNumber = false;
+          String value = ITraceFileTypes::valueAsString(param, data, isNumber);
+          writer.writeValue(encodedName, value, isNumber);
+        }
+
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark Monitor::FieldStats
+        #pragma mark
+
+        //---------------------------------------------------------------------
+        void Monitor::FieldStats::add(double value)
+        {
+          if ((0 == mCount) || (value < mMin)) mMin = value;
+          if ((0 == mCount) || (value > mMax)) mMax = value;
+          mTotal += value;
+          ++mCount;
+
+          if (mBuckets.size() < 1) mBuckets.resize(ZS_EVENTING_TOOL_MONITOR_STATS_HISTOGRAM_BUCKETS);
+
+          // bucket n holds the values below 2^n (bucket 0 also holds any
+          // negative values)
+          size_t bucket = 0;
+          if (value >= 1.0) {
+            int exponent = 0;
+            frexp(value, &exponent);
+            bucket = static_cast<size_t>(exponent);
           }
-          if (sizeof(double) == data.Size) {
-            double value ={};
-            memcpy(&value, (const void *)(data.Ptr), sizeof(value));
-            return value;
+          if (bucket >= mBuckets.size()) bucket = mBuckets.size() - 1;
+          ++(mBuckets[bucket]);
+        }
+
+        //---------------------------------------------------------------------
+        double Monitor::FieldStats::getPercentile(double percentile) const
+        {
+          if (0 == mCount) return 0.0;
+
+          size_t target = static_cast<size_t>(ceil(percentile * static_cast<double>(mCount)));
+          if (target < 1) target = 1;
+
+          size_t total = 0;
+          for (size_t index = 0; index < mBuckets.size(); ++index) {
+            total += mBuckets[index];
+            if (total < target) continue;
+
+            double upper = ldexp(1.0, static_cast<int>(index));
+            return (upper < mMax ? upper : mMax);
           }
-          
-          double value = 0;
-          memcpy(&value, (const void *)(data.Ptr), sizeof(double) > data.Size ? data.Size : sizeof(double));
-          return value;
+          return mMax;
         }
-        
+
         //---------------------------------------------------------------------
-        static String valueAsString(
-                                    const USE_EVENT_PARAMETER_DESCRIPTOR &param,
-                                    const USE_EVENT_DATA_DESCRIPTOR &data,
-                                    bool &outIsNumber
-                                    )
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark Monitor::RateStats
+        #pragma mark
+
+        //---------------------------------------------------------------------
+        void Monitor::RateStats::roll(double intervalSeconds)
         {
-          outIsNumber = true;
-          
-          switch (param.Type) {
-            case EventParameterType_Boolean:          {
-              outIsNumber = false;
-              if (0 != getUnsignedValue(data)) return "true";
-              return "false";
-            }
-            case EventParameterType_UnsignedInteger:  return string(getUnsignedValue(data));
-            case EventParameterType_SignedInteger:    return string(getSignedValue(data));
-            
-            case EventParameterType_FloatingPoint:    return string(getFloatValue(data));
-            case EventParameterType_Pointer:          return string(getUnsignedValue(data));
-            case EventParameterType_AString:          {
-              outIsNumber = false;
-              if (!data.Ptr) return String();
-              if (0 == data.Size) return String();
-              auto temp = IHelper::convertToBuffer(reinterpret_cast<const BYTE *>(data.Ptr), data.Size);
-              return String(reinterpret_cast<const char *>(temp->BytePtr()));
-            }
-            case EventParameterType_WString:          {
-              outIsNumber = false;
-              if (!data.Ptr) return String();
-              if (0 == data.Size) return String();
-              size_t total = data.Size / sizeof(wchar_t);
-              
-              if (0 == total) return String();
-              
-              wchar_t *temp = new wchar_t[total+1] {};
-              memcpy(temp, (const void *)(data.Ptr), data.Size);
-              
-              String result(&(temp[0]));
-              
-              delete [] temp;
-              temp = NULL;
-              
-              return result;
-            }
-            case EventParameterType_Binary:
-            default:
-            {
-              break;
-            }
+          mLastRate = (intervalSeconds > 0.0 ? static_cast<double>(mIntervalTotal) / intervalSeconds : 0.0);
+
+          // the first interval seeds the smoothed rate
+          if (mTotal == mIntervalTotal) {
+            mRate = mLastRate;
+          } else {
+            mRate = (ZS_EVENTING_TOOL_MONITOR_STATS_RATE_SMOOTHING * mLastRate) + ((1.0 - ZS_EVENTING_TOOL_MONITOR_STATS_RATE_SMOOTHING) * mRate);
+          }
+          mIntervalTotal = 0;
+        }
+
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark Monitor::HeavyHitters
+        #pragma mark
+
+        //---------------------------------------------------------------------
+        static bool isLighterHeavyHitter(
+                                         const Monitor::HeavyHitters::HeavyHitter &left,
+                                         const Monitor::HeavyHitters::HeavyHitter &right
+                                         )
+        {
+          // ordering used to keep the lightest value at the front of the heap
+          return left.first > right.first;
+        }
+
+        //---------------------------------------------------------------------
+        void Monitor::HeavyHitters::add(const String &value)
+        {
+          if (mSketch.size() < 1) mSketch.resize(ZS_EVENTING_TOOL_MONITOR_HEAVY_HITTERS_SKETCH_WIDTH * ZS_EVENTING_TOOL_MONITOR_HEAVY_HITTERS_SKETCH_DEPTH);
+
+          ++mTotal;
+
+          ULONGLONG hash = static_cast<ULONGLONG>(std::hash<std::string>()(value));
+
+          ULONGLONG estimate {};
+          for (size_t row = 0; row < ZS_EVENTING_TOOL_MONITOR_HEAVY_HITTERS_SKETCH_DEPTH; ++row) {
+            // derive an independent hash per row (splitmix64 finalizer)
+            ULONGLONG mixed = hash + (static_cast<ULONGLONG>(row + 1) * 0x9E3779B97F4A7C15ULL);
+            mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EBULL;
+            mixed = mixed ^ (mixed >> 31);
+
+            auto &counter = mSketch[(row * ZS_EVENTING_TOOL_MONITOR_HEAVY_HITTERS_SKETCH_WIDTH) + static_cast<size_t>(mixed % ZS_EVENTING_TOOL_MONITOR_HEAVY_HITTERS_SKETCH_WIDTH)];
+            ++counter;
+            if ((0 == row) || (counter < estimate)) estimate = counter;
+          }
+
+          // the heap only holds the top few values so a scan is cheap
+          for (auto iter = mHeap.begin(); iter != mHeap.end(); ++iter) {
+            if ((*iter).second != value) continue;
+            (*iter).first = estimate;
+            std::make_heap(mHeap.begin(), mHeap.end(), isLighterHeavyHitter);
+            return;
+          }
+
+          if (mHeap.size() < mTop) {
+            mHeap.push_back(HeavyHitter(estimate, value));
+            std::push_heap(mHeap.begin(), mHeap.end(), isLighterHeavyHitter);
+            return;
           }
 
-          outIsNumber = false;
-          if (!data.Ptr) return String();
-          if (0 == data.Size) return String();
-          return IHelper::convertToHex(reinterpret_cast<const BYTE *>(data.Ptr), data.Size);
+          if ((mHeap.size() < 1) ||
+              (estimate <= mHeap.front().first)) return;
+
+          std::pop_heap(mHeap.begin(), mHeap.end(), isLighterHeavyHitter);
+          mHeap.back() = HeavyHitter(estimate, value);
+          std::push_heap(mHeap.begin(), mHeap.end(), isLighterHeavyHitter);
         }
-        
+
+        //---------------------------------------------------------------------
+        Monitor::HeavyHitters::HeavyHitterList Monitor::HeavyHitters::getHeaviest() const
+        {
+          HeavyHitterList result(mHeap);
+          std::sort(result.begin(), result.end(), isLighterHeavyHitter);
+          return result;
+        }
+
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark Monitor::LatencyHistogram
+        #pragma mark
+
+        //---------------------------------------------------------------------
+        void Monitor::LatencyHistogram::record(ULONGLONG value)
+        {
+          if ((0 == mTotal) || (value < mMin)) mMin = value;
+          if ((0 == mTotal) || (value > mMax)) mMax = value;
+          ++mTotal;
+
+          size_t index = toIndex(value);
+          if (index >= mCounts.size()) mCounts.resize(index + 1);
+          ++(mCounts[index]);
+        }
+
+        //---------------------------------------------------------------------
+        ULONGLONG Monitor::LatencyHistogram::getPercentile(double percentile) const
+        {
+          if (0 == mTotal) return 0;
+
+          size_t target = static_cast<size_t>(ceil(percentile * static_cast<double>(mTotal)));
+          if (target < 1) target = 1;
+
+          size_t total = 0;
+          for (size_t index = 0; index < mCounts.size(); ++index) {
+            total += mCounts[index];
+            if (total < target) continue;
+
+            ULONGLONG upper = fromIndex(index);
+            return (upper < mMax ? upper : mMax);
+          }
+          return mMax;
+        }
+
+        //---------------------------------------------------------------------
+        size_t Monitor::LatencyHistogram::toIndex(ULONGLONG value)
+        {
+          const ULONGLONG subBucketCount = (static_cast<ULONGLONG>(1) << ZS_EVENTING_TOOL_MONITOR_LATENCY_SUB_BUCKET_BITS);
+          const ULONGLONG subBucketHalfCount = subBucketCount / 2;
+
+          // values below the sub-bucket count are recorded exactly
+          if (value < subBucketCount) return static_cast<size_t>(value);
+
+          size_t highestBit = 0;
+          for (ULONGLONG temp = value; temp > 1; temp >>= 1) {
+            ++highestBit;
+          }
+
+          // shift the value so it lands in the top half of the sub-buckets
+          size_t shift = highestBit - (ZS_EVENTING_TOOL_MONITOR_LATENCY_SUB_BUCKET_BITS - 1);
+          ULONGLONG subBucket = (value >> shift);
+
+          return static_cast<size_t>(subBucketCount + ((shift - 1) * subBucketHalfCount) + (subBucket - subBucketHalfCount));
+        }
+
+        //---------------------------------------------------------------------
+        ULONGLONG Monitor::LatencyHistogram::fromIndex(size_t index)
+        {
+          const ULONGLONG subBucketCount = (static_cast<ULONGLONG>(1) << ZS_EVENTING_TOOL_MONITOR_LATENCY_SUB_BUCKET_BITS);
+          const ULONGLONG subBucketHalfCount = subBucketCount / 2;
+
+          if (index < subBucketCount) return static_cast<ULONGLONG>(index);
+
+          size_t shift = static_cast<size_t>((index - subBucketCount) / subBucketHalfCount) + 1;
+          ULONGLONG subBucket = ((index - subBucketCount) % subBucketHalfCount) + subBucketHalfCount;
+
+          return ((subBucket + 1) << shift) - 1;
+        }
+
         //---------------------------------------------------------------------
         //---------------------------------------------------------------------
         //---------------------------------------------------------------------
@@ -235,9 +474,15 @@ namespace zsLib
                          ) :
           MessageQueueAssociator(queue),
           mMonitorInfo(monitorInfo),
-          mEventingAtom(zsLib::Log::registerEventingAtom("org.zsLib.eventing.tool.Monitor"))
+          mEventingAtom(zsLib::Log::registerEventingAtom("org.zsLib.eventing.tool.Monitor")),
+          mSchemaAtom(zsLib::Log::registerEventingAtom(ZS_EVENTING_PROVIDER_SCHEMA_ATOM_NAME))
         {
-          if (mMonitorInfo.mOutputJSON) {
+          if (mMonitorInfo.mFilter.hasData()) {
+            mFilter = EventFilter::create(mMonitorInfo.mFilter);
+            mUnknownEventFilter = mFilter->bind(String(), EventFilter::FieldIndexMap());
+          }
+
+          if (ICommandLineTypes::OutputFormat_JSON == mMonitorInfo.mOutputFormat) {
             tool::output() << "{ \"events\": { \"event\": [\n";
           }
         }
@@ -246,6 +491,9 @@ namespace zsLib
         Monitor::~Monitor()
         {
           mThisWeak.reset();
+
+          stopFormatters();
+          stopSchemaLoader();
           
           for (auto iter = mCleanProviderInfos.begin(); iter != mCleanProviderInfos.end(); ++iter) {
             auto info = (*iter);
@@ -358,6 +606,27 @@ namespace zsLib
             cancel();
             return;
           }
+          if (timer == mFlushTimer) {
+            flushOutput();
+            return;
+          }
+          if (timer == mMergeTimer) {
+            size_t released = 0;
+            {
+              AutoLock pipelineLock(mPipelineLock);
+              released = releaseMergedEvents();
+            }
+            if (released > 0) mPipelineWorkAvailable.notify_all();
+            return;
+          }
+          if (timer == mStatsTimer) {
+            outputStats();
+            return;
+          }
+          if (timer == mLatencyTimer) {
+            outputLatency();
+            return;
+          }
         }
 
         //---------------------------------------------------------------------
@@ -376,7 +645,15 @@ namespace zsLib
             step();
           }
 
-          if (mMonitorInfo.mOutputJSON) {
+          if (ICommandLineTypes::OutputFormat_None != mMonitorInfo.mOutputFormat) {
+            // events are output in blocks from a background writer
+            if (isOutputToCommandLine()) tool::output().setBlockBuffering(true);
+            startFormatters();
+          }
+
+          if ((ICommandLineTypes::OutputFormat_None != mMonitorInfo.mOutputFormat) ||
+              (isStatsMode()) ||
+              (isLatencyMode())) {
             Log::addEventingProviderListener(mThisWeak.lock());
             Log::addEventingListener(mThisWeak.lock());
           }
@@ -397,7 +674,11 @@ namespace zsLib
                                                    )
         {
           if (!mMonitorInfo.mQuietMode) {
-            tool::output() << "[Info] Remoting eventing state: " << IRemoteEventing::toString(state) << "\n";
+            if (hasMultipleSources()) {
+              tool::output() << "[Info] Remoting eventing state: " << IRemoteEventing::toString(state) << " (" << getRemoteName(connection->getID()) << ")\n";
+            } else {
+              tool::output() << "[Info] Remoting eventing state: " << IRemoteEventing::toString(state) << "\n";
+            }
           }
 
           switch (state) {
@@ -405,9 +686,34 @@ namespace zsLib
             case IRemoteEventingTypes::State_Shutdown:
             {
               AutoRecursiveLock lock(mLock);
+
+              // monitoring continues while any remote is still connected
+              if (!mGracefulShutdownReference) {
+                for (auto iter = mRemotes.begin(); iter != mRemotes.end(); ++iter) {
+                  auto remoteState = (*iter)->getState();
+                  if ((IRemoteEventingTypes::State_ShuttingDown != remoteState) &&
+                      (IRemoteEventingTypes::State_Shutdown != remoteState)) return;
+                }
+              }
               cancel();
               break;
             }
+            case IRemoteEventingTypes::State_Connected:
+            {
+              if (mMonitorInfo.mQuietMode) break;
+
+              // estimated during the handshake (a -record file is stamped
+              // with the remote's clock and offset back to this one)
+              auto stats = connection->getStatistics();
+              if (!stats.mHasRemoteClockOffset) break;
+
+              tool::output() << "[Info] Remote clock offset (us): " << string(stats.mRemoteClockOffset.count()) << " +/- " << string(stats.mRemoteClockRoundTrip.count() / 2);
+              if (hasMultipleSources()) {
+                tool::output() << " (" << getRemoteName(connection->getID()) << ")";
+              }
+              tool::output() << "\n";
+              break;
+            }
             default: {
               break;
             }
@@ -435,6 +741,12 @@ namespace zsLib
           if (!mMonitorInfo.mQuietMode) {
             tool::output() << "[Info] Remote provider \"" << String(providerName) << "\", \"" << string(providerID) << ", \"" << providerUniqueHash << "\" found.\n";
           }
+
+          // also loaded when no events are formatted so top talkers can
+          // name the provider's events
+          if (mMonitorInfo.mJMANFolder.hasData()) {
+            requestIndexedSchema(String(providerUniqueHash));
+          }
         }
         
         //---------------------------------------------------------------------
@@ -471,7 +783,36 @@ namespace zsLib
                                                           size_t totalDropped
                                                           )
         {
-          mTotalEventsDropped = totalDropped;
+          // every remote reports its own running total
+          AutoRecursiveLock lock(mLock);
+          mRemoteEventsDropped[connection->getID()] = totalDropped;
+
+          size_t total = 0;
+          for (auto iter = mRemoteEventsDropped.begin(); iter != mRemoteEventsDropped.end(); ++iter) {
+            total += (*iter).second;
+          }
+          mTotalEventsDropped = total;
+        }
+
+        //---------------------------------------------------------------------
+        void Monitor::onRemoteEventingRemoteEventCounters(
+                                                          IRemoteEventingPtr connection,
+                                                          EventCounterListPtr counters
+                                                          )
+        {
+          if (0 == mMonitorInfo.mTopTalkers) return;
+
+          AutoRecursiveLock lock(mLock);
+
+          for (auto iter = counters->begin(); iter != counters->end(); ++iter) {
+            auto &counter = (*iter);
+            mEventCounters[EventCounterKey(connection->getID(), counter.mProviderID, counter.mEventID)] = counter;
+          }
+
+          // table output would corrupt the event stream
+          if (isOutputToCommandLine()) return;
+
+          outputTopTalkers();
         }
 
         //---------------------------------------------------------------------
@@ -492,10 +833,22 @@ namespace zsLib
 
           bool subscribeLogging = false;
 
+          // the schema is parsed by the loader thread; it is waited for
+          // without holding the lock so other remotes are not held up
+          if ((NULL == provider) &&
+              (mMonitorInfo.mJMANFolder.hasData())) {
+            UUID providerID;
+            String providerName;
+            String providerUniqueHash;
+            if (Log::getEventingWriterInfo(handle, providerID, providerName, providerUniqueHash)) {
+              waitForIndexedSchema(providerUniqueHash);
+            }
+          }
+
           // process event
           {
             AutoRecursiveLock lock(mLock);
-            if (!mRemote) return;
+            if (mRemotes.size() < 1) return;
 
             if (NULL == provider) {
               provider = new ProviderInfo;
@@ -506,26 +859,29 @@ namespace zsLib
               eventingAtomDataArray[mEventingAtom] = reinterpret_cast<EventingAtomData>(provider);
 
               if (Log::getEventingWriterInfo(handle, provider->mProviderID, provider->mProviderName, provider->mProviderUniqueHash)) {
-                auto found = mProviders.find(provider->mProviderID);
-                if (found != mProviders.end()) {
-
-                  auto existingProvider = (*found).second;
+                ProviderPtr existingProvider = findProvider(provider->mProviderID, provider->mProviderUniqueHash);
+
+                // a schema shipped by the producer is used when there is no
+                // matching local schema
+                if ((!existingProvider) ||
+                    (existingProvider->mUniqueHash != provider->mProviderUniqueHash)) {
+                  auto shippedProvider = loadShippedProvider(*provider, eventingAtomDataArray);
+                  if (shippedProvider) existingProvider = shippedProvider;
+                }
 
+                if (existingProvider) {
                   if (existingProvider->mUniqueHash == provider->mProviderUniqueHash) {
-                    provider->mExistingProvider = (*found).second;
-
-                    // process all events into a quick lookup map
-                    for (auto iter = provider->mExistingProvider->mEvents.begin(); iter != provider->mExistingProvider->mEvents.end(); ++iter)
-                    {
-                      auto event = (*iter).second;
-                      provider->mEvents[event->mValue] = event;
-                    }
+                    compileFormatters(provider, existingProvider);
                   } else {
                     if (!mMonitorInfo.mQuietMode) {
                       tool::output() << "[Warning] Provider \"" << provider->mProviderName << "\" hashes do not match: X=" << existingProvider->mUniqueHash << " Y=" << provider->mProviderUniqueHash << "\n";
                     }
                   }
                 }
+
+                // remote eventing attaches the shipped schema after the
+                // provider is registered
+                if (!provider->mExistingProvider) provider->mSchemaPending = true;
               }
             }
 
@@ -577,197 +933,616 @@ namespace zsLib
                                       size_t dataDescriptorCount
                                       )
         {
-          static const size_t skipStartLength = strlen("{\"event\":");
-          static const size_t skipEndLength = strlen("}");
-          
           ProviderInfo *provider = reinterpret_cast<ProviderInfo *>(eventingAtomDataArray[mEventingAtom]);
           if (!provider) return;
 
-          ++mTotalEvents;
+          // looked for once, before any of the provider's events are queued
+          if (provider->mSchemaPending.exchange(false)) {
+            AutoRecursiveLock lock(mLock);
+            auto shippedProvider = loadShippedProvider(*provider, eventingAtomDataArray);
+            if (shippedProvider) compileFormatters(provider, shippedProvider);
+          }
 
-          String output;
+          // filtered on the raw event data before anything is copied or
+          // formatted
+          if (mFilter) {
+            size_t eventID = static_cast<size_t>(descriptor->Id);
+            EventFormatter *formatter = (eventID < provider->mFormatters.size() ? provider->mFormatters[eventID].get() : NULL);
 
-          if (provider->mEvents.size() > 0) {
-            auto found = provider->mEvents.find(descriptor->Id);
-            if (found != provider->mEvents.end()) {
-              auto event = (*found).second;
+            auto &filter = ((formatter) && (formatter->mFilter) ? *(formatter->mFilter) : *mUnknownEventFilter);
+            if (!EventFilter::matches(filter, severity, level, paramDescriptor, dataDescriptor, dataDescriptorCount)) {
+              ++mTotalEventsFiltered;
+              return;
+            }
+          }
 
-              ElementPtr rootEl = Element::create("event");
-              rootEl->adoptAsLastChild(IHelper::createElementWithText("severity", Log::toString(severity)));
-              rootEl->adoptAsLastChild(IHelper::createElementWithText("level", Log::toString(level)));
-              rootEl->adoptAsLastChild(IHelper::createElementWithTextAndJSONEncode("name", event->mName));
-              if (event->mChannel) {
-                rootEl->adoptAsLastChild(IHelper::createElementWithTextAndJSONEncode("channel", event->mChannel->mID));
-              }
-              if (event->mTask) {
-                rootEl->adoptAsLastChild(IHelper::createElementWithTextAndJSONEncode("task", event->mTask->mName));
-              }
-              if (event->mOpCode) {
-                rootEl->adoptAsLastChild(IHelper::createElementWithTextAndJSONEncode("opCode", event->mOpCode->mName));
-              }
-              
-              ElementPtr valuesEl = Element::create("values");
-              rootEl->adoptAsLastChild(valuesEl);
+          ++mTotalEvents;
 
-              size_t totalDataParams = ZS_EVENTING_TOTAL_BUILT_IN_EVENT_DATA;
+          // aggregated on the notifying thread without formatting the event
+          if ((isStatsMode()) ||
+              (isLatencyMode())) {
+            if (isStatsMode()) updateStats(provider, descriptor, paramDescriptor, dataDescriptor, dataDescriptorCount);
+            if (isLatencyMode()) updateLatency(provider, descriptor, paramDescriptor, dataDescriptor, dataDescriptorCount);
+            return;
+          }
 
-              if (event->mDataTemplate) {
-                totalDataParams += event->mDataTemplate->mDataTypes.size();
-              }
+          // the receiving thread never waits for the output; once the
+          // pipeline is full events are dropped (and counted) instead
+          PendingEventPtr pending;
+          {
+            AutoLock lock(mPipelineLock);
+            if (mPipelineShutdown) return;
+            if (mPipelinePending >= ZS_EVENTING_TOOL_MONITOR_MAX_PENDING_EVENTS) {
+              ++mTotalEventsOverflowed;
+              return;
+            }
+            ++mPipelinePending;
 
-              if (totalDataParams != dataDescriptorCount) {
-                // reduce total params by number of buffer sizes not included
-                for (auto iter = event->mDataTemplate->mDataTypes.begin(); iter != event->mDataTemplate->mDataTypes.end(); ++iter) {
-                  auto &dataType = (*iter);
-                  if (dataType->mType == IEventingTypes::PredefinedTypedef_size) {
-                    --totalDataParams;
-                  }
-                }
-                if (totalDataParams != dataDescriptorCount) {
-                  if (!mMonitorInfo.mQuietMode) {
-                    tool::output() << "[Warning] Event \"" << event->mName << "\" parameter count does not match: X=" << string(totalDataParams) << " Y=" << string(dataDescriptorCount) << "\n";
-                    return;
-                  }
-                }
-              }
+            if (mPipelineFreeEvents.size() > 0) {
+              pending = mPipelineFreeEvents.front();
+              mPipelineFreeEvents.pop_front();
+            }
+          }
 
-              for (size_t index = 0; index < ZS_EVENTING_TOTAL_BUILT_IN_EVENT_DATA; ++index)
-              {
-                bool isNumber = false;
-                String valueName("unknown");
-                String value = valueAsString(paramDescriptor[index], dataDescriptor[index], isNumber);
-                switch (index) {
-                  case 0: valueName = "_subsystemName"; break;
-                  case 1: valueName = "_function"; break;
-                  case 2: valueName = "_line"; break;
-                }
-                
-                if (isNumber) {
-                  valuesEl->adoptAsLastChild(IHelper::createElementWithNumber(valueName, value));
-                } else {
-                  valuesEl->adoptAsLastChild(IHelper::createElementWithTextAndJSONEncode(valueName, value));
-                }
-              }
+          // the event is copied so it can be formatted on a formatter thread
+          // (into an event already output where possible so its buffers are
+          // reused)
+          if (!pending) pending = make_shared<PendingEvent>();
+          pending->mProvider = provider;
+          pending->mSource = getSource();
+
+          auto &event = pending->mEvent;
+          event.mSeverity = severity;
+          event.mLevel = level;
+          event.mDescriptor = (*descriptor);
+          event.mDataDescriptorCount = (dataDescriptorCount > ZSLIB_EVENTING_TRACE_EVENT_CODEC_MAX_DATA_DESCRIPTORS ? ZSLIB_EVENTING_TRACE_EVENT_CODEC_MAX_DATA_DESCRIPTORS : dataDescriptorCount);
+
+          size_t totalSize = 0;
+          for (size_t index = 0; index < event.mDataDescriptorCount; ++index) {
+            if (dataDescriptor[index].Ptr) totalSize += static_cast<size_t>(dataDescriptor[index].Size);
+          }
+          pending->mData.resize(totalSize);
 
-              if (event->mDataTemplate) {
-                auto iterDataType = event->mDataTemplate->mDataTypes.begin();
-                for (int index = ZS_EVENTING_TOTAL_BUILT_IN_EVENT_DATA; static_cast<size_t>(index) < dataDescriptorCount; ++iterDataType)
-                {
-                  {
-                    if (iterDataType == event->mDataTemplate->mDataTypes.end()) break;
-                    
-                    auto &dataType = (*iterDataType);
-
-                    bool isNumber = false;
-                    String valueName = dataType->mValueName;
-
-                    int offset = 0;
-                    if (dataType->mType == IEventingTypes::PredefinedTypedef_binary) {
-                      if (static_cast<size_t>(index + 1) >= dataDescriptorCount) {
-                        if (!mMonitorInfo.mQuietMode) {
-                          tool::output() << "[Warning] Event \"" << event->mName << "\" parameter count buffer missing space for buffer: COUNT=" << string(dataDescriptorCount) << " INDEX=" << string(index) << "\n";
-                        }
-                        return;
-                      }
-
-                      // the actual type and value of the buffer is stored just after its size in the array
-                      offset = 1;
-                    } else if (dataType->mType == IEventingTypes::PredefinedTypedef_size) {
-                      if (index < 1) {
-                        if (!mMonitorInfo.mQuietMode) {
-                          tool::output() << "[Warning] Event \"" << event->mName << "\" parameter count buffer missing space for buffer size: COUNT=" << string(dataDescriptorCount) << " INDEX=" << string(index) << "\n";
-                        }
-                        return;
-                      }
-                      offset = -1;
-                    }
+          size_t offset = 0;
+          for (size_t index = 0; index < event.mDataDescriptorCount; ++index) {
+            event.mParameterDescriptors[index] = paramDescriptor[index];
+
+            auto &data = event.mDataDescriptors[index];
+            data = dataDescriptor[index];
+            if ((!data.Ptr) || (0 == data.Size)) {
+              data.Ptr = 0;
+              continue;
+            }
 
-                    String value = valueAsString(paramDescriptor[index + offset], dataDescriptor[index + offset], isNumber);
+            memcpy(&(pending->mData[offset]), reinterpret_cast<const void *>(dataDescriptor[index].Ptr), static_cast<size_t>(data.Size));
+            data.Ptr = reinterpret_cast<uintptr_t>(&(pending->mData[offset]));
+            offset += static_cast<size_t>(data.Size);
+          }
 
-                    if (isNumber) {
-                      valuesEl->adoptAsLastChild(IHelper::createElementWithNumber(valueName, value));
-                    } else {
-                      valuesEl->adoptAsLastChild(IHelper::createElementWithTextAndJSONEncode(valueName, value));
-                    }
-                    goto next_index;
-                  }
-                  
-                next_index:
-                  {
-                    ++index;
-                  }
-                }
-              }
+          // events from several remotes are held back briefly so they are
+          // output in the order they happened (on the monitor's clock, see
+          // IRemoteEventing::getWritingEventTime) rather than the order they
+          // arrived
+          bool merging = hasMultipleSources();
+          if (merging) pending->mTime = IRemoteEventing::getWritingEventTime();
 
-              output = IHelper::toString(rootEl);
+          size_t released = 1;
+          {
+            AutoLock lock(mPipelineLock);
+            if (merging) {
+              mPipelineMerging.insert(PendingEventTimeMap::value_type(pending->mTime, pending));
+              released = releaseMergedEvents();
+            } else {
+              pending->mSequence = mNextSequence;
+              ++mNextSequence;
+              mPipelineQueue.push_back(pending);
             }
           }
-          
-          if (!output.hasData()) {
-            ElementPtr rootEl = Element::create("event");
-            rootEl->adoptAsLastChild(IHelper::createElementWithText("severity", Log::toString(severity)));
-            rootEl->adoptAsLastChild(IHelper::createElementWithText("level", Log::toString(level)));
-            rootEl->adoptAsLastChild(IHelper::createElementWithNumber("name", string(descriptor->Id)));
-            rootEl->adoptAsLastChild(IHelper::createElementWithNumber("channel", string(descriptor->Channel)));
-            rootEl->adoptAsLastChild(IHelper::createElementWithNumber("task", string(descriptor->Task)));
-            rootEl->adoptAsLastChild(IHelper::createElementWithNumber("opCode", string(descriptor->Opcode)));
-
-            ElementPtr valuesEl = Element::create("values");
-            rootEl->adoptAsLastChild(valuesEl);
+          if (released > 1) {
+            mPipelineWorkAvailable.notify_all();
+          } else if (released > 0) {
+            mPipelineWorkAvailable.notify_one();
+          }
+        }
 
-            for (size_t index = 0; index < ZS_EVENTING_TOTAL_BUILT_IN_EVENT_DATA; ++index)
-            {
-              bool isNumber = false;
-              String valueName("unknown");
-              String value = valueAsString(paramDescriptor[index], dataDescriptor[index], isNumber);
-              switch (index) {
-                case 0: valueName = "_subsystemName"; break;
-                case 1: valueName = "_function"; break;
-                case 2: valueName = "_line"; break;
-              }
-              
-              if (isNumber) {
-                valuesEl->adoptAsLastChild(IHelper::createElementWithNumber(valueName, value));
-              } else {
-                valuesEl->adoptAsLastChild(IHelper::createElementWithTextAndJSONEncode(valueName, value));
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark Monitor => (internal)
+        #pragma mark
+
+        //---------------------------------------------------------------------
+        void Monitor::startFormatters()
+        {
+          // one core is left for receiving the events
+          size_t totalWorkers = static_cast<size_t>(std::thread::hardware_concurrency());
+          if (totalWorkers > 1) --totalWorkers;
+          if (totalWorkers < 1) totalWorkers = 1;
+
+          for (size_t index = 0; index < totalWorkers; ++index) {
+            mPipelineWorkers.push_back(std::thread(&Monitor::runFormatter, this));
+          }
+        }
+
+        //---------------------------------------------------------------------
+        void Monitor::stopFormatters()
+        {
+          {
+            AutoLock lock(mPipelineLock);
+            releaseMergedEvents(true);
+            mPipelineShutdown = true;
+          }
+          mPipelineWorkAvailable.notify_all();
+
+          // the workers finish the events already received before exiting
+          for (auto iter = mPipelineWorkers.begin(); iter != mPipelineWorkers.end(); ++iter) {
+            auto &worker = (*iter);
+            if (worker.joinable()) worker.join();
+          }
+          mPipelineWorkers.clear();
+        }
+
+        //---------------------------------------------------------------------
+        void Monitor::runFormatter()
+        {
+          JSONWriter writer;
+
+          while (true) {
+            PendingEventPtr pending;
+
+            {
+              std::unique_lock<Lock> lock(mPipelineLock);
+              while ((mPipelineQueue.size() < 1) &&
+                     (!mPipelineShutdown)) {
+                mPipelineWorkAvailable.wait(lock);
+              }
+              if (mPipelineQueue.size() < 1) return;
+
+              pending = mPipelineQueue.front();
+              mPipelineQueue.pop_front();
+            }
+
+            formatEvent(*pending, writer);
+            outputFormatted(pending);
+          }
+        }
+
+        //---------------------------------------------------------------------
+        void Monitor::formatEvent(
+                                  PendingEvent &pending,
+                                  JSONWriter &writer
+                                  )
+        {
+          // binary output passes the values through without a schema
+          if (ICommandLineTypes::OutputFormat_Binary == mMonitorInfo.mOutputFormat) {
+            formatBinary(pending);
+            return;
+          }
+
+          size_t dataDescriptorCount = pending.mEvent.mDataDescriptorCount;
+
+          EventFormatter *formatter = getFormatter(pending);
+
+          if (formatter) {
+            if ((formatter->mTotalDataParams != dataDescriptorCount) &&
+                (formatter->mTotalDataParamsWithoutSizes != dataDescriptorCount)) {
+              if (!mMonitorInfo.mQuietMode) {
+                pending.mWarning = String("[Warning] Event \"") + formatter->mEvent->mName + "\" parameter count does not match: X=" + string(formatter->mTotalDataParamsWithoutSizes) + " Y=" + string(dataDescriptorCount) + "\n";
+                return;
+              }
+            }
+
+            for (size_t index = 0; index < formatter->mFields.size(); ++index)
+            {
+              if (ZS_EVENTING_TOTAL_BUILT_IN_EVENT_DATA + index >= dataDescriptorCount) break;
+              if (formatter->mFields[index].mIndex < dataDescriptorCount) continue;
+
+              if (!mMonitorInfo.mQuietMode) {
+                pending.mWarning = String("[Warning] Event \"") + formatter->mEvent->mName + "\" parameter count buffer missing space for buffer: COUNT=" + string(dataDescriptorCount) + " INDEX=" + string(ZS_EVENTING_TOTAL_BUILT_IN_EVENT_DATA + index) + "\n";
               }
+              return;
+            }
+          }
+
+          if (ICommandLineTypes::OutputFormat_CSV == mMonitorInfo.mOutputFormat) {
+            formatCSV(pending, formatter);
+            return;
+          }
+          formatJSON(pending, formatter, writer);
+        }
+
+        //---------------------------------------------------------------------
+        void Monitor::formatJSON(
+                                 PendingEvent &pending,
+                                 EventFormatter *formatter,
+                                 JSONWriter &writer
+                                 )
+        {
+          auto &event = pending.mEvent;
+          auto descriptor = &(event.mDescriptor);
+          auto paramDescriptor = &(event.mParameterDescriptors[0]);
+          auto dataDescriptor = &(event.mDataDescriptors[0]);
+          size_t dataDescriptorCount = event.mDataDescriptorCount;
+
+          // the event is written into the worker's reused buffer without the
+          // "event" wrapper object
+          writer.clear();
+
+          if (formatter) {
+            writer.beginObject();
+            if (hasMultipleSources()) writer.writeString("source", getSourceName(pending.mSource));
+            writer.writeString("severity", Log::toString(event.mSeverity));
+            writer.writeString("level", Log::toString(event.mLevel));
+            writer.writeMembers(formatter->mEncodedMembers);
+
+            writer.beginObject("values");
+
+            for (size_t index = 0; index < ZS_EVENTING_TOTAL_BUILT_IN_EVENT_DATA; ++index)
+            {
+              writeValue(writer, getBuiltInEncodedName(index), paramDescriptor[index], dataDescriptor[index]);
+            }
+
+            for (size_t index = 0; index < formatter->mFields.size(); ++index)
+            {
+              if (ZS_EVENTING_TOTAL_BUILT_IN_EVENT_DATA + index >= dataDescriptorCount) break;
+
+              auto &field = formatter->mFields[index];
+              writeValue(writer, field.mEncodedName, paramDescriptor[field.mIndex], dataDescriptor[field.mIndex]);
+            }
+
+            writer.endObject();
+            writer.endObject();
+          } else {
+            writer.beginObject();
+            if (hasMultipleSources()) writer.writeString("source", getSourceName(pending.mSource));
+            writer.writeString("severity", Log::toString(event.mSeverity));
+            writer.writeString("level", Log::toString(event.mLevel));
+            writer.writeNumber("name", string(descriptor->Id));
+            writer.writeNumber("channel", string(descriptor->Channel));
+            writer.writeNumber("task", string(descriptor->Task));
+            writer.writeNumber("opCode", string(descriptor->Opcode));
+
+            writer.beginObject("values");
+
+            for (size_t index = 0; index < ZS_EVENTING_TOTAL_BUILT_IN_EVENT_DATA; ++index)
+            {
+              writeValue(writer, getBuiltInEncodedName(index), paramDescriptor[index], dataDescriptor[index]);
             }
             
             for (size_t index = ZS_EVENTING_TOTAL_BUILT_IN_EVENT_DATA; index < dataDescriptorCount; ++index)
             {
-              bool isNumber = false;
-              String valueName = string(index-ZS_EVENTING_TOTAL_BUILT_IN_EVENT_DATA);
-              String value = valueAsString(paramDescriptor[index], dataDescriptor[index], isNumber);
-              
-              if (isNumber) {
-                valuesEl->adoptAsLastChild(IHelper::createElementWithNumber(valueName, value));
-              } else {
-                valuesEl->adoptAsLastChild(IHelper::createElementWithTextAndJSONEncode(valueName, value));
-              }
+              writeValue(writer, JSONWriter::encodeName(string(index-ZS_EVENTING_TOTAL_BUILT_IN_EVENT_DATA)), paramDescriptor[index], dataDescriptor[index]);
             }
 
-            output = IHelper::toString(rootEl);
+            writer.endObject();
+            writer.endObject();
           }
 
-          if (output.hasData()) {
-            AutoRecursiveLock lock(mLock);
-            if (!mFirstOutputEvent) {
-              tool::output() << ",";
-            } else {
-              mFirstOutputEvent = false;
+          pending.mOutput = String(std::string(writer.data(), writer.size()));
+        }
+
+        //---------------------------------------------------------------------
+        void Monitor::formatCSV(
+                                PendingEvent &pending,
+                                EventFormatter *formatter
+                                )
+        {
+          auto &event = pending.mEvent;
+          auto paramDescriptor = &(event.mParameterDescriptors[0]);
+          auto dataDescriptor = &(event.mDataDescriptors[0]);
+          size_t dataDescriptorCount = event.mDataDescriptorCount;
+
+          // columns are in the same order as the header written by
+          // getCSVWriter
+          String &output = pending.mOutput;
+          if (hasMultipleSources()) {
+            appendCSVValue(output, getSourceName(pending.mSource));
+            output.append(",");
+          }
+          output.append(Log::toString(event.mSeverity));
+          output.append(",");
+          output.append(Log::toString(event.mLevel));
+
+          for (size_t index = 0; (index < ZS_EVENTING_TOTAL_BUILT_IN_EVENT_DATA) && (index < dataDescriptorCount); ++index)
+          {
+            output.append(",");
+            appendCSVValue(output, paramDescriptor[index], dataDescriptor[index]);
+          }
+
+          if (formatter) {
+            for (size_t index = 0; index < formatter->mFields.size(); ++index)
+            {
+              if (ZS_EVENTING_TOTAL_BUILT_IN_EVENT_DATA + index >= dataDescriptorCount) break;
+
+              auto &field = formatter->mFields[index];
+              output.append(",");
+              appendCSVValue(output, paramDescriptor[field.mIndex], dataDescriptor[field.mIndex]);
             }
-            tool::output().write(output.c_str() + skipStartLength, output.length() - skipStartLength - skipEndLength);
-            tool::output() << "\n";
+          } else {
+            for (size_t index = ZS_EVENTING_TOTAL_BUILT_IN_EVENT_DATA; index < dataDescriptorCount; ++index)
+            {
+              output.append(",");
+              appendCSVValue(output, paramDescriptor[index], dataDescriptor[index]);
+            }
+          }
+
+          output.append("\n");
+        }
+
+        //---------------------------------------------------------------------
+        void Monitor::formatBinary(PendingEvent &pending)
+        {
+          auto &event = pending.mEvent;
+          auto &descriptor = event.mDescriptor;
+
+          String &output = pending.mOutput;
+          size_t recordOffset = beginBinaryRecord(output, BinaryRecordType_Event);
+
+          Helper::appendLittleEndian(output, pending.mProvider->mHandle, sizeof(uint64_t));
+          Helper::appendLittleEndian(output, static_cast<uint64_t>(event.mSeverity), sizeof(uint8_t));
+          Helper::appendLittleEndian(output, static_cast<uint64_t>(event.mLevel), sizeof(uint8_t));
+
+          Helper::appendLittleEndian(output, descriptor.Id, sizeof(uint16_t));
+          Helper::appendLittleEndian(output, descriptor.Version, sizeof(uint8_t));
+          Helper::appendLittleEndian(output, descriptor.Channel, sizeof(uint8_t));
+          Helper::appendLittleEndian(output, descriptor.Level, sizeof(uint8_t));
+          Helper::appendLittleEndian(output, descriptor.Opcode, sizeof(uint8_t));
+          Helper::appendLittleEndian(output, descriptor.Task, sizeof(uint16_t));
+          Helper::appendLittleEndian(output, descriptor.Keyword, sizeof(uint64_t));
+
+          Helper::appendLittleEndian(output, event.mDataDescriptorCount, sizeof(uint16_t));
+          for (size_t index = 0; index < event.mDataDescriptorCount; ++index)
+          {
+            auto &data = event.mDataDescriptors[index];
+            size_t size = (data.Ptr ? static_cast<size_t>(data.Size) : 0);
+
+            Helper::appendLittleEndian(output, static_cast<uint64_t>(event.mParameterDescriptors[index].Type), sizeof(uint16_t));
+            Helper::appendLittleEndian(output, size, sizeof(uint32_t));
+            if (size > 0) {
+              output.append(reinterpret_cast<const char *>(data.Ptr), size);
+            }
+          }
+
+          endBinaryRecord(output, recordOffset);
+        }
+
+        //---------------------------------------------------------------------
+        size_t Monitor::releaseMergedEvents(bool all)
+        {
+          // (called with the pipeline lock held) an event is released once
+          // it is older than the merge window, so an event from another
+          // remote arriving up to the window late is still output in order;
+          // the window gives way rather than overflow the pipeline
+          Time releaseBefore = zsLib::now() - Milliseconds(ZS_EVENTING_TOOL_MONITOR_MERGE_WINDOW_IN_MILLISECONDS);
+
+          size_t released = 0;
+          while (mPipelineMerging.size() > 0) {
+            auto iter = mPipelineMerging.begin();
+            auto pending = (*iter).second;
+            if ((!all) &&
+                (pending->mTime > releaseBefore) &&
+                (mPipelineMerging.size() < (ZS_EVENTING_TOOL_MONITOR_MAX_PENDING_EVENTS / 2))) break;
+
+            mPipelineMerging.erase(iter);
+            pending->mSequence = mNextSequence;
+            ++mNextSequence;
+            mPipelineQueue.push_back(pending);
+            ++released;
           }
+          return released;
         }
 
         //---------------------------------------------------------------------
+        void Monitor::outputFormatted(PendingEventPtr pending)
+        {
+          // only one worker outputs at a time; the others leave their events
+          // behind for it to output in sequence
+          {
+            AutoLock lock(mPipelineLock);
+            mPipelineFormatted[pending->mSequence] = pending;
+            if (mPipelineOutputting) return;
+            mPipelineOutputting = true;
+          }
+
+          PendingEventList ready;
+
+          while (true) {
+            // output events are kept for reuse (at most one per pending slot)
+            for (auto iter = ready.begin(); iter != ready.end(); ++iter) {
+              (*iter)->mOutput.clear();
+              (*iter)->mWarning.clear();
+            }
+
+            {
+              AutoLock lock(mPipelineLock);
+              if (mPipelineFreeEvents.size() < ZS_EVENTING_TOOL_MONITOR_MAX_PENDING_EVENTS) {
+                mPipelineFreeEvents.splice(mPipelineFreeEvents.end(), ready);
+              }
+              ready.clear();
+
+              while (mPipelineFormatted.size() > 0) {
+                auto iter = mPipelineFormatted.begin();
+                if ((*iter).first != mNextOutputSequence) break;
+
+                ready.push_back((*iter).second);
+                mPipelineFormatted.erase(iter);
+                ++mNextOutputSequence;
+              }
+
+              if (ready.size() < 1) {
+                mPipelineOutputting = false;
+                break;
+              }
+              mPipelinePending -= ready.size();
+            }
+
+            for (auto iter = ready.begin(); iter != ready.end(); ++iter) {
+              auto &event = (*iter);
+
+              if (event->mWarning.hasData()) {
+                tool::output() << event->mWarning;
+              }
+              if (event->mOutput.isEmpty()) continue;
+              if (mOutputFailed) continue;
+
+              try {
+                outputEvent(*event);
+              } catch (const Failure &e) {
+                tool::output() << "[Warning] Event output stopped: " << e.message() << "\n";
+                mOutputFailed = true;
+              }
+            }
+          }
+        }
+
         //---------------------------------------------------------------------
+        void Monitor::outputEvent(PendingEvent &pending) throw (Failure)
+        {
+          switch (mMonitorInfo.mOutputFormat) {
+            case ICommandLineTypes::OutputFormat_None:    break;
+            case ICommandLineTypes::OutputFormat_JSON:    {
+              if (!mFirstOutputEvent) {
+                tool::output() << ",";
+              } else {
+                mFirstOutputEvent = false;
+              }
+              tool::output() << pending.mOutput;
+              tool::output() << "\n";
+              break;
+            }
+            case ICommandLineTypes::OutputFormat_NDJSON:  {
+              if (!mOutputWriter) {
+                tool::output() << pending.mOutput;
+                tool::output() << "\n";
+                break;
+              }
+              mOutputWriter->rotateIfNeeded();
+              mOutputWriter->write(pending.mOutput);
+              mOutputWriter->write("\n", 1);
+              break;
+            }
+            case ICommandLineTypes::OutputFormat_CSV:     {
+              // a rotated csv file starts with the header again
+              auto writer = getCSVWriter(pending);
+              writer->rotateIfNeeded();
+              writer->write(pending.mOutput);
+              break;
+            }
+            case ICommandLineTypes::OutputFormat_Binary:  {
+              // providers are announced again at the start of every file so
+              // each rotated file can be read on its own
+              if (mOutputWriter->rotateIfNeeded()) {
+                mBinaryProviders.clear();
+                mBinarySourceAnnounced = false;
+              }
+              if ((hasMultipleSources()) &&
+                  ((!mBinarySourceAnnounced) ||
+                   (mBinarySource != pending.mSource))) {
+                mBinarySource = pending.mSource;
+                mBinarySourceAnnounced = true;
+
+                String record;
+                size_t recordOffset = beginBinaryRecord(record, BinaryRecordType_Source);
+                Helper::appendLittleEndian(record, pending.mSource, sizeof(uint16_t));
+                Helper::appendString(record, getSourceName(pending.mSource));
+                endBinaryRecord(record, recordOffset);
+
+                mOutputWriter->write(record);
+              }
+              if (mBinaryProviders.end() == mBinaryProviders.find(pending.mProvider)) {
+                mBinaryProviders.insert(pending.mProvider);
+
+                String record;
+                size_t recordOffset = beginBinaryRecord(record, BinaryRecordType_Provider);
+                Helper::appendLittleEndian(record, pending.mProvider->mHandle, sizeof(uint64_t));
+                Helper::appendString(record, pending.mProvider->mProviderName);
+                Helper::appendString(record, pending.mProvider->mProviderUniqueHash);
+                endBinaryRecord(record, recordOffset);
+
+                mOutputWriter->write(record);
+              }
+              mOutputWriter->write(pending.mOutput);
+              break;
+            }
+          }
+        }
+
         //---------------------------------------------------------------------
+        BufferedWriterPtr Monitor::getCSVWriter(const PendingEvent &pending) throw (Failure)
+        {
+          // events from the same provider on different remotes share a file
+          CSVWriterKey key(pending.mProvider->mProviderName, static_cast<size_t>(pending.mEvent.mDescriptor.Id));
+
+          {
+            AutoLock lock(mPipelineLock);
+            auto found = mCSVWriters.find(key);
+            if (found != mCSVWriters.end()) return (*found).second;
+          }
+
+          // the header is taken from the schema if known, otherwise the values
+          // are numbered as in the json output
+          EventFormatter *formatter = getFormatter(pending);
+
+          String eventName = (formatter ? formatter->mEvent->mName : string(pending.mEvent.mDescriptor.Id));
+
+          String header(hasMultipleSources() ? "source,severity,level" : "severity,level");
+          for (size_t index = 0; index < ZS_EVENTING_TOTAL_BUILT_IN_EVENT_DATA; ++index) {
+            header.append(",");
+            appendCSVValue(header, getBuiltInName(index));
+          }
+          if (formatter) {
+            for (auto iter = formatter->mFields.begin(); iter != formatter->mFields.end(); ++iter) {
+              header.append(",");
+              appendCSVValue(header, (*iter).mName);
+            }
+          } else {
+            for (size_t index = ZS_EVENTING_TOTAL_BUILT_IN_EVENT_DATA; index < pending.mEvent.mDataDescriptorCount; ++index) {
+              header.append(",");
+              header.append(string(index - ZS_EVENTING_TOTAL_BUILT_IN_EVENT_DATA));
+            }
+          }
+          header.append("\n");
+
+          // names that differ only in characters unsafe for a file name
+          // must not truncate each other's file
+          String fileName;
+          {
+            AutoLock lock(mPipelineLock);
+            fileName = Helper::toUniqueFileName(Helper::toFileNamePart(pending.mProvider->mProviderName) + "." + Helper::toFileNamePart(eventName), ".csv", mCSVFileNames);
+          }
+
+          auto writer = BufferedWriter::create(mMonitorInfo.mOutputPath + "/" + fileName, toRotationOptions(mMonitorInfo), header);
+
+          {
+            AutoLock lock(mPipelineLock);
+            mCSVWriters[key] = writer;
+          }
+          return writer;
+        }
+
         //---------------------------------------------------------------------
-        #pragma mark
-        #pragma mark Monitor => (internal)
-        #pragma mark
+        void Monitor::flushOutput()
+        {
+          CSVWriterMap csvWriters;
+          {
+            AutoLock lock(mPipelineLock);
+            csvWriters = mCSVWriters;
+          }
+
+          try {
+            if (mOutputWriter) mOutputWriter->flush();
+
+            for (auto iter = csvWriters.begin(); iter != csvWriters.end(); ++iter) {
+              (*iter).second->flush();
+            }
+          } catch (const Failure &e) {
+            if (!mMonitorInfo.mQuietMode) {
+              tool::output() << "[Warning] Failed to flush event output: " << e.message() << "\n";
+            }
+          }
+        }
 
         //---------------------------------------------------------------------
         void Monitor::internalInterrupt()
@@ -784,8 +1559,8 @@ namespace zsLib
           auto pThis = mThisWeak.lock();
           mGracefulShutdownReference = pThis;
 
-          if (mRemote) {
-            mRemote->shutdown();
+          for (auto iter = mRemotes.begin(); iter != mRemotes.end(); ++iter) {
+            (*iter)->shutdown();
           }
 
           if (mAutoQuitTimer) {
@@ -794,26 +1569,124 @@ namespace zsLib
           }
 
           if (mGracefulShutdownReference) {
-            if (mRemote) {
-              auto state = mRemote->getState();
+            for (auto iter = mRemotes.begin(); iter != mRemotes.end(); ++iter) {
+              auto state = (*iter)->getState();
               if (IRemoteEventingTypes::State_Shutdown != state) return;
             }
           }
           
-          if (mMonitorInfo.mOutputJSON) {
+          if ((ICommandLineTypes::OutputFormat_None != mMonitorInfo.mOutputFormat) ||
+              (isStatsMode()) ||
+              (isLatencyMode())) {
             Log::removeEventingListener(pThis);
             Log::removeEventingProviderListener(pThis);
           }
 
-          mRemote.reset();
+          stopFormatters();
+
+          // the schema cache is written once at shutdown and whenever the
+          // loader runs out of work, never per schema
+          stopSchemaLoader();
+          saveSchemaCache();
+
+          if (mStatsTimer) {
+            mStatsTimer->cancel();
+            mStatsTimer.reset();
+            outputStats();
+          }
+          if (mLatencyTimer) {
+            mLatencyTimer->cancel();
+            mLatencyTimer.reset();
+            outputLatency();
+          }
+
+          if (mFlushTimer) {
+            mFlushTimer->cancel();
+            mFlushTimer.reset();
+          }
+          flushOutput();
+
+          if (mMergeTimer) {
+            mMergeTimer->cancel();
+            mMergeTimer.reset();
+          }
+
+          // releasing the writers waits for rotated files to be compressed
+          mOutputWriter.reset();
+          {
+            AutoLock lock(mPipelineLock);
+            mCSVWriters.clear();
+          }
+
+          // transport statistics are totalled over all the remotes
+          IRemoteEventingTypes::Statistics stats;
+          for (auto iter = mRemotes.begin(); iter != mRemotes.end(); ++iter) {
+            auto remoteStats = (*iter)->getStatistics();
+            stats.mBytesSent += remoteStats.mBytesSent;
+            stats.mBytesReceived += remoteStats.mBytesReceived;
+            stats.mFramesSent += remoteStats.mFramesSent;
+            stats.mFramesReceived += remoteStats.mFramesReceived;
+            stats.mSendCalls += remoteStats.mSendCalls;
+            stats.mReceiveCalls += remoteStats.mReceiveCalls;
+            if (remoteStats.mOutgoingQueueHighWaterMark > stats.mOutgoingQueueHighWaterMark) stats.mOutgoingQueueHighWaterMark = remoteStats.mOutgoingQueueHighWaterMark;
+            stats.mWriteBlockedTime += remoteStats.mWriteBlockedTime;
+            if (remoteStats.mHandshakeDuration > stats.mHandshakeDuration) stats.mHandshakeDuration = remoteStats.mHandshakeDuration;
+          }
+
+          mRemotes.clear();
+
+          if (mRecordWriter) {
+            try {
+              mRecordWriter->close();
+            } catch (const StdError &e) {
+              tool::output() << "[Warning] Failed to close record file: " << mRecordWriter->getFileName() << ", error=" << string(e.result()) << ", reason=" << e.message() << "\n";
+            }
+            if (!mMonitorInfo.mQuietMode) {
+              tool::output() << "[Info] Total events recorded: " << string(mRecordWriter->getTotalRecords()) << "\n";
+
+              // measured on the trace just recorded
+              auto compression = mRecordWriter->getCompressionStats();
+              if (0 != compression.mInputBytes) {
+                tool::output() << "[Info] Record compression: " << string(compression.mInputBytes) << " -> " << string(compression.mStoredBytes) << " bytes (" << string(static_cast<double>(compression.mInputBytes) / static_cast<double>(compression.mStoredBytes > 0 ? compression.mStoredBytes : 1)) << "x), " << string(compression.mTotalCompressedBlocks) << " of " << string(compression.mTotalBlocks) << " chunk(s) compressed\n";
+                if (Microseconds() != compression.mCompressTime) {
+                  tool::output() << "[Info] Record compression speed (MB/s): " << string(static_cast<double>(compression.mInputBytes) / static_cast<double>(compression.mCompressTime.count())) << "\n";
+                }
+                if (Microseconds() != compression.mVerifyTime) {
+                  tool::output() << "[Info] Record decompression speed (MB/s): " << string(static_cast<double>(compression.mVerifiedBytes) / static_cast<double>(compression.mVerifyTime.count())) << "\n";
+                }
+                if (0 != compression.mTotalVerifyFailures) {
+                  tool::output() << "[Warning] Record chunks that failed the compression round trip (stored uncompressed): " << string(compression.mTotalVerifyFailures) << "\n";
+                }
+              }
+            }
+            mRecordWriter.reset();
+          }
 
-          if (mMonitorInfo.mOutputJSON) {
+          if (ICommandLineTypes::OutputFormat_JSON == mMonitorInfo.mOutputFormat) {
             tool::output() << "\n] } }\n";
           }
+          if (isOutputToCommandLine()) {
+            tool::output().setBlockBuffering(false);
+          }
           if (!mMonitorInfo.mQuietMode) {
             tool::output() << "\n";
             tool::output() << "[Info] Total events dropped: " << string(mTotalEventsDropped) << "\n";
+            if (0 != mTotalEventsOverflowed) {
+              tool::output() << "[Info] Total events dropped by the monitor (output too slow): " << string(mTotalEventsOverflowed) << "\n";
+            }
             tool::output() << "[Info] Total events received: " << string(mTotalEvents) << "\n";
+            if (mFilter) {
+              tool::output() << "[Info] Total events filtered out: " << string(mTotalEventsFiltered) << "\n";
+            }
+            tool::output() << "[Info] Transport bytes sent/received: " << string(stats.mBytesSent) << " / " << string(stats.mBytesReceived) << "\n";
+            tool::output() << "[Info] Transport frames sent/received: " << string(stats.mFramesSent) << " / " << string(stats.mFramesReceived) << "\n";
+            tool::output() << "[Info] Transport send/receive calls: " << string(stats.mSendCalls) << " / " << string(stats.mReceiveCalls) << "\n";
+            tool::output() << "[Info] Transport outgoing queue high water mark: " << string(stats.mOutgoingQueueHighWaterMark) << "\n";
+            tool::output() << "[Info] Transport write blocked (ms): " << string(std::chrono::duration_cast<Milliseconds>(stats.mWriteBlockedTime).count()) << "\n";
+            tool::output() << "[Info] Transport handshake (ms): " << string(stats.mHandshakeDuration.count()) << "\n";
+            if (0 != mMonitorInfo.mTopTalkers) {
+              outputTopTalkers();
+            }
           }
           mShouldQuit = true;
 
@@ -821,68 +1694,934 @@ namespace zsLib
         }
 
         //---------------------------------------------------------------------
-        void Monitor::step()
+        void Monitor::outputTopTalkers()
         {
-          for (auto iter = mMonitorInfo.mJMANFiles.begin(); iter != mMonitorInfo.mJMANFiles.end(); ++iter) {
-            auto fileName = (*iter);
-            
-            ProviderPtr provider;
-            SecureByteBlockPtr jmanRaw;
-            
-            try {
-              jmanRaw = IHelper::loadFile(fileName);
-            } catch (const StdError &e) {
-              ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_FILE_FAILED_TO_LOAD, String("Failed to load jman file: ") + fileName + ", error=" + string(e.result()) + ", reason=" + e.message());
-            }
-            if (!jmanRaw) {
-              ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_FILE_FAILED_TO_LOAD, String("Failed to load jman file: ") + fileName);
-            }
-            
-            auto rootEl = IHelper::read(jmanRaw);
-            
-            try {
-              provider = Provider::create(rootEl);
-            } catch (const InvalidContent &e) {
-              ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_INVALID_CONTENT, "Failed to parse jman file: " + e.message());
-            }
-            if (!provider) {
-              ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_FILE_FAILED_TO_LOAD, "Failed to parse jman file: " + fileName);
-            }
-            
-            auto found = mProviders.find(provider->mID);
-            if (found != mProviders.end()) {
-              ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_INVALID_CONTENT, "Duplicate provider found in jman file: " + fileName);
-            }
-            
-            mProviders[provider->mID] = provider;
-          }
-          
-          if (Seconds() != mMonitorInfo.mTimeout) {
-            mAutoQuitTimer = ITimer::create(mThisWeak.lock(), zsLib::now() + mMonitorInfo.mTimeout);
+          if (mEventCounters.size() < 1) return;
+
+          collectIndexedSchemas();
+
+          typedef std::vector<const EventCounterMap::value_type *> EventCounterPtrList;
+          EventCounterPtrList sorted;
+          sorted.reserve(mEventCounters.size());
+
+          for (auto iter = mEventCounters.begin(); iter != mEventCounters.end(); ++iter) {
+            sorted.push_back(&(*iter));
           }
-          
-          if (mMonitorInfo.mIPAddress.isAddressEmpty()) {
-            mRemote = IRemoteEventing::listenForRemote(mThisWeak.lock(), mMonitorInfo.mPort, mMonitorInfo.mSecret);
-            if (!mMonitorInfo.mQuietMode) {
-              tool::output() << "[Info] Listening for remote connection: " << string(mMonitorInfo.mPort) << "\n";
-            }
+
+          size_t total = (mMonitorInfo.mTopTalkers < sorted.size() ? mMonitorInfo.mTopTalkers : sorted.size());
+
+          std::partial_sort(sorted.begin(), sorted.begin() + total, sorted.end(), [](const EventCounterMap::value_type *leftEntry, const EventCounterMap::value_type *rightEntry) -> bool {
+            auto left = &(leftEntry->second);
+            auto right = &(rightEntry->second);
+            if (left->mTotalBytes != right->mTotalBytes) return left->mTotalBytes > right->mTotalBytes;
+            if (left->mTotalDropped != right->mTotalDropped) return left->mTotalDropped > right->mTotalDropped;
+            return left->mTotalEvents > right->mTotalEvents;
+          });
+
+          bool multipleSources = hasMultipleSources();
+
+          if (multipleSources) {
+            tool::output() << "[Info] Top talkers (events / bytes / dropped / source / provider / event):\n";
           } else {
-            mRemote = IRemoteEventing::connectToRemote(mThisWeak.lock(), mMonitorInfo.mIPAddress, mMonitorInfo.mSecret);
-            if (!mMonitorInfo.mQuietMode) {
-              tool::output() << "[Info] Connecting to remote process: " << mMonitorInfo.mIPAddress.string() << "\n";
-            }
+            tool::output() << "[Info] Top talkers (events / bytes / dropped / provider / event):\n";
           }
-          
-          if (!mRemote) {
-            cancel();
-            return;
+          for (size_t index = 0; index < total; ++index) {
+            auto counter = &(sorted[index]->second);
+            tool::output() << "  " << string(counter->mTotalEvents) << " / " << string(counter->mTotalBytes) << " / " << string(counter->mTotalDropped) << " / ";
+            if (multipleSources) {
+              tool::output() << getRemoteName(std::get<0>(sorted[index]->first)) << " / ";
+            }
+            tool::output() << counter->mProviderName << " / " << getEventName(*counter) << "\n";
           }
-          
-          for (auto iter = mProviders.begin(); iter != mProviders.end(); ++iter) {
+        }
+
+        //---------------------------------------------------------------------
+        size_t Monitor::getSource() const
+        {
+          // events are written by a remote on its own queue's thread
+          if (!hasMultipleSources()) return 0;
+
+          PUID remoteID = IRemoteEventing::getWritingRemoteID();
+
+          AutoLock lock(mSourceLock);
+          auto found = mSourceIndexes.find(remoteID);
+          if (found == mSourceIndexes.end()) return mSourceNames.size();
+          return (*found).second;
+        }
+
+        //---------------------------------------------------------------------
+        String Monitor::getSourceName(size_t source) const
+        {
+          if (source >= mSourceNames.size()) return String("unknown");
+          return mSourceNames[source];
+        }
+
+        //---------------------------------------------------------------------
+        String Monitor::getRemoteName(PUID remoteID) const
+        {
+          size_t source = mSourceNames.size();
+          {
+            AutoLock lock(mSourceLock);
+            auto found = mSourceIndexes.find(remoteID);
+            if (found != mSourceIndexes.end()) source = (*found).second;
+          }
+          return getSourceName(source);
+        }
+
+        //---------------------------------------------------------------------
+        String Monitor::getEventName(const EventCounter &counter) const
+        {
+          auto found = mProvidersByID.find(counter.mProviderID);
+          if (found != mProvidersByID.end()) {
+            auto provider = (*found).second;
+            for (auto iter = provider->mEvents.begin(); iter != provider->mEvents.end(); ++iter) {
+              auto event = (*iter).second;
+              if (event->mValue == counter.mEventID) return event->mName;
+            }
+          }
+          return String("#") + string(counter.mEventID);
+        }
+
+        //---------------------------------------------------------------------
+        void Monitor::updateStats(
+                                  ProviderInfo *provider,
+                                  EVENT_DESCRIPTOR_HANDLE descriptor,
+                                  EVENT_PARAMETER_DESCRIPTOR_HANDLE paramDescriptor,
+                                  EVENT_DATA_DESCRIPTOR_HANDLE dataDescriptor,
+                                  size_t dataDescriptorCount
+                                  )
+        {
+          size_t eventID = static_cast<size_t>(descriptor->Id);
+
+          EventFormatter *formatter = NULL;
+          if (eventID < provider->mFormatters.size()) {
+            formatter = provider->mFormatters[eventID].get();
+          }
+
+          String subsystemName;
+          if ((dataDescriptorCount > 0) &&
+              (EventParameterType_AString == paramDescriptor[0].Type) &&
+              (dataDescriptor[0].Ptr)) {
+            const char *name = reinterpret_cast<const char *>(dataDescriptor[0].Ptr);
+            subsystemName = String(std::string(name, strnlen(name, static_cast<size_t>(dataDescriptor[0].Size))));
+          }
+
+          AutoLock lock(mStatsLock);
+
+          auto &stats = mEventStats[EventStatsKey(provider, eventID)];
+          stats.mProvider = provider;
+          stats.mEventID = eventID;
+          stats.mRate.add();
+
+          mProviderStats[provider].add();
+          if (subsystemName.hasData()) {
+            mSubsystemStats[subsystemName].add();
+          }
+
+          if (!formatter) return;
+          if ((formatter->mTotalDataParams != dataDescriptorCount) &&
+              (formatter->mTotalDataParamsWithoutSizes != dataDescriptorCount)) return;
+
+          if (stats.mFields.size() < formatter->mFields.size()) {
+            stats.mFields.resize(formatter->mFields.size());
+          }
+
+          for (size_t index = 0; index < formatter->mFields.size(); ++index)
+          {
+            auto &field = formatter->mFields[index];
+            if (field.mIndex >= dataDescriptorCount) break;
+
+            if (mHeavyHitters.size() > 0) {
+              auto found = mHeavyHitters.find(field.mName);
+              if (found != mHeavyHitters.end()) {
+                bool isNumber {};
+                (*found).second.add(ITraceFileTypes::valueAsString(paramDescriptor[field.mIndex], dataDescriptor[field.mIndex], isNumber));
+              }
+            }
+
+            double value {};
+            if (!ITraceFileTypes::getNumericValue(paramDescriptor[field.mIndex], dataDescriptor[field.mIndex], value)) continue;
+
+            stats.mFields[index].add(value);
+          }
+        }
+
+        //---------------------------------------------------------------------
+        void Monitor::outputStats()
+        {
+          typedef std::vector<const EventStats *> EventStatsPtrList;
+
+          auto now = std::chrono::steady_clock::now();
+
+          AutoLock lock(mStatsLock);
+
+          double interval = std::chrono::duration_cast<std::chrono::duration<double>>(now - mStatsLastOutput).count();
+          mStatsLastOutput = now;
+
+          EventStatsPtrList sorted;
+          sorted.reserve(mEventStats.size());
+
+          for (auto iter = mEventStats.begin(); iter != mEventStats.end(); ++iter) {
+            (*iter).second.mRate.roll(interval);
+            sorted.push_back(&((*iter).second));
+          }
+          for (auto iter = mProviderStats.begin(); iter != mProviderStats.end(); ++iter) {
+            (*iter).second.roll(interval);
+          }
+          for (auto iter = mSubsystemStats.begin(); iter != mSubsystemStats.end(); ++iter) {
+            (*iter).second.roll(interval);
+          }
+
+          std::sort(sorted.begin(), sorted.end(), [](const EventStats *left, const EventStats *right) -> bool {
+            if (left->mRate.mLastRate != right->mRate.mLastRate) return left->mRate.mLastRate > right->mRate.mLastRate;
+            return left->mRate.mTotal > right->mRate.mTotal;
+          });
+
+          tool::output() << "[Info] Event rates (events/s last interval / events/s smoothed / total / provider / event):\n";
+          for (auto iter = sorted.begin(); iter != sorted.end(); ++iter) {
+            auto stats = (*iter);
+            auto provider = stats->mProvider;
+
+            EventFormatter *formatter = NULL;
+            if (stats->mEventID < provider->mFormatters.size()) {
+              formatter = provider->mFormatters[stats->mEventID].get();
+            }
+
+            String eventName = (formatter ? formatter->mEvent->mName : (String("#") + string(stats->mEventID)));
+            tool::output() << "  " << string(stats->mRate.mLastRate) << " / " << string(stats->mRate.mRate) << " / " << string(stats->mRate.mTotal) << " / " << provider->mProviderName << " / " << eventName << "\n";
+
+            if (!formatter) continue;
+
+            for (size_t index = 0; (index < stats->mFields.size()) && (index < formatter->mFields.size()); ++index) {
+              auto &field = stats->mFields[index];
+              if (0 == field.mCount) continue;
+
+              tool::output() << "      " << formatter->mFields[index].mName << ": count=" << string(field.mCount) << " min=" << string(field.mMin) << " mean=" << string(field.mTotal / static_cast<double>(field.mCount)) << " max=" << string(field.mMax) << " p50<=" << string(field.getPercentile(0.5)) << " p99<=" << string(field.getPercentile(0.99)) << "\n";
+            }
+          }
+
+          tool::output() << "[Info] Provider rates (events/s last interval / events/s smoothed / total / provider):\n";
+          for (auto iter = mProviderStats.begin(); iter != mProviderStats.end(); ++iter) {
+            auto &stats = (*iter).second;
+            tool::output() << "  " << string(stats.mLastRate) << " / " << string(stats.mRate) << " / " << string(stats.mTotal) << " / " << (*iter).first->mProviderName << "\n";
+          }
+
+          tool::output() << "[Info] Subsystem rates (events/s last interval / events/s smoothed / total / subsystem):\n";
+          for (auto iter = mSubsystemStats.begin(); iter != mSubsystemStats.end(); ++iter) {
+            auto &stats = (*iter).second;
+            tool::output() << "  " << string(stats.mLastRate) << " / " << string(stats.mRate) << " / " << string(stats.mTotal) << " / " << (*iter).first << "\n";
+          }
+
+          for (auto iter = mHeavyHitters.begin(); iter != mHeavyHitters.end(); ++iter) {
+            auto &heavyHitters = (*iter).second;
+            tool::output() << "[Info] Heavy hitters of \"" << (*iter).first << "\" out of " << string(heavyHitters.mTotal) << " values (approximate count / value):\n";
+
+            auto heaviest = heavyHitters.getHeaviest();
+            for (auto iterHeaviest = heaviest.begin(); iterHeaviest != heaviest.end(); ++iterHeaviest) {
+              tool::output() << "  " << string((*iterHeaviest).first) << " / " << (*iterHeaviest).second << "\n";
+            }
+          }
+        }
+
+        //---------------------------------------------------------------------
+        void Monitor::updateLatency(
+                                    ProviderInfo *provider,
+                                    EVENT_DESCRIPTOR_HANDLE descriptor,
+                                    EVENT_PARAMETER_DESCRIPTOR_HANDLE paramDescriptor,
+                                    EVENT_DATA_DESCRIPTOR_HANDLE dataDescriptor,
+                                    size_t dataDescriptorCount
+                                    )
+        {
+          size_t opCode = static_cast<size_t>(descriptor->Opcode);
+          if ((IEventingTypes::PredefinedOpCode_Start != opCode) &&
+              (IEventingTypes::PredefinedOpCode_Stop != opCode)) return;
+
+          // spans are timed by the remote's own write times where it sends
+          // them (otherwise as the events arrive)
+          SpanTime now = IRemoteEventing::getWritingEventTime();
+
+          size_t task = static_cast<size_t>(descriptor->Task);
+          size_t eventID = static_cast<size_t>(descriptor->Id);
+
+          EventFormatter *formatter = NULL;
+          if (eventID < provider->mFormatters.size()) {
+            formatter = provider->mFormatters[eventID].get();
+          }
+
+          String correlation;
+          if ((formatter) &&
+              (mMonitorInfo.mCorrelationField.hasData())) {
+            for (auto iter = formatter->mFields.begin(); iter != formatter->mFields.end(); ++iter) {
+              auto &field = (*iter);
+              if (field.mName != mMonitorInfo.mCorrelationField) continue;
+              if (field.mIndex >= dataDescriptorCount) break;
+
+              bool isNumber {};
+              correlation = ITraceFileTypes::valueAsString(paramDescriptor[field.mIndex], dataDescriptor[field.mIndex], isNumber);
+              break;
+            }
+          }
+
+          AutoLock lock(mLatencyLock);
+
+          // spans only pair up within the remote process that started them
+          OpenSpanKey key(provider, getSource(), task, correlation);
+
+          if (IEventingTypes::PredefinedOpCode_Start == opCode) {
+            if (mTotalOpenSpans >= ZS_EVENTING_TOOL_MONITOR_LATENCY_MAX_OPEN_SPANS) {
+              ++mTotalDroppedSpans;
+              return;
+            }
+            mOpenSpans[key].push_back(now);
+            ++mTotalOpenSpans;
+            return;
+          }
+
+          auto &latency = mTaskLatencies[TaskLatencyKey(provider, task)];
+          if (latency.mTaskName.isEmpty()) {
+            latency.mProvider = provider;
+            if ((formatter) && (formatter->mEvent->mTask)) {
+              latency.mTaskName = formatter->mEvent->mTask->mName;
+            } else {
+              latency.mTaskName = String("#") + string(task);
+            }
+          }
+
+          auto found = mOpenSpans.find(key);
+          if (found == mOpenSpans.end()) {
+            ++latency.mUnmatchedStops;
+            return;
+          }
+
+          auto &starts = (*found).second;
+          auto started = starts.back();
+          starts.pop_back();
+          --mTotalOpenSpans;
+          if (starts.size() < 1) mOpenSpans.erase(found);
+
+          auto duration = std::chrono::duration_cast<Microseconds>(now - started).count();
+          if (duration < 0) duration = 0;
+
+          latency.mHistogram.record(static_cast<ULONGLONG>(duration));
+          latency.mIntervalHistogram.record(static_cast<ULONGLONG>(duration));
+        }
+
+        //---------------------------------------------------------------------
+        void Monitor::outputLatency()
+        {
+          AutoLock lock(mLatencyLock);
+
+          tool::output() << "[Info] Task latency in microseconds (interval count p50/p99/p999 / total count p50/p99/p999 max / provider / task):\n";
+          for (auto iter = mTaskLatencies.begin(); iter != mTaskLatencies.end(); ++iter) {
+            auto &latency = (*iter).second;
+            auto &interval = latency.mIntervalHistogram;
+            auto &total = latency.mHistogram;
+
+            tool::output() << "  " << string(interval.mTotal) << " " << string(interval.getPercentile(0.5)) << "/" << string(interval.getPercentile(0.99)) << "/" << string(interval.getPercentile(0.999));
+            tool::output() << " / " << string(total.mTotal) << " " << string(total.getPercentile(0.5)) << "/" << string(total.getPercentile(0.99)) << "/" << string(total.getPercentile(0.999)) << " " << string(total.mMax);
+            tool::output() << " / " << latency.mProvider->mProviderName << " / " << latency.mTaskName;
+            if (0 != latency.mUnmatchedStops) {
+              tool::output() << " (unmatched stops: " << string(latency.mUnmatchedStops) << ")";
+            }
+            tool::output() << "\n";
+
+            interval.reset();
+          }
+
+          tool::output() << "[Info] Open task spans: " << string(mTotalOpenSpans) << "\n";
+          if (0 != mTotalDroppedSpans) {
+            tool::output() << "[Warning] Task spans not measured (too many open spans): " << string(mTotalDroppedSpans) << "\n";
+          }
+        }
+
+        //---------------------------------------------------------------------
+        bool Monitor::isOutputToCommandLine() const
+        {
+          switch (mMonitorInfo.mOutputFormat) {
+            case ICommandLineTypes::OutputFormat_None:    return false;
+            case ICommandLineTypes::OutputFormat_JSON:
+            case ICommandLineTypes::OutputFormat_NDJSON:  return mMonitorInfo.mOutputPath.isEmpty();
+            case ICommandLineTypes::OutputFormat_CSV:     return false;
+            case ICommandLineTypes::OutputFormat_Binary:  return ("-" == mMonitorInfo.mOutputPath);
+          }
+          return false;
+        }
+
+        //---------------------------------------------------------------------
+        Monitor::EventFormatterPtr Monitor::createFormatter(EventPtr event)
+        {
+          auto formatter = make_shared<EventFormatter>();
+          formatter->mEvent = event;
+
+          {
+            JSONWriter writer;
+            writer.writeString("name", event->mName);
+            if (event->mChannel) {
+              writer.writeString("channel", event->mChannel->mID);
+            }
+            if (event->mTask) {
+              writer.writeString("task", event->mTask->mName);
+            }
+            if (event->mOpCode) {
+              writer.writeString("opCode", event->mOpCode->mName);
+            }
+            formatter->mEncodedMembers = String(std::string(writer.data(), writer.size()));
+          }
+
+          formatter->mTotalDataParams = ZS_EVENTING_TOTAL_BUILT_IN_EVENT_DATA;
+          formatter->mTotalDataParamsWithoutSizes = ZS_EVENTING_TOTAL_BUILT_IN_EVENT_DATA;
+
+          if (!event->mDataTemplate) return formatter;
+
+          size_t index = ZS_EVENTING_TOTAL_BUILT_IN_EVENT_DATA;
+          for (auto iter = event->mDataTemplate->mDataTypes.begin(); iter != event->mDataTemplate->mDataTypes.end(); ++iter, ++index)
+          {
+            auto &dataType = (*iter);
+
+            FormatterField field;
+            field.mName = dataType->mValueName;
+            field.mEncodedName = JSONWriter::encodeName(dataType->mValueName);
+            field.mIndex = index;
+
+            ++(formatter->mTotalDataParams);
+
+            if (dataType->mType == IEventingTypes::PredefinedTypedef_size) {
+              // the size refers to the buffer size stored just before it
+              field.mIndex = index - 1;
+            } else {
+              ++(formatter->mTotalDataParamsWithoutSizes);
+
+              // the actual type and value of the buffer is stored just after its size in the array
+              if (dataType->mType == IEventingTypes::PredefinedTypedef_binary) {
+                field.mIndex = index + 1;
+              }
+            }
+
+            formatter->mFields.push_back(field);
+          }
+
+          return formatter;
+        }
+
+        //---------------------------------------------------------------------
+        Monitor::EventFormatter *Monitor::getFormatter(const PendingEvent &pending)
+        {
+          size_t eventID = static_cast<size_t>(pending.mEvent.mDescriptor.Id);
+          if (eventID >= pending.mProvider->mFormatters.size()) return NULL;
+          return pending.mProvider->mFormatters[eventID].get();
+        }
+
+        //---------------------------------------------------------------------
+        Monitor::ProviderPtr Monitor::loadProvider(
+                                                   const String &fileName,
+                                                   bool &outFromCache
+                                                   ) throw (Failure)
+        {
+          ProviderPtr provider;
+          SecureByteBlockPtr jmanRaw;
+
+          outFromCache = false;
+
+          try {
+            jmanRaw = IHelper::loadFile(fileName);
+          } catch (const StdError &e) {
+            ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_FILE_FAILED_TO_LOAD, String("Failed to load jman file: ") + fileName + ", error=" + string(e.result()) + ", reason=" + e.message());
+          }
+          if (!jmanRaw) {
+            ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_FILE_FAILED_TO_LOAD, String("Failed to load jman file: ") + fileName);
+          }
+
+          // the compiled schema is only used if it was compiled from the
+          // same jman contents
+          String sourceHash;
+          if (mSchemaCache) {
+            sourceHash = SchemaCache::toSourceHash(*jmanRaw);
+            try {
+              provider = mSchemaCache->getProvider(sourceHash);
+            } catch (const InvalidContent &e) {
+              if (!mMonitorInfo.mQuietMode) {
+                tool::output() << "[Warning] Ignoring compiled schema for jman file: " << fileName << ", reason=" << e.message() << "\n";
+              }
+            }
+          }
+
+          if (provider) {
+            outFromCache = true;
+            return provider;
+          }
+
+          auto rootEl = IHelper::read(jmanRaw);
+
+          try {
+            provider = Provider::create(rootEl);
+          } catch (const InvalidContent &e) {
+            ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_INVALID_CONTENT, "Failed to parse jman file: " + e.message());
+          }
+          if (!provider) {
+            ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_FILE_FAILED_TO_LOAD, "Failed to parse jman file: " + fileName);
+          }
+
+          if (mSchemaCache) mSchemaCache->setProvider(sourceHash, provider);
+          return provider;
+        }
+
+        //---------------------------------------------------------------------
+        void Monitor::indexSchemas() throw (Failure)
+        {
+          StringList files;
+          try {
+            files = Helper::listFiles(mMonitorInfo.mJMANFolder, ".jman");
+          } catch (const StdError &e) {
+            ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_FILE_FAILED_TO_LOAD, String("Failed to list jman folder: ") + mMonitorInfo.mJMANFolder + ", error=" + string(e.result()) + ", reason=" + e.message());
+          }
+
+          size_t totalLoaded = 0;
+
+          for (auto iter = files.begin(); iter != files.end(); ++iter) {
+            auto &fileName = (*iter);
+
+            IndexedSchema schema;
+            schema.mFileName = fileName;
+
+            if (!scanSchemaHeader(fileName, schema.mProviderID, schema.mUniqueHash)) {
+              // a jman file that cannot be indexed is loaded right away
+              bool fromCache {};
+              auto provider = loadProvider(fileName, fromCache);
+              ++totalLoaded;
+
+              if (!addProvider(provider)) {
+                if (!mMonitorInfo.mQuietMode) {
+                  tool::output() << "[Warning] Ignoring duplicate provider in jman file: " << fileName << "\n";
+                }
+              }
+              continue;
+            }
+
+            if (mProviders.end() != mProviders.find(schema.mUniqueHash)) continue;  // already loaded from a -jman file
+
+            AutoLock lock(mSchemaLoaderLock);
+            mIndexedSchemas[schema.mUniqueHash] = schema;
+          }
+
+          if (!mMonitorInfo.mQuietMode) {
+            AutoLock lock(mSchemaLoaderLock);
+            tool::output() << "[Info] Indexed jman files: " << string(mIndexedSchemas.size()) << " (loaded up front: " << string(totalLoaded) << ")\n";
+          }
+        }
+
+        //---------------------------------------------------------------------
+        bool Monitor::requestIndexedSchema(const String &uniqueHash)
+        {
+          {
+            AutoLock lock(mSchemaLoaderLock);
+            if (mSchemaLoaderShutdown) return false;
+
+            auto found = mIndexedSchemas.find(uniqueHash);
+            if (found == mIndexedSchemas.end()) {
+              // already requested (or never indexed)
+              if (uniqueHash == mSchemaLoading) return true;
+              for (auto iter = mSchemaRequests.begin(); iter != mSchemaRequests.end(); ++iter) {
+                if (uniqueHash == (*iter).mUniqueHash) return true;
+              }
+              return false;
+            }
+
+            mSchemaRequests.push_back((*found).second);
+            mIndexedSchemas.erase(found);
+
+            if (!mSchemaLoader.joinable()) {
+              mSchemaLoader = std::thread(&Monitor::runSchemaLoader, this);
+            }
+          }
+          mSchemaLoaderWorkAvailable.notify_one();
+          return true;
+        }
+
+        //---------------------------------------------------------------------
+        void Monitor::waitForIndexedSchema(const String &uniqueHash)
+        {
+          if (!requestIndexedSchema(uniqueHash)) return;
+
+          std::unique_lock<Lock> lock(mSchemaLoaderLock);
+          while (!mSchemaLoaderShutdown) {
+            bool pending = (uniqueHash == mSchemaLoading);
+            for (auto iter = mSchemaRequests.begin(); (!pending) && (iter != mSchemaRequests.end()); ++iter) {
+              pending = (uniqueHash == (*iter).mUniqueHash);
+            }
+            if (!pending) break;
+            mSchemaLoaded.wait(lock);
+          }
+        }
+
+        //---------------------------------------------------------------------
+        void Monitor::collectIndexedSchemas()
+        {
+          ProviderMap loaded;
+          {
+            AutoLock lock(mSchemaLoaderLock);
+            loaded.swap(mLoadedSchemas);
+          }
+
+          for (auto iter = loaded.begin(); iter != loaded.end(); ++iter) {
+            addProvider((*iter).second);
+          }
+        }
+
+        //---------------------------------------------------------------------
+        void Monitor::stopSchemaLoader()
+        {
+          {
+            AutoLock lock(mSchemaLoaderLock);
+            mSchemaLoaderShutdown = true;
+          }
+          mSchemaLoaderWorkAvailable.notify_all();
+          mSchemaLoaded.notify_all();
+
+          if (mSchemaLoader.joinable()) mSchemaLoader.join();
+        }
+
+        //---------------------------------------------------------------------
+        void Monitor::runSchemaLoader()
+        {
+          while (true) {
+            IndexedSchema schema;
+
+            {
+              std::unique_lock<Lock> lock(mSchemaLoaderLock);
+              while ((mSchemaRequests.size() < 1) &&
+                     (!mSchemaLoaderShutdown)) {
+                mSchemaLoaderWorkAvailable.wait(lock);
+              }
+              if (mSchemaLoaderShutdown) return;
+
+              schema = mSchemaRequests.front();
+              mSchemaRequests.pop_front();
+              mSchemaLoading = schema.mUniqueHash;
+            }
+
+            ProviderPtr provider;
+            try {
+              bool fromCache {};
+              provider = loadProvider(schema.mFileName, fromCache);
+            } catch (const Failure &e) {
+              tool::output() << "[Warning] " << e.message() << "\n";
+            }
+
+            if ((provider) &&
+                (provider->mID != schema.mProviderID)) {
+              if (!mMonitorInfo.mQuietMode) {
+                tool::output() << "[Warning] Provider ID in jman file does not match its header: " << schema.mFileName << "\n";
+              }
+              provider.reset();
+            }
+
+            if ((provider) &&
+                (!mMonitorInfo.mQuietMode)) {
+              tool::output() << "[Info] Loaded provider \"" << provider->mName << "\" from jman file: " << schema.mFileName << "\n";
+            }
+
+            bool idle {};
+            {
+              AutoLock lock(mSchemaLoaderLock);
+              if (provider) mLoadedSchemas[schema.mUniqueHash] = provider;
+              mSchemaLoading.clear();
+              idle = (mSchemaRequests.size() < 1);
+            }
+            mSchemaLoaded.notify_all();
+
+            // providers announced together are saved together
+            if (idle) saveSchemaCache();
+          }
+        }
+
+        //---------------------------------------------------------------------
+        void Monitor::saveSchemaCache()
+        {
+          if (!mSchemaCache) return;
+          if (!mSchemaCache->isDirty()) return;
+
+          try {
+            mSchemaCache->save();
+          } catch (const Failure &e) {
+            tool::output() << "[Warning] " << e.message() << "\n";
+          }
+        }
+
+        //---------------------------------------------------------------------
+        bool Monitor::addProvider(ProviderPtr provider)
+        {
+          if (mProviders.end() != mProviders.find(provider->mUniqueHash)) return false;
+
+          mProviders[provider->mUniqueHash] = provider;
+          if (mProvidersByID.end() == mProvidersByID.find(provider->mID)) {
+            mProvidersByID[provider->mID] = provider;
+          }
+
+          applySubsystemLevels(provider);
+          return true;
+        }
+
+        //---------------------------------------------------------------------
+        Monitor::ProviderPtr Monitor::findProvider(
+                                                   UUID providerID,
+                                                   const String &uniqueHash
+                                                   )
+        {
+          collectIndexedSchemas();
+
+          {
+            auto found = mProviders.find(uniqueHash);
+            if (found != mProviders.end()) return (*found).second;
+          }
+
+          // another version of the provider (reported as a hash mismatch)
+          auto found = mProvidersByID.find(providerID);
+          if (found != mProvidersByID.end()) return (*found).second;
+          return ProviderPtr();
+        }
+
+        //---------------------------------------------------------------------
+        Monitor::ProviderPtr Monitor::loadShippedProvider(
+                                                          const ProviderInfo &provider,
+                                                          EventingAtomDataArray eventingAtomDataArray
+                                                          )
+        {
+          const BYTE *schema = reinterpret_cast<const BYTE *>(eventingAtomDataArray[mSchemaAtom]);
+          if (!schema) return ProviderPtr();
+
+          // remotes of the same build ship the same schema, decoded once
+          {
+            auto found = mShippedProviders.find(provider.mProviderUniqueHash);
+            if ((found != mShippedProviders.end()) &&
+                ((*found).second->mID == provider.mProviderID)) return (*found).second;
+          }
+
+          size_t size {};
+          const BYTE *compiled = IHelper::getSizePrefixedBuffer(schema, size);
+
+          ProviderPtr shippedProvider;
+          try {
+            shippedProvider = SchemaCache::decompile(compiled, size);
+          } catch (const InvalidContent &e) {
+            if (!mMonitorInfo.mQuietMode) {
+              tool::output() << "[Warning] Schema shipped by provider \"" << provider.mProviderName << "\" is not valid: " << e.message() << "\n";
+            }
+            return ProviderPtr();
+          }
+
+          if ((shippedProvider->mID != provider.mProviderID) ||
+              (shippedProvider->mUniqueHash != provider.mProviderUniqueHash)) {
+            if (!mMonitorInfo.mQuietMode) {
+              tool::output() << "[Warning] Schema shipped by provider \"" << provider.mProviderName << "\" does not match the provider: " << shippedProvider->mUniqueHash << "\n";
+            }
+            return ProviderPtr();
+          }
+
+          if (!mMonitorInfo.mQuietMode) {
+            tool::output() << "[Info] Loaded provider \"" << shippedProvider->mName << "\" from the schema shipped by the remote.\n";
+          }
+
+          mShippedProviders[shippedProvider->mUniqueHash] = shippedProvider;
+
+          // a local jman file of the same version is kept
+          addProvider(shippedProvider);
+          return shippedProvider;
+        }
+
+        //---------------------------------------------------------------------
+        void Monitor::applySubsystemLevels(ProviderPtr provider)
+        {
+          for (auto iterSubsystem = provider->mSubsystems.begin(); iterSubsystem != provider->mSubsystems.end(); ++iterSubsystem) {
+            auto subsystem = (*iterSubsystem).second;
+            for (auto iterRemote = mRemotes.begin(); iterRemote != mRemotes.end(); ++iterRemote) {
+              (*iterRemote)->setRemoteLevel(subsystem->mName, subsystem->mLevel);
+            }
+          }
+        }
+
+        //---------------------------------------------------------------------
+        void Monitor::compileFormatters(
+                                        ProviderInfo *provider,
+                                        ProviderPtr existingProvider
+                                        )
+        {
+          provider->mExistingProvider = existingProvider;
+
+          // compile all events into formatters indexed by event ID
+          for (auto iter = existingProvider->mEvents.begin(); iter != existingProvider->mEvents.end(); ++iter)
+          {
+            auto event = (*iter).second;
+            if (event->mValue > static_cast<ValueID>(std::numeric_limits<decltype(USE_EVENT_DESCRIPTOR::Id)>::max())) continue;  // cannot be written by an event
+
+            if (event->mValue >= provider->mFormatters.size()) {
+              provider->mFormatters.resize(event->mValue + 1);
+            }
+            auto formatter = createFormatter(event);
+            if (mFilter) {
+              EventFilter::FieldIndexMap fields;
+              for (auto iterField = formatter->mFields.begin(); iterField != formatter->mFields.end(); ++iterField) {
+                fields[(*iterField).mName] = (*iterField).mIndex;
+              }
+              formatter->mFilter = mFilter->bind(event->mName, fields);
+            }
+            provider->mFormatters[event->mValue] = formatter;
+          }
+        }
+
+        //---------------------------------------------------------------------
+        void Monitor::step()
+        {
+          if (mMonitorInfo.mSchemaCacheFile.hasData()) {
+            mSchemaCache = SchemaCache::create(mMonitorInfo.mSchemaCacheFile);
+          }
+
+          size_t totalCachedProviders = 0;
+
+          for (auto iter = mMonitorInfo.mJMANFiles.begin(); iter != mMonitorInfo.mJMANFiles.end(); ++iter) {
+            auto fileName = (*iter);
+
+            bool fromCache {};
+            auto provider = loadProvider(fileName, fromCache);
+            if (fromCache) ++totalCachedProviders;
+            
+            if (!addProvider(provider)) {
+              ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_INVALID_CONTENT, "Duplicate provider found in jman file: " + fileName);
+            }
+          }
+
+          if ((mSchemaCache) &&
+              (mMonitorInfo.mJMANFiles.size() > 0) &&
+              (!mMonitorInfo.mQuietMode)) {
+            tool::output() << "[Info] Providers loaded from the schema cache: " << string(totalCachedProviders) << " of " << string(mMonitorInfo.mJMANFiles.size()) << "\n";
+          }
+
+          if (mMonitorInfo.mJMANFolder.hasData()) {
+            indexSchemas();
+          }
+          saveSchemaCache();
+          
+          if (Seconds() != mMonitorInfo.mTimeout) {
+            mAutoQuitTimer = ITimer::create(mThisWeak.lock(), zsLib::now() + mMonitorInfo.mTimeout);
+          }
+          
+          if (mMonitorInfo.mReplayFile.hasData()) {
+            IRemoteEventingPtr remote;
+            try {
+              remote = IRemoteEventing::replayFromFile(mThisWeak.lock(), mMonitorInfo.mReplayFile, mMonitorInfo.mReplaySpeed);
+            } catch (const StdError &e) {
+              ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_FILE_FAILED_TO_LOAD, String("Failed to open replay file: ") + mMonitorInfo.mReplayFile + ", error=" + string(e.result()) + ", reason=" + e.message());
+            }
+            if (remote) mRemotes.push_back(remote);
+            if (!mMonitorInfo.mQuietMode) {
+              tool::output() << "[Info] Replaying trace file: " << mMonitorInfo.mReplayFile << "\n";
+            }
+          } else if (mMonitorInfo.mIPAddresses.size() < 1) {
+            auto remote = IRemoteEventing::listenForRemote(mThisWeak.lock(), mMonitorInfo.mPort, mMonitorInfo.mSecret);
+            if (remote) mRemotes.push_back(remote);
+            if (!mMonitorInfo.mQuietMode) {
+              tool::output() << "[Info] Listening for remote connection: " << string(mMonitorInfo.mPort) << "\n";
+            }
+          } else {
+            // every remote decodes and writes its events on its own queue so
+            // the remotes are received in parallel; the events are tagged
+            // with their source when there is more than one
+            // (the source names are fixed before any events can arrive)
+            for (auto iter = mMonitorInfo.mIPAddresses.begin(); iter != mMonitorInfo.mIPAddresses.end(); ++iter) {
+              mSourceNames.push_back((*iter).string());
+            }
+
+            size_t source = 0;
+            for (auto iter = mMonitorInfo.mIPAddresses.begin(); iter != mMonitorInfo.mIPAddresses.end(); ++iter, ++source) {
+              auto &ipAddress = (*iter);
+
+              IMessageQueuePtr queue;
+              if (hasMultipleSources()) {
+                queue = IMessageQueueManager::getMessageQueue((String("org.zsLib.eventing.tool.Monitor.remote.") + string(source)).c_str());
+              }
+
+              auto remote = IRemoteEventing::connectToRemote(mThisWeak.lock(), ipAddress, mMonitorInfo.mSecret, queue);
+              if (!remote) continue;
+
+              {
+                AutoLock lock(mSourceLock);
+                mSourceIndexes[remote->getID()] = source;
+              }
+              mRemotes.push_back(remote);
+
+              if (!mMonitorInfo.mQuietMode) {
+                tool::output() << "[Info] Connecting to remote process: " << ipAddress.string() << "\n";
+              }
+            }
+          }
+
+          if (mRemotes.size() < 1) {
+            cancel();
+            return;
+          }
+
+          if (mMonitorInfo.mRecordFile.hasData()) {
+            try {
+              mRecordWriter = ITraceFileWriter::create(mMonitorInfo.mRecordFile);
+            } catch (const StdError &e) {
+              ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_FILE_FAILED_TO_LOAD, String("Failed to create record file: ") + mMonitorInfo.mRecordFile + ", error=" + string(e.result()) + ", reason=" + e.message());
+            }
+            mRemotes.front()->recordTo(mRecordWriter);
+            if (!mMonitorInfo.mQuietMode) {
+              tool::output() << "[Info] Recording events to: " << mMonitorInfo.mRecordFile << "\n";
+            }
+          }
+
+          if ((ICommandLineTypes::OutputFormat_Binary == mMonitorInfo.mOutputFormat) ||
+              ((ICommandLineTypes::OutputFormat_NDJSON == mMonitorInfo.mOutputFormat) &&
+               (mMonitorInfo.mOutputPath.hasData()))) {
+            String header;
+            if (ICommandLineTypes::OutputFormat_Binary == mMonitorInfo.mOutputFormat) {
+              header = ZS_EVENTING_TOOL_MONITOR_BINARY_MAGIC;
+              Helper::appendLittleEndian(header, ZS_EVENTING_TOOL_MONITOR_BINARY_VERSION, sizeof(uint32_t));
+            }
+
+            try {
+              mOutputWriter = BufferedWriter::create(mMonitorInfo.mOutputPath, toRotationOptions(mMonitorInfo), header);
+            } catch (const Failure &e) {
+              ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_FILE_FAILED_TO_LOAD, String("Failed to create output file: ") + mMonitorInfo.mOutputPath + ", reason=" + e.message());
+            }
+          }
+
+          if (isStatsMode()) {
+            {
+              AutoLock statsLock(mStatsLock);
+              for (auto iter = mMonitorInfo.mHeavyHitterFields.begin(); iter != mMonitorInfo.mHeavyHitterFields.end(); ++iter) {
+                mHeavyHitters[(*iter)].mTop = mMonitorInfo.mHeavyHittersTop;
+              }
+            }
+            mStatsLastOutput = std::chrono::steady_clock::now();
+            mStatsTimer = ITimer::create(mThisWeak.lock(), mMonitorInfo.mStatsInterval);
+          }
+          if (isLatencyMode()) {
+            mLatencyTimer = ITimer::create(mThisWeak.lock(), mMonitorInfo.mLatencyInterval);
+          }
+
+          // output written to files is flushed periodically so it can be
+          // tailed even when events arrive slowly
+          if ((mOutputWriter) ||
+              (ICommandLineTypes::OutputFormat_CSV == mMonitorInfo.mOutputFormat)) {
+            mFlushTimer = ITimer::create(mThisWeak.lock(), Milliseconds(ZS_EVENTING_TOOL_BUFFERED_WRITER_FLUSH_INTERVAL_IN_MILLISECONDS));
+          }
+
+          // events held back to merge the remotes are released even when no
+          // more arrive
+          if ((ICommandLineTypes::OutputFormat_None != mMonitorInfo.mOutputFormat) &&
+              (hasMultipleSources())) {
+            mMergeTimer = ITimer::create(mThisWeak.lock(), Milliseconds(ZS_EVENTING_TOOL_MONITOR_MERGE_WINDOW_IN_MILLISECONDS));
+          }
+          
+          for (auto iter = mProviders.begin(); iter != mProviders.end(); ++iter) {
             auto provider = (*iter).second;
             for (auto iterSubsystem = provider->mSubsystems.begin(); iterSubsystem != provider->mSubsystems.end(); ++iterSubsystem) {
               auto subsystem = (*iterSubsystem).second;
-              mRemote->setRemoteLevel(subsystem->mName, subsystem->mLevel);
+              for (auto iterRemote = mRemotes.begin(); iterRemote != mRemotes.end(); ++iterRemote) {
+                (*iterRemote)->setRemoteLevel(subsystem->mName, subsystem->mLevel);
+              }
             }
           }
         }
@@ -0,0 +1,602 @@
+/*
+
+Copyright (c) 2016, Robin Raymond
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are those
+of the authors and should not be interpreted as representing official policies,
+either expressed or implied, of the FreeBSD Project.
+
+*/
+
+
+
+#include <zsLib/eventing/tool/internal/zsLib_eventing_tool_SchemaCache.h>
+#include <zsLib/eventing/tool/internal/zsLib_eventing_tool_Helper.h>
+
+#include <zsLib/eventing/IHasher.h>
+#include <zsLib/eventing/IHelper.h>
+
+#include <zsLib/Numeric.h>
+
+#include <errno.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif //ndef _WIN32
+
+namespace zsLib { namespace eventing { namespace tool { ZS_DECLARE_SUBSYSTEM(zsLib_eventing_tool) } } }
+
+namespace zsLib
+{
+  namespace eventing
+  {
+    namespace tool
+    {
+      namespace internal
+      {
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark (helpers)
+        #pragma mark
+
+        //---------------------------------------------------------------------
+        // reads values written by Helper::appendLittleEndian and
+        // Helper::appendString and throws if the buffer is too short
+        class SchemaReader
+        {
+        public:
+          SchemaReader(
+                       const BYTE *buffer,
+                       size_t size
+                       ) : mPos(buffer), mEnd(buffer + size) {}
+
+          bool isEnd() const {return mPos >= mEnd;}
+
+          uint64_t readLittleEndian(size_t size) throw (InvalidContent)
+          {
+            if (static_cast<size_t>(mEnd - mPos) < size) {
+              ZS_THROW_CUSTOM(InvalidContent, "Compiled schema is truncated");
+            }
+            uint64_t value {};
+            for (size_t index = 0; index < size; ++index) {
+              value |= (static_cast<uint64_t>(mPos[index]) << (8 * index));
+            }
+            mPos += size;
+            return value;
+          }
+
+          const BYTE *readBytes(size_t size) throw (InvalidContent)
+          {
+            if (static_cast<size_t>(mEnd - mPos) < size) {
+              ZS_THROW_CUSTOM(InvalidContent, "Compiled schema is truncated");
+            }
+            const BYTE *result = mPos;
+            mPos += size;
+            return result;
+          }
+
+          String readString() throw (InvalidContent)
+          {
+            size_t length = static_cast<size_t>(readLittleEndian(sizeof(uint32_t)));
+            const BYTE *value = readBytes(length);
+            return String(std::string(reinterpret_cast<const char *>(value), length));
+          }
+
+        protected:
+          const BYTE *mPos {};
+          const BYTE *mEnd {};
+        };
+
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark SchemaCache
+        #pragma mark
+
+        //---------------------------------------------------------------------
+        SchemaCache::SchemaCache(
+                                 const make_private &,
+                                 const String &fileName
+                                 ) :
+          mFileName(fileName)
+        {
+        }
+
+        //---------------------------------------------------------------------
+        SchemaCache::~SchemaCache()
+        {
+          unmapFile();
+        }
+
+        //---------------------------------------------------------------------
+        SchemaCachePtr SchemaCache::create(const String &fileName)
+        {
+          auto pThis(make_shared<SchemaCache>(make_private{}, fileName));
+
+          try {
+            pThis->mapFile();
+            pThis->readEntries();
+          } catch (const StdError &) {
+            pThis->unmapFile();
+          } catch (const InvalidContent &) {
+            pThis->mEntries.clear();
+            pThis->mSources.clear();
+            pThis->unmapFile();
+          }
+          return pThis;
+        }
+
+        //---------------------------------------------------------------------
+        SchemaCache::ProviderPtr SchemaCache::getProvider(const String &sourceHash) throw (InvalidContent)
+        {
+          auto found = mSources.find(sourceHash);
+          if (found == mSources.end()) return ProviderPtr();
+
+          auto foundEntry = mEntries.find((*found).second);
+          if (foundEntry == mEntries.end()) return ProviderPtr();
+
+          auto &entry = (*foundEntry).second;
+          if (entry.mSourceHash != sourceHash) return ProviderPtr();
+
+          size_t size {};
+          const BYTE *schema = getSchema(entry, size);
+
+          auto provider = decompile(schema, size);
+          if (provider->mUniqueHash != (*found).second) return ProviderPtr();
+          return provider;
+        }
+
+        //---------------------------------------------------------------------
+        SchemaCache::ProviderPtr SchemaCache::getProviderByHash(const String &providerUniqueHash) throw (InvalidContent)
+        {
+          auto found = mEntries.find(providerUniqueHash);
+          if (found == mEntries.end()) return ProviderPtr();
+
+          size_t size {};
+          const BYTE *schema = getSchema((*found).second, size);
+
+          auto provider = decompile(schema, size);
+          if (provider->mUniqueHash != providerUniqueHash) return ProviderPtr();
+          return provider;
+        }
+
+        //---------------------------------------------------------------------
+        void SchemaCache::setProvider(
+                                      const String &sourceHash,
+                                      ProviderPtr provider
+                                      )
+        {
+          if (!provider) return;
+          if (provider->mUniqueHash.isEmpty()) return;
+
+          // a jman file recompiled with the same unique hash replaces the
+          // stale schema
+          auto found = mEntries.find(provider->mUniqueHash);
+          if (found != mEntries.end()) {
+            mSources.erase((*found).second.mSourceHash);
+          }
+
+          Entry entry;
+          entry.mSourceHash = sourceHash;
+          entry.mCompiled = compile(*provider);
+
+          mEntries[provider->mUniqueHash] = entry;
+          mSources[sourceHash] = provider->mUniqueHash;
+          mDirty = true;
+        }
+
+        //---------------------------------------------------------------------
+        void SchemaCache::save() throw (Failure)
+        {
+          String output(ZS_EVENTING_TOOL_SCHEMA_CACHE_MAGIC);
+          Helper::appendLittleEndian(output, ZS_EVENTING_TOOL_SCHEMA_CACHE_VERSION, sizeof(uint32_t));
+          Helper::appendLittleEndian(output, mEntries.size(), sizeof(uint32_t));
+
+          for (auto iter = mEntries.begin(); iter != mEntries.end(); ++iter) {
+            auto &entry = (*iter).second;
+
+            size_t size {};
+            const BYTE *schema = getSchema(entry, size);
+
+            Helper::appendString(output, (*iter).first);
+            Helper::appendString(output, entry.mSourceHash);
+            Helper::appendLittleEndian(output, size, sizeof(uint32_t));
+            output.append(reinterpret_cast<const char *>(schema), size);
+          }
+
+          // the mapped schemas were copied above and the file is about to be
+          // replaced
+          for (auto iter = mEntries.begin(); iter != mEntries.end(); ++iter) {
+            auto &entry = (*iter).second;
+            if (entry.mCompiled.hasData()) continue;
+            entry.mCompiled = String(std::string(reinterpret_cast<const char *>(entry.mSchema), entry.mSchemaSize));
+            entry.mSchema = NULL;
+            entry.mSchemaSize = 0;
+          }
+          unmapFile();
+
+          SecureByteBlock buffer(reinterpret_cast<const BYTE *>(output.c_str()), output.length());
+          try {
+            IHelper::saveFile(mFileName, buffer);
+          } catch (const StdError &e) {
+            ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_SYSTEM_ERROR, String("Failed to save schema cache: ") + mFileName + ", error=" + string(e.result()) + ", reason=" + e.message());
+          }
+          mDirty = false;
+        }
+
+        //---------------------------------------------------------------------
+        String SchemaCache::toSourceHash(const SecureByteBlock &jmanRaw)
+        {
+          return IHasher::hashAsString(jmanRaw, IHasher::sha256());
+        }
+
+        //---------------------------------------------------------------------
+        String SchemaCache::compile(const IEventingTypes::Provider &provider)
+        {
+          String output;
+          Helper::appendLittleEndian(output, ZS_EVENTING_TOOL_SCHEMA_VERSION, sizeof(uint32_t));
+          Helper::appendString(output, string(provider.mID));
+          Helper::appendString(output, provider.mName);
+          Helper::appendString(output, provider.mUniqueHash);
+
+          Helper::appendLittleEndian(output, provider.mSubsystems.size(), sizeof(uint32_t));
+          for (auto iter = provider.mSubsystems.begin(); iter != provider.mSubsystems.end(); ++iter) {
+            auto subsystem = (*iter).second;
+            Helper::appendString(output, subsystem->mName);
+            Helper::appendLittleEndian(output, static_cast<uint64_t>(subsystem->mLevel), sizeof(uint8_t));
+          }
+
+          Helper::appendLittleEndian(output, provider.mEvents.size(), sizeof(uint32_t));
+          for (auto iter = provider.mEvents.begin(); iter != provider.mEvents.end(); ++iter) {
+            auto event = (*iter).second;
+
+            Helper::appendLittleEndian(output, event->mValue, sizeof(uint32_t));
+            Helper::appendString(output, event->mName);
+            Helper::appendString(output, event->mSubsystem);
+            Helper::appendLittleEndian(output, static_cast<uint64_t>(event->mSeverity), sizeof(uint8_t));
+            Helper::appendLittleEndian(output, static_cast<uint64_t>(event->mLevel), sizeof(uint8_t));
+
+            Helper::appendString(output, event->mChannel ? event->mChannel->mID : String());
+            Helper::appendLittleEndian(output, event->mChannel ? event->mChannel->mValue : 0, sizeof(uint32_t));
+            Helper::appendString(output, event->mTask ? event->mTask->mName : String());
+            Helper::appendLittleEndian(output, event->mTask ? event->mTask->mValue : 0, sizeof(uint32_t));
+            Helper::appendString(output, event->mOpCode ? event->mOpCode->mName : String());
+            Helper::appendLittleEndian(output, event->mOpCode ? event->mOpCode->mValue : 0, sizeof(uint32_t));
+
+            if (!event->mDataTemplate) {
+              Helper::appendString(output, String());
+              Helper::appendLittleEndian(output, 0, sizeof(uint32_t));
+              continue;
+            }
+
+            Helper::appendString(output, event->mDataTemplate->uniqueID());
+            Helper::appendLittleEndian(output, event->mDataTemplate->mDataTypes.size(), sizeof(uint32_t));
+            for (auto iterType = event->mDataTemplate->mDataTypes.begin(); iterType != event->mDataTemplate->mDataTypes.end(); ++iterType) {
+              auto dataType = (*iterType);
+              Helper::appendLittleEndian(output, static_cast<uint64_t>(dataType->mType), sizeof(uint8_t));
+              Helper::appendString(output, dataType->mValueName);
+            }
+          }
+
+          return output;
+        }
+
+        //---------------------------------------------------------------------
+        SchemaCache::ProviderPtr SchemaCache::decompile(
+                                                        const BYTE *schema,
+                                                        size_t size
+                                                        ) throw (InvalidContent)
+        {
+          SchemaReader reader(schema, size);
+
+          if (ZS_EVENTING_TOOL_SCHEMA_VERSION != reader.readLittleEndian(sizeof(uint32_t))) {
+            ZS_THROW_CUSTOM(InvalidContent, "Compiled schema version is not supported");
+          }
+
+          auto provider = Provider::create();
+
+          String providerID = reader.readString();
+          try {
+            provider->mID = Numeric<UUID>(providerID);
+          } catch (const Numeric<UUID>::ValueOutOfRange &) {
+            ZS_THROW_CUSTOM(InvalidContent, String("Compiled schema provider ID is not valid: ") + providerID);
+          }
+          provider->mName = reader.readString();
+          provider->mUniqueHash = reader.readString();
+
+          size_t totalSubsystems = static_cast<size_t>(reader.readLittleEndian(sizeof(uint32_t)));
+          for (size_t index = 0; index < totalSubsystems; ++index) {
+            auto subsystem = IEventingTypes::Subsystem::create();
+            subsystem->mName = reader.readString();
+
+            auto level = reader.readLittleEndian(sizeof(uint8_t));
+            if (level > static_cast<uint64_t>(Log::Level_Last)) {
+              ZS_THROW_CUSTOM(InvalidContent, String("Compiled schema subsystem level is not valid: ") + subsystem->mName);
+            }
+            subsystem->mLevel = static_cast<Log::Level>(level);
+            provider->mSubsystems[subsystem->mName] = subsystem;
+          }
+
+          size_t totalEvents = static_cast<size_t>(reader.readLittleEndian(sizeof(uint32_t)));
+          for (size_t index = 0; index < totalEvents; ++index) {
+            auto event = IEventingTypes::Event::create();
+
+            event->mValue = static_cast<size_t>(reader.readLittleEndian(sizeof(uint32_t)));
+            event->mName = reader.readString();
+            event->mSubsystem = reader.readString();
+
+            auto severity = reader.readLittleEndian(sizeof(uint8_t));
+            auto level = reader.readLittleEndian(sizeof(uint8_t));
+            if ((severity > static_cast<uint64_t>(Log::Severity_Last)) ||
+                (level > static_cast<uint64_t>(Log::Level_Last))) {
+              ZS_THROW_CUSTOM(InvalidContent, String("Compiled schema event severity or level is not valid: ") + event->mName);
+            }
+            event->mSeverity = static_cast<Log::Severity>(severity);
+            event->mLevel = static_cast<Log::Level>(level);
+
+            // channels, tasks, opcodes and data templates are shared by the
+            // events that use them (as when parsed from a jman file)
+            String channelID = reader.readString();
+            size_t channelValue = static_cast<size_t>(reader.readLittleEndian(sizeof(uint32_t)));
+            if (channelID.hasData()) {
+              auto found = provider->mChannels.find(channelID);
+              if (found == provider->mChannels.end()) {
+                auto channel = IEventingTypes::Channel::create();
+                channel->mID = channelID;
+                channel->mValue = channelValue;
+                provider->mChannels[channelID] = channel;
+                event->mChannel = channel;
+              } else {
+                event->mChannel = (*found).second;
+              }
+            }
+
+            String taskName = reader.readString();
+            size_t taskValue = static_cast<size_t>(reader.readLittleEndian(sizeof(uint32_t)));
+            if (taskName.hasData()) {
+              auto found = provider->mTasks.find(taskName);
+              if (found == provider->mTasks.end()) {
+                auto task = IEventingTypes::Task::create();
+                task->mName = taskName;
+                task->mValue = taskValue;
+                provider->mTasks[taskName] = task;
+                event->mTask = task;
+              } else {
+                event->mTask = (*found).second;
+              }
+            }
+
+            String opCodeName = reader.readString();
+            size_t opCodeValue = static_cast<size_t>(reader.readLittleEndian(sizeof(uint32_t)));
+            if (opCodeName.hasData()) {
+              auto &opCodes = (event->mTask ? event->mTask->mOpCodes : provider->mOpCodes);
+              auto found = opCodes.find(opCodeName);
+              if (found == opCodes.end()) {
+                auto opCode = IEventingTypes::OpCode::create();
+                opCode->mName = opCodeName;
+                opCode->mTask = event->mTask;
+                opCode->mValue = opCodeValue;
+                opCodes[opCodeName] = opCode;
+                event->mOpCode = opCode;
+              } else {
+                event->mOpCode = (*found).second;
+              }
+            }
+
+            String dataTemplateID = reader.readString();
+            size_t totalDataTypes = static_cast<size_t>(reader.readLittleEndian(sizeof(uint32_t)));
+
+            IEventingTypes::DataTemplatePtr dataTemplate;
+            if (dataTemplateID.hasData()) {
+              auto found = provider->mDataTemplates.find(dataTemplateID);
+              if (found == provider->mDataTemplates.end()) {
+                dataTemplate = IEventingTypes::DataTemplate::create();
+                dataTemplate->mID = dataTemplateID;
+                provider->mDataTemplates[dataTemplateID] = dataTemplate;
+              } else {
+                dataTemplate = (*found).second;
+              }
+              event->mDataTemplate = dataTemplate;
+            }
+
+            bool fillTemplate = ((dataTemplate) && (dataTemplate->mDataTypes.size() < 1));
+
+            for (size_t indexType = 0; indexType < totalDataTypes; ++indexType) {
+              auto type = reader.readLittleEndian(sizeof(uint8_t));
+              if (type > static_cast<uint64_t>(IEventingTypes::PredefinedTypedef_Last)) {
+                ZS_THROW_CUSTOM(InvalidContent, String("Compiled schema data type is not valid: ") + event->mName);
+              }
+
+              auto dataType = IEventingTypes::DataType::create();
+              dataType->mType = static_cast<IEventingTypes::PredefinedTypedefs>(type);
+              dataType->mValueName = reader.readString();
+
+              if (fillTemplate) dataTemplate->mDataTypes.push_back(dataType);
+            }
+
+            provider->mEvents[event->mName] = event;
+          }
+
+          if (!reader.isEnd()) {
+            ZS_THROW_CUSTOM(InvalidContent, "Compiled schema has unexpected trailing data");
+          }
+
+          return provider;
+        }
+
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark SchemaCache => (internal)
+        #pragma mark
+
+        //---------------------------------------------------------------------
+        void SchemaCache::mapFile() throw (StdError)
+        {
+          String pathStr(mFileName);
+
+#ifdef _WIN32
+          pathStr.replaceAll("/", "\\");
+
+          mFile = CreateFileA(pathStr, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+          if (INVALID_HANDLE_VALUE == mFile) {
+            ZS_THROW_CUSTOM_PROPERTIES_1(StdError, static_cast<int>(GetLastError()), String("Failed to open schema cache: ") + pathStr);
+          }
+
+          LARGE_INTEGER fileSize {};
+          if (!GetFileSizeEx(mFile, &fileSize)) {
+            auto error = static_cast<int>(GetLastError());
+            unmapFile();
+            ZS_THROW_CUSTOM_PROPERTIES_1(StdError, error, String("Failed to size schema cache: ") + pathStr);
+          }
+          mMappedSize = static_cast<size_t>(fileSize.QuadPart);
+          if (0 == mMappedSize) return;
+
+          mFileMapping = CreateFileMappingA(mFile, NULL, PAGE_READONLY, 0, 0, NULL);
+          if (NULL == mFileMapping) {
+            auto error = static_cast<int>(GetLastError());
+            unmapFile();
+            ZS_THROW_CUSTOM_PROPERTIES_1(StdError, error, String("Failed to map schema cache: ") + pathStr);
+          }
+
+          mMapped = reinterpret_cast<const BYTE *>(MapViewOfFile(mFileMapping, FILE_MAP_READ, 0, 0, mMappedSize));
+          if (NULL == mMapped) {
+            auto error = static_cast<int>(GetLastError());
+            unmapFile();
+            ZS_THROW_CUSTOM_PROPERTIES_1(StdError, error, String("Failed to map schema cache: ") + pathStr);
+          }
+#else
+          mFile = ::open(pathStr, O_RDONLY);
+          if (mFile < 0) {
+            ZS_THROW_CUSTOM_PROPERTIES_1(StdError, errno, String("Failed to open schema cache: ") + pathStr);
+          }
+
+          struct stat fileStat {};
+          if (0 != fstat(mFile, &fileStat)) {
+            auto error = errno;
+            unmapFile();
+            ZS_THROW_CUSTOM_PROPERTIES_1(StdError, error, String("Failed to size schema cache: ") + pathStr);
+          }
+          mMappedSize = static_cast<size_t>(fileStat.st_size);
+          if (0 == mMappedSize) return;
+
+          void *mapped = mmap(NULL, mMappedSize, PROT_READ, MAP_PRIVATE, mFile, 0);
+          if (MAP_FAILED == mapped) {
+            auto error = errno;
+            unmapFile();
+            ZS_THROW_CUSTOM_PROPERTIES_1(StdError, error, String("Failed to map schema cache: ") + pathStr);
+          }
+          mMapped = reinterpret_cast<const BYTE *>(mapped);
+#endif //_WIN32
+        }
+
+        //---------------------------------------------------------------------
+        void SchemaCache::unmapFile()
+        {
+#ifdef _WIN32
+          if (mMapped) {
+            UnmapViewOfFile(mMapped);
+            mMapped = NULL;
+          }
+          if (NULL != mFileMapping) {
+            CloseHandle(mFileMapping);
+            mFileMapping = NULL;
+          }
+          if (INVALID_HANDLE_VALUE != mFile) {
+            CloseHandle(mFile);
+            mFile = INVALID_HANDLE_VALUE;
+          }
+#else
+          if (mMapped) {
+            munmap(const_cast<BYTE *>(mMapped), mMappedSize);
+            mMapped = NULL;
+          }
+          if (mFile >= 0) {
+            ::close(mFile);
+            mFile = -1;
+          }
+#endif //_WIN32
+          mMappedSize = 0;
+        }
+
+        //---------------------------------------------------------------------
+        void SchemaCache::readEntries() throw (InvalidContent)
+        {
+          if (!mMapped) return;
+
+          // only the entry headers are read; a schema is decompiled straight
+          // from the mapped file when its provider is needed
+          SchemaReader reader(mMapped, mMappedSize);
+
+          const BYTE *magic = reader.readBytes(strlen(ZS_EVENTING_TOOL_SCHEMA_CACHE_MAGIC));
+          if (0 != memcmp(magic, ZS_EVENTING_TOOL_SCHEMA_CACHE_MAGIC, strlen(ZS_EVENTING_TOOL_SCHEMA_CACHE_MAGIC))) {
+            ZS_THROW_CUSTOM(InvalidContent, "Schema cache magic is not valid");
+          }
+          if (ZS_EVENTING_TOOL_SCHEMA_CACHE_VERSION != reader.readLittleEndian(sizeof(uint32_t))) {
+            ZS_THROW_CUSTOM(InvalidContent, "Schema cache version is not supported");
+          }
+
+          size_t totalEntries = static_cast<size_t>(reader.readLittleEndian(sizeof(uint32_t)));
+          for (size_t index = 0; index < totalEntries; ++index) {
+            String uniqueHash = reader.readString();
+
+            Entry entry;
+            entry.mSourceHash = reader.readString();
+            entry.mSchemaSize = static_cast<size_t>(reader.readLittleEndian(sizeof(uint32_t)));
+            entry.mSchema = reader.readBytes(entry.mSchemaSize);
+
+            mEntries[uniqueHash] = entry;
+            mSources[entry.mSourceHash] = uniqueHash;
+          }
+        }
+
+        //---------------------------------------------------------------------
+        const BYTE *SchemaCache::getSchema(
+                                           const Entry &entry,
+                                           size_t &outSize
+                                           )
+        {
+          if (entry.mCompiled.hasData()) {
+            outSize = entry.mCompiled.length();
+            return reinterpret_cast<const BYTE *>(entry.mCompiled.c_str());
+          }
+          outSize = entry.mSchemaSize;
+          return entry.mSchema;
+        }
+
+      } // namespace internal
+    } // namespace tool
+  } // namespace eventing
+} // namespace zsLib
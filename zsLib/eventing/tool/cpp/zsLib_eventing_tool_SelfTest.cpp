@@ -0,0 +1,546 @@
+/*
+
+Copyright (c) 2016, Robin Raymond
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are those
+of the authors and should not be interpreted as representing official policies,
+either expressed or implied, of the FreeBSD Project.
+
+*/
+
+
+#include <zsLib/eventing/tool/internal/zsLib_eventing_tool_SelfTest.h>
+
+#include <zsLib/eventing/tool/OutputStream.h>
+#include <zsLib/eventing/IFlightRecorder.h>
+#include <zsLib/eventing/IHelper.h>
+#include <zsLib/eventing/ITraceFile.h>
+
+#include <zsLib/eventing/internal/zsLib_eventing_BlockCodec.h>
+#include <zsLib/eventing/internal/zsLib_eventing_FlightRecorder.h>
+
+#include <chrono>
+
+namespace zsLib { namespace eventing { namespace tool { ZS_DECLARE_SUBSYSTEM(zsLib_eventing_tool) } } }
+
+namespace zsLib
+{
+  namespace eventing
+  {
+    namespace tool
+    {
+      ZS_DECLARE_USING_PTR(zsLib::eventing, IHelper);
+
+      typedef eventing::internal::BlockCodec UseBlockCodec;
+
+      namespace internal
+      {
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark (helpers)
+        #pragma mark
+
+        // values the monitor commonly outputs, including every character
+        // the JSON encoding escapes
+        static const SelfTest::GoldenValue gCallValues[] =
+        {
+          {"_subsystemName", "zsLib_eventing", false},
+          {"_function", "void zsLib::eventing::internal::RemoteEventing::step()", false},
+          {"_line", "1130", true},
+          {"url", "https://example.com/calls/42?from=\"alice\"&to=bob", false},
+          {"path", "C:\\Users\\trace\\call.log", false},
+          {"message", "line one\nline two\ttabbed\r\b\f", false},
+          {"control", "\x01\x1f\x7f", false},
+          {"unicode", "caf\xc3\xa9 \xe2\x82\xac", false},
+          {"empty", "", false},
+          {"durationMs", "512", true},
+          {"delta", "-17", true},
+          {"ratio", "0.125", true},
+        };
+
+        static const SelfTest::GoldenValue gNoSchemaValues[] =
+        {
+          {"_subsystemName", "zsLib", false},
+          {"_function", "operator()", false},
+          {"_line", "77", true},
+          {"0", "18446744073709551615", true},
+          {"1", "</script>", false},
+          {"2", "AAECAwQFBgcICQoLDA0ODw==", false},
+        };
+
+        static const SelfTest::GoldenEvent gGoldenEvents[] =
+        {
+          {"Informational", "Debug", true, "CallStart", "call", "Call", "Start", gCallValues, sizeof(gCallValues) / sizeof(gCallValues[0])},
+          {"Warning", "Basic", true, "Call \"Stop\"/end", NULL, "Call", NULL, gCallValues, sizeof(gCallValues) / sizeof(gCallValues[0])},
+          {"Error", "Insane", false, "1001", "16", "3", "2", gNoSchemaValues, sizeof(gNoSchemaValues) / sizeof(gNoSchemaValues[0])},
+        };
+
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark SelfTest
+        #pragma mark
+
+        //---------------------------------------------------------------------
+        void SelfTest::process(const TraceInfo &traceInfo) throw (Failure)
+        {
+          if (traceInfo.mSelfTest) {
+            testBlockCodec();
+            testJSONWriter();
+            testFlightRecorderConvert();
+            tool::output() << "[Info] Self test passed\n";
+          }
+          if (traceInfo.mBenchmark) {
+            benchmarkJSONWriter();
+          }
+        }
+
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark SelfTest => (internal)
+        #pragma mark
+
+        //---------------------------------------------------------------------
+        void SelfTest::testBlockCodec() throw (Failure)
+        {
+          Buffer none;
+
+          checkBlockCodecRoundTrip("block codec: empty input", none, none);
+          checkBlockCodecRoundTrip("block codec: empty input after a dictionary", randomBytes(256, 1), none);
+
+          {
+            Buffer data = randomBytes(64*1024, 2);
+            size_t compressedSize {};
+            checkBlockCodecRoundTrip("block codec: incompressible input", none, data, &compressedSize);
+            if (compressedSize > UseBlockCodec::getMaxCompressedSize(data.size())) {
+              ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_INTERNAL_ERROR, String("Self test failed: block codec: incompressible input exceeds the worst case size, size=") + string(compressedSize));
+            }
+          }
+
+          {
+            // overlapping matches repeat the most recent bytes
+            Buffer data(4096, 'a');
+            const char *text = "0123456789";
+            data.insert(data.end(), text, text + strlen(text));
+            checkBlockCodecRoundTrip("block codec: repeating input", none, data);
+          }
+
+          {
+            Buffer dictionary = randomBytes(4096, 3);
+            Buffer data(dictionary.begin() + 1000, dictionary.begin() + 1500);
+            Buffer noise = randomBytes(100, 4);
+            data.insert(data.end(), noise.begin(), noise.end());
+            data.insert(data.end(), dictionary.begin() + 3000, dictionary.end());
+
+            size_t compressedSize {};
+            checkBlockCodecRoundTrip("block codec: matches into the dictionary", dictionary, data, &compressedSize);
+            if (compressedSize >= noise.size() * 2) {
+              ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_INTERNAL_ERROR, String("Self test failed: block codec: matches into the dictionary were not found, size=") + string(compressedSize));
+            }
+          }
+
+          {
+            // the only earlier occurrence of the data is at the start of a
+            // dictionary large enough to need a four byte offset
+            Buffer pattern = randomBytes(32, 5);
+            Buffer dictionary(pattern);
+            dictionary.resize(ZS_EVENTING_TOOL_SELF_TEST_LARGE_DICTIONARY_SIZE);
+
+            Buffer data(pattern);
+            Buffer noise = randomBytes(16, 6);
+            data.insert(data.end(), noise.begin(), noise.end());
+
+            size_t compressedSize {};
+            checkBlockCodecRoundTrip("block codec: four byte offset", dictionary, data, &compressedSize);
+            if (compressedSize >= data.size()) {
+              ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_INTERNAL_ERROR, String("Self test failed: block codec: four byte offset match was not found, size=") + string(compressedSize));
+            }
+          }
+
+          {
+            // a 4 byte match at offset 16 with the offset written in the
+            // longest form the decoder accepts (five bytes) and one longer
+            const char *text = "ABCDEFGHIJKLMNOP";
+            Buffer dictionary(text, text + strlen(text));
+            Buffer expected(text, text + 4);
+
+            const BYTE longestOffset[] = {0x00, 0x90, 0x80, 0x80, 0x80, 0x00};
+            const BYTE tooLongOffset[] = {0x00, 0x90, 0x80, 0x80, 0x80, 0x80, 0x00};
+            const BYTE offsetBeyondWindow[] = {0x00, 0x11};
+
+            checkBlockCodecDecode("block codec: maximum offset varint", dictionary, Buffer(longestOffset, longestOffset + sizeof(longestOffset)), expected, true);
+            checkBlockCodecDecode("block codec: offset varint too long", dictionary, Buffer(tooLongOffset, tooLongOffset + sizeof(tooLongOffset)), expected, false);
+            checkBlockCodecDecode("block codec: offset beyond the window", dictionary, Buffer(offsetBeyondWindow, offsetBeyondWindow + sizeof(offsetBeyondWindow)), expected, false);
+          }
+        }
+
+        //---------------------------------------------------------------------
+        void SelfTest::testJSONWriter() throw (Failure)
+        {
+          static const size_t skipStartLength = strlen("{\"event\":");
+          static const size_t skipEndLength = strlen("}");
+
+          auto formatters = prepareGoldenFormatters();
+
+          JSONWriter writer;
+
+          for (size_t index = 0; index < sizeof(gGoldenEvents) / sizeof(gGoldenEvents[0]); ++index) {
+            auto &event = gGoldenEvents[index];
+
+            // the element tree path wraps the event in an "event" object
+            String expected = writeElementEvent(event);
+            expected = expected.substr(skipStartLength, expected.length() - skipStartLength - skipEndLength);
+
+            writer.clear();
+            writeStreamedEvent(writer, event, formatters[index]);
+            String streamed(std::string(writer.data(), writer.size()));
+
+            if (expected != streamed) {
+              ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_INTERNAL_ERROR, String("Self test failed: json writer: event ") + string(index) + " differs from the element tree output, expected=" + expected + ", streamed=" + streamed);
+            }
+
+            tool::output() << "[Info] Passed: json writer: event " << string(index) << " matches the element tree output\n";
+          }
+        }
+
+        //---------------------------------------------------------------------
+        void SelfTest::testFlightRecorderConvert() throw (Failure)
+        {
+          const size_t dataSize = ZS_EVENTING_TOOL_SELF_TEST_RING_DATA_SIZE;
+          const size_t headerSize = ZSLIB_EVENTING_FLIGHT_RECORDER_HEADER_SIZE;
+          const size_t recordHeaderSize = (sizeof(uint32_t)*2) + sizeof(uint64_t);
+
+          // 12 records of 60 bytes thus only the bytes from position 464
+          // onward survive the 256 byte ring
+          Buffer stream;
+          std::vector<size_t> positions;
+          StringVector payloads;
+          for (size_t index = 0; index < 12; ++index) {
+            String payload = String("{\"notify\":{\"type\":\"subsystem\",\"name\":\"s") + (index < 10 ? "0" : "") + string(index) + "\"}}";
+
+            BYTE header[recordHeaderSize] {};
+            IHelper::setBE32(&(header[0]), static_cast<uint32_t>(recordHeaderSize - sizeof(uint32_t) + payload.length()));
+            IHelper::setBE32(&(header[sizeof(uint32_t)]), static_cast<uint32_t>(ITraceFileTypes::RecordType_Notify));
+            IHelper::setBE64(&(header[sizeof(uint32_t)*2]), static_cast<uint64_t>(1000 + index));
+
+            positions.push_back(stream.size());
+            payloads.push_back(payload);
+            stream.insert(stream.end(), header, header + sizeof(header));
+            stream.insert(stream.end(), payload.c_str(), payload.c_str() + payload.length());
+          }
+
+          Buffer ringFile(headerSize + dataSize);
+          memcpy(&(ringFile[0]), ZSLIB_EVENTING_FLIGHT_RECORDER_MAGIC, strlen(ZSLIB_EVENTING_FLIGHT_RECORDER_MAGIC));
+          IHelper::setBE32(&(ringFile[4]), ZSLIB_EVENTING_FLIGHT_RECORDER_VERSION);
+          IHelper::setBE32(&(ringFile[8]), static_cast<uint32_t>(headerSize));
+          IHelper::setBE64(&(ringFile[16]), static_cast<uint64_t>(dataSize));
+          IHelper::setBE64(&(ringFile[24]), static_cast<uint64_t>(stream.size()));
+
+          // the stream start and the checkpoint before record 8 were
+          // overwritten when the ring wrapped
+          const size_t checkpoints[ZSLIB_EVENTING_FLIGHT_RECORDER_TOTAL_CHECKPOINTS] = {0, 3, 8, 10};
+          for (size_t index = 0; index < ZSLIB_EVENTING_FLIGHT_RECORDER_TOTAL_CHECKPOINTS; ++index) {
+            IHelper::setBE64(&(ringFile[32 + (sizeof(uint64_t) * index)]), static_cast<uint64_t>(positions[checkpoints[index]]));
+          }
+
+          for (size_t position = stream.size() - dataSize; position < stream.size(); ++position) {
+            ringFile[headerSize + (position % dataSize)] = stream[position];
+          }
+
+          checkFlightRecorderConvert("flight recorder: oldest surviving checkpoint", ringFile, StringVector(payloads.begin() + 8, payloads.end()), true);
+
+          {
+            // a writer that terminated abnormally tore the oldest record
+            Buffer tornFile(ringFile);
+            memset(&(tornFile[headerSize + (positions[8] % dataSize)]), 0xFF, sizeof(uint32_t));
+            checkFlightRecorderConvert("flight recorder: torn oldest checkpoint", tornFile, StringVector(payloads.begin() + 10, payloads.end()), true);
+          }
+
+          {
+            Buffer notRingFile(ringFile);
+            notRingFile[0] = 'X';
+            checkFlightRecorderConvert("flight recorder: magic", notRingFile, StringVector(), false);
+          }
+        }
+
+        //---------------------------------------------------------------------
+        void SelfTest::benchmarkJSONWriter()
+        {
+          const size_t totalEvents = sizeof(gGoldenEvents) / sizeof(gGoldenEvents[0]);
+
+          auto formatters = prepareGoldenFormatters();
+
+          // the output sizes are summed so neither path can be optimized away
+          size_t elementBytes {};
+          auto elementStart = std::chrono::steady_clock::now();
+          for (size_t round = 0; round < ZS_EVENTING_TOOL_SELF_TEST_BENCHMARK_ROUNDS; ++round) {
+            for (size_t index = 0; index < totalEvents; ++index) {
+              elementBytes += writeElementEvent(gGoldenEvents[index]).length();
+            }
+          }
+          auto elementTime = std::chrono::duration_cast<Nanoseconds>(std::chrono::steady_clock::now() - elementStart);
+
+          JSONWriter writer;
+
+          size_t streamedBytes {};
+          auto streamedStart = std::chrono::steady_clock::now();
+          for (size_t round = 0; round < ZS_EVENTING_TOOL_SELF_TEST_BENCHMARK_ROUNDS; ++round) {
+            for (size_t index = 0; index < totalEvents; ++index) {
+              writer.clear();
+              writeStreamedEvent(writer, gGoldenEvents[index], formatters[index]);
+              streamedBytes += writer.size();
+            }
+          }
+          auto streamedTime = std::chrono::duration_cast<Nanoseconds>(std::chrono::steady_clock::now() - streamedStart);
+
+          size_t totalFormatted = ZS_EVENTING_TOOL_SELF_TEST_BENCHMARK_ROUNDS * totalEvents;
+          double elementPerEvent = static_cast<double>(elementTime.count()) / static_cast<double>(totalFormatted);
+          double streamedPerEvent = static_cast<double>(streamedTime.count()) / static_cast<double>(totalFormatted);
+
+          tool::output() << "[Info] Benchmark: json output of " << string(totalFormatted) << " events\n";
+          tool::output() << "[Info] Element tree (ns/event): " << string(elementPerEvent) << " (" << string(elementBytes) << " bytes)\n";
+          tool::output() << "[Info] Streamed (ns/event): " << string(streamedPerEvent) << " (" << string(streamedBytes) << " bytes)\n";
+          if (streamedPerEvent > 0.0) {
+            tool::output() << "[Info] Speedup: " << string(elementPerEvent / streamedPerEvent) << "x\n";
+          }
+        }
+
+        //---------------------------------------------------------------------
+        SelfTest::GoldenFormatterList SelfTest::prepareGoldenFormatters()
+        {
+          GoldenFormatterList result;
+
+          for (size_t index = 0; index < sizeof(gGoldenEvents) / sizeof(gGoldenEvents[0]); ++index) {
+            auto &event = gGoldenEvents[index];
+
+            GoldenFormatter formatter;
+
+            if (event.mHasSchema) {
+              JSONWriter writer;
+              writer.writeString("name", event.mName);
+              if (event.mChannel) writer.writeString("channel", event.mChannel);
+              if (event.mTask) writer.writeString("task", event.mTask);
+              if (event.mOpCode) writer.writeString("opCode", event.mOpCode);
+              formatter.mEncodedMembers = String(std::string(writer.data(), writer.size()));
+            }
+
+            for (size_t valueIndex = 0; valueIndex < event.mTotalValues; ++valueIndex) {
+              formatter.mEncodedNames.push_back(JSONWriter::encodeName(event.mValues[valueIndex].mName));
+            }
+
+            result.push_back(formatter);
+          }
+
+          return result;
+        }
+
+        //---------------------------------------------------------------------
+        String SelfTest::writeElementEvent(const GoldenEvent &event)
+        {
+          // built exactly as the monitor did before output was streamed
+          ElementPtr rootEl = Element::create("event");
+          rootEl->adoptAsLastChild(IHelper::createElementWithText("severity", event.mSeverity));
+          rootEl->adoptAsLastChild(IHelper::createElementWithText("level", event.mLevel));
+
+          if (event.mHasSchema) {
+            rootEl->adoptAsLastChild(IHelper::createElementWithTextAndJSONEncode("name", event.mName));
+            if (event.mChannel) rootEl->adoptAsLastChild(IHelper::createElementWithTextAndJSONEncode("channel", event.mChannel));
+            if (event.mTask) rootEl->adoptAsLastChild(IHelper::createElementWithTextAndJSONEncode("task", event.mTask));
+            if (event.mOpCode) rootEl->adoptAsLastChild(IHelper::createElementWithTextAndJSONEncode("opCode", event.mOpCode));
+          } else {
+            rootEl->adoptAsLastChild(IHelper::createElementWithNumber("name", event.mName));
+            rootEl->adoptAsLastChild(IHelper::createElementWithNumber("channel", event.mChannel));
+            rootEl->adoptAsLastChild(IHelper::createElementWithNumber("task", event.mTask));
+            rootEl->adoptAsLastChild(IHelper::createElementWithNumber("opCode", event.mOpCode));
+          }
+
+          ElementPtr valuesEl = Element::create("values");
+          rootEl->adoptAsLastChild(valuesEl);
+
+          for (size_t index = 0; index < event.mTotalValues; ++index) {
+            auto &value = event.mValues[index];
+            if (value.mIsNumber) {
+              valuesEl->adoptAsLastChild(IHelper::createElementWithNumber(value.mName, value.mValue));
+            } else {
+              valuesEl->adoptAsLastChild(IHelper::createElementWithTextAndJSONEncode(value.mName, value.mValue));
+            }
+          }
+
+          return IHelper::toString(rootEl);
+        }
+
+        //---------------------------------------------------------------------
+        void SelfTest::writeStreamedEvent(
+                                          JSONWriter &writer,
+                                          const GoldenEvent &event,
+                                          const GoldenFormatter &formatter
+                                          )
+        {
+          // written the same way as the monitor's formatters
+          writer.beginObject();
+          writer.writeString("severity", event.mSeverity);
+          writer.writeString("level", event.mLevel);
+
+          if (event.mHasSchema) {
+            writer.writeMembers(formatter.mEncodedMembers);
+          } else {
+            writer.writeNumber("name", event.mName);
+            writer.writeNumber("channel", event.mChannel);
+            writer.writeNumber("task", event.mTask);
+            writer.writeNumber("opCode", event.mOpCode);
+          }
+
+          writer.beginObject("values");
+          for (size_t index = 0; index < event.mTotalValues; ++index) {
+            auto &value = event.mValues[index];
+            writer.writeValue(formatter.mEncodedNames[index], value.mValue, value.mIsNumber);
+          }
+          writer.endObject();
+          writer.endObject();
+        }
+
+        //---------------------------------------------------------------------
+        void SelfTest::checkBlockCodecRoundTrip(
+                                                const char *testName,
+                                                const Buffer &dictionary,
+                                                const Buffer &data,
+                                                size_t *outCompressedSize
+                                                ) throw (Failure)
+        {
+          Buffer window(dictionary);
+          window.insert(window.end(), data.begin(), data.end());
+          window.resize(window.size() + 1);   // never empty (the last byte is not part of the window)
+
+          Buffer compressed(UseBlockCodec::getMaxCompressedSize(data.size()));
+          size_t compressedSize = UseBlockCodec::compress(&(window[0]), dictionary.size(), dictionary.size() + data.size(), &(compressed[0]));
+          compressed.resize(compressedSize);
+
+          if (outCompressedSize) *outCompressedSize = compressedSize;
+
+          checkBlockCodecDecode(testName, dictionary, compressed, data, true);
+        }
+
+        //---------------------------------------------------------------------
+        void SelfTest::checkBlockCodecDecode(
+                                             const char *testName,
+                                             const Buffer &dictionary,
+                                             const Buffer &block,
+                                             const Buffer &expected,
+                                             bool expectSuccess
+                                             ) throw (Failure)
+        {
+          Buffer window(dictionary);
+          window.resize(dictionary.size() + expected.size() + 1);
+
+          bool decoded = UseBlockCodec::decompress(&(window[0]), dictionary.size(), (block.size() > 0 ? &(block[0]) : NULL), block.size(), expected.size());
+          if ((decoded) &&
+              (expected.size() > 0)) {
+            decoded = (0 == memcmp(&(window[dictionary.size()]), &(expected[0]), expected.size()));
+          }
+
+          if (decoded != expectSuccess) {
+            ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_INTERNAL_ERROR, String("Self test failed: ") + testName + ", compressed size=" + string(block.size()) + ", size=" + string(expected.size()));
+          }
+
+          tool::output() << "[Info] Passed: " << testName << "\n";
+        }
+
+        //---------------------------------------------------------------------
+        void SelfTest::checkFlightRecorderConvert(
+                                                  const char *testName,
+                                                  const Buffer &ringFile,
+                                                  const StringVector &expected,
+                                                  bool expectSuccess
+                                                  ) throw (Failure)
+        {
+          const char *ringFileName = ZS_EVENTING_TOOL_SELF_TEST_RING_FILE_NAME;
+          const char *traceFileName = ZS_EVENTING_TOOL_SELF_TEST_TRACE_FILE_NAME;
+
+          FILE *file = NULL;
+#ifdef _WIN32
+          fopen_s(&file, ringFileName, "wb");
+#else
+          file = fopen(ringFileName, "wb");
+#endif //_WIN32
+          if (NULL == file) {
+            ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_SYSTEM_ERROR, String("Self test failed to create file: ") + ringFileName);
+          }
+          size_t written = fwrite(&(ringFile[0]), ringFile.size(), 1, file);
+          fclose(file);
+
+          bool converted = false;
+          StringVector found;
+
+          if (1 == written) {
+            try {
+              IFlightRecorder::convert(ringFileName, traceFileName);
+              converted = true;
+
+              auto reader = ITraceFileReader::open(traceFileName);
+              ITraceFileTypes::Record record;
+              while (reader->readNext(record)) {
+                found.push_back(String(std::string(reinterpret_cast<const char *>(record.mPayload), record.mPayloadSize)));
+              }
+            } catch (const StdError &) {
+            }
+          }
+
+          ::remove(ringFileName);
+          ::remove(traceFileName);
+
+          if ((converted != expectSuccess) ||
+              (found != expected)) {
+            ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_INTERNAL_ERROR, String("Self test failed: ") + testName + ", expected records=" + string(expected.size()) + ", found records=" + string(found.size()));
+          }
+
+          tool::output() << "[Info] Passed: " << testName << "\n";
+        }
+
+        //---------------------------------------------------------------------
+        SelfTest::Buffer SelfTest::randomBytes(
+                                               size_t size,
+                                               uint32_t seed
+                                               )
+        {
+          // a fixed sequence so a failure can be reproduced
+          Buffer result(size);
+          uint32_t state = 2463534242U ^ seed;
+          for (size_t index = 0; index < size; ++index) {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            result[index] = static_cast<BYTE>(state >> 24);
+          }
+          return result;
+        }
+
+      } // namespace internal
+    } // namespace tool
+  } // namespace eventing
+} // namespace zsLib
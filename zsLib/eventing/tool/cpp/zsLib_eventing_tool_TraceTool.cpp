@@ -0,0 +1,1146 @@
+/*
+
+Copyright (c) 2016, Robin Raymond
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are those
+of the authors and should not be interpreted as representing official policies,
+either expressed or implied, of the FreeBSD Project.
+
+*/
+
+
+#include <zsLib/eventing/tool/internal/zsLib_eventing_tool_TraceTool.h>
+#include <zsLib/eventing/tool/internal/zsLib_eventing_tool_Helper.h>
+
+#include <zsLib/eventing/tool/OutputStream.h>
+#include <zsLib/eventing/IFlightRecorder.h>
+#include <zsLib/eventing/ITraceFile.h>
+
+#include <zsLib/Numeric.h>
+
+#include <algorithm>
+#include <thread>
+
+#define ZS_EVENTING_TOOL_TOTAL_BUILT_IN_EVENT_DATA (3)
+#define ZS_EVENTING_TOOL_TRACE_EXPORT_TOTAL_RECORD_COLUMNS (3)
+
+namespace zsLib { namespace eventing { namespace tool { ZS_DECLARE_SUBSYSTEM(zsLib_eventing_tool) } } }
+
+namespace zsLib
+{
+  namespace eventing
+  {
+    namespace tool
+    {
+      ZS_DECLARE_USING_PTR(zsLib::eventing, IHelper);
+
+      typedef eventing::USE_EVENT_PARAMETER_DESCRIPTOR USE_EVENT_PARAMETER_DESCRIPTOR;
+      typedef eventing::USE_EVENT_DATA_DESCRIPTOR USE_EVENT_DATA_DESCRIPTOR;
+
+      namespace internal
+      {
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark (helpers)
+        #pragma mark
+
+        //---------------------------------------------------------------------
+        static uint64_t toMicroseconds(Time time)
+        {
+          return static_cast<uint64_t>(std::chrono::duration_cast<Microseconds>(time.time_since_epoch()).count());
+        }
+
+        //---------------------------------------------------------------------
+        static void appendDictionaryValue(
+                                          TraceTool::ExportColumn &column,
+                                          const String &value
+                                          )
+        {
+          auto found = column.mDictionary.find(value);
+          if (found == column.mDictionary.end()) {
+            uint32_t index = static_cast<uint32_t>(column.mDictionaryValues.size());
+            column.mDictionaryValues.push_back(value);
+            found = column.mDictionary.insert(TraceTool::StringIndexMap::value_type(value, index)).first;
+          }
+          Helper::appendLittleEndian(column.mData, (*found).second, column.mWidth);
+        }
+
+        //---------------------------------------------------------------------
+        static size_t toColumnWidth(size_t size)
+        {
+          if (size <= sizeof(uint8_t)) return sizeof(uint8_t);
+          if (size <= sizeof(uint16_t)) return sizeof(uint16_t);
+          if (size <= sizeof(uint32_t)) return sizeof(uint32_t);
+          return sizeof(uint64_t);
+        }
+
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark TraceTool::NumericStats
+        #pragma mark
+
+        //---------------------------------------------------------------------
+        void TraceTool::NumericStats::add(double value)
+        {
+          if ((0 == mCount) || (value < mMin)) mMin = value;
+          if ((0 == mCount) || (value > mMax)) mMax = value;
+          mTotal += value;
+          ++mCount;
+        }
+
+        //---------------------------------------------------------------------
+        void TraceTool::NumericStats::merge(const NumericStats &source)
+        {
+          if (0 == source.mCount) return;
+          if ((0 == mCount) || (source.mMin < mMin)) mMin = source.mMin;
+          if ((0 == mCount) || (source.mMax > mMax)) mMax = source.mMax;
+          mTotal += source.mTotal;
+          mCount += source.mCount;
+        }
+
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark TraceTool::Summary
+        #pragma mark
+
+        //---------------------------------------------------------------------
+        void TraceTool::Summary::merge(const Summary &source)
+        {
+          mTotalChunks += source.mTotalChunks;
+          mTotalRecords += source.mTotalRecords;
+          mTotalEvents += source.mTotalEvents;
+          mTotalUndecodedEvents += source.mTotalUndecodedEvents;
+
+          // every partial summary shares the same histogram layout
+          for (size_t index = 0; (index < mHistogram.size()) && (index < source.mHistogram.size()); ++index) {
+            mHistogram[index] += source.mHistogram[index];
+          }
+
+          for (auto iter = source.mEvents.begin(); iter != source.mEvents.end(); ++iter) {
+            auto &sourceEvent = (*iter).second;
+            auto found = mEvents.find((*iter).first);
+            if (found == mEvents.end()) {
+              mEvents[(*iter).first] = sourceEvent;
+              continue;
+            }
+
+            auto &event = (*found).second;
+            event.mTotal += sourceEvent.mTotal;
+            for (auto iterValue = sourceEvent.mValues.begin(); iterValue != sourceEvent.mValues.end(); ++iterValue) {
+              event.mValues[(*iterValue).first].merge((*iterValue).second);
+            }
+          }
+
+          for (auto iter = source.mSubsystems.begin(); iter != source.mSubsystems.end(); ++iter) {
+            mSubsystems[(*iter).first] += (*iter).second;
+          }
+          for (auto iter = source.mSeverities.begin(); iter != source.mSeverities.end(); ++iter) {
+            mSeverities[(*iter).first] += (*iter).second;
+          }
+        }
+
+        //---------------------------------------------------------------------
+        ElementPtr TraceTool::Summary::toJSON() const
+        {
+          ElementPtr rootEl = Element::create("summary");
+
+          rootEl->adoptAsLastChild(IHelper::createElementWithNumber("chunks", string(mTotalChunks)));
+          rootEl->adoptAsLastChild(IHelper::createElementWithNumber("records", string(mTotalRecords)));
+          rootEl->adoptAsLastChild(IHelper::createElementWithNumber("events", string(mTotalEvents)));
+          rootEl->adoptAsLastChild(IHelper::createElementWithNumber("undecoded", string(mTotalUndecodedEvents)));
+
+          {
+            ElementPtr eventsEl = Element::create("events");
+            for (auto iter = mEvents.begin(); iter != mEvents.end(); ++iter) {
+              auto &event = (*iter).second;
+
+              ElementPtr eventEl = Element::create("event");
+              eventEl->adoptAsLastChild(IHelper::createElementWithTextAndJSONEncode("provider", event.mProviderName));
+              eventEl->adoptAsLastChild(IHelper::createElementWithTextAndJSONEncode("name", event.mEventName));
+              eventEl->adoptAsLastChild(IHelper::createElementWithNumber("total", string(event.mTotal)));
+
+              if (event.mValues.size() > 0) {
+                ElementPtr valuesEl = Element::create("values");
+                for (auto iterValue = event.mValues.begin(); iterValue != event.mValues.end(); ++iterValue) {
+                  auto &stats = (*iterValue).second;
+
+                  ElementPtr valueEl = Element::create("value");
+                  valueEl->adoptAsLastChild(IHelper::createElementWithTextAndJSONEncode("name", (*iterValue).first));
+                  valueEl->adoptAsLastChild(IHelper::createElementWithNumber("count", string(stats.mCount)));
+                  valueEl->adoptAsLastChild(IHelper::createElementWithNumber("min", string(stats.mMin)));
+                  valueEl->adoptAsLastChild(IHelper::createElementWithNumber("max", string(stats.mMax)));
+                  valueEl->adoptAsLastChild(IHelper::createElementWithNumber("mean", string(stats.mTotal / static_cast<double>(stats.mCount))));
+                  valuesEl->adoptAsLastChild(valueEl);
+                }
+                eventEl->adoptAsLastChild(valuesEl);
+              }
+              eventsEl->adoptAsLastChild(eventEl);
+            }
+            rootEl->adoptAsLastChild(eventsEl);
+          }
+
+          {
+            ElementPtr subsystemsEl = Element::create("subsystems");
+            for (auto iter = mSubsystems.begin(); iter != mSubsystems.end(); ++iter) {
+              ElementPtr subsystemEl = Element::create("subsystem");
+              subsystemEl->adoptAsLastChild(IHelper::createElementWithTextAndJSONEncode("name", (*iter).first));
+              subsystemEl->adoptAsLastChild(IHelper::createElementWithNumber("total", string((*iter).second)));
+              subsystemsEl->adoptAsLastChild(subsystemEl);
+            }
+            rootEl->adoptAsLastChild(subsystemsEl);
+          }
+
+          {
+            ElementPtr severitiesEl = Element::create("severities");
+            for (auto iter = mSeverities.begin(); iter != mSeverities.end(); ++iter) {
+              ElementPtr severityEl = Element::create("severity");
+              severityEl->adoptAsLastChild(IHelper::createElementWithText("name", (*iter).first));
+              severityEl->adoptAsLastChild(IHelper::createElementWithNumber("total", string((*iter).second)));
+              severitiesEl->adoptAsLastChild(severityEl);
+            }
+            rootEl->adoptAsLastChild(severitiesEl);
+          }
+
+          {
+            ElementPtr histogramEl = Element::create("histogram");
+            histogramEl->adoptAsLastChild(IHelper::createElementWithNumber("start", string(toMicroseconds(mFirstTime))));
+            histogramEl->adoptAsLastChild(IHelper::createElementWithNumber("bucketDuration", string(mBucketDuration.count())));
+
+            ElementPtr bucketsEl = Element::create("buckets");
+            for (auto iter = mHistogram.begin(); iter != mHistogram.end(); ++iter) {
+              bucketsEl->adoptAsLastChild(IHelper::createElementWithNumber("bucket", string(*iter)));
+            }
+            histogramEl->adoptAsLastChild(bucketsEl);
+            rootEl->adoptAsLastChild(histogramEl);
+          }
+
+          return rootEl;
+        }
+
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark TraceTool::ExportTable
+        #pragma mark
+
+        //---------------------------------------------------------------------
+        void TraceTool::ExportTable::open() throw (Failure)
+        {
+          std::vector<BYTE> header(ZS_EVENTING_TOOL_TRACE_EXPORT_MAGIC, ZS_EVENTING_TOOL_TRACE_EXPORT_MAGIC + strlen(ZS_EVENTING_TOOL_TRACE_EXPORT_MAGIC));
+          Helper::appendLittleEndian(header, ZS_EVENTING_TOOL_TRACE_EXPORT_VERSION, sizeof(uint32_t));
+
+          write("wb", header);
+          mOffset = header.size();
+        }
+
+        //---------------------------------------------------------------------
+        void TraceTool::ExportTable::appendRow(
+                                               const ITraceFileTypes::Record &record,
+                                               const ITraceFileTypes::TraceEvent &event,
+                                               const EventValueList &values
+                                               )
+        {
+          Helper::appendLittleEndian(mColumns[0].mData, toMicroseconds(record.mTime), mColumns[0].mWidth);
+          appendDictionaryValue(mColumns[1], Log::toString(event.mSeverity));
+          appendDictionaryValue(mColumns[2], Log::toString(event.mLevel));
+
+          for (size_t index = ZS_EVENTING_TOOL_TRACE_EXPORT_TOTAL_RECORD_COLUMNS; index < mColumns.size(); ++index) {
+            auto &column = mColumns[index];
+            size_t valueIndex = index - ZS_EVENTING_TOOL_TRACE_EXPORT_TOTAL_RECORD_COLUMNS;
+
+            if ((valueIndex >= values.size()) ||
+                (values[valueIndex].mIndex >= event.mDataDescriptorCount)) {
+              // the event has fewer values than the table's first event had
+              if (ColumnType_String == column.mType) {
+                appendDictionaryValue(column, String());
+              } else {
+                Helper::appendLittleEndian(column.mData, 0, column.mWidth);
+              }
+              continue;
+            }
+
+            auto &param = event.mParameterDescriptors[values[valueIndex].mIndex];
+            auto &data = event.mDataDescriptors[values[valueIndex].mIndex];
+
+            switch (column.mType) {
+              case ColumnType_Boolean:          Helper::appendLittleEndian(column.mData, (0 != ITraceFileTypes::getUnsignedValue(data) ? 1 : 0), column.mWidth); break;
+              case ColumnType_UnsignedInteger:  Helper::appendLittleEndian(column.mData, ITraceFileTypes::getUnsignedValue(data), column.mWidth); break;
+              case ColumnType_SignedInteger:    Helper::appendLittleEndian(column.mData, static_cast<uint64_t>(ITraceFileTypes::getSignedValue(data)), column.mWidth); break;
+              case ColumnType_Float:            {
+                double value = ITraceFileTypes::getFloatValue(data);
+                uint64_t bits {};
+                memcpy(&bits, &value, sizeof(bits));
+                Helper::appendLittleEndian(column.mData, bits, column.mWidth);
+                break;
+              }
+              case ColumnType_String:           {
+                bool isNumber = false;
+                appendDictionaryValue(column, ITraceFileTypes::valueAsString(param, data, isNumber));
+                break;
+              }
+            }
+          }
+
+          ++mTotalRows;
+          ++mRowGroupRows;
+        }
+
+        //---------------------------------------------------------------------
+        void TraceTool::ExportTable::flushRowGroup() throw (Failure)
+        {
+          if (0 == mRowGroupRows) return;
+
+          ExportRowGroup rowGroup;
+          rowGroup.mOffset = mOffset;
+          rowGroup.mTotalRows = mRowGroupRows;
+
+          std::vector<BYTE> buffer;
+          for (auto iter = mColumns.begin(); iter != mColumns.end(); ++iter) {
+            auto &column = (*iter);
+            buffer.insert(buffer.end(), column.mData.begin(), column.mData.end());
+            column.mData.clear();
+          }
+
+          write("ab", buffer);
+
+          mOffset += buffer.size();
+          mRowGroups.push_back(rowGroup);
+          mRowGroupRows = 0;
+        }
+
+        //---------------------------------------------------------------------
+        void TraceTool::ExportTable::close() throw (Failure)
+        {
+          flushRowGroup();
+
+          std::vector<BYTE> footer;
+          Helper::appendString(footer, mName);
+          Helper::appendLittleEndian(footer, mTotalRows, sizeof(uint64_t));
+
+          Helper::appendLittleEndian(footer, mColumns.size(), sizeof(uint32_t));
+          for (auto iter = mColumns.begin(); iter != mColumns.end(); ++iter) {
+            auto &column = (*iter);
+            Helper::appendString(footer, column.mName);
+            Helper::appendLittleEndian(footer, static_cast<uint64_t>(column.mType), sizeof(uint8_t));
+            Helper::appendLittleEndian(footer, column.mWidth, sizeof(uint8_t));
+
+            Helper::appendLittleEndian(footer, column.mDictionaryValues.size(), sizeof(uint32_t));
+            for (auto iterValue = column.mDictionaryValues.begin(); iterValue != column.mDictionaryValues.end(); ++iterValue) {
+              Helper::appendString(footer, (*iterValue));
+            }
+          }
+
+          Helper::appendLittleEndian(footer, mRowGroups.size(), sizeof(uint32_t));
+          for (auto iter = mRowGroups.begin(); iter != mRowGroups.end(); ++iter) {
+            Helper::appendLittleEndian(footer, (*iter).mOffset, sizeof(uint64_t));
+            Helper::appendLittleEndian(footer, (*iter).mTotalRows, sizeof(uint64_t));
+          }
+
+          size_t footerSize = footer.size();
+          Helper::appendLittleEndian(footer, footerSize, sizeof(uint32_t));
+          footer.insert(footer.end(), ZS_EVENTING_TOOL_TRACE_EXPORT_MAGIC, ZS_EVENTING_TOOL_TRACE_EXPORT_MAGIC + strlen(ZS_EVENTING_TOOL_TRACE_EXPORT_MAGIC));
+
+          write("ab", footer);
+        }
+
+        //---------------------------------------------------------------------
+        void TraceTool::ExportTable::write(
+                                           const char *mode,
+                                           const std::vector<BYTE> &buffer
+                                           ) throw (Failure)
+        {
+          // the file is only open while writing so that any number of event
+          // types can be exported without running out of file handles
+          String pathStr(mFileName);
+#ifdef _WIN32
+          pathStr.replaceAll("/", "\\");
+#endif //_WIN32
+
+          FILE *file = NULL;
+#ifdef _WIN32
+          fopen_s(&file, pathStr, mode);
+#else
+          file = fopen(pathStr, mode);
+#endif //_WIN32
+          if (NULL == file) {
+            ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_SYSTEM_ERROR, String("Failed to open columnar table file: ") + pathStr);
+          }
+
+          size_t written = (buffer.size() > 0 ? fwrite(&(buffer[0]), buffer.size(), 1, file) : 1);
+          fclose(file);
+
+          if (1 != written) {
+            ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_SYSTEM_ERROR, String("Failed to write columnar table file: ") + pathStr);
+          }
+        }
+
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark TraceTool
+        #pragma mark
+
+        //---------------------------------------------------------------------
+        void TraceTool::process(const TraceInfo &traceInfo) throw (Failure)
+        {
+          if (traceInfo.mMergeOutputFile.hasData()) {
+            merge(traceInfo);
+            return;
+          }
+          if (traceInfo.mSummarizeFile.hasData()) {
+            summarize(traceInfo);
+            return;
+          }
+          if (traceInfo.mQueryFile.hasData()) {
+            query(traceInfo);
+            return;
+          }
+          if (traceInfo.mExportFile.hasData()) {
+            exportTables(traceInfo);
+            return;
+          }
+          if (traceInfo.mConvertRingFile.hasData()) {
+            convert(traceInfo);
+            return;
+          }
+        }
+
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark TraceTool => (internal)
+        #pragma mark
+
+        //---------------------------------------------------------------------
+        void TraceTool::merge(const TraceInfo &traceInfo) throw (Failure)
+        {
+          tool::output() << "[Info] Merging " << string(traceInfo.mMergeFiles.size()) << " trace file(s) into: " << traceInfo.mMergeOutputFile << "\n";
+
+          size_t totalRecords {};
+
+          try {
+            totalRecords = ITraceFileWriter::merge(traceInfo.mMergeOutputFile.c_str(), traceInfo.mMergeFiles);
+          } catch (const StdError &e) {
+            ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_SYSTEM_ERROR, String("Failed to merge trace files into: ") + traceInfo.mMergeOutputFile + ", error=" + string(e.result()) + ", reason=" + e.message());
+          }
+
+          tool::output() << "[Info] Merged " << string(totalRecords) << " record(s) into: " << traceInfo.mMergeOutputFile << "\n";
+        }
+
+        //---------------------------------------------------------------------
+        void TraceTool::summarize(const TraceInfo &traceInfo) throw (Failure)
+        {
+          auto providers = loadProviders(traceInfo.mJMANFiles);
+
+          // the file is opened (and its index read) once; every worker reads
+          // through its own cursor (and decoding buffers) and pulls whole
+          // chunks from the shared chunk list until none remain
+          size_t totalWorkers = static_cast<size_t>(std::thread::hardware_concurrency());
+          if (totalWorkers < 1) totalWorkers = 1;
+
+          ITraceFileReaderPtr reader;
+          try {
+            reader = ITraceFileReader::open(traceInfo.mSummarizeFile);
+          } catch (const StdError &e) {
+            ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_FILE_FAILED_TO_LOAD, String("Failed to open trace file: ") + traceInfo.mSummarizeFile + ", error=" + string(e.result()) + ", reason=" + e.message());
+          }
+
+          auto chunks = reader->getChunks();
+
+          if (totalWorkers > chunks->size()) totalWorkers = chunks->size();
+          if (totalWorkers < 1) totalWorkers = 1;
+
+          std::vector<ITraceFileChunkCursorPtr> cursors;
+          while (cursors.size() < totalWorkers) {
+            cursors.push_back(reader->createChunkCursor());
+          }
+
+          // the histogram layout is decided up front from the chunk index so
+          // the partial results can be merged bucket by bucket
+          Summary layout;
+          layout.mHistogram.resize(ZS_EVENTING_TOOL_TRACE_SUMMARY_HISTOGRAM_BUCKETS);
+          if (chunks->size() > 0) {
+            Time firstTime = (*chunks)[0].mFirstTime;
+            Time lastTime = (*chunks)[0].mLastTime;
+            for (auto iter = chunks->begin(); iter != chunks->end(); ++iter) {
+              if ((*iter).mFirstTime < firstTime) firstTime = (*iter).mFirstTime;
+              if ((*iter).mLastTime > lastTime) lastTime = (*iter).mLastTime;
+            }
+            layout.mFirstTime = firstTime;
+            layout.mBucketDuration = Microseconds((std::chrono::duration_cast<Microseconds>(lastTime - firstTime).count() / ZS_EVENTING_TOOL_TRACE_SUMMARY_HISTOGRAM_BUCKETS) + 1);
+          }
+
+          tool::output() << "[Info] Summarizing " << string(chunks->size()) << " chunk(s) with " << string(totalWorkers) << " worker(s): " << traceInfo.mSummarizeFile << "\n";
+
+          std::vector<Summary> partials(totalWorkers, layout);
+          std::atomic<size_t> nextChunk {};
+
+          {
+            std::vector<std::thread> workers;
+            for (size_t index = 1; index < totalWorkers; ++index) {
+              workers.push_back(std::thread(&TraceTool::summarizeChunks, cursors[index], std::cref(*chunks), std::cref(providers), std::ref(nextChunk), std::ref(partials[index])));
+            }
+
+            summarizeChunks(cursors[0], *chunks, providers, nextChunk, partials[0]);
+
+            for (auto iter = workers.begin(); iter != workers.end(); ++iter) {
+              (*iter).join();
+            }
+          }
+
+          Summary &summary = partials[0];
+          for (size_t index = 1; index < partials.size(); ++index) {
+            summary.merge(partials[index]);
+          }
+
+          tool::output() << IHelper::toString(summary.toJSON()) << "\n";
+        }
+
+        //---------------------------------------------------------------------
+        void TraceTool::query(const TraceInfo &traceInfo) throw (Failure)
+        {
+          auto providers = loadProviders(traceInfo.mJMANFiles);
+
+          QueryConditionList conditions;
+          for (auto iter = traceInfo.mQueryConditions.begin(); iter != traceInfo.mQueryConditions.end(); ++iter) {
+            QueryCondition condition;
+            condition.mName = (*iter).first;
+            condition.mValue = (*iter).second;
+            condition.mValueHash = ITraceFileTypes::ValueFilter::hash(condition.mValue);
+            conditions.push_back(condition);
+          }
+
+          Time fromTime = traceInfo.mFrom;
+          Time toTime = (Time() != traceInfo.mTo ? traceInfo.mTo : Time::max());
+
+          ITraceFileReaderPtr reader;
+          try {
+            reader = ITraceFileReader::open(traceInfo.mQueryFile);
+          } catch (const StdError &e) {
+            ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_FILE_FAILED_TO_LOAD, String("Failed to open trace file: ") + traceInfo.mQueryFile + ", error=" + string(e.result()) + ", reason=" + e.message());
+          }
+
+          auto chunks = reader->findChunks(fromTime, toTime);
+
+          ProviderInfoMap providerInfos;
+          SecureByteBlock buffer;
+          ITraceFileTypes::TraceEvent event;
+          ITraceFileTypes::Record record;
+          EventValueList values;
+
+          size_t totalSkippedChunks {};
+          size_t totalIndexedChunks {};
+          size_t totalMatches {};
+          bool firstOutputEvent {true};
+
+          tool::output() << "{ \"events\": { \"event\": [\n";
+
+          for (auto iter = chunks->begin(); iter != chunks->end(); ++iter) {
+            auto &chunk = (*iter);
+            if (chunk.mValues.hasData()) ++totalIndexedChunks;
+
+            bool mightMatch = true;
+            for (auto iterCondition = conditions.begin(); iterCondition != conditions.end(); ++iterCondition) {
+              if (chunk.mValues.mightContainHash((*iterCondition).mValueHash)) continue;
+              mightMatch = false;
+              break;
+            }
+            if (!mightMatch) {
+              ++totalSkippedChunks;
+              continue;
+            }
+
+            reader->seekToChunk(chunk.mIndex);
+            while (reader->readNextInChunk(record)) {
+              if (ITraceFileTypes::RecordType_Notify == record.mType) {
+                updateProviders(record, providers, providerInfos);
+                continue;
+              }
+              if (ITraceFileTypes::RecordType_TraceEvent != record.mType) continue;
+              if ((record.mTime < fromTime) || (record.mTime > toTime)) continue;
+
+              if (!ITraceFileReader::decodeEvent(record, buffer, event)) continue;
+
+              EventPtr eventInfo;
+              auto found = providerInfos.find(event.mHandle);
+              if (found != providerInfos.end()) {
+                auto foundEvent = (*found).second.mEvents.find(event.mDescriptor.Id);
+                if (foundEvent != (*found).second.mEvents.end()) eventInfo = (*foundEvent).second;
+              }
+
+              getEventValues(eventInfo, event, values);
+              if (!matchesQuery(conditions, event, values)) continue;
+
+              ++totalMatches;
+
+              static const size_t skipStartLength = strlen("{\"event\":");
+              static const size_t skipEndLength = strlen("}");
+
+              String output = IHelper::toString(eventToJSON(record, event, providerInfos, values));
+              if (!firstOutputEvent) {
+                tool::output() << ",";
+              } else {
+                firstOutputEvent = false;
+              }
+              tool::output().write(output.c_str() + skipStartLength, output.length() - skipStartLength - skipEndLength);
+              tool::output() << "\n";
+            }
+          }
+
+          tool::output() << "\n] } }\n";
+
+          tool::output() << "[Info] Matched " << string(totalMatches) << " event(s), skipped " << string(totalSkippedChunks) << " of " << string(chunks->size()) << " chunk(s) using the value index\n";
+          if ((chunks->size() > 0) &&
+              (0 == totalIndexedChunks)) {
+            tool::output() << "[Info] Trace file was recorded without a value index (see the \"zsLib/eventing/trace-file/index-values\" setting); every chunk was scanned\n";
+          }
+        }
+
+        //---------------------------------------------------------------------
+        void TraceTool::exportTables(const TraceInfo &traceInfo) throw (Failure)
+        {
+          auto providers = loadProviders(traceInfo.mJMANFiles);
+
+          Time fromTime = traceInfo.mFrom;
+          Time toTime = (Time() != traceInfo.mTo ? traceInfo.mTo : Time::max());
+
+          ITraceFileReaderPtr reader;
+          try {
+            reader = ITraceFileReader::open(traceInfo.mExportFile);
+          } catch (const StdError &e) {
+            ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_FILE_FAILED_TO_LOAD, String("Failed to open trace file: ") + traceInfo.mExportFile + ", error=" + string(e.result()) + ", reason=" + e.message());
+          }
+
+          tool::output() << "[Info] Exporting events as columnar tables into: " << traceInfo.mExportDirectory << "\n";
+
+          ProviderInfoMap providerInfos;
+          ExportTableMap tables;
+          Helper::FileNameSet usedFileNames;
+          SecureByteBlock buffer;
+          ITraceFileTypes::TraceEvent event;
+          ITraceFileTypes::Record record;
+          EventValueList values;
+
+          size_t totalEvents {};
+          size_t totalUndecodedEvents {};
+
+          while (reader->readNext(record)) {
+            if (ITraceFileTypes::RecordType_Notify == record.mType) {
+              updateProviders(record, providers, providerInfos);
+              continue;
+            }
+            if (ITraceFileTypes::RecordType_TraceEvent != record.mType) continue;
+            if ((record.mTime < fromTime) || (record.mTime > toTime)) continue;
+
+            if (!ITraceFileReader::decodeEvent(record, buffer, event)) {
+              ++totalUndecodedEvents;
+              continue;
+            }
+
+            String providerName;
+            EventPtr eventInfo;
+
+            auto found = providerInfos.find(event.mHandle);
+            if (found != providerInfos.end()) {
+              auto &info = (*found).second;
+              providerName = info.mProviderName;
+              auto foundEvent = info.mEvents.find(event.mDescriptor.Id);
+              if (foundEvent != info.mEvents.end()) eventInfo = (*foundEvent).second;
+            } else {
+              providerName = String("#") + string(event.mHandle);
+            }
+
+            getEventValues(eventInfo, event, values);
+
+            ExportTablePtr table;
+            ExportTableKey key(providerName, event.mDescriptor.Id);
+
+            auto foundTable = tables.find(key);
+            if (foundTable != tables.end()) {
+              table = (*foundTable).second;
+            } else {
+              String eventName = (eventInfo ? eventInfo->mName : (String("#") + string(event.mDescriptor.Id)));
+              table = createExportTable(traceInfo.mExportDirectory, providerName, eventName, event, values, usedFileNames);
+              tables[key] = table;
+            }
+
+            table->appendRow(record, event, values);
+            if (table->mRowGroupRows >= ZS_EVENTING_TOOL_TRACE_EXPORT_ROWS_PER_GROUP) {
+              table->flushRowGroup();
+            }
+            ++totalEvents;
+          }
+
+          for (auto iter = tables.begin(); iter != tables.end(); ++iter) {
+            auto &table = (*iter).second;
+            table->close();
+            tool::output() << "[Info] Exported " << string(table->mTotalRows) << " row(s) into: " << table->mFileName << "\n";
+          }
+
+          tool::output() << "[Info] Exported " << string(totalEvents) << " event(s) into " << string(tables.size()) << " table(s)";
+          if (0 != totalUndecodedEvents) {
+            tool::output() << ", " << string(totalUndecodedEvents) << " event(s) could not be decoded";
+          }
+          tool::output() << "\n";
+        }
+
+        //---------------------------------------------------------------------
+        void TraceTool::convert(const TraceInfo &traceInfo) throw (Failure)
+        {
+          tool::output() << "[Info] Converting flight recorder file: " << traceInfo.mConvertRingFile << "\n";
+
+          size_t totalRecords {};
+
+          try {
+            totalRecords = IFlightRecorder::convert(traceInfo.mConvertRingFile.c_str(), traceInfo.mConvertOutputFile.c_str());
+          } catch (const StdError &e) {
+            ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_FILE_FAILED_TO_LOAD, String("Failed to convert flight recorder file: ") + traceInfo.mConvertRingFile + ", error=" + string(e.result()) + ", reason=" + e.message());
+          }
+
+          tool::output() << "[Info] Converted " << string(totalRecords) << " record(s) into: " << traceInfo.mConvertOutputFile << "\n";
+        }
+
+        //---------------------------------------------------------------------
+        TraceTool::ProviderMap TraceTool::loadProviders(const StringList &jmanFiles) throw (Failure)
+        {
+          ProviderMap result;
+
+          for (auto iter = jmanFiles.begin(); iter != jmanFiles.end(); ++iter) {
+            auto fileName = (*iter);
+
+            ProviderPtr provider;
+            SecureByteBlockPtr jmanRaw;
+
+            try {
+              jmanRaw = IHelper::loadFile(fileName);
+            } catch (const StdError &e) {
+              ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_FILE_FAILED_TO_LOAD, String("Failed to load jman file: ") + fileName + ", error=" + string(e.result()) + ", reason=" + e.message());
+            }
+            if (!jmanRaw) {
+              ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_FILE_FAILED_TO_LOAD, String("Failed to load jman file: ") + fileName);
+            }
+
+            auto rootEl = IHelper::read(jmanRaw);
+
+            try {
+              provider = Provider::create(rootEl);
+            } catch (const InvalidContent &e) {
+              ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_INVALID_CONTENT, "Failed to parse jman file: " + e.message());
+            }
+            if (!provider) {
+              ZS_THROW_CUSTOM_PROPERTIES_1(Failure, ZS_EVENTING_TOOL_FILE_FAILED_TO_LOAD, "Failed to parse jman file: " + fileName);
+            }
+
+            result[string(provider->mID)] = provider;
+          }
+
+          return result;
+        }
+
+        //---------------------------------------------------------------------
+        void TraceTool::summarizeChunks(
+                                        ITraceFileChunkCursorPtr cursor,
+                                        const ITraceFileTypes::ChunkInfoList &chunks,
+                                        const ProviderMap &providers,
+                                        std::atomic<size_t> &nextChunk,
+                                        Summary &ioSummary
+                                        )
+        {
+          ProviderInfoMap providerInfos;
+          SecureByteBlock buffer;
+          ITraceFileTypes::TraceEvent event;
+          ITraceFileTypes::Record record;
+
+          while (true) {
+            size_t chunkIndex = nextChunk.fetch_add(1);
+            if (chunkIndex >= chunks.size()) break;
+
+            ++(ioSummary.mTotalChunks);
+
+            cursor->seekToChunk(chunkIndex);
+            while (cursor->readNextInChunk(record)) {
+              ++(ioSummary.mTotalRecords);
+
+              if (ITraceFileTypes::RecordType_Notify == record.mType) {
+                updateProviders(record, providers, providerInfos);
+                continue;
+              }
+              if (ITraceFileTypes::RecordType_TraceEvent != record.mType) continue;
+
+              ++(ioSummary.mTotalEvents);
+              if (!ITraceFileReader::decodeEvent(record, buffer, event)) {
+                ++(ioSummary.mTotalUndecodedEvents);
+                continue;
+              }
+
+              summarizeEvent(record, event, providerInfos, ioSummary);
+            }
+          }
+        }
+
+        //---------------------------------------------------------------------
+        void TraceTool::updateProviders(
+                                        const ITraceFileTypes::Record &record,
+                                        const ProviderMap &providers,
+                                        ProviderInfoMap &ioProviderInfos
+                                        )
+        {
+          // only provider announcements (which every chunk repeats) matter
+          static const char *providerType = "\"provider\"";
+          if (std::search(record.mPayload, record.mPayload + record.mPayloadSize, providerType, providerType + strlen(providerType)) == record.mPayload + record.mPayloadSize) return;
+
+          ElementPtr rootEl = IHelper::toJSON(String(std::string(reinterpret_cast<const char *>(record.mPayload), record.mPayloadSize)));
+          if (!rootEl) return;
+
+          if ("provider" != IHelper::getElementText(rootEl->findFirstChildElement("type"))) return;
+
+          String providerName = IHelper::getElementText(rootEl->findFirstChildElement("name"));
+          if (providerName.isEmpty()) return;
+
+          uint64_t handle {};
+          try {
+            handle = Numeric<uint64_t>(IHelper::getElementText(rootEl->findFirstChildElement("handle")));
+          } catch (const Numeric<uint64_t>::ValueOutOfRange &) {
+            return;
+          }
+
+          auto &info = ioProviderInfos[handle];
+          if (info.mProviderName == providerName) return;
+
+          info.mProviderName = providerName;
+          info.mEvents.clear();
+
+          auto found = providers.find(IHelper::getElementText(rootEl->findFirstChildElement("id")));
+          if (found == providers.end()) return;
+
+          auto provider = (*found).second;
+          for (auto iter = provider->mEvents.begin(); iter != provider->mEvents.end(); ++iter) {
+            auto event = (*iter).second;
+            info.mEvents[event->mValue] = event;
+          }
+        }
+
+        //---------------------------------------------------------------------
+        void TraceTool::getEventValues(
+                                       EventPtr eventInfo,
+                                       const ITraceFileTypes::TraceEvent &event,
+                                       EventValueList &outValues
+                                       )
+        {
+          static const char *builtInNames[ZS_EVENTING_TOOL_TOTAL_BUILT_IN_EVENT_DATA] = {"_subsystemName", "_function", "_line"};
+
+          outValues.clear();
+
+          for (size_t index = 0; (index < ZS_EVENTING_TOOL_TOTAL_BUILT_IN_EVENT_DATA) && (index < event.mDataDescriptorCount); ++index) {
+            EventValue value;
+            value.mName = builtInNames[index];
+            value.mIndex = index;
+            outValues.push_back(value);
+          }
+
+          if (!eventInfo) {
+            // without a schema the values are named by their position
+            for (size_t index = ZS_EVENTING_TOOL_TOTAL_BUILT_IN_EVENT_DATA; index < event.mDataDescriptorCount; ++index) {
+              EventValue value;
+              value.mName = string(index - ZS_EVENTING_TOOL_TOTAL_BUILT_IN_EVENT_DATA);
+              value.mIndex = index;
+              outValues.push_back(value);
+            }
+            return;
+          }
+
+          if (!eventInfo->mDataTemplate) return;
+
+          size_t index = ZS_EVENTING_TOOL_TOTAL_BUILT_IN_EVENT_DATA;
+          for (auto iter = eventInfo->mDataTemplate->mDataTypes.begin(); (iter != eventInfo->mDataTemplate->mDataTypes.end()) && (index < event.mDataDescriptorCount); ++iter, ++index) {
+            auto &dataType = (*iter);
+
+            // the actual value of a buffer is stored just after its size
+            size_t valueIndex = index;
+            if (IEventingTypes::PredefinedTypedef_binary == dataType->mType) {
+              if (index + 1 >= event.mDataDescriptorCount) break;
+              valueIndex = index + 1;
+            } else if (IEventingTypes::PredefinedTypedef_size == dataType->mType) {
+              valueIndex = index - 1;
+            }
+
+            EventValue value;
+            value.mName = dataType->mValueName;
+            value.mIndex = valueIndex;
+            value.mType = dataType->mType;
+            outValues.push_back(value);
+          }
+        }
+
+        //---------------------------------------------------------------------
+        void TraceTool::summarizeEvent(
+                                       const ITraceFileTypes::Record &record,
+                                       const ITraceFileTypes::TraceEvent &event,
+                                       const ProviderInfoMap &providerInfos,
+                                       Summary &ioSummary
+                                       )
+        {
+          String providerName;
+          EventPtr eventInfo;
+
+          auto found = providerInfos.find(event.mHandle);
+          if (found != providerInfos.end()) {
+            auto &info = (*found).second;
+            providerName = info.mProviderName;
+            auto foundEvent = info.mEvents.find(event.mDescriptor.Id);
+            if (foundEvent != info.mEvents.end()) eventInfo = (*foundEvent).second;
+          } else {
+            providerName = String("#") + string(event.mHandle);
+          }
+
+          auto &summary = ioSummary.mEvents[EventSummaryKey(providerName, event.mDescriptor.Id)];
+          if (0 == summary.mTotal) {
+            summary.mProviderName = providerName;
+            summary.mEventName = (eventInfo ? eventInfo->mName : (String("#") + string(event.mDescriptor.Id)));
+          }
+          ++(summary.mTotal);
+
+          ++(ioSummary.mSeverities[Log::toString(event.mSeverity)]);
+
+          if (event.mDataDescriptorCount > 0) {
+            auto &data = event.mDataDescriptors[0];
+            String subsystemName;
+            if ((data.Ptr) && (0 != data.Size)) {
+              subsystemName = String(std::string(reinterpret_cast<const char *>(data.Ptr), strnlen(reinterpret_cast<const char *>(data.Ptr), data.Size)));
+            }
+            ++(ioSummary.mSubsystems[subsystemName]);
+          }
+
+          if (Microseconds() != ioSummary.mBucketDuration) {
+            auto offset = std::chrono::duration_cast<Microseconds>(record.mTime - ioSummary.mFirstTime).count();
+            if (offset < 0) offset = 0;
+            size_t bucket = static_cast<size_t>(offset / ioSummary.mBucketDuration.count());
+            if (bucket >= ioSummary.mHistogram.size()) bucket = ioSummary.mHistogram.size() - 1;
+            ++(ioSummary.mHistogram[bucket]);
+          }
+
+          if (!eventInfo) {
+            // without a schema the values are named by their position
+            for (size_t index = ZS_EVENTING_TOOL_TOTAL_BUILT_IN_EVENT_DATA; index < event.mDataDescriptorCount; ++index) {
+              double value {};
+              if (!ITraceFileTypes::getNumericValue(event.mParameterDescriptors[index], event.mDataDescriptors[index], value)) continue;
+              summary.mValues[string(index - ZS_EVENTING_TOOL_TOTAL_BUILT_IN_EVENT_DATA)].add(value);
+            }
+            return;
+          }
+
+          if (!eventInfo->mDataTemplate) return;
+
+          size_t index = ZS_EVENTING_TOOL_TOTAL_BUILT_IN_EVENT_DATA;
+          for (auto iter = eventInfo->mDataTemplate->mDataTypes.begin(); (iter != eventInfo->mDataTemplate->mDataTypes.end()) && (index < event.mDataDescriptorCount); ++iter, ++index) {
+            auto &dataType = (*iter);
+
+            // buffers and their sizes are not numeric values
+            if ((IEventingTypes::PredefinedTypedef_binary == dataType->mType) ||
+                (IEventingTypes::PredefinedTypedef_size == dataType->mType)) continue;
+
+            double value {};
+            if (!ITraceFileTypes::getNumericValue(event.mParameterDescriptors[index], event.mDataDescriptors[index], value)) continue;
+            summary.mValues[dataType->mValueName].add(value);
+          }
+        }
+
+        //---------------------------------------------------------------------
+        bool TraceTool::matchesQuery(
+                                     const QueryConditionList &conditions,
+                                     const ITraceFileTypes::TraceEvent &event,
+                                     const EventValueList &values
+                                     )
+        {
+          for (auto iter = conditions.begin(); iter != conditions.end(); ++iter) {
+            auto &condition = (*iter);
+
+            bool matched = false;
+            for (auto iterValue = values.begin(); iterValue != values.end(); ++iterValue) {
+              auto &value = (*iterValue);
+              if (value.mName != condition.mName) continue;
+
+              bool isNumber = false;
+              matched = (condition.mValue == ITraceFileTypes::valueAsString(event.mParameterDescriptors[value.mIndex], event.mDataDescriptors[value.mIndex], isNumber));
+              break;
+            }
+            if (!matched) return false;
+          }
+          return true;
+        }
+
+        //---------------------------------------------------------------------
+        ElementPtr TraceTool::eventToJSON(
+                                          const ITraceFileTypes::Record &record,
+                                          const ITraceFileTypes::TraceEvent &event,
+                                          const ProviderInfoMap &providerInfos,
+                                          const EventValueList &values
+                                          )
+        {
+          String providerName;
+          EventPtr eventInfo;
+
+          auto found = providerInfos.find(event.mHandle);
+          if (found != providerInfos.end()) {
+            auto &info = (*found).second;
+            providerName = info.mProviderName;
+            auto foundEvent = info.mEvents.find(event.mDescriptor.Id);
+            if (foundEvent != info.mEvents.end()) eventInfo = (*foundEvent).second;
+          }
+
+          ElementPtr rootEl = Element::create("event");
+          rootEl->adoptAsLastChild(IHelper::createElementWithNumber("time", string(toMicroseconds(record.mTime))));
+          rootEl->adoptAsLastChild(IHelper::createElementWithTextAndJSONEncode("provider", providerName));
+          rootEl->adoptAsLastChild(IHelper::createElementWithText("severity", Log::toString(event.mSeverity)));
+          rootEl->adoptAsLastChild(IHelper::createElementWithText("level", Log::toString(event.mLevel)));
+
+          if (eventInfo) {
+            rootEl->adoptAsLastChild(IHelper::createElementWithTextAndJSONEncode("name", eventInfo->mName));
+            if (eventInfo->mChannel) {
+              rootEl->adoptAsLastChild(IHelper::createElementWithTextAndJSONEncode("channel", eventInfo->mChannel->mID));
+            }
+            if (eventInfo->mTask) {
+              rootEl->adoptAsLastChild(IHelper::createElementWithTextAndJSONEncode("task", eventInfo->mTask->mName));
+            }
+            if (eventInfo->mOpCode) {
+              rootEl->adoptAsLastChild(IHelper::createElementWithTextAndJSONEncode("opCode", eventInfo->mOpCode->mName));
+            }
+          } else {
+            rootEl->adoptAsLastChild(IHelper::createElementWithNumber("name", string(event.mDescriptor.Id)));
+            rootEl->adoptAsLastChild(IHelper::createElementWithNumber("channel", string(event.mDescriptor.Channel)));
+            rootEl->adoptAsLastChild(IHelper::createElementWithNumber("task", string(event.mDescriptor.Task)));
+            rootEl->adoptAsLastChild(IHelper::createElementWithNumber("opCode", string(event.mDescriptor.Opcode)));
+          }
+
+          ElementPtr valuesEl = Element::create("values");
+          rootEl->adoptAsLastChild(valuesEl);
+
+          for (auto iter = values.begin(); iter != values.end(); ++iter) {
+            auto &value = (*iter);
+
+            bool isNumber = false;
+            String valueStr = ITraceFileTypes::valueAsString(event.mParameterDescriptors[value.mIndex], event.mDataDescriptors[value.mIndex], isNumber);
+
+            if (isNumber) {
+              valuesEl->adoptAsLastChild(IHelper::createElementWithNumber(value.mName, valueStr));
+            } else {
+              valuesEl->adoptAsLastChild(IHelper::createElementWithTextAndJSONEncode(value.mName, valueStr));
+            }
+          }
+
+          return rootEl;
+        }
+
+        //---------------------------------------------------------------------
+        TraceTool::ExportTablePtr TraceTool::createExportTable(
+                                                               const String &directory,
+                                                               const String &providerName,
+                                                               const String &eventName,
+                                                               const ITraceFileTypes::TraceEvent &event,
+                                                               const EventValueList &values,
+                                                               Helper::FileNameSet &ioUsedFileNames
+                                                               ) throw (Failure)
+        {
+          auto table = make_shared<ExportTable>();
+          table->mName = providerName + "." + eventName;
+
+          // names that differ only in characters unsafe for a file name
+          // must not truncate each other's table
+          table->mFileName = directory + "/" + Helper::toUniqueFileName(Helper::toFileNamePart(providerName) + "." + Helper::toFileNamePart(eventName), ".zscol", ioUsedFileNames);
+
+          {
+            ExportColumn column;
+            column.mName = "_time";
+            column.mType = ColumnType_SignedInteger;
+            column.mWidth = sizeof(int64_t);
+            table->mColumns.push_back(column);
+
+            column = ExportColumn();
+            column.mName = "_severity";
+            column.mWidth = sizeof(uint32_t);
+            table->mColumns.push_back(column);
+
+            column = ExportColumn();
+            column.mName = "_level";
+            column.mWidth = sizeof(uint32_t);
+            table->mColumns.push_back(column);
+          }
+
+          // the column types are those of the schema's data template or,
+          // without a schema, those of the table's first event (anything not
+          // numeric is exported as a dictionary encoded string)
+          for (auto iter = values.begin(); iter != values.end(); ++iter) {
+            auto &value = (*iter);
+
+            ExportColumn column;
+            column.mName = value.mName;
+
+            if (value.mType.hasValue()) {
+              auto type = value.mType.value();
+              switch (IEventingTypes::getBaseType(type)) {
+                case IEventingTypes::BaseType_Boolean:  column.mType = ColumnType_Boolean; column.mWidth = sizeof(uint8_t); break;
+                case IEventingTypes::BaseType_Integer:  column.mType = (IEventingTypes::isSigned(type) ? ColumnType_SignedInteger : ColumnType_UnsignedInteger); column.mWidth = toColumnWidth(IEventingTypes::getMaxBytes(type)); break;
+                case IEventingTypes::BaseType_Float:    column.mType = ColumnType_Float; column.mWidth = sizeof(double); break;
+                case IEventingTypes::BaseType_Pointer:  column.mType = ColumnType_UnsignedInteger; column.mWidth = sizeof(uint64_t); break;
+                case IEventingTypes::BaseType_Binary:
+                case IEventingTypes::BaseType_String:   break;
+              }
+            } else if (value.mIndex < event.mDataDescriptorCount) {
+              auto &param = event.mParameterDescriptors[value.mIndex];
+              auto &data = event.mDataDescriptors[value.mIndex];
+
+              switch (param.Type) {
+                case EventParameterType_Boolean:          column.mType = ColumnType_Boolean; column.mWidth = sizeof(uint8_t); break;
+                case EventParameterType_UnsignedInteger:
+                case EventParameterType_Pointer:          column.mType = ColumnType_UnsignedInteger; column.mWidth = toColumnWidth(data.Size); break;
+                case EventParameterType_SignedInteger:    column.mType = ColumnType_SignedInteger; column.mWidth = toColumnWidth(data.Size); break;
+                case EventParameterType_FloatingPoint:    column.mType = ColumnType_Float; column.mWidth = sizeof(double); break;
+                default:                                  break;
+              }
+            }
+            if (ColumnType_String == column.mType) column.mWidth = sizeof(uint32_t);
+
+            table->mColumns.push_back(column);
+          }
+
+          table->open();
+          return table;
+        }
+
+      } // namespace internal
+    } // namespace tool
+  } // namespace eventing
+} // namespace zsLib
@@ -51,10 +51,15 @@ namespace zsLib
     {
       namespace internal
       {
+        ZS_DECLARE_CLASS_PTR(BufferedWriter);
         ZS_DECLARE_CLASS_PTR(CommandLine);
+        ZS_DECLARE_CLASS_PTR(EventFilter);
         ZS_DECLARE_CLASS_PTR(EventingCompiler);
         ZS_DECLARE_CLASS_PTR(IDLCompiler);
         ZS_DECLARE_CLASS_PTR(Monitor);
+        ZS_DECLARE_CLASS_PTR(SchemaCache);
+        ZS_DECLARE_CLASS_PTR(SelfTest);
+        ZS_DECLARE_CLASS_PTR(TraceTool);
 
         ZS_DECLARE_STRUCT_PTR(GenerateHelper);
         ZS_DECLARE_STRUCT_PTR(GenerateStructHeader);
@@ -0,0 +1,176 @@
+/*
+
+Copyright (c) 2016, Robin Raymond
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are those
+of the authors and should not be interpreted as representing official policies,
+either expressed or implied, of the FreeBSD Project.
+
+*/
+
+
+#pragma once
+
+#include <zsLib/eventing/tool/internal/types.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <vector>
+
+#define ZS_EVENTING_TOOL_BUFFERED_WRITER_BLOCK_SIZE (64*1024)
+#define ZS_EVENTING_TOOL_BUFFERED_WRITER_FLUSH_INTERVAL_IN_MILLISECONDS (100)
+
+namespace zsLib
+{
+  namespace eventing
+  {
+    namespace tool
+    {
+      namespace internal
+      {
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark BufferedWriter
+        #pragma mark
+
+        // Collects output in memory and appends it to a file (or writes it to
+        // the standard output) once a block fills up or the flush interval
+        // passes. The file is only open while a block is written so any
+        // number of writers can be active at once and the file can be tailed.
+        //
+        // A file can be rotated by size or age: the full file is renamed to
+        // "<file name>.<n>" and a new file is started with the same header.
+        // Numbering continues after the highest "<n>" already on disk so a
+        // restarted monitor never overwrites earlier runs' files, and those
+        // files count towards the retention limit. Compressing rotated files
+        // and removing those beyond the limit happens on a single background
+        // thread shared by all writers.
+        class BufferedWriter
+        {
+        protected:
+          struct make_private {};
+
+        public:
+          struct RotationOptions
+          {
+            ULONGLONG mMaxFileSize {};              // rotate once a file reaches this size (0 = never)
+            Seconds mMaxFileAge {};                 // rotate once a file is this old (0 = never)
+            size_t mMaxRotatedFiles {};             // rotated files kept (0 = all)
+            bool mCompress {};                      // gzip rotated files
+
+            bool hasRotation() const {return (0 != mMaxFileSize) || (Seconds() != mMaxFileAge);}
+          };
+
+          struct RotatedFiles
+          {
+            bool mCompress {};
+            size_t mMaxRotatedFiles {};
+
+            Lock mLock;
+            std::condition_variable mCompleted;
+            size_t mPending {};                     // waiting on the background thread
+            StringList mKept;                       // (oldest first)
+
+            // compresses the file (if enabled) then keeps it
+            void process(const String &fileName);
+            // removes the oldest files beyond the retention limit
+            void keep(const String &fileName);
+          };
+          typedef std::shared_ptr<RotatedFiles> RotatedFilesPtr;
+
+        public:
+          BufferedWriter(
+                         const make_private &,
+                         const String &fileName,
+                         const RotationOptions &rotation,
+                         const String &fileHeader
+                         );
+          ~BufferedWriter();
+
+          // creates (or truncates) the file; a file name of "-" writes to the
+          // standard output instead (and is never rotated); the header is
+          // written at the start of every file
+          static BufferedWriterPtr create(
+                                          const String &fileName,
+                                          const RotationOptions &rotation,
+                                          const String &fileHeader = String()
+                                          ) throw (Failure);
+          static BufferedWriterPtr create(const String &fileName) throw (Failure) {return create(fileName, RotationOptions());}
+
+          const String &getFileName() const {return mFileName;}
+
+          // must only be called between records so a record is never split
+          // across files; returns true if a new file was started
+          bool rotateIfNeeded() throw (Failure);
+
+          void write(
+                     const void *buffer,
+                     size_t size
+                     ) throw (Failure);
+          void write(const String &value) throw (Failure) {write(value.c_str(), value.length());}
+
+          // writes out anything buffered (safe to call from any thread)
+          void flush() throw (Failure);
+
+        protected:
+          void internalFlush() throw (Failure);
+          void writeFile(
+                         const char *mode,
+                         const BYTE *buffer,
+                         size_t size
+                         ) throw (Failure);
+
+          void startFile() throw (Failure);
+          void resumeRotation();
+
+          static String compressFile(const String &fileName);
+
+          static String toPath(const String &fileName);
+
+        protected:
+          mutable Lock mLock;
+
+          String mFileName;
+          bool mStandardOutput {};
+
+          RotationOptions mRotation;
+          String mFileHeader;
+
+          std::vector<BYTE> mBuffer;
+          std::chrono::steady_clock::time_point mLastFlush {};
+
+          ULONGLONG mFileSize {};                   // including what is buffered
+          std::chrono::steady_clock::time_point mFileStarted {};
+          size_t mTotalRotations {};                // highest rotated file number used
+
+          RotatedFilesPtr mRotatedFiles;
+        };
+
+      } // namespace internal
+    } // namespace tool
+  } // namespace eventing
+} // namespace zsLib
@@ -0,0 +1,218 @@
+/*
+
+Copyright (c) 2016, Robin Raymond
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are those
+of the authors and should not be interpreted as representing official policies,
+either expressed or implied, of the FreeBSD Project.
+
+*/
+
+
+#pragma once
+
+#include <zsLib/eventing/tool/internal/types.h>
+
+#include <zsLib/eventing/Log.h>
+
+#include <zsLib/Log.h>
+
+#include <map>
+#include <vector>
+
+namespace zsLib
+{
+  namespace eventing
+  {
+    namespace tool
+    {
+      namespace internal
+      {
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark EventFilter
+        #pragma mark
+
+        // Filter expression over the event name, severity, level, subsystem
+        // and named data template fields, e.g.:
+        //
+        //   name==CallStart && durationMs>500
+        //   (severity>=Warning || subsystem=="zsLib_socket") && !(level==Insane)
+        //
+        // The expression is parsed once. Binding it to an event resolves the
+        // field names to data descriptor indexes and folds the comparisons
+        // known from the schema (such as the event name) into constants so
+        // matching an event only reads its raw data descriptors.
+        class EventFilter
+        {
+        protected:
+          struct make_private {};
+
+        public:
+          typedef zsLib::Log::Severity Severity;
+          typedef zsLib::Log::Level Level;
+
+          enum Results
+          {
+            Result_Never,
+            Result_Always,
+            Result_Evaluate,
+          };
+
+          enum NodeTypes
+          {
+            NodeType_And,
+            NodeType_Or,
+            NodeType_Not,
+            NodeType_Compare,
+          };
+
+          enum Fields
+          {
+            Field_Name,
+            Field_Severity,
+            Field_Level,
+            Field_Subsystem,
+            Field_Data,                             // data template field
+          };
+
+          enum Operators
+          {
+            Operator_Equal,
+            Operator_NotEqual,
+            Operator_Less,
+            Operator_LessOrEqual,
+            Operator_Greater,
+            Operator_GreaterOrEqual,
+          };
+
+          struct Node
+          {
+            NodeTypes mType {NodeType_Compare};
+            size_t mLeft {};                        // and, or and not operand
+            size_t mRight {};                       // and and or operand
+
+            Fields mField {Field_Data};
+            String mFieldName;
+            Operators mOperator {Operator_Equal};
+            String mValue;
+            bool mIsNumber {};
+            double mNumber {};
+
+            size_t mIndex {};                       // data descriptor (once bound)
+            Results mResult {Result_Evaluate};      // (once bound)
+          };
+          typedef std::vector<Node> NodeList;
+
+          ZS_DECLARE_STRUCT_PTR(BoundFilter);
+
+          struct BoundFilter
+          {
+            NodeList mNodes;
+            size_t mRoot {};
+            Results mResult {Result_Evaluate};
+          };
+
+          typedef std::map<String, size_t> FieldIndexMap;   // data template field name to data descriptor index
+
+        public:
+          EventFilter(
+                      const make_private &,
+                      const String &expression
+                      ) throw (InvalidArgument);
+
+          static EventFilterPtr create(const String &expression) throw (InvalidArgument);
+
+          const String &getExpression() const {return mExpression;}
+
+          // an event without a schema is bound with an empty name and no
+          // fields (so only its severity, level and subsystem can match)
+          BoundFilterPtr bind(
+                              const String &eventName,
+                              const FieldIndexMap &fields
+                              ) const;
+
+          static bool matches(
+                              const BoundFilter &filter,
+                              Severity severity,
+                              Level level,
+                              EVENT_PARAMETER_DESCRIPTOR_HANDLE paramDescriptor,
+                              EVENT_DATA_DESCRIPTOR_HANDLE dataDescriptor,
+                              size_t dataDescriptorCount
+                              );
+
+        protected:
+          size_t parseOr() throw (InvalidArgument);
+          size_t parseAnd() throw (InvalidArgument);
+          size_t parseUnary() throw (InvalidArgument);
+          size_t parseCompare() throw (InvalidArgument);
+
+          void skipWhiteSpace();
+          bool consume(const char *token);
+          String parseIdentifier();
+          String parseValue() throw (InvalidArgument);
+          String getParseError(const char *reason) const;
+
+          static Results bindNode(
+                                  NodeList &nodes,
+                                  size_t index,
+                                  const String &eventName,
+                                  const FieldIndexMap &fields
+                                  );
+
+          static bool evaluate(
+                               const NodeList &nodes,
+                               size_t index,
+                               Severity severity,
+                               Level level,
+                               EVENT_PARAMETER_DESCRIPTOR_HANDLE paramDescriptor,
+                               EVENT_DATA_DESCRIPTOR_HANDLE dataDescriptor,
+                               size_t dataDescriptorCount
+                               );
+
+          static bool compare(
+                              Operators op,
+                              int result                    // <0, 0 or >0 as left is less, equal or greater than right
+                              );
+          static bool compare(
+                              Operators op,
+                              double left,
+                              double right
+                              );
+
+        protected:
+          String mExpression;
+          size_t mPos {};                           // (while parsing)
+
+          NodeList mNodes;
+          size_t mRoot {};
+        };
+
+      } // namespace internal
+    } // namespace tool
+  } // namespace eventing
+} // namespace zsLib
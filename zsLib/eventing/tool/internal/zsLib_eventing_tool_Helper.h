@@ -35,6 +35,9 @@ either expressed or implied, of the FreeBSD Project.
 
 #include <zsLib/eventing/IHelper.h>
 
+#include <set>
+#include <vector>
+
 namespace zsLib
 {
   namespace eventing
@@ -54,9 +57,54 @@ namespace zsLib
         class Helper : public eventing::IHelper
         {
         public:
+          typedef std::set<String> FileNameSet;
+
           static String fileNameAfterPath(const String &filePath);
           static String fixRelativeFilePath(const String &originalFileName, const String &newFileName);
 
+          // replaces characters that are not safe in a file name
+          static String toFileNamePart(const String &value);
+
+          // a file name (the base name plus the extension) not yet in the set
+          // of used names (compared without case), with a numeric suffix added
+          // to the base name on a collision; the name returned is added to
+          // the set
+          static String toUniqueFileName(
+                                         const String &baseName,
+                                         const char *extension,
+                                         FileNameSet &ioUsedFileNames
+                                         );
+
+          // appends the low "size" bytes of the value (least significant
+          // first), as used by the tool's binary file formats
+          static void appendLittleEndian(
+                                         String &output,
+                                         uint64_t value,
+                                         size_t size
+                                         );
+          static void appendLittleEndian(
+                                         std::vector<BYTE> &output,
+                                         uint64_t value,
+                                         size_t size
+                                         );
+
+          // appends a 32 bit little endian length followed by the string
+          static void appendString(
+                                   String &output,
+                                   const String &value
+                                   );
+          static void appendString(
+                                   std::vector<BYTE> &output,
+                                   const String &value
+                                   );
+
+          // the paths of the files in a folder (not its sub-folders) whose
+          // names end with the extension (e.g. ".jman")
+          static StringList listFiles(
+                                      const String &folder,
+                                      const char *extension
+                                      ) throw (StdError);
+
           static bool isLikelyJSON(const char *p);
 
           static bool skipEOL(
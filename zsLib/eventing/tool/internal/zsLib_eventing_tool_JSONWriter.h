@@ -0,0 +1,105 @@
+/*
+
+Copyright (c) 2016, Robin Raymond
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are those
+of the authors and should not be interpreted as representing official policies,
+either expressed or implied, of the FreeBSD Project.
+
+*/
+
+
+#pragma once
+
+#include <zsLib/eventing/tool/internal/types.h>
+
+#include <string>
+
+namespace zsLib
+{
+  namespace eventing
+  {
+    namespace tool
+    {
+      namespace internal
+      {
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark JSONWriter
+        #pragma mark
+
+        // Writes compact JSON directly into a reusable buffer without
+        // building a document first. The output is byte identical to what
+        // IHelper::toString produces for the same element tree (checked by
+        // the tool's -selftest).
+        class JSONWriter
+        {
+        public:
+          void clear();
+
+          void beginObject(const char *name = NULL);
+          void endObject();
+
+          void writeString(
+                           const char *name,
+                           const String &value
+                           );
+          void writeNumber(
+                           const char *name,
+                           const String &value
+                           );
+
+          // names (and whole members) can be encoded once up front and then
+          // written as is
+          static String encodeName(const String &name);
+
+          void writeValue(
+                          const String &encodedName,
+                          const String &value,
+                          bool isNumber
+                          );
+          void writeMembers(const String &encodedMembers);
+
+          const char *data() const  {return mBuffer.c_str();}
+          size_t size() const       {return mBuffer.length();}
+
+        protected:
+          void writeName(const char *name);
+          void writeEncoded(
+                            const char *value,
+                            size_t length
+                            );
+
+        protected:
+          std::string mBuffer;
+          bool mNeedsSeparator {};
+        };
+
+      } // namespace internal
+    } // namespace tool
+  } // namespace eventing
+} // namespace zsLib
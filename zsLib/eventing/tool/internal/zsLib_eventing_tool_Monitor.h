@@ -32,10 +32,16 @@ either expressed or implied, of the FreeBSD Project.
 #pragma once
 
 #include <zsLib/eventing/tool/internal/types.h>
+#include <zsLib/eventing/tool/internal/zsLib_eventing_tool_BufferedWriter.h>
+#include <zsLib/eventing/tool/internal/zsLib_eventing_tool_EventFilter.h>
+#include <zsLib/eventing/tool/internal/zsLib_eventing_tool_Helper.h>
+#include <zsLib/eventing/tool/internal/zsLib_eventing_tool_JSONWriter.h>
+#include <zsLib/eventing/tool/internal/zsLib_eventing_tool_SchemaCache.h>
 
 #include <zsLib/eventing/tool/ICommandLine.h>
 
 #include <zsLib/eventing/IRemoteEventing.h>
+#include <zsLib/eventing/ITraceFile.h>
 #include <zsLib/eventing/IEventingTypes.h>
 
 #include <zsLib/ITimer.h>
@@ -43,8 +49,29 @@ either expressed or implied, of the FreeBSD Project.
 #include <zsLib/Singleton.h>
 #include <zsLib/IWakeDelegate.h>
 
+#include <condition_variable>
+#include <thread>
+#include <tuple>
+
 #define ZS_EVENTING_TOTAL_BUILT_IN_EVENT_DATA (3)
 
+#define ZS_EVENTING_TOOL_MONITOR_MAX_PENDING_EVENTS (16384)
+#define ZS_EVENTING_TOOL_MONITOR_MERGE_WINDOW_IN_MILLISECONDS (250)
+
+#define ZS_EVENTING_TOOL_MONITOR_STATS_HISTOGRAM_BUCKETS (64)
+#define ZS_EVENTING_TOOL_MONITOR_STATS_RATE_SMOOTHING (0.3)
+
+#define ZS_EVENTING_TOOL_MONITOR_LATENCY_SUB_BUCKET_BITS (7)
+#define ZS_EVENTING_TOOL_MONITOR_LATENCY_MAX_OPEN_SPANS (100000)
+
+#define ZS_EVENTING_TOOL_MONITOR_HEAVY_HITTERS_SKETCH_WIDTH (4096)
+#define ZS_EVENTING_TOOL_MONITOR_HEAVY_HITTERS_SKETCH_DEPTH (4)
+
+#define ZS_EVENTING_TOOL_MONITOR_SCHEMA_HEADER_SCAN_SIZE (4096)
+
+#define ZS_EVENTING_TOOL_MONITOR_BINARY_MAGIC "zsEV"
+#define ZS_EVENTING_TOOL_MONITOR_BINARY_VERSION (1)
+
 
 namespace zsLib
 {
@@ -90,10 +117,73 @@ namespace zsLib
 
           ZS_DECLARE_TYPEDEF_PTR(IEventingTypes::Provider, Provider);
           ZS_DECLARE_TYPEDEF_PTR(IEventingTypes::Event, Event);
-          typedef std::map<UUID, ProviderPtr> ProviderMap;
+          typedef std::map<String, ProviderPtr> ProviderMap;                // by provider unique hash
+          typedef std::map<UUID, ProviderPtr> ProviderIDMap;
+
+          // a -jman-dir file, loaded in the background once a remote has
+          // its provider
+          struct IndexedSchema
+          {
+            String mFileName;
+            UUID mProviderID {};
+            String mUniqueHash;
+          };
+          typedef std::map<String, IndexedSchema> IndexedSchemaMap;         // by provider unique hash
+          typedef std::list<IndexedSchema> IndexedSchemaList;
+          typedef std::map<String, ProviderPtr> ShippedProviderMap;         // by provider unique hash
           
           typedef size_t ValueID;
-          typedef std::map<ValueID, EventPtr> EventMap;
+
+          // Binary output (all values little endian unless noted):
+          //
+          //   "zsEV" magic, uint32 version
+          //   records, each: uint8 record type, uint32 size of the rest of
+          //   the record (so unknown record types can be skipped)
+          //
+          //   provider record (sent before the provider's first event):
+          //     uint64 provider handle, string name, string unique hash
+          //     (strings are a uint32 length followed by the characters)
+          //
+          //   source record (only when connected to multiple remotes; sent
+          //   whenever the events that follow are from another remote):
+          //     uint16 source index, string source name
+          //
+          //   event record:
+          //     uint64 provider handle, uint8 severity, uint8 level,
+          //     uint16 event ID, uint8 version, uint8 channel, uint8 level,
+          //     uint8 opcode, uint16 task, uint64 keyword, uint16 value
+          //     count, then per value: uint16 parameter type, uint32 size
+          //     and the value as received (numbers in the monitor's host
+          //     order)
+          enum BinaryRecordTypes
+          {
+            BinaryRecordType_Provider = 1,
+            BinaryRecordType_Event =    2,
+            BinaryRecordType_Source =   3,
+          };
+
+          // an event's values in output order, resolved from its data
+          // template when the provider's schema is matched
+          struct FormatterField
+          {
+            String mName;
+            String mEncodedName;                    // see JSONWriter::encodeName
+            size_t mIndex {};                       // data descriptor holding the value
+          };
+          typedef std::vector<FormatterField> FormatterFieldList;
+
+          ZS_DECLARE_STRUCT_PTR(EventFormatter);
+
+          struct EventFormatter
+          {
+            EventPtr mEvent;
+            String mEncodedMembers;                 // name, channel, task and opCode
+            size_t mTotalDataParams {};             // including buffer sizes
+            size_t mTotalDataParamsWithoutSizes {};
+            FormatterFieldList mFields;
+            EventFilter::BoundFilterPtr mFilter;
+          };
+          typedef std::vector<EventFormatterPtr> EventFormatterList;  // by event ID
           
           struct ProviderInfo
           {
@@ -102,11 +192,135 @@ namespace zsLib
             UUID mProviderID {};
             String mProviderName;
             String mProviderUniqueHash;
-            EventMap mEvents;
+            EventFormatterList mFormatters;
+            std::atomic<bool> mSchemaPending {};    // shipped schema not yet looked for
           };
 
+          // an event copied off the notifying thread, formatted by one of the
+          // formatter threads and output in the order it was received (or in
+          // event time order when merging several remotes)
+          struct PendingEvent
+          {
+            uint64_t mSequence {};
+            ProviderInfo *mProvider {};
+            size_t mSource {};                      // see getSource
+            Time mTime {};                          // see IRemoteEventing::getWritingEventTime (only when merging)
+            ITraceFileTypes::TraceEvent mEvent;
+            std::vector<BYTE> mData;                // referenced by the event's data descriptors
+
+            String mOutput;                         // json, csv row or binary record
+            String mWarning;
+          };
+          ZS_DECLARE_STRUCT_PTR(PendingEvent);
+          typedef std::list<PendingEventPtr> PendingEventList;
+          typedef std::map<uint64_t, PendingEventPtr> PendingEventMap;    // by sequence
+          typedef std::multimap<Time, PendingEventPtr> PendingEventTimeMap;
+
           typedef std::set<ProviderInfo *> ProviderInfoSet;
 
+          typedef std::pair<String, size_t> CSVWriterKey;                   // provider name, event ID
+          typedef std::map<CSVWriterKey, BufferedWriterPtr> CSVWriterMap;
+
+          // -stats aggregation of a numeric data template field; the
+          // histogram buckets are by powers of two
+          struct FieldStats
+          {
+            size_t mCount {};
+            double mMin {};
+            double mMax {};
+            double mTotal {};
+            std::vector<size_t> mBuckets;
+
+            void add(double value);
+            double getPercentile(double percentile) const;  // upper bound of the bucket
+          };
+          typedef std::vector<FieldStats> FieldStatsList;   // by formatter field
+
+          struct RateStats
+          {
+            size_t mTotal {};
+            size_t mIntervalTotal {};
+            double mLastRate {};                    // per second in the last interval
+            double mRate {};                        // per second, smoothed over the intervals
+
+            void add() {++mTotal; ++mIntervalTotal;}
+            void roll(double intervalSeconds);
+          };
+
+          struct EventStats
+          {
+            ProviderInfo *mProvider {};
+            size_t mEventID {};
+            RateStats mRate;
+            FieldStatsList mFields;
+          };
+          typedef std::pair<ProviderInfo *, size_t> EventStatsKey;          // provider, event ID
+          typedef std::map<EventStatsKey, EventStats> EventStatsMap;
+          typedef std::map<ProviderInfo *, RateStats> ProviderStatsMap;
+          typedef std::map<String, RateStats> SubsystemStatsMap;
+
+          // approximate most frequent values of a high cardinality field in
+          // fixed memory; a count-min sketch estimates the count of every
+          // value and a small min-heap keeps the heaviest values seen
+          struct HeavyHitters
+          {
+            typedef std::pair<ULONGLONG, String> HeavyHitter;   // approximate count, value
+            typedef std::vector<HeavyHitter> HeavyHitterList;
+
+            size_t mTop {};
+            ULONGLONG mTotal {};
+            std::vector<ULONGLONG> mSketch;         // depth rows of width counters
+            HeavyHitterList mHeap;                  // at most mTop values
+
+            void add(const String &value);
+            HeavyHitterList getHeaviest() const;    // heaviest first
+          };
+          typedef std::map<String, HeavyHitters> HeavyHittersMap;           // by field name
+
+          // HDR style histogram of span durations (in microseconds); every
+          // power of two range is split into linear sub-buckets so values
+          // keep ZS_EVENTING_TOOL_MONITOR_LATENCY_SUB_BUCKET_BITS bits of
+          // precision over the full range
+          struct LatencyHistogram
+          {
+            std::vector<size_t> mCounts;
+            size_t mTotal {};
+            ULONGLONG mMin {};
+            ULONGLONG mMax {};
+
+            void record(ULONGLONG value);
+            ULONGLONG getPercentile(double percentile) const;  // highest value of the bucket
+            void reset() {mCounts.clear(); mTotal = 0; mMin = 0; mMax = 0;}
+
+            static size_t toIndex(ULONGLONG value);
+            static ULONGLONG fromIndex(size_t index);
+          };
+
+          struct TaskLatency
+          {
+            ProviderInfo *mProvider {};
+            String mTaskName;
+            LatencyHistogram mHistogram;            // since monitoring started
+            LatencyHistogram mIntervalHistogram;    // since the last output
+            size_t mUnmatchedStops {};
+          };
+          typedef std::pair<ProviderInfo *, size_t> TaskLatencyKey;         // provider, task
+          typedef std::map<TaskLatencyKey, TaskLatency> TaskLatencyMap;
+
+          typedef Time SpanTime;                                            // see IRemoteEventing::getWritingEventTime
+          typedef std::vector<SpanTime> SpanTimeList;                       // nested spans are stacked
+          typedef std::tuple<ProviderInfo *, size_t, size_t, String> OpenSpanKey;   // provider, source, task, correlation value
+          typedef std::map<OpenSpanKey, SpanTimeList> OpenSpanMap;
+
+          typedef IRemoteEventingTypes::EventCounter EventCounter;
+          typedef std::tuple<PUID, UUID, ValueID> EventCounterKey;         // remote, provider, event
+          typedef std::map<EventCounterKey, EventCounter> EventCounterMap;
+
+          typedef std::list<IRemoteEventingPtr> RemoteEventingList;
+          typedef std::map<PUID, size_t> SourceIndexMap;                    // remote ID to source index
+          typedef std::vector<String> SourceNameList;                       // by source index
+          typedef std::map<PUID, size_t> RemoteDroppedMap;                  // remote ID to total dropped
+
         public:
           Monitor(
                   const make_private &,
@@ -181,6 +395,11 @@ namespace zsLib
                                                            size_t totalDropped
                                                            ) override;
 
+          virtual void onRemoteEventingRemoteEventCounters(
+                                                           IRemoteEventingPtr connection,
+                                                           EventCounterListPtr counters
+                                                           ) override;
+
           //-------------------------------------------------------------------
           #pragma mark
           #pragma mark Monitor::ILogEventingProviderDelegate
@@ -224,6 +443,87 @@ namespace zsLib
           void cancel();
           void step();
           bool shouldQuit() const { return mShouldQuit; }
+          bool isOutputToCommandLine() const;
+          bool isStatsMode() const {return Seconds() != mMonitorInfo.mStatsInterval;}
+          bool isLatencyMode() const {return Seconds() != mMonitorInfo.mLatencyInterval;}
+          bool hasMultipleSources() const {return mSourceNames.size() > 1;}
+
+          size_t getSource() const;
+          String getSourceName(size_t source) const;
+          String getRemoteName(PUID remoteID) const;
+
+          ProviderPtr loadProvider(
+                                   const String &fileName,
+                                   bool &outFromCache
+                                   ) throw (Failure);
+          void indexSchemas() throw (Failure);
+          bool requestIndexedSchema(const String &uniqueHash);
+          void waitForIndexedSchema(const String &uniqueHash);
+          void collectIndexedSchemas();
+          void stopSchemaLoader();
+          void runSchemaLoader();
+          void saveSchemaCache();
+          bool addProvider(ProviderPtr provider);
+          ProviderPtr findProvider(
+                                   UUID providerID,
+                                   const String &uniqueHash
+                                   );
+          ProviderPtr loadShippedProvider(
+                                          const ProviderInfo &provider,
+                                          EventingAtomDataArray eventingAtomDataArray
+                                          );
+          void applySubsystemLevels(ProviderPtr provider);
+          void compileFormatters(
+                                 ProviderInfo *provider,
+                                 ProviderPtr existingProvider
+                                 );
+
+          void outputTopTalkers();
+          String getEventName(const EventCounter &counter) const;
+
+          static EventFormatterPtr createFormatter(EventPtr event);
+          static EventFormatter *getFormatter(const PendingEvent &pending);
+
+          void startFormatters();
+          void stopFormatters();
+          void runFormatter();
+          void formatEvent(
+                           PendingEvent &pending,
+                           JSONWriter &writer
+                           );
+          void formatJSON(
+                          PendingEvent &pending,
+                          EventFormatter *formatter,
+                          JSONWriter &writer
+                          );
+          void formatCSV(
+                         PendingEvent &pending,
+                         EventFormatter *formatter
+                         );
+          void formatBinary(PendingEvent &pending);
+          size_t releaseMergedEvents(bool all = false);
+          void outputFormatted(PendingEventPtr pending);
+          void outputEvent(PendingEvent &pending) throw (Failure);
+          BufferedWriterPtr getCSVWriter(const PendingEvent &pending) throw (Failure);
+          void flushOutput();
+
+          void updateStats(
+                           ProviderInfo *provider,
+                           EVENT_DESCRIPTOR_HANDLE descriptor,
+                           EVENT_PARAMETER_DESCRIPTOR_HANDLE paramDescriptor,
+                           EVENT_DATA_DESCRIPTOR_HANDLE dataDescriptor,
+                           size_t dataDescriptorCount
+                           );
+          void outputStats();
+
+          void updateLatency(
+                             ProviderInfo *provider,
+                             EVENT_DESCRIPTOR_HANDLE descriptor,
+                             EVENT_PARAMETER_DESCRIPTOR_HANDLE paramDescriptor,
+                             EVENT_DATA_DESCRIPTOR_HANDLE dataDescriptor,
+                             size_t dataDescriptorCount
+                             );
+          void outputLatency();
 
         protected:
           //-------------------------------------------------------------------
@@ -239,18 +539,84 @@ namespace zsLib
           ICommandLineTypes::MonitorInfo mMonitorInfo;
           
           EventingAtomIndex mEventingAtom;
+          EventingAtomIndex mSchemaAtom;
 
           ProviderMap mProviders;
+          ProviderIDMap mProvidersByID;             // first schema of each provider (for lookups by ID)
           ProviderInfoSet mCleanProviderInfos;
+
+          SchemaCachePtr mSchemaCache;              // (only used by the schema loader once started)
+          ShippedProviderMap mShippedProviders;
+
+          Lock mSchemaLoaderLock;
+          std::condition_variable mSchemaLoaderWorkAvailable;
+          std::condition_variable mSchemaLoaded;
+          IndexedSchemaMap mIndexedSchemas;         // (protected by mSchemaLoaderLock) not yet requested
+          IndexedSchemaList mSchemaRequests;        // (protected by mSchemaLoaderLock) waiting to be loaded
+          String mSchemaLoading;                    // (protected by mSchemaLoaderLock) unique hash being loaded
+          ProviderMap mLoadedSchemas;               // (protected by mSchemaLoaderLock) waiting to be collected
+          bool mSchemaLoaderShutdown {};
+          std::thread mSchemaLoader;
           
           std::atomic<bool> mShouldQuit {false};
           std::atomic<size_t> mTotalEventsDropped {};
+          std::atomic<size_t> mTotalEventsOverflowed {};    // dropped because output could not keep up
           std::atomic<size_t> mTotalEvents {};
+          std::atomic<size_t> mTotalEventsFiltered {};
           bool mFirstOutputEvent {true};
 
+          mutable Lock mSourceLock;
+          SourceIndexMap mSourceIndexes;
+          SourceNameList mSourceNames;              // one per remote connection
+          RemoteDroppedMap mRemoteEventsDropped;
+
+          Lock mPipelineLock;
+          std::condition_variable mPipelineWorkAvailable;
+          PendingEventTimeMap mPipelineMerging;     // held back to be output in event time order
+          PendingEventList mPipelineQueue;          // waiting to be formatted
+          PendingEventMap mPipelineFormatted;       // waiting for earlier events
+          PendingEventList mPipelineFreeEvents;     // output and ready to be reused
+          uint64_t mNextSequence {};
+          uint64_t mNextOutputSequence {};
+          size_t mPipelinePending {};               // received but not yet output
+          bool mPipelineOutputting {};
+          bool mPipelineShutdown {};
+          std::vector<std::thread> mPipelineWorkers;
+
+          EventCounterMap mEventCounters;
+
+          EventFilterPtr mFilter;
+          EventFilter::BoundFilterPtr mUnknownEventFilter;    // for events without a schema
+
+          CSVWriterMap mCSVWriters;                 // (protected by mPipelineLock)
+          Helper::FileNameSet mCSVFileNames;        // (protected by mPipelineLock)
+          BufferedWriterPtr mOutputWriter;          // binary or ndjson output file
+          ProviderInfoSet mBinaryProviders;         // providers already announced in the current file
+          size_t mBinarySource {};                  // source announced last in the current file
+          bool mBinarySourceAnnounced {};
+          bool mOutputFailed {};
+
+          Lock mStatsLock;
+          EventStatsMap mEventStats;
+          ProviderStatsMap mProviderStats;
+          SubsystemStatsMap mSubsystemStats;
+          std::chrono::steady_clock::time_point mStatsLastOutput {};
+          HeavyHittersMap mHeavyHitters;
+          ITimerPtr mStatsTimer;
+
+          Lock mLatencyLock;
+          TaskLatencyMap mTaskLatencies;
+          OpenSpanMap mOpenSpans;
+          size_t mTotalOpenSpans {};
+          size_t mTotalDroppedSpans {};
+          ITimerPtr mLatencyTimer;
+
           ITimerPtr mAutoQuitTimer;
+          ITimerPtr mFlushTimer;
+          ITimerPtr mMergeTimer;
 
-          IRemoteEventingPtr mRemote;
+          RemoteEventingList mRemotes;
+          ITraceFileWriterPtr mRecordWriter;
         };
 
       } // namespace internal
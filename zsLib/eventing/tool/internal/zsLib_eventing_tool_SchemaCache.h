@@ -0,0 +1,176 @@
+/*
+
+Copyright (c) 2016, Robin Raymond
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are those
+of the authors and should not be interpreted as representing official policies,
+either expressed or implied, of the FreeBSD Project.
+
+*/
+
+
+
+#pragma once
+
+#include <zsLib/eventing/tool/internal/types.h>
+
+#include <zsLib/eventing/IEventingTypes.h>
+
+#include <map>
+#include <vector>
+
+#define ZS_EVENTING_TOOL_SCHEMA_CACHE_MAGIC "zsSC"
+#define ZS_EVENTING_TOOL_SCHEMA_CACHE_VERSION (1)
+#define ZS_EVENTING_TOOL_SCHEMA_VERSION (1)
+
+namespace zsLib
+{
+  namespace eventing
+  {
+    namespace tool
+    {
+      namespace internal
+      {
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark SchemaCache
+        #pragma mark
+
+        // Compiled provider schemas kept in a memory mapped file so a jman
+        // file does not have to be parsed again at every launch. A compiled
+        // schema only holds what is needed to decode events (the provider,
+        // its subsystems and its events with their channel, task, opcode
+        // and data template).
+        //
+        // Cache file (all values little endian):
+        //
+        //   "zsSC" magic, uint32 version, uint32 entry count
+        //   entries, each: string provider unique hash, string source hash
+        //   (of the jman file the schema was compiled from), uint32 schema
+        //   size and the compiled schema
+        //   (strings are a uint32 length followed by the characters)
+        //
+        // Compiled schema:
+        //
+        //   uint32 version, string provider ID, string name, string unique
+        //   hash, uint32 subsystem count, then per subsystem: string name,
+        //   uint8 level, uint32 event count, then per event: uint32 value,
+        //   string name, string subsystem, uint8 severity, uint8 level,
+        //   string channel ID, uint32 channel value, string task name,
+        //   uint32 task value, string opcode name, uint32 opcode value,
+        //   string data template ID, uint32 data type count, then per data
+        //   type: uint8 type, string value name
+        //   (empty names mean the event has no channel, task, opcode or
+        //   data template)
+        //
+        // The same compiled schema is embedded in generated events headers
+        // and shipped by remote eventing (see
+        // ZS_EVENTING_PROVIDER_SCHEMA_ATOM_NAME).
+        class SchemaCache
+        {
+        protected:
+          struct make_private {};
+
+        public:
+          ZS_DECLARE_TYPEDEF_PTR(IEventingTypes::Provider, Provider);
+
+          struct Entry
+          {
+            String mSourceHash;
+            const BYTE *mSchema {};                 // within the mapped file
+            size_t mSchemaSize {};
+            String mCompiled;                       // schemas added since the file was mapped
+          };
+          typedef std::map<String, Entry> EntryMap;                         // by provider unique hash
+          typedef std::map<String, String> SourceMap;                       // source hash to provider unique hash
+
+        public:
+          SchemaCache(
+                      const make_private &,
+                      const String &fileName
+                      );
+          ~SchemaCache();
+
+          // maps the cache file if it exists; a missing or unreadable cache
+          // is treated as empty (and replaced when saved)
+          static SchemaCachePtr create(const String &fileName);
+
+          const String &getFileName() const {return mFileName;}
+
+          // returns NULL if the provider is not in the cache or was compiled
+          // from different jman contents
+          ProviderPtr getProvider(const String &sourceHash) throw (InvalidContent);
+          ProviderPtr getProviderByHash(const String &providerUniqueHash) throw (InvalidContent);
+
+          // providers without a unique hash are not cached
+          void setProvider(
+                           const String &sourceHash,
+                           ProviderPtr provider
+                           );
+
+          bool isDirty() const {return mDirty;}
+          void save() throw (Failure);
+
+          static String toSourceHash(const SecureByteBlock &jmanRaw);
+
+          static String compile(const IEventingTypes::Provider &provider);
+          static ProviderPtr decompile(
+                                       const BYTE *schema,
+                                       size_t size
+                                       ) throw (InvalidContent);
+
+        protected:
+          void mapFile() throw (StdError);
+          void unmapFile();
+          void readEntries() throw (InvalidContent);
+
+          static const BYTE *getSchema(
+                                       const Entry &entry,
+                                       size_t &outSize
+                                       );
+
+        protected:
+          String mFileName;
+
+#ifdef _WIN32
+          HANDLE mFile {INVALID_HANDLE_VALUE};
+          HANDLE mFileMapping {NULL};
+#else
+          int mFile {-1};
+#endif //_WIN32
+          const BYTE *mMapped {};
+          size_t mMappedSize {};
+
+          EntryMap mEntries;
+          SourceMap mSources;
+          bool mDirty {};
+        };
+
+      } // namespace internal
+    } // namespace tool
+  } // namespace eventing
+} // namespace zsLib
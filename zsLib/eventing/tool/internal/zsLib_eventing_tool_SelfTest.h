@@ -0,0 +1,160 @@
+/*
+
+Copyright (c) 2016, Robin Raymond
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are those
+of the authors and should not be interpreted as representing official policies,
+either expressed or implied, of the FreeBSD Project.
+
+*/
+
+
+#pragma once
+
+#include <zsLib/eventing/tool/internal/types.h>
+#include <zsLib/eventing/tool/internal/zsLib_eventing_tool_JSONWriter.h>
+
+#include <zsLib/eventing/tool/ICommandLine.h>
+
+#include <vector>
+
+#define ZS_EVENTING_TOOL_SELF_TEST_LARGE_DICTIONARY_SIZE ((1 << 21) + 64)
+#define ZS_EVENTING_TOOL_SELF_TEST_BENCHMARK_ROUNDS (20000)
+#define ZS_EVENTING_TOOL_SELF_TEST_RING_DATA_SIZE (256)
+#define ZS_EVENTING_TOOL_SELF_TEST_RING_FILE_NAME "zsLib-eventing-selftest.ring"
+#define ZS_EVENTING_TOOL_SELF_TEST_TRACE_FILE_NAME "zsLib-eventing-selftest.trace"
+
+namespace zsLib
+{
+  namespace eventing
+  {
+    namespace tool
+    {
+      namespace internal
+      {
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark SelfTest
+        #pragma mark
+
+        // checks the encoders the tool and the trace files depend on against
+        // known results (the tree has no separate test project)
+        class SelfTest
+        {
+        public:
+          typedef ICommandLineTypes::TraceInfo TraceInfo;
+          typedef std::vector<BYTE> Buffer;
+          typedef std::vector<String> StringVector;
+
+          struct GoldenValue
+          {
+            const char *mName;
+            const char *mValue;
+            bool mIsNumber;
+          };
+
+          // an event as the monitor outputs it; without a schema the name,
+          // channel, task and op code are the descriptor's numbers
+          struct GoldenEvent
+          {
+            const char *mSeverity;
+            const char *mLevel;
+            bool mHasSchema;
+            const char *mName;
+            const char *mChannel;
+            const char *mTask;
+            const char *mOpCode;
+            const GoldenValue *mValues;
+            size_t mTotalValues;
+          };
+
+          // the names and schema members encoded once up front (as the
+          // monitor's precompiled formatters do)
+          struct GoldenFormatter
+          {
+            String mEncodedMembers;
+            StringVector mEncodedNames;
+          };
+          typedef std::vector<GoldenFormatter> GoldenFormatterList;
+
+          //-------------------------------------------------------------------
+          #pragma mark
+          #pragma mark SelfTest => (friends)
+          #pragma mark
+
+          static void process(const TraceInfo &traceInfo) throw (Failure);
+
+        protected:
+          //-------------------------------------------------------------------
+          #pragma mark
+          #pragma mark SelfTest => (internal)
+          #pragma mark
+
+          static void testBlockCodec() throw (Failure);
+          static void testJSONWriter() throw (Failure);
+          static void testFlightRecorderConvert() throw (Failure);
+          static void benchmarkJSONWriter();
+
+          static void checkBlockCodecRoundTrip(
+                                               const char *testName,
+                                               const Buffer &dictionary,
+                                               const Buffer &data,
+                                               size_t *outCompressedSize = NULL
+                                               ) throw (Failure);
+          static void checkBlockCodecDecode(
+                                            const char *testName,
+                                            const Buffer &dictionary,
+                                            const Buffer &block,
+                                            const Buffer &expected,
+                                            bool expectSuccess
+                                            ) throw (Failure);
+
+          static void checkFlightRecorderConvert(
+                                                 const char *testName,
+                                                 const Buffer &ringFile,
+                                                 const StringVector &expected,
+                                                 bool expectSuccess
+                                                 ) throw (Failure);
+
+          static GoldenFormatterList prepareGoldenFormatters();
+          static String writeElementEvent(const GoldenEvent &event);
+          static void writeStreamedEvent(
+                                         JSONWriter &writer,
+                                         const GoldenEvent &event,
+                                         const GoldenFormatter &formatter
+                                         );
+
+          static Buffer randomBytes(
+                                    size_t size,
+                                    uint32_t seed
+                                    );
+        };
+
+      } // namespace internal
+    } // namespace tool
+  } // namespace eventing
+} // namespace zsLib
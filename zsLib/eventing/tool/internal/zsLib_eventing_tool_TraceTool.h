@@ -0,0 +1,306 @@
+/*
+
+Copyright (c) 2016, Robin Raymond
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are those
+of the authors and should not be interpreted as representing official policies,
+either expressed or implied, of the FreeBSD Project.
+
+*/
+
+
+#pragma once
+
+#include <zsLib/eventing/tool/internal/types.h>
+#include <zsLib/eventing/tool/internal/zsLib_eventing_tool_Helper.h>
+
+#include <zsLib/eventing/tool/ICommandLine.h>
+
+#include <zsLib/eventing/IEventingTypes.h>
+#include <zsLib/eventing/ITraceFile.h>
+
+#include <zsLib/Log.h>
+
+#include <atomic>
+
+#define ZS_EVENTING_TOOL_TRACE_SUMMARY_HISTOGRAM_BUCKETS (60)
+
+#define ZS_EVENTING_TOOL_TRACE_EXPORT_MAGIC "zsCL"
+#define ZS_EVENTING_TOOL_TRACE_EXPORT_VERSION (1)
+#define ZS_EVENTING_TOOL_TRACE_EXPORT_ROWS_PER_GROUP (65536)
+
+namespace zsLib
+{
+  namespace eventing
+  {
+    namespace tool
+    {
+      namespace internal
+      {
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark TraceTool
+        #pragma mark
+
+        // offline commands operating on recorded trace files
+        class TraceTool
+        {
+        public:
+          typedef ICommandLineTypes::TraceInfo TraceInfo;
+          typedef zsLib::Log::Severity Severity;
+
+          ZS_DECLARE_TYPEDEF_PTR(IEventingTypes::Provider, Provider);
+          ZS_DECLARE_TYPEDEF_PTR(IEventingTypes::Event, Event);
+          typedef std::map<String, ProviderPtr> ProviderMap;   // by provider ID
+
+          typedef size_t ValueID;
+          typedef std::map<ValueID, EventPtr> EventMap;
+
+          struct ProviderInfo
+          {
+            String mProviderName;
+            EventMap mEvents;
+          };
+          typedef std::map<uint64_t, ProviderInfo> ProviderInfoMap;   // by provider handle
+
+          struct EventValue
+          {
+            String mName;
+            size_t mIndex {};           // index of the event data descriptor
+            Optional<IEventingTypes::PredefinedTypedefs> mType;  // from the schema's data template
+          };
+          typedef std::vector<EventValue> EventValueList;
+
+          struct QueryCondition
+          {
+            String mName;
+            String mValue;
+            uint64_t mValueHash {};
+          };
+          typedef std::list<QueryCondition> QueryConditionList;
+
+          struct NumericStats
+          {
+            size_t mCount {};
+            double mMin {};
+            double mMax {};
+            double mTotal {};
+
+            void add(double value);
+            void merge(const NumericStats &source);
+          };
+          typedef std::map<String, NumericStats> NumericStatsMap;     // by value name
+
+          struct EventSummary
+          {
+            String mProviderName;
+            String mEventName;
+            size_t mTotal {};
+            NumericStatsMap mValues;
+          };
+          typedef std::pair<String, ValueID> EventSummaryKey;         // provider name, event ID
+          typedef std::map<EventSummaryKey, EventSummary> EventSummaryMap;
+
+          typedef std::map<String, size_t> CountMap;
+          typedef std::vector<size_t> HistogramBucketList;
+
+          // partial results are produced per worker and merged afterwards
+          struct Summary
+          {
+            size_t mTotalChunks {};
+            size_t mTotalRecords {};
+            size_t mTotalEvents {};
+            size_t mTotalUndecodedEvents {};
+
+            Time mFirstTime {};
+            Microseconds mBucketDuration {};
+            HistogramBucketList mHistogram;
+
+            EventSummaryMap mEvents;
+            CountMap mSubsystems;
+            CountMap mSeverities;
+
+            void merge(const Summary &source);
+            ElementPtr toJSON() const;
+          };
+
+          enum ColumnTypes
+          {
+            ColumnType_First,
+
+            ColumnType_Boolean = ColumnType_First,
+            ColumnType_UnsignedInteger,
+            ColumnType_SignedInteger,
+            ColumnType_Float,
+            ColumnType_String,
+
+            ColumnType_Last = ColumnType_String,
+          };
+
+          typedef std::map<String, uint32_t> StringIndexMap;
+          typedef std::vector<String> StringVector;
+
+          // the values of a column for the row group being built; strings
+          // are stored as 32 bit indexes into the column's dictionary
+          struct ExportColumn
+          {
+            String mName;
+            ColumnTypes mType {ColumnType_String};
+            size_t mWidth {};                     // bytes per value
+
+            std::vector<BYTE> mData;
+
+            StringIndexMap mDictionary;
+            StringVector mDictionaryValues;       // by index
+          };
+          typedef std::vector<ExportColumn> ExportColumnList;
+
+          struct ExportRowGroup
+          {
+            uint64_t mOffset {};
+            size_t mTotalRows {};
+          };
+          typedef std::list<ExportRowGroup> ExportRowGroupList;
+
+          // One columnar table file per event type. All values are little
+          // endian so a column can be loaded directly as a typed array.
+          //
+          // [magic "zsCL"][version (32 bits)]
+          // per row group:
+          //   per column: [row group rows * column width bytes]
+          // footer:
+          //   [table name][total rows (64 bits)][total columns (32 bits)]
+          //   per column:
+          //     [name][type (8 bits)][width (8 bits)]
+          //     [dictionary size (32 bits)][dictionary strings...]
+          //   [total row groups (32 bits)]
+          //   per row group: [file offset (64 bits)][rows (64 bits)]
+          // [footer size (32 bits)][magic "zsCL"]
+          //
+          // Strings are written as [length (32 bits)][UTF-8 bytes].
+          ZS_DECLARE_STRUCT_PTR(ExportTable);
+
+          struct ExportTable
+          {
+            String mName;
+            String mFileName;
+            uint64_t mOffset {};
+
+            ExportColumnList mColumns;
+            size_t mTotalRows {};
+            size_t mRowGroupRows {};
+            ExportRowGroupList mRowGroups;
+
+            void open() throw (Failure);
+            void appendRow(
+                           const ITraceFileTypes::Record &record,
+                           const ITraceFileTypes::TraceEvent &event,
+                           const EventValueList &values
+                           );
+            void flushRowGroup() throw (Failure);
+            void close() throw (Failure);
+
+          protected:
+            void write(
+                       const char *mode,
+                       const std::vector<BYTE> &buffer
+                       ) throw (Failure);
+          };
+          typedef std::pair<String, ValueID> ExportTableKey;          // provider name, event ID
+          typedef std::map<ExportTableKey, ExportTablePtr> ExportTableMap;
+
+          //-------------------------------------------------------------------
+          #pragma mark
+          #pragma mark TraceTool => (friends)
+          #pragma mark
+
+          static void process(const TraceInfo &traceInfo) throw (Failure);
+
+        protected:
+          //-------------------------------------------------------------------
+          #pragma mark
+          #pragma mark TraceTool => (internal)
+          #pragma mark
+
+          static void merge(const TraceInfo &traceInfo) throw (Failure);
+          static void summarize(const TraceInfo &traceInfo) throw (Failure);
+          static void query(const TraceInfo &traceInfo) throw (Failure);
+          static void exportTables(const TraceInfo &traceInfo) throw (Failure);
+          static void convert(const TraceInfo &traceInfo) throw (Failure);
+
+          static ProviderMap loadProviders(const StringList &jmanFiles) throw (Failure);
+
+          static void summarizeChunks(
+                                      ITraceFileChunkCursorPtr cursor,
+                                      const ITraceFileTypes::ChunkInfoList &chunks,
+                                      const ProviderMap &providers,
+                                      std::atomic<size_t> &nextChunk,
+                                      Summary &ioSummary
+                                      );
+          static void updateProviders(
+                                      const ITraceFileTypes::Record &record,
+                                      const ProviderMap &providers,
+                                      ProviderInfoMap &ioProviderInfos
+                                      );
+          static void getEventValues(
+                                     EventPtr eventInfo,
+                                     const ITraceFileTypes::TraceEvent &event,
+                                     EventValueList &outValues
+                                     );
+          static void summarizeEvent(
+                                     const ITraceFileTypes::Record &record,
+                                     const ITraceFileTypes::TraceEvent &event,
+                                     const ProviderInfoMap &providerInfos,
+                                     Summary &ioSummary
+                                     );
+
+          static bool matchesQuery(
+                                   const QueryConditionList &conditions,
+                                   const ITraceFileTypes::TraceEvent &event,
+                                   const EventValueList &values
+                                   );
+          static ElementPtr eventToJSON(
+                                        const ITraceFileTypes::Record &record,
+                                        const ITraceFileTypes::TraceEvent &event,
+                                        const ProviderInfoMap &providerInfos,
+                                        const EventValueList &values
+                                        );
+
+          static ExportTablePtr createExportTable(
+                                                  const String &directory,
+                                                  const String &providerName,
+                                                  const String &eventName,
+                                                  const ITraceFileTypes::TraceEvent &event,
+                                                  const EventValueList &values,
+                                                  Helper::FileNameSet &ioUsedFileNames
+                                                  ) throw (Failure);
+        };
+
+      } // namespace internal
+    } // namespace tool
+  } // namespace eventing
+} // namespace zsLib
@@ -64,7 +64,11 @@ namespace zsLib
     ZS_DECLARE_INTERACTION_PTR(IHelper);
     ZS_DECLARE_INTERACTION_PTR(IHasher);
     ZS_DECLARE_INTERACTION_PTR(IHasherAlgorithm);
+    ZS_DECLARE_INTERACTION_PTR(IFlightRecorder);
     ZS_DECLARE_INTERACTION_PTR(IRemoteEventing);
+    ZS_DECLARE_INTERACTION_PTR(ITraceFileChunkCursor);
+    ZS_DECLARE_INTERACTION_PTR(ITraceFileReader);
+    ZS_DECLARE_INTERACTION_PTR(ITraceFileWriter);
 
     ZS_DECLARE_INTERACTION_PROXY(IRemoteEventingDelegate);
   }